@@ -746,6 +746,21 @@ class Action<R(Args...)> {
   template <typename G>
   using IsCompatibleFunctor = std::is_constructible<std::function<F>, G>;
 
+  template <typename G>
+  struct IsStdFunction : std::false_type {};
+  template <typename Signature>
+  struct IsStdFunction<std::function<Signature>> : std::true_type {};
+
+  // Whether calling a G can't change its state: it has none, or it can be
+  // called as const.  A std::function can be called as const whatever the
+  // callable it holds, so it's left out.
+  template <typename G, typename... CallArgs>
+  using HasFixedState = internal::conjunction<
+      internal::negation<IsStdFunction<G>>,
+      internal::disjunction<
+          std::is_empty<G>,
+          internal::is_callable_r<void, const G&, CallArgs...>>>;
+
  public:
   typedef typename internal::Function<F>::Result Result;
   typedef typename internal::Function<F>::ArgumentTuple ArgumentTuple;
@@ -766,20 +781,29 @@ class Action<R(Args...)> {
     Init(::std::forward<G>(fun), IsCompatibleFunctor<G>());
   }
 
-  // Constructs an Action from its implementation.
+  // Constructs an Action from its implementation.  Copies of the Action
+  // share the implementation, so it can be performed in place.
   explicit Action(ActionInterface<F>* impl)
-      : fun_(ActionAdapter{::std::shared_ptr<ActionInterface<F>>(impl)}) {}
+      : fun_(ActionAdapter{::std::shared_ptr<ActionInterface<F>>(impl)}),
+        can_perform_in_place_(true) {}
 
   // This constructor allows us to turn an Action<Func> object into an
   // Action<F>, as long as F's arguments can be implicitly converted
   // to Func's and Func's return type can be implicitly converted to F's.
   template <typename Func>
   Action(const Action<Func>& action)  // NOLINT
-      : fun_(action.fun_) {}
+      : fun_(action.fun_),
+        can_perform_in_place_(action.can_perform_in_place_) {}
 
   // Returns true if and only if this is the DoDefault() action.
   bool IsDoDefault() const { return fun_ == nullptr; }
 
+  // Returns true if and only if performing the action has the same effect
+  // as performing a copy of it: the callable it was created from can't
+  // change its state when called, or its copies share their state.  A
+  // mock function performs such an action without copying it first.
+  bool CanPerformInPlace() const { return can_perform_in_place_; }
+
   // Performs the action.  Note that this method is const even though
   // the corresponding method in ActionInterface is not.  The reason
   // is that a const Action<F> means that it cannot be re-bound to
@@ -817,11 +841,15 @@ class Action<R(Args...)> {
 
   template <typename G>
   void Init(G&& g, ::std::true_type) {
+    can_perform_in_place_ =
+        HasFixedState<typename ::std::decay<G>::type, Args...>::value;
     fun_ = ::std::forward<G>(g);
   }
 
   template <typename G>
   void Init(G&& g, ::std::false_type) {
+    can_perform_in_place_ =
+        HasFixedState<typename ::std::decay<G>::type>::value;
     fun_ = IgnoreArgs<typename ::std::decay<G>::type>{::std::forward<G>(g)};
   }
 
@@ -837,6 +865,7 @@ class Action<R(Args...)> {
 
   // fun_ is an empty function if and only if this is the DoDefault() action.
   ::std::function<F> fun_;
+  bool can_perform_in_place_ = false;
 };
 
 // The PolymorphicAction class template makes it easy to implement a
@@ -256,6 +256,7 @@
 #define GOOGLEMOCK_INCLUDE_GMOCK_GMOCK_MATCHERS_H_
 
 #include <algorithm>
+#include <array>
 #include <cmath>
 #include <initializer_list>
 #include <iterator>
@@ -265,6 +266,7 @@
 #include <sstream>
 #include <string>
 #include <type_traits>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
@@ -1177,6 +1179,10 @@ class PairMatchBase {
     return MakeMatcher(new Impl<const ::std::tuple<T1, T2>&>);
   }
 
+  // Returns a function object that tells whether two values form a
+  // matching pair (see PairPredicate).
+  Op AsPredicate() const { return Op(); }
+
  private:
   static ::std::ostream& GetDesc(::std::ostream& os) {  // NOLINT
     return os << D::Desc();
@@ -1782,6 +1788,60 @@ class FloatingEqMatcher {
   const FloatType max_abs_error_;
 };
 
+// Tells whether a floating-point value matches an expected one, giving the
+// same answer FloatingEqMatcher does.  Unlike the matcher, it computes
+// every part of the answer and combines them with bitwise operators, so
+// that a loop calling it has no branches and the compiler can vectorize
+// it.
+template <typename FloatType>
+class FloatingEqPredicate {
+ public:
+  // A negative max_abs_error means that ULP-based approximation is used.
+  FloatingEqPredicate(FloatType max_abs_error, bool nan_eq_nan)
+      : max_abs_error_(max_abs_error),
+        has_max_abs_error_(max_abs_error >= 0),
+        nan_eq_nan_(nan_eq_nan) {}
+
+  bool operator()(FloatType expected, FloatType actual) const {
+    const Bits actual_bits = FloatingPoint<FloatType>(actual).bits();
+    const Bits expected_bits = FloatingPoint<FloatType>(expected).bits();
+    const bool actual_is_nan = IsNan(actual_bits);
+    const bool expected_is_nan = IsNan(expected_bits);
+    const Bits biased_actual = ToBiased(actual_bits);
+    const Bits biased_expected = ToBiased(expected_bits);
+    const bool almost_equals =
+        (biased_actual >= biased_expected ? biased_actual - biased_expected
+                                          : biased_expected - biased_actual) <=
+        FloatingPoint<FloatType>::kMaxUlps;
+    const bool near = (actual == expected) |
+                      (::std::fabs(actual - expected) <= max_abs_error_);
+    const bool equals = (has_max_abs_error_ & near) |
+                        (!has_max_abs_error_ & almost_equals);
+    return (actual_is_nan & expected_is_nan & nan_eq_nan_) |
+           (!actual_is_nan & !expected_is_nan & equals);
+  }
+
+ private:
+  typedef typename FloatingPoint<FloatType>::Bits Bits;
+
+  // Like FloatingPoint::is_nan().
+  static bool IsNan(Bits bits) {
+    return (bits & ~FloatingPoint<FloatType>::kSignBitMask) >
+           FloatingPoint<FloatType>::kExponentBitMask;
+  }
+
+  // Like FloatingPoint::SignAndMagnitudeToBiased().
+  static Bits ToBiased(Bits sam) {
+    return (sam & FloatingPoint<FloatType>::kSignBitMask)
+               ? ~sam + 1
+               : FloatingPoint<FloatType>::kSignBitMask | sam;
+  }
+
+  FloatType max_abs_error_;
+  bool has_max_abs_error_;
+  bool nan_eq_nan_;
+};
+
 // A 2-tuple ("binary") wrapper around FloatingEqMatcher:
 // FloatingEq2Matcher() matches (x, y) by matching FloatingEqMatcher(x, false)
 // against y, and FloatingEq2Matcher(e) matches FloatingEqMatcher(x, false, e)
@@ -1813,6 +1873,16 @@ class FloatingEq2Matcher {
         new Impl<const ::std::tuple<T1, T2>&>(max_abs_error_, nan_eq_nan_));
   }
 
+  // Returns a function object that tells whether two values form a
+  // matching pair (see PairPredicate).
+  FloatingEqPredicate<FloatType> AsPredicate() const {
+    if (max_abs_error_ != -1) {
+      GTEST_CHECK_(max_abs_error_ >= 0)
+          << ", where max_abs_error is" << max_abs_error_;
+    }
+    return FloatingEqPredicate<FloatType>(max_abs_error_, nan_eq_nan_);
+  }
+
  private:
   static ::std::ostream& GetDesc(::std::ostream& os) {  // NOLINT
     return os << "an almost-equal pair";
@@ -2566,6 +2636,63 @@ class WhenSortedByMatcher {
   const ContainerMatcher matcher_;
 };
 
+// IsContiguousContainer<C>::value is true if and only if C is known to
+// store its elements in one array, so that &*c.begin() points to c.size()
+// consecutive elements.
+template <typename C>
+struct IsContiguousContainer : std::false_type {};
+
+template <typename C>
+struct IsContiguousContainer<const C> : IsContiguousContainer<C> {};
+
+template <typename T, typename Allocator>
+struct IsContiguousContainer<std::vector<T, Allocator>>
+    : std::integral_constant<bool, !std::is_same<T, bool>::value> {};
+
+template <typename T, size_t N>
+struct IsContiguousContainer<std::array<T, N>> : std::true_type {};
+
+template <typename T>
+struct IsContiguousContainer<NativeArray<T>> : std::true_type {};
+
+// PairPredicate<M>::Get(m) returns a function object that tells whether
+// two arithmetic values form a pair matching the 2-tuple matcher m, giving
+// the same answer m does, without explaining why.  Matchers provide it
+// with an AsPredicate() member; for other matchers, PairPredicate<M>::type
+// is void.
+template <typename M, typename = void>
+struct PairPredicate {
+  typedef void type;
+};
+
+template <typename M>
+struct PairPredicate<M, decltype(static_cast<void>(
+                            std::declval<const M&>().AsPredicate()))> {
+  typedef decltype(std::declval<const M&>().AsPredicate()) type;
+
+  static type Get(const M& m) { return m.AsPredicate(); }
+};
+
+// Returns the number of leading indices i < n where pred(lhs[i], rhs[i])
+// holds.  The indices are tested a block at a time, without stopping at a
+// mismatch inside the block, so that the compiler can vectorize the inner
+// loop.
+template <typename Lhs, typename Rhs, typename Predicate>
+size_t CountMatchingPrefix(const Lhs* lhs, const Rhs* rhs, size_t n,
+                           const Predicate& pred) {
+  const size_t kBlockSize = 64;
+  size_t i = 0;
+  for (; n - i >= kBlockSize; i += kBlockSize) {
+    size_t mismatches = 0;
+    for (size_t j = i; j != i + kBlockSize; ++j) {
+      mismatches += !pred(lhs[j], rhs[j]);
+    }
+    if (mismatches != 0) break;
+  }
+  while (i != n && pred(lhs[i], rhs[i])) ++i;
+  return i;
+}
+
 // Implements Pointwise(tuple_matcher, rhs_container).  tuple_matcher
 // must be able to be safely cast to Matcher<std::tuple<const T1&, const
 // T2&> >, where T1 and T2 are the types of elements in the LHS
@@ -2616,10 +2743,26 @@ class PointwiseMatcher {
     // 20.2.2 [lib.pairs]).
     typedef ::std::tuple<const LhsValue&, const RhsValue&> InnerMatcherArg;
 
+    // Whether MatchAndExplain() can skip the leading matching values with
+    // CountMatchingPrefix(), which is when both containers are arrays of
+    // arithmetic values and the tuple matcher has a PairPredicate.
+    typedef std::integral_constant<
+        bool,
+        !std::is_void<typename PairPredicate<TupleMatcher>::type>::value &&
+            IsContiguousContainer<LhsStlContainer>::value &&
+            IsContiguousContainer<RhsStlContainer>::value &&
+            std::is_arithmetic<LhsValue>::value &&
+            std::is_arithmetic<RhsValue>::value>
+        CanMatchInBulk;
+    typedef typename std::conditional<
+        CanMatchInBulk::value, typename PairPredicate<TupleMatcher>::type,
+        std::nullptr_t>::type Predicate;
+
     Impl(const TupleMatcher& tuple_matcher, const RhsStlContainer& rhs)
         // mono_tuple_matcher_ holds a monomorphic version of the tuple matcher.
         : mono_tuple_matcher_(SafeMatcherCast<InnerMatcherArg>(tuple_matcher)),
-          rhs_(rhs) {}
+          rhs_(rhs),
+          predicate_(MakePredicate(tuple_matcher, CanMatchInBulk())) {}
 
     void DescribeTo(::std::ostream* os) const override {
       *os << "contains " << rhs_.size()
@@ -2646,9 +2789,14 @@ class PointwiseMatcher {
         return false;
       }
 
+      // The leading pairs that match need no explanation, so skip them in
+      // bulk where possible.
+      size_t i = MatchingPrefixLength(lhs_stl_container, CanMatchInBulk());
       auto left = lhs_stl_container.begin();
       auto right = rhs_.begin();
-      for (size_t i = 0; i != actual_size; ++i, ++left, ++right) {
+      std::advance(left, i);
+      std::advance(right, i);
+      for (; i != actual_size; ++i, ++left, ++right) {
         if (listener->IsInterested()) {
           StringMatchResultListener inner_listener;
           // Create InnerMatcherArg as a temporarily object to avoid it outlives
@@ -2678,8 +2826,30 @@ class PointwiseMatcher {
     }
 
    private:
+    static Predicate MakePredicate(const TupleMatcher& tuple_matcher,
+                                   std::true_type /* can_match_in_bulk */) {
+      return PairPredicate<TupleMatcher>::Get(tuple_matcher);
+    }
+    static Predicate MakePredicate(const TupleMatcher& /* tuple_matcher */,
+                                   std::false_type /* can_match_in_bulk */) {
+      return nullptr;
+    }
+
+    // Returns how many leading pairs match; lhs has as many values as rhs_.
+    size_t MatchingPrefixLength(LhsStlContainerReference lhs,
+                                std::true_type /* can_match_in_bulk */) const {
+      if (rhs_.size() == 0) return 0;
+      return CountMatchingPrefix(&*lhs.begin(), &*rhs_.begin(), rhs_.size(),
+                                 predicate_);
+    }
+    size_t MatchingPrefixLength(LhsStlContainerReference /* lhs */,
+                                std::false_type /* can_match_in_bulk */) const {
+      return 0;
+    }
+
     const Matcher<InnerMatcherArg> mono_tuple_matcher_;
     const RhsStlContainer rhs_;
+    const Predicate predicate_;
   };
 
  private:
@@ -3375,6 +3545,7 @@ class ElementsAreMatcherImpl : public MatcherInterface<Container> {
     while (first != last) {
       matchers_.push_back(MatcherCast<const Element&>(*first++));
     }
+    FindExpectedValues(CanMatchInBulk());
   }
 
   // Describes what this matcher does.
@@ -3421,10 +3592,13 @@ class ElementsAreMatcherImpl : public MatcherInterface<Container> {
     const bool listener_interested = listener->IsInterested();
 
     // explanations[i] is the explanation of the element at index i.
-    ::std::vector<std::string> explanations(count());
+    ::std::vector<std::string> explanations(listener_interested ? count() : 0);
     StlContainerReference stl_container = View::ConstReference(container);
+    // The leading elements that equal their expected values match without
+    // an explanation, so skip them in bulk where possible.
+    size_t exam_pos = MatchingPrefixLength(stl_container, CanMatchInBulk());
     auto it = stl_container.begin();
-    size_t exam_pos = 0;
+    std::advance(it, exam_pos);
     bool mismatch_found = false;  // Have we found a mismatched element yet?
 
     // Go through the elements and matchers in pairs, until we reach
@@ -3500,27 +3674,88 @@ class ElementsAreMatcherImpl : public MatcherInterface<Container> {
 
   size_t count() const { return matchers_.size(); }
 
+  // Whether the leading elements can be compared with expected_values_ by
+  // CountMatchingPrefix(), which needs an array of arithmetic values.
+  typedef std::integral_constant<bool,
+                                 IsContiguousContainer<StlContainer>::value &&
+                                     std::is_arithmetic<Element>::value>
+      CanMatchInBulk;
+
+  // Sets expected_values_ if all the matchers are Eq() matchers.
+  void FindExpectedValues(std::true_type /* can_match_in_bulk */) {
+    ::std::vector<Element> values;
+    values.reserve(count());
+    for (const auto& m : matchers_) {
+      const Element* const value = m.GetEqualOperand();
+      if (value == nullptr) return;
+      values.push_back(*value);
+    }
+    expected_values_ = std::move(values);
+  }
+  void FindExpectedValues(std::false_type /* can_match_in_bulk */) {}
+
+  // Returns how many leading elements equal their expected values.
+  size_t MatchingPrefixLength(StlContainerReference stl_container,
+                              std::true_type /* can_match_in_bulk */) const {
+    const size_t n = (std::min)(stl_container.size(), expected_values_.size());
+    if (n == 0) return 0;
+    return CountMatchingPrefix(&*stl_container.begin(), expected_values_.data(),
+                               n, AnyEq());
+  }
+  size_t MatchingPrefixLength(StlContainerReference /* stl_container */,
+                              std::false_type /* can_match_in_bulk */) const {
+    return 0;
+  }
+
   ::std::vector<Matcher<const Element&>> matchers_;
+  // The operands of matchers_ if they are all Eq() matchers on arithmetic
+  // values in an array, and empty otherwise.
+  ::std::vector<Element> expected_values_;
 };
 
-// Connectivity matrix of (elements X matchers), in element-major order.
+// IsHashable<T>::value is true if and only if std::hash supports T.
+template <typename T, typename = void>
+struct IsHashable : std::false_type {};
+
+template <typename T>
+struct IsHashable<T, decltype(static_cast<void>(
+                         std::hash<T>()(std::declval<const T&>())))>
+    : std::true_type {};
+
+// Connectivity matrix of (elements X matchers).  Only the edges are
+// stored, as a list of matchers per element, so that a matrix of many
+// elements that each match few matchers stays small.
 // Initially, there are no edges.
 // Use NextGraph() to iterate over all possible edge configurations.
 // Use Randomize() to generate a random edge configuration.
 class GTEST_API_ MatchMatrix {
  public:
   MatchMatrix(size_t num_elements, size_t num_matchers)
-      : num_elements_(num_elements),
-        num_matchers_(num_matchers),
-        matched_(num_elements_ * num_matchers_, 0) {}
+      : num_matchers_(num_matchers), edges_(num_elements) {}
 
-  size_t LhsSize() const { return num_elements_; }
+  size_t LhsSize() const { return edges_.size(); }
   size_t RhsSize() const { return num_matchers_; }
   bool HasEdge(size_t ilhs, size_t irhs) const {
-    return matched_[SpaceIndex(ilhs, irhs)] == 1;
+    return ::std::binary_search(edges_[ilhs].begin(), edges_[ilhs].end(),
+                                irhs);
   }
   void SetEdge(size_t ilhs, size_t irhs, bool b) {
-    matched_[SpaceIndex(ilhs, irhs)] = b ? 1 : 0;
+    ::std::vector<size_t>& edges = edges_[ilhs];
+    // Edges are usually added in order, at the end.
+    const auto it = edges.empty() || edges.back() < irhs
+                        ? edges.end()
+                        : ::std::lower_bound(edges.begin(), edges.end(), irhs);
+    const bool has_edge = it != edges.end() && *it == irhs;
+    if (b && !has_edge) {
+      edges.insert(it, irhs);
+    } else if (!b && has_edge) {
+      edges.erase(it);
+    }
+  }
+
+  // Returns the matchers element ilhs has an edge to, in increasing order.
+  const ::std::vector<size_t>& EdgesOf(size_t ilhs) const {
+    return edges_[ilhs];
   }
 
   // Treating the connectivity matrix as a (LhsSize()*RhsSize())-bit number,
@@ -3533,17 +3768,11 @@ class GTEST_API_ MatchMatrix {
   std::string DebugString() const;
 
  private:
-  size_t SpaceIndex(size_t ilhs, size_t irhs) const {
-    return ilhs * num_matchers_ + irhs;
-  }
-
-  size_t num_elements_;
   size_t num_matchers_;
 
-  // Each element is a char interpreted as bool. They are stored as a
-  // flattened array in lhs-major order, use 'SpaceIndex()' to translate
-  // a (ilhs, irhs) matrix coordinate into an offset.
-  ::std::vector<char> matched_;
+  // For each element, the matchers it has an edge to, in increasing
+  // order.
+  ::std::vector<::std::vector<size_t>> edges_;
 };
 
 typedef ::std::pair<size_t, size_t> ElementMatcherPair;
@@ -3624,6 +3853,7 @@ class UnorderedElementsAreMatcherImpl
     for (const auto& m : matchers_) {
       matcher_describers().push_back(m.GetDescriber());
     }
+    FindEqualOperands(CanMatchByHash());
   }
 
   // Describes what this matcher does.
@@ -3639,6 +3869,11 @@ class UnorderedElementsAreMatcherImpl
   bool MatchAndExplain(Container container,
                        MatchResultListener* listener) const override {
     StlContainerReference stl_container = View::ConstReference(container);
+    if (!equal_operands_.empty() && !listener->IsInterested()) {
+      return MatchEqualOperands(stl_container.begin(), stl_container.end(),
+                                CanMatchByHash());
+    }
+
     ::std::vector<std::string> element_printouts;
     MatchMatrix matrix =
         AnalyzeElements(stl_container.begin(), stl_container.end(),
@@ -3671,30 +3906,101 @@ class UnorderedElementsAreMatcherImpl
                               ::std::vector<std::string>* element_printouts,
                               MatchResultListener* listener) const {
     element_printouts->clear();
-    ::std::vector<char> did_match;
-    size_t num_elements = 0;
+    MatchMatrix matrix(
+        static_cast<size_t>(::std::distance(elem_first, elem_last)),
+        matchers_.size());
     DummyMatchResultListener dummy;
-    for (; elem_first != elem_last; ++num_elements, ++elem_first) {
+    for (size_t ilhs = 0; elem_first != elem_last; ++ilhs, ++elem_first) {
       if (listener->IsInterested()) {
         element_printouts->push_back(PrintToString(*elem_first));
       }
       for (size_t irhs = 0; irhs != matchers_.size(); ++irhs) {
-        did_match.push_back(
-            matchers_[irhs].MatchAndExplain(*elem_first, &dummy));
+        if (matchers_[irhs].MatchAndExplain(*elem_first, &dummy)) {
+          matrix.SetEdge(ilhs, irhs, true);
+        }
       }
     }
+    return matrix;
+  }
 
-    MatchMatrix matrix(num_elements, matchers_.size());
-    ::std::vector<char>::const_iterator did_match_iter = did_match.begin();
-    for (size_t ilhs = 0; ilhs != num_elements; ++ilhs) {
-      for (size_t irhs = 0; irhs != matchers_.size(); ++irhs) {
-        matrix.SetEdge(ilhs, irhs, *did_match_iter++ != 0);
+  // Whether elements can be hashed and compared, which matching them by
+  // hash needs (see MatchEqualOperands()).
+  using CanMatchByHash =
+      std::integral_constant<bool, IsHashable<Element>::value &&
+                                       IsEqualityComparable<Element>::value>;
+
+  // Sets equal_operands_ if all the matchers are Eq() matchers.
+  void FindEqualOperands(std::true_type /* can_match_by_hash */) {
+    for (const auto& m : matchers_) {
+      const Element* const operand = m.GetEqualOperand();
+      if (operand == nullptr) {
+        equal_operands_.clear();
+        return;
       }
+      equal_operands_.push_back(operand);
     }
-    return matrix;
+  }
+  void FindEqualOperands(std::false_type /* can_match_by_hash */) {}
+
+  // Hashes and compares the values that equal_operands_ point to.
+  struct OperandHash {
+    size_t operator()(const Element* operand) const {
+      return ::std::hash<Element>()(*operand);
+    }
+  };
+  struct OperandEqual {
+    bool operator()(const Element* lhs, const Element* rhs) const {
+      return *lhs == *rhs;
+    }
+  };
+
+  // Matches the elements against equal_operands_ in O(N) time, rather
+  // than matching each element against each matcher and looking for a
+  // pairing.  Eq() matchers match an element if and only if it equals
+  // their value, so the matchers and the elements fall into groups of
+  // equal values, and an element can be paired with a matcher if and
+  // only if they are in the same group.  Counting the matchers in each
+  // group thus finds the size of the best pairing, but not the pairing
+  // itself, which is needed to explain the result.
+  template <typename ElementIter>
+  bool MatchEqualOperands(ElementIter elem_first, ElementIter elem_last,
+                          std::true_type /* can_match_by_hash */) const {
+    ::std::unordered_map<const Element*, size_t, OperandHash, OperandEqual>
+        unpaired_matchers;
+    for (const Element* operand : equal_operands_) {
+      ++unpaired_matchers[operand];
+    }
+
+    size_t num_elements = 0;
+    size_t num_pairs = 0;
+    for (; elem_first != elem_last; ++num_elements, ++elem_first) {
+      // Binds a temporary if the iterator returns a proxy.
+      const Element& element = *elem_first;
+      const auto it = unpaired_matchers.find(&element);
+      if (it != unpaired_matchers.end() && it->second > 0) {
+        --it->second;
+        ++num_pairs;
+      }
+    }
+
+    return (!(match_flags() & UnorderedMatcherRequire::Superset) ||
+            num_pairs == matchers_.size()) &&
+           (!(match_flags() & UnorderedMatcherRequire::Subset) ||
+            num_pairs == num_elements);
+  }
+  // Never called, as equal_operands_ is empty then.
+  template <typename ElementIter>
+  bool MatchEqualOperands(ElementIter, ElementIter,
+                          std::false_type /* can_match_by_hash */) const {
+    return false;
   }
 
   ::std::vector<Matcher<const Element&>> matchers_;
+
+  // If all the matchers are Eq() matchers and std::hash supports Element,
+  // the values they compare elements with, in the same order.  Otherwise
+  // empty.
+  ::std::vector<const Element*> equal_operands_;
 };
 
 // Functor for use in TransformTuple.
@@ -27,7 +27,8 @@
 // (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
 // OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
-// Implements class templates NiceMock, NaggyMock, and StrictMock.
+// Implements class templates NiceMock, NaggyMock, StrictMock, and
+// SpyMock.
 //
 // Given a mock class MockFoo that is created using Google Mock,
 // NiceMock<MockFoo> is a subclass of MockFoo that allows
@@ -56,6 +57,11 @@
 // or "strict" modifier may not affect it, depending on the compiler.
 // In particular, nesting NiceMock, NaggyMock, and StrictMock is NOT
 // supported.
+//
+// SpyMock<MockFoo> is a subclass of MockFoo whose mock methods record
+// their calls, and only match them against their expectations when the
+// expectations are verified (or more are set).  It's orthogonal to the
+// strictness modifiers, e.g. SpyMock<NiceMock<MockFoo>> is fine.
 
 // IWYU pragma: private, include "gmock/gmock.h"
 // IWYU pragma: friend gmock/.*
@@ -76,6 +82,8 @@ template <class MockClass>
 class NaggyMock;
 template <class MockClass>
 class StrictMock;
+template <class MockClass>
+class SpyMock;
 
 namespace internal {
 template <typename T>
@@ -143,6 +151,19 @@ class StrictMockImpl {
   }
 };
 
+template <typename Base>
+class SpyMockImpl {
+ public:
+  SpyMockImpl() {
+    ::testing::Mock::RecordCalls(reinterpret_cast<uintptr_t>(this));
+  }
+
+  ~SpyMockImpl() {
+    ::testing::Mock::UnregisterCallRecording(
+        reinterpret_cast<uintptr_t>(this));
+  }
+};
+
 }  // namespace internal
 
 template <class MockClass>
@@ -270,6 +291,44 @@ class GTEST_INTERNAL_EMPTY_BASE_CLASS StrictMock
   StrictMock& operator=(const StrictMock&) = delete;
 };
 
+// A mock whose calls are recorded, and only matched against expectations
+// when they are verified.  This makes calls to mock methods expected to
+// be called many times cheap, at the cost of reporting unexpected calls
+// late.  A call is matched as it's made instead if its mock method has
+// an expectation with an action, or takes an argument that can't be
+// recorded (see IsRecordableArgument), such as a reference or a pointer.
+// Recorded arguments are copied when the call is made.
+template <class MockClass>
+class GTEST_INTERNAL_EMPTY_BASE_CLASS SpyMock
+    : private internal::SpyMockImpl<MockClass>,
+      public MockClass {
+ public:
+  SpyMock() : MockClass() {
+    static_assert(sizeof(*this) == sizeof(MockClass),
+                  "The impl subclass shouldn't introduce any padding");
+  }
+
+  // Single argument constructor is special-cased so that it can be
+  // made explicit.
+  template <typename A>
+  explicit SpyMock(A&& arg) : MockClass(std::forward<A>(arg)) {
+    static_assert(sizeof(*this) == sizeof(MockClass),
+                  "The impl subclass shouldn't introduce any padding");
+  }
+
+  template <typename TArg1, typename TArg2, typename... An>
+  SpyMock(TArg1&& arg1, TArg2&& arg2, An&&... args)
+      : MockClass(std::forward<TArg1>(arg1), std::forward<TArg2>(arg2),
+                  std::forward<An>(args)...) {
+    static_assert(sizeof(*this) == sizeof(MockClass),
+                  "The impl subclass shouldn't introduce any padding");
+  }
+
+ private:
+  SpyMock(const SpyMock&) = delete;
+  SpyMock& operator=(const SpyMock&) = delete;
+};
+
 #undef GTEST_INTERNAL_EMPTY_BASE_CLASS
 
 }  // namespace testing
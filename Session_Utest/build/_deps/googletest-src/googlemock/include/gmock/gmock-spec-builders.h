@@ -61,6 +61,8 @@
 #ifndef GOOGLEMOCK_INCLUDE_GMOCK_GMOCK_SPEC_BUILDERS_H_
 #define GOOGLEMOCK_INCLUDE_GMOCK_GMOCK_SPEC_BUILDERS_H_
 
+#include <algorithm>
+#include <atomic>
 #include <cstdint>
 #include <functional>
 #include <map>
@@ -69,6 +71,7 @@
 #include <sstream>
 #include <string>
 #include <type_traits>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
@@ -112,27 +115,135 @@ class TypedExpectation;
 // Helper class for testing the Expectation class template.
 class ExpectationTester;
 
-// Helper classes for implementing NiceMock, StrictMock, and NaggyMock.
+// Helper classes for implementing NiceMock, StrictMock, NaggyMock, and
+// SpyMock.
 template <typename MockClass>
 class NiceMockImpl;
 template <typename MockClass>
 class StrictMockImpl;
 template <typename MockClass>
 class NaggyMockImpl;
+template <typename MockClass>
+class SpyMockImpl;
 
-// Protects the mock object registry (in class Mock), all function
-// mockers, and all expectations.
+// Protects the mock object registry (in class Mock), and the
+// expectations of all function mockers whose expectations are ordered
+// with respect to expectations of other function mockers.
 //
-// The reason we don't use more fine-grained protection is: when a
-// mock function Foo() is called, it needs to consult its expectations
-// to see which one should be picked.  If another thread is allowed to
-// call a mock function (either Foo() or a different one) at the same
-// time, it could affect the "retired" attributes of Foo()'s
-// expectations when InSequence() is used, and thus affect which
-// expectation gets picked.  Therefore, we sequence all mock function
-// calls to ensure the integrity of the mock objects' states.
+// When a mock function Foo() is called, it needs to consult its
+// expectations to see which one should be picked.  If .After() or
+// InSequence() orders Foo()'s expectations with respect to those of
+// another mock function Bar(), a call to Bar() in another thread could
+// affect the "retired" attributes of Foo()'s expectations, and thus
+// affect which expectation gets picked.  Therefore, we sequence all calls
+// to such mock functions with this mutex.  Calls to any other mock
+// function only lock a mutex of its own function mocker (see
+// UntypedFunctionMockerBase::expectations_mutex()), so that tests calling
+// independent mocks from many threads don't serialize.
 GTEST_API_ GTEST_DECLARE_STATIC_MUTEX_(g_gmock_mutex);
 
+// The type of g_gmock_mutex, which depends on the platform.
+typedef decltype(g_gmock_mutex) GMockMutex;
+
+// ArgumentHasher<T>::Combine(value, &hash) mixes the std::hash of *value
+// into hash and returns true, unless value is null or std::hash doesn't
+// support T, in which case it returns false.
+template <typename T, typename = void>
+struct ArgumentHasher {
+  static bool Combine(const T* /* value */, size_t* /* hash */) {
+    return false;
+  }
+};
+
+template <typename T>
+struct ArgumentHasher<T, typename std::enable_if<IsHashable<T>::value>::type> {
+  static bool Combine(const T* value, size_t* hash) {
+    if (value == nullptr) return false;
+    *hash ^= std::hash<T>()(*value) + 0x9e3779b9 + (*hash << 6) + (*hash >> 2);
+    return true;
+  }
+};
+
+// Sets *hash to the hash of the given argument values, which mock
+// functions use to index their expectations by argument value.  Returns
+// false if any of the pointers is null or points to a type std::hash
+// doesn't support.
+template <typename... T>
+bool HashArgumentValues(size_t* hash, const T*... values) {
+  *hash = 0;
+  bool hashed = true;
+  bool dummy[] = {
+      true, (hashed = hashed && ArgumentHasher<T>::Combine(values, hash))...};
+  static_cast<void>(dummy);
+  return hashed;
+}
+
+// Possible reactions on uninteresting calls.
+enum CallReaction {
+  kAllow,
+  kWarn,
+  kFail,
+};
+
+// A string stream that is only constructed when it's first written to.  A
+// mock function call describes itself in such streams, as most calls are
+// expected and never need a description.
+class LazyStringStream {
+ public:
+  // Returns the stream, constructing it first if needed.
+  ::std::ostream* get() {
+    if (stream_ == nullptr) stream_.reset(new ::std::stringstream);
+    return stream_.get();
+  }
+
+  // Returns what has been written to the stream.
+  std::string str() const {
+    return stream_ == nullptr ? std::string() : stream_->str();
+  }
+
+ private:
+  std::unique_ptr<::std::stringstream> stream_;
+};
+
+// A call to a mock function of a SpyMock, recorded with copies of its
+// arguments so that it can be matched against the expectations on the
+// mock function later.
+class RecordedCall {
+ public:
+  virtual ~RecordedCall() {}
+
+  // Matches the call against the expectations on its mock function,
+  // and reports it as if it were being made now.
+  virtual void Replay() = 0;
+};
+
+// Appends the given call to the log of calls recorded on the current
+// thread.
+GTEST_API_ void RecordCall(std::unique_ptr<RecordedCall> call);
+
+// Returns true if and only if some recorded calls haven't been replayed
+// yet.
+GTEST_API_ bool HasUnreplayedCalls();
+
+// Replays the calls recorded on all threads so far, in the order they
+// were made.  Must not be called with g_gmock_mutex held, as replaying a
+// call locks the mutex protecting the expectations of its mock function.
+GTEST_API_ void ReplayRecordedCalls() GTEST_LOCK_EXCLUDED_(g_gmock_mutex);
+
+// Arguments of these types, passed by value, can be copied into a
+// RecordedCall: the copy is cheap, and matching it against expectations
+// after the call returns gives the same result as matching the argument
+// when the call is made.  Pointers and classes that may refer to other
+// objects are left out, as matchers like Pointee() look at the objects,
+// which may be gone by then.
+template <typename T>
+struct IsRecordableArgument
+    : std::integral_constant<bool, std::is_arithmetic<T>::value ||
+                                       std::is_enum<T>::value> {};
+template <typename Char, typename Traits, typename Allocator>
+struct IsRecordableArgument<std::basic_string<Char, Traits, Allocator>>
+    : std::true_type {};
+
 // Abstract base class of FunctionMocker.  This is the
 // type-agnostic part of the function mocker interface.  Its pure
 // virtual methods are implemented by FunctionMocker.
@@ -167,10 +278,12 @@ class GTEST_API_ UntypedFunctionMockerBase {
   // untyped_action is set to point to the action that should be
   // performed (or NULL if the action is "do default"), and
   // is_excessive is modified to indicate whether the call exceeds the
-  // expected number.
-  virtual const ExpectationBase* UntypedFindMatchingExpectation(
+  // expected number.  Unless the call is expected, describes what
+  // happened to 'what' and why to 'why'.  The caller co-owns the
+  // expectation, and thus the action, until it drops the result.
+  virtual std::shared_ptr<const ExpectationBase> UntypedFindMatchingExpectation(
       const void* untyped_args, const void** untyped_action, bool* is_excessive,
-      ::std::ostream* what, ::std::ostream* why)
+      LazyStringStream* what, LazyStringStream* why)
       GTEST_LOCK_EXCLUDED_(g_gmock_mutex) = 0;
 
   // Prints the given function arguments to the ostream.
@@ -198,6 +311,38 @@ class GTEST_API_ UntypedFunctionMockerBase {
   // SetOwnerAndName() has been called.
   const char* Name() const GTEST_LOCK_EXCLUDED_(g_gmock_mutex);
 
+  // Returns the reaction on uninteresting calls made on the mock object
+  // this mock method belongs to, like
+  // Mock::GetReactionOnUninterestingCalls(MockObject()).  Caches it, so
+  // that it only locks the registry of mock objects if the reaction set
+  // for some mock object changed since the last time.
+  CallReaction ReactionOnUninterestingCalls() const
+      GTEST_LOCK_EXCLUDED_(g_gmock_mutex);
+
+  // Returns true if and only if the mock object this mock method belongs
+  // to is a SpyMock, like Mock::IsSpy(MockObject()).  Cached along with
+  // ReactionOnUninterestingCalls().
+  bool RecordsCalls() const GTEST_LOCK_EXCLUDED_(g_gmock_mutex);
+
+  // Returns the mutex protecting the state (call counts and retirement)
+  // of the expectations on this mock function: g_gmock_mutex once they
+  // are ordered with respect to expectations on another mock function,
+  // and a mutex of this function mocker otherwise.
+  GMockMutex* expectations_mutex() const {
+    if (sequenced_with_other_mockers_) return &g_gmock_mutex;
+    return &mutex_;
+  }
+
+  // Makes expectations_mutex() return g_gmock_mutex from now on.  Called
+  // when .After() or InSequence() orders an expectation on this mock
+  // function with respect to an expectation on another one.
+  void SequenceWithOtherMockers() { sequenced_with_other_mockers_ = true; }
+
+  // Makes calls to this mock function be matched against its expectations
+  // as they are made, even if it belongs to a SpyMock.  Called when an
+  // expectation on it specifies an action, as the call has to perform it.
+  void SpecifyExpectationAction() { expectations_specify_actions_ = true; }
+
  protected:
   typedef std::vector<const void*> UntypedOnCallSpecs;
 
@@ -209,16 +354,35 @@ class GTEST_API_ UntypedFunctionMockerBase {
 
   // Address of the mock object this mock method belongs to.  Only
   // valid after this mock method has been called or
-  // ON_CALL/EXPECT_CALL has been invoked on it.
-  const void* mock_obj_;  // Protected by g_gmock_mutex.
+  // ON_CALL/EXPECT_CALL has been invoked on it.  Atomic, as every call
+  // sets it and this mock function may be called from two threads
+  // concurrently.
+  std::atomic<const void*> mock_obj_;
 
   // Name of the function being mocked.  Only valid after this mock
-  // method has been called.
-  const char* name_;  // Protected by g_gmock_mutex.
+  // method has been called.  Atomic for the same reason as mock_obj_.
+  std::atomic<const char*> name_;
 
   // All default action specs for this function mocker.
   UntypedOnCallSpecs untyped_on_call_specs_;
 
+  // Once this mock function has many ON_CALLs, calls to it look them up
+  // in an index like the one of expectations below.  The index covers the
+  // first indexed_on_call_spec_count_ ON_CALLs.  Calls bring it up to date
+  // while holding on_call_index_mutex_, and read it without locking once
+  // it is.
+  mutable std::unordered_map<size_t, std::vector<size_t>>
+      on_call_specs_by_hash_;
+  mutable std::vector<size_t> unhashed_on_call_specs_;
+  mutable std::atomic<size_t> indexed_on_call_spec_count_;
+  mutable Mutex on_call_index_mutex_;
+
+  // The reaction on uninteresting calls and whether calls are recorded,
+  // cached by CachedMockObjectState() with the generation of the registry
+  // shard holding the mock object, which changes only when reactions or
+  // SpyMocks registered in that shard do.
+  mutable std::atomic<uint64_t> cached_reaction_;
+
   // All expectations for this function mocker.
   //
   // It's undefined behavior to interleave expectations (EXPECT_CALLs
@@ -229,6 +393,39 @@ class GTEST_API_ UntypedFunctionMockerBase {
   // untyped_expectations, we deliberately leave accesses to it
   // unprotected.
   UntypedExpectations untyped_expectations_;
+
+  // True if and only if an expectation on this mock function is ordered
+  // with respect to an expectation on another mock function.  Like
+  // untyped_expectations_, it only changes when expectations are set, and
+  // is deliberately left unprotected.
+  bool sequenced_with_other_mockers_;
+
+  // True if and only if an expectation on this mock function specifies an
+  // action.  Changes like sequenced_with_other_mockers_.
+  bool expectations_specify_actions_;
+
+  // Protects the state of this mock function's expectations unless
+  // sequenced_with_other_mockers_ is true.
+  mutable Mutex mutex_;
+
+  // Once this mock function has many expectations, calls to it look them
+  // up in an index instead of trying them all.  The index maps the hash of
+  // the values matched by expectations whose argument matchers are all
+  // Eq(value) to their positions in untyped_expectations_, and lists the
+  // positions of the other expectations, all in increasing order.  It
+  // covers the first indexed_expectation_count_ expectations, less some
+  // retired ones, and is brought up to date by calls (a .With() clause can
+  // still be added to an expectation after it's created) while holding
+  // expectations_mutex().
+  mutable std::unordered_map<size_t, std::vector<size_t>>
+      expectations_by_hash_;
+  mutable std::vector<size_t> unhashed_expectations_;
+  mutable size_t indexed_expectation_count_;
+
+ private:
+  // Returns the state of the mock object cached in cached_reaction_,
+  // refreshing it first if it's stale.
+  uint64_t CachedMockObjectState() const GTEST_LOCK_EXCLUDED_(g_gmock_mutex);
 };  // class UntypedFunctionMockerBase
 
 // Untyped base class for OnCallSpec<F>.
@@ -320,6 +517,14 @@ class OnCallSpec : public UntypedOnCallSpecBase {
     return TupleMatches(matchers_, args) && extra_matcher_.Matches(args);
   }
 
+  // If this ON_CALL has no .With() clause and all its argument matchers
+  // are Eq(value), sets *hash to the hash of those values (see
+  // HashArgumentValues()) and returns true.  Otherwise returns false.
+  bool HashEqualOperands(size_t* hash) const {
+    using Indices = MakeIndexSequence<std::tuple_size<ArgumentTuple>::value>;
+    return last_clause_ != kWith && HashEqualOperands(hash, Indices());
+  }
+
   // Returns the action specified by the user.
   const Action<F>& GetAction() const {
     AssertSpecProperty(last_clause_ == kWillByDefault,
@@ -345,14 +550,13 @@ class OnCallSpec : public UntypedOnCallSpecBase {
   ArgumentMatcherTuple matchers_;
   Matcher<const ArgumentTuple&> extra_matcher_;
   Action<F> action_;
-};  // class OnCallSpec
 
-// Possible reactions on uninteresting calls.
-enum CallReaction {
-  kAllow,
-  kWarn,
-  kFail,
-};
+  template <size_t... I>
+  bool HashEqualOperands(size_t* hash, IndexSequence<I...>) const {
+    return HashArgumentValues(hash,
+                              std::get<I>(matchers_).GetEqualOperand()...);
+  }
+};  // class OnCallSpec
 
 }  // namespace internal
 
@@ -387,6 +591,9 @@ class GTEST_API_ Mock {
   // Returns whether the mock was created as a strict mock
   static bool IsStrict(void* mock_obj)
       GTEST_LOCK_EXCLUDED_(internal::g_gmock_mutex);
+  // Returns whether the mock was created as a spy mock
+  static bool IsSpy(void* mock_obj)
+      GTEST_LOCK_EXCLUDED_(internal::g_gmock_mutex);
 
  private:
   friend class internal::UntypedFunctionMockerBase;
@@ -402,6 +609,8 @@ class GTEST_API_ Mock {
   friend class internal::NaggyMockImpl;
   template <typename MockClass>
   friend class internal::StrictMockImpl;
+  template <typename MockClass>
+  friend class internal::SpyMockImpl;
 
   // Tells Google Mock to allow uninteresting calls on the given mock
   // object.
@@ -423,6 +632,16 @@ class GTEST_API_ Mock {
   static void UnregisterCallReaction(uintptr_t mock_obj)
       GTEST_LOCK_EXCLUDED_(internal::g_gmock_mutex);
 
+  // Tells Google Mock to record calls on the given mock object, and to
+  // match them against expectations when they are verified.
+  static void RecordCalls(uintptr_t mock_obj)
+      GTEST_LOCK_EXCLUDED_(internal::g_gmock_mutex);
+
+  // Tells Google Mock the given mock object is being destroyed and
+  // its entry in the table of SpyMocks should be removed.
+  static void UnregisterCallRecording(uintptr_t mock_obj)
+      GTEST_LOCK_EXCLUDED_(internal::g_gmock_mutex);
+
   // Returns the reaction Google Mock will have on uninteresting calls
   // made on the given mock object.
   static internal::CallReaction GetReactionOnUninterestingCalls(
@@ -450,12 +669,13 @@ class GTEST_API_ Mock {
                                               const char* file, int line)
       GTEST_LOCK_EXCLUDED_(internal::g_gmock_mutex);
 
-  // Unregisters a mock method; removes the owning mock object from
-  // the registry when the last mock method associated with it has
-  // been unregistered.  This is called only in the destructor of
-  // FunctionMocker.
-  static void UnregisterLocked(internal::UntypedFunctionMockerBase* mocker)
-      GTEST_EXCLUSIVE_LOCK_REQUIRED_(internal::g_gmock_mutex);
+  // Unregisters a mock method of the given mock object; removes the
+  // mock object from the registry when the last mock method associated
+  // with it has been unregistered.  This is called only in the
+  // destructor of FunctionMocker.
+  static void Unregister(const void* mock_obj,
+                         internal::UntypedFunctionMockerBase* mocker)
+      GTEST_LOCK_EXCLUDED_(internal::g_gmock_mutex);
 };  // class Mock
 
 // An abstract handle of an expectation.  Useful in the .After()
@@ -680,8 +900,11 @@ GTEST_API_ extern ThreadLocal<Sequence*> g_gmock_implicit_sequence;
 // This class is internal and mustn't be used by user code directly.
 class GTEST_API_ ExpectationBase {
  public:
-  // source_text is the EXPECT_CALL(...) source that created this Expectation.
-  ExpectationBase(const char* file, int line, const std::string& source_text);
+  // owner is the mock function this expectation is set on, and
+  // source_text is the EXPECT_CALL(...) source that created this
+  // Expectation.
+  ExpectationBase(UntypedFunctionMockerBase* owner, const char* file, int line,
+                  const std::string& source_text);
 
   virtual ~ExpectationBase();
 
@@ -700,7 +923,18 @@ class GTEST_API_ ExpectationBase {
   // Describes how many times a function call matching this
   // expectation has occurred.
   void DescribeCallCountTo(::std::ostream* os) const
-      GTEST_EXCLUSIVE_LOCK_REQUIRED_(g_gmock_mutex);
+      GTEST_EXCLUSIVE_LOCK_REQUIRED_(*state_mutex());
+
+  // Returns the mutex protecting the state of this expectation.  This is
+  // g_gmock_mutex if the expectation is ordered with respect to an
+  // expectation on another mock function (whose calls may then read or
+  // change its state), or if the mock function it was set on is gone.
+  GMockMutex* state_mutex() const {
+    if (sequenced_with_other_mockers_ || untyped_owner_ == nullptr) {
+      return &g_gmock_mutex;
+    }
+    return untyped_owner_->expectations_mutex();
+  }
 
   // If this mock method has an extra matcher (i.e. .With(matcher)),
   // describes it to the ostream.
@@ -753,61 +987,67 @@ class GTEST_API_ ExpectationBase {
     cardinality_ = a_cardinality;
   }
 
+  // Makes prerequisite an immediate pre-requisite of this expectation.
+  // If the two are set on different mock functions, calls to both
+  // functions are sequenced with g_gmock_mutex from now on.
+  void AddPrerequisite(const Expectation& prerequisite);
+
   // The following group of methods should only be called after the
-  // EXPECT_CALL() statement, and only when g_gmock_mutex is held by
-  // the current thread.
+  // EXPECT_CALL() statement, and only when the current thread holds
+  // state_mutex().  A pre-requisite on another mock function has the same
+  // state_mutex() as this expectation.
 
   // Retires all pre-requisites of this expectation.
-  void RetireAllPreRequisites() GTEST_EXCLUSIVE_LOCK_REQUIRED_(g_gmock_mutex);
+  void RetireAllPreRequisites() GTEST_EXCLUSIVE_LOCK_REQUIRED_(*state_mutex());
 
   // Returns true if and only if this expectation is retired.
-  bool is_retired() const GTEST_EXCLUSIVE_LOCK_REQUIRED_(g_gmock_mutex) {
-    g_gmock_mutex.AssertHeld();
+  bool is_retired() const GTEST_EXCLUSIVE_LOCK_REQUIRED_(*state_mutex()) {
+    state_mutex()->AssertHeld();
     return retired_;
   }
 
   // Retires this expectation.
-  void Retire() GTEST_EXCLUSIVE_LOCK_REQUIRED_(g_gmock_mutex) {
-    g_gmock_mutex.AssertHeld();
+  void Retire() GTEST_EXCLUSIVE_LOCK_REQUIRED_(*state_mutex()) {
+    state_mutex()->AssertHeld();
     retired_ = true;
   }
 
   // Returns true if and only if this expectation is satisfied.
-  bool IsSatisfied() const GTEST_EXCLUSIVE_LOCK_REQUIRED_(g_gmock_mutex) {
-    g_gmock_mutex.AssertHeld();
+  bool IsSatisfied() const GTEST_EXCLUSIVE_LOCK_REQUIRED_(*state_mutex()) {
+    state_mutex()->AssertHeld();
     return cardinality().IsSatisfiedByCallCount(call_count_);
   }
 
   // Returns true if and only if this expectation is saturated.
-  bool IsSaturated() const GTEST_EXCLUSIVE_LOCK_REQUIRED_(g_gmock_mutex) {
-    g_gmock_mutex.AssertHeld();
+  bool IsSaturated() const GTEST_EXCLUSIVE_LOCK_REQUIRED_(*state_mutex()) {
+    state_mutex()->AssertHeld();
     return cardinality().IsSaturatedByCallCount(call_count_);
   }
 
   // Returns true if and only if this expectation is over-saturated.
-  bool IsOverSaturated() const GTEST_EXCLUSIVE_LOCK_REQUIRED_(g_gmock_mutex) {
-    g_gmock_mutex.AssertHeld();
+  bool IsOverSaturated() const GTEST_EXCLUSIVE_LOCK_REQUIRED_(*state_mutex()) {
+    state_mutex()->AssertHeld();
     return cardinality().IsOverSaturatedByCallCount(call_count_);
   }
 
   // Returns true if and only if all pre-requisites of this expectation are
   // satisfied.
   bool AllPrerequisitesAreSatisfied() const
-      GTEST_EXCLUSIVE_LOCK_REQUIRED_(g_gmock_mutex);
+      GTEST_EXCLUSIVE_LOCK_REQUIRED_(*state_mutex());
 
   // Adds unsatisfied pre-requisites of this expectation to 'result'.
   void FindUnsatisfiedPrerequisites(ExpectationSet* result) const
-      GTEST_EXCLUSIVE_LOCK_REQUIRED_(g_gmock_mutex);
+      GTEST_EXCLUSIVE_LOCK_REQUIRED_(*state_mutex());
 
   // Returns the number this expectation has been invoked.
-  int call_count() const GTEST_EXCLUSIVE_LOCK_REQUIRED_(g_gmock_mutex) {
-    g_gmock_mutex.AssertHeld();
+  int call_count() const GTEST_EXCLUSIVE_LOCK_REQUIRED_(*state_mutex()) {
+    state_mutex()->AssertHeld();
     return call_count_;
   }
 
   // Increments the number this expectation has been invoked.
-  void IncrementCallCount() GTEST_EXCLUSIVE_LOCK_REQUIRED_(g_gmock_mutex) {
-    g_gmock_mutex.AssertHeld();
+  void IncrementCallCount() GTEST_EXCLUSIVE_LOCK_REQUIRED_(*state_mutex()) {
+    state_mutex()->AssertHeld();
     call_count_++;
   }
 
@@ -826,6 +1066,16 @@ class GTEST_API_ ExpectationBase {
   // Implements the .Times() clause.
   void UntypedTimes(const Cardinality& a_cardinality);
 
+  // The mock function this expectation is set on, or NULL once that
+  // function has cleared its expectations (this expectation can outlive
+  // it as a pre-requisite of an expectation on another mock function).
+  // Changes under both g_gmock_mutex and state_mutex().
+  UntypedFunctionMockerBase* untyped_owner_;
+  // True if and only if this expectation is ordered with respect to an
+  // expectation on another mock function.  Set together with
+  // immediate_prerequisites_.
+  bool sequenced_with_other_mockers_;
+
   // This group of fields are part of the spec and won't change after
   // an EXPECT_CALL() statement finishes.
   const char* file_;               // The file that contains the expectation.
@@ -872,7 +1122,7 @@ class TypedExpectation<R(Args...)> : public ExpectationBase {
   TypedExpectation(FunctionMocker<F>* owner, const char* a_file, int a_line,
                    const std::string& a_source_text,
                    const ArgumentMatcherTuple& m)
-      : ExpectationBase(a_file, a_line, a_source_text),
+      : ExpectationBase(owner, a_file, a_line, a_source_text),
         owner_(owner),
         matchers_(m),
         // By default, extra_matcher_ should match anything.  However,
@@ -955,7 +1205,7 @@ class TypedExpectation<R(Args...)> : public ExpectationBase {
     last_clause_ = kAfter;
 
     for (ExpectationSet::const_iterator it = s.begin(); it != s.end(); ++it) {
-      immediate_prerequisites_ += *it;
+      AddPrerequisite(*it);
     }
     return *this;
   }
@@ -1000,6 +1250,7 @@ class TypedExpectation<R(Args...)> : public ExpectationBase {
     last_clause_ = kWillOnce;
 
     untyped_actions_.push_back(new Action<F>(std::move(action)));
+    owner_->SpecifyExpectationAction();
 
     if (!cardinality_specified()) {
       set_cardinality(Exactly(static_cast<int>(untyped_actions_.size())));
@@ -1020,6 +1271,7 @@ class TypedExpectation<R(Args...)> : public ExpectationBase {
     }
     last_clause_ = kWillRepeatedly;
     repeated_action_specified_ = true;
+    owner_->SpecifyExpectationAction();
 
     repeated_action_ = action;
     if (!cardinality_specified()) {
@@ -1088,20 +1340,20 @@ class TypedExpectation<R(Args...)> : public ExpectationBase {
 
   // The following methods will be called only after the EXPECT_CALL()
   // statement finishes and when the current thread holds
-  // g_gmock_mutex.
+  // state_mutex().
 
   // Returns true if and only if this expectation matches the given arguments.
   bool Matches(const ArgumentTuple& args) const
-      GTEST_EXCLUSIVE_LOCK_REQUIRED_(g_gmock_mutex) {
-    g_gmock_mutex.AssertHeld();
+      GTEST_EXCLUSIVE_LOCK_REQUIRED_(*state_mutex()) {
+    state_mutex()->AssertHeld();
     return TupleMatches(matchers_, args) && extra_matcher_.Matches(args);
   }
 
   // Returns true if and only if this expectation should handle the given
   // arguments.
   bool ShouldHandleArguments(const ArgumentTuple& args) const
-      GTEST_EXCLUSIVE_LOCK_REQUIRED_(g_gmock_mutex) {
-    g_gmock_mutex.AssertHeld();
+      GTEST_EXCLUSIVE_LOCK_REQUIRED_(*state_mutex()) {
+    state_mutex()->AssertHeld();
 
     // In case the action count wasn't checked when the expectation
     // was defined (e.g. if this expectation has no WillRepeatedly()
@@ -1111,11 +1363,25 @@ class TypedExpectation<R(Args...)> : public ExpectationBase {
     return !is_retired() && AllPrerequisitesAreSatisfied() && Matches(args);
   }
 
+  // If this expectation has no .With() clause and all its argument
+  // matchers are Eq(value), sets *hash to the hash of those values (see
+  // HashArgumentValues()) and returns true.  Otherwise returns false.
+  bool HashEqualOperands(size_t* hash) const {
+    return !extra_matcher_specified_ &&
+           HashEqualOperands(hash, IndexSequenceFor<Args...>());
+  }
+
+  template <size_t... I>
+  bool HashEqualOperands(size_t* hash, IndexSequence<I...>) const {
+    return HashArgumentValues(hash,
+                              std::get<I>(matchers_).GetEqualOperand()...);
+  }
+
   // Describes the result of matching the arguments against this
   // expectation to the given ostream.
   void ExplainMatchResultTo(const ArgumentTuple& args, ::std::ostream* os) const
-      GTEST_EXCLUSIVE_LOCK_REQUIRED_(g_gmock_mutex) {
-    g_gmock_mutex.AssertHeld();
+      GTEST_EXCLUSIVE_LOCK_REQUIRED_(*state_mutex()) {
+    state_mutex()->AssertHeld();
 
     if (is_retired()) {
       *os << "         Expected: the expectation is active\n"
@@ -1158,8 +1424,8 @@ class TypedExpectation<R(Args...)> : public ExpectationBase {
   // Returns the action that should be taken for the current invocation.
   const Action<F>& GetCurrentAction(const FunctionMocker<F>* mocker,
                                     const ArgumentTuple& args) const
-      GTEST_EXCLUSIVE_LOCK_REQUIRED_(g_gmock_mutex) {
-    g_gmock_mutex.AssertHeld();
+      GTEST_EXCLUSIVE_LOCK_REQUIRED_(*state_mutex()) {
+    state_mutex()->AssertHeld();
     const int count = call_count();
     Assert(count >= 1, __FILE__, __LINE__,
            "call_count() is <= 0 when GetCurrentAction() is "
@@ -1188,23 +1454,23 @@ class TypedExpectation<R(Args...)> : public ExpectationBase {
 
   // Given the arguments of a mock function call, if the call will
   // over-saturate this expectation, returns the default action;
-  // otherwise, returns the next action in this expectation.  Also
-  // describes *what* happened to 'what', and explains *why* Google
-  // Mock does it to 'why'.  This method is not const as it calls
-  // IncrementCallCount().  A return value of NULL means the default
-  // action.
+  // otherwise, returns the next action in this expectation.  If the
+  // call is excessive, also describes *what* happened to 'what', and
+  // explains *why* Google Mock does it to 'why'.  This method is not
+  // const as it calls IncrementCallCount().  A return value of NULL means
+  // the default action.
   const Action<F>* GetActionForArguments(const FunctionMocker<F>* mocker,
                                          const ArgumentTuple& args,
-                                         ::std::ostream* what,
-                                         ::std::ostream* why)
-      GTEST_EXCLUSIVE_LOCK_REQUIRED_(g_gmock_mutex) {
-    g_gmock_mutex.AssertHeld();
+                                         LazyStringStream* what,
+                                         LazyStringStream* why)
+      GTEST_EXCLUSIVE_LOCK_REQUIRED_(*state_mutex()) {
+    state_mutex()->AssertHeld();
     if (IsSaturated()) {
       // We have an excessive call.
       IncrementCallCount();
-      *what << "Mock function called more times than expected - ";
-      mocker->DescribeDefaultActionTo(args, what);
-      DescribeCallCountTo(why);
+      *what->get() << "Mock function called more times than expected - ";
+      mocker->DescribeDefaultActionTo(args, what->get());
+      DescribeCallCountTo(why->get());
 
       return nullptr;
     }
@@ -1216,8 +1482,6 @@ class TypedExpectation<R(Args...)> : public ExpectationBase {
       Retire();
     }
 
-    // Must be done after IncrementCount()!
-    *what << "Mock function call matches " << source_text() << "...\n";
     return &(GetCurrentAction(mocker, args));
   }
 
@@ -1401,16 +1665,28 @@ class FunctionMocker<R(Args...)> final : public UntypedFunctionMockerBase {
   // function have been satisfied.  If not, it will report Google Test
   // non-fatal failures for the violations.
   ~FunctionMocker() override GTEST_LOCK_EXCLUDED_(g_gmock_mutex) {
-    MutexLock l(&g_gmock_mutex);
-    VerifyAndClearExpectationsLocked();
-    Mock::UnregisterLocked(this);
-    ClearDefaultActionsLocked();
+    // Calls recorded by SpyMocks refer to their function mockers, so they
+    // are all replayed before one of those goes away.
+    if (HasUnreplayedCalls()) ReplayRecordedCalls();
+    {
+      MutexLock l(&g_gmock_mutex);
+      VerifyAndClearExpectationsLocked();
+      ClearDefaultActionsLocked();
+    }
+
+    // This mock method isn't registered if it knows no mock object.
+    const void* const mock_obj = mock_obj_.load(std::memory_order_relaxed);
+    if (mock_obj != nullptr) Mock::Unregister(mock_obj, this);
   }
 
   // Returns the ON_CALL spec that matches this mock function with the
   // given arguments; returns NULL if no matching ON_CALL is found.
   // L = *
   const OnCallSpec<F>* FindOnCallSpec(const ArgumentTuple& args) const {
+    if (untyped_on_call_specs_.size() >= kMinIndexedSpecs) {
+      return FindIndexedOnCallSpec(args);
+    }
+
     for (UntypedOnCallSpecs::const_reverse_iterator it =
              untyped_on_call_specs_.rbegin();
          it != untyped_on_call_specs_.rend(); ++it) {
@@ -1463,6 +1739,9 @@ class FunctionMocker<R(Args...)> final : public UntypedFunctionMockerBase {
     // actions outside of the mutex.
     UntypedOnCallSpecs specs_to_delete;
     untyped_on_call_specs_.swap(specs_to_delete);
+    on_call_specs_by_hash_.clear();
+    unhashed_on_call_specs_.clear();
+    indexed_on_call_spec_count_.store(0, std::memory_order_relaxed);
 
     g_gmock_mutex.Unlock();
     for (UntypedOnCallSpecs::const_iterator it = specs_to_delete.begin();
@@ -1505,6 +1784,10 @@ class FunctionMocker<R(Args...)> final : public UntypedFunctionMockerBase {
                                          const std::string& source_text,
                                          const ArgumentMatcherTuple& m)
       GTEST_LOCK_EXCLUDED_(g_gmock_mutex) {
+    // Calls recorded by SpyMocks so far must only be matched against the
+    // expectations set before they were made.
+    if (HasUnreplayedCalls()) ReplayRecordedCalls();
+
     Mock::RegisterUseByOnCallOrExpectCall(MockObject(), file, line);
     TypedExpectation<F>* const expectation =
         new TypedExpectation<F>(this, file, line, source_text, m);
@@ -1574,19 +1857,23 @@ class FunctionMocker<R(Args...)> final : public UntypedFunctionMockerBase {
   // section.  The reason is that we have no control on what the
   // action does (it can invoke an arbitrary user function or even a
   // mock function) and excessive locking could cause a dead lock.
-  const ExpectationBase* UntypedFindMatchingExpectation(
+  std::shared_ptr<const ExpectationBase> UntypedFindMatchingExpectation(
       const void* untyped_args, const void** untyped_action, bool* is_excessive,
-      ::std::ostream* what, ::std::ostream* why) override
-      GTEST_LOCK_EXCLUDED_(g_gmock_mutex) {
+      LazyStringStream* what, LazyStringStream* why) override
+      GTEST_LOCK_EXCLUDED_(*expectations_mutex()) {
     const ArgumentTuple& args =
         *static_cast<const ArgumentTuple*>(untyped_args);
-    MutexLock l(&g_gmock_mutex);
-    TypedExpectation<F>* exp = this->FindMatchingExpectationLocked(args);
-    if (exp == nullptr) {  // A match wasn't found.
-      this->FormatUnexpectedCallMessageLocked(args, what, why);
+    MutexLock l(expectations_mutex());
+    std::shared_ptr<ExpectationBase> untyped_exp =
+        this->FindMatchingExpectationLocked(args);
+    if (untyped_exp == nullptr) {  // A match wasn't found.
+      this->FormatUnexpectedCallMessageLocked(args, what->get(), why->get());
       return nullptr;
     }
 
+    TypedExpectation<F>* const exp =
+        static_cast<TypedExpectation<F>*>(untyped_exp.get());
+
     // This line must be done before calling GetActionForArguments(),
     // which will increment the call count for *exp and thus affect
     // its saturation status.
@@ -1595,7 +1882,7 @@ class FunctionMocker<R(Args...)> final : public UntypedFunctionMockerBase {
     if (action != nullptr && action->IsDoDefault())
       action = nullptr;  // Normalize "do default" to NULL.
     *untyped_action = action;
-    return exp;
+    return untyped_exp;
   }
 
   // Prints the given function arguments to the ostream.
@@ -1608,9 +1895,14 @@ class FunctionMocker<R(Args...)> final : public UntypedFunctionMockerBase {
 
   // Returns the expectation that matches the arguments, or NULL if no
   // expectation matches them.
-  TypedExpectation<F>* FindMatchingExpectationLocked(const ArgumentTuple& args)
-      const GTEST_EXCLUSIVE_LOCK_REQUIRED_(g_gmock_mutex) {
-    g_gmock_mutex.AssertHeld();
+  std::shared_ptr<ExpectationBase> FindMatchingExpectationLocked(
+      const ArgumentTuple& args) const
+      GTEST_EXCLUSIVE_LOCK_REQUIRED_(*expectations_mutex()) {
+    expectations_mutex()->AssertHeld();
+    if (untyped_expectations_.size() >= kMinIndexedSpecs) {
+      return FindIndexedExpectationLocked(args);
+    }
+
     // See the definition of untyped_expectations_ for why access to
     // it is unprotected here.
     for (typename UntypedExpectations::const_reverse_iterator it =
@@ -1619,18 +1911,187 @@ class FunctionMocker<R(Args...)> final : public UntypedFunctionMockerBase {
       TypedExpectation<F>* const exp =
           static_cast<TypedExpectation<F>*>(it->get());
       if (exp->ShouldHandleArguments(args)) {
-        return exp;
+        return *it;
       }
     }
     return nullptr;
   }
 
+  // Like the scan in FindOnCallSpec(), but only tries the ON_CALLs that
+  // can match args: the unhashed ones, and the hashed ones with the same
+  // hash as args.
+  // L = *
+  const OnCallSpec<F>* FindIndexedOnCallSpec(const ArgumentTuple& args) const {
+    UpdateOnCallSpecIndex();
+
+    // The newest matching hashed ON_CALL, if any...
+    const OnCallSpec<F>* match = nullptr;
+    size_t match_position = 0;
+    size_t hash;
+    if (!on_call_specs_by_hash_.empty() &&
+        HashArguments(args, &hash, IndexSequenceFor<Args...>())) {
+      const auto bucket = on_call_specs_by_hash_.find(hash);
+      if (bucket != on_call_specs_by_hash_.end()) {
+        for (auto it = bucket->second.rbegin(); it != bucket->second.rend();
+             ++it) {
+          const OnCallSpec<F>* const spec = OnCallSpecAt(*it);
+          if (spec->Matches(args)) {
+            match = spec;
+            match_position = *it;
+            break;
+          }
+        }
+      }
+    }
+
+    // ... unless a newer unhashed one matches.
+    for (auto it = unhashed_on_call_specs_.rbegin();
+         it != unhashed_on_call_specs_.rend() &&
+         (match == nullptr || *it > match_position);
+         ++it) {
+      const OnCallSpec<F>* const spec = OnCallSpecAt(*it);
+      if (spec->Matches(args)) return spec;
+    }
+    return match;
+  }
+
+  // Adds the ON_CALLs set since the last call to the index.  Only locks a
+  // mutex if there are any.
+  // L = *
+  void UpdateOnCallSpecIndex() const {
+    if (indexed_on_call_spec_count_.load(std::memory_order_acquire) ==
+        untyped_on_call_specs_.size()) {
+      return;
+    }
+
+    MutexLock l(&on_call_index_mutex_);
+    size_t count = indexed_on_call_spec_count_.load(std::memory_order_relaxed);
+    for (; count < untyped_on_call_specs_.size(); ++count) {
+      size_t hash;
+      if (OnCallSpecAt(count)->HashEqualOperands(&hash)) {
+        on_call_specs_by_hash_[hash].push_back(count);
+      } else {
+        unhashed_on_call_specs_.push_back(count);
+      }
+    }
+    indexed_on_call_spec_count_.store(count, std::memory_order_release);
+  }
+
+  // Returns the ON_CALL at the given position in untyped_on_call_specs_.
+  const OnCallSpec<F>* OnCallSpecAt(size_t position) const {
+    return static_cast<const OnCallSpec<F>*>(untyped_on_call_specs_[position]);
+  }
+
+  // The number of expectations or ON_CALLs from which on they are looked
+  // up in an index.
+  static constexpr size_t kMinIndexedSpecs = 16;
+
+  // Sets *hash to the hash of args (see HashArgumentValues()).  Returns
+  // false if std::hash doesn't support all argument types.
+  template <size_t... I>
+  static bool HashArguments(const ArgumentTuple& args, size_t* hash,
+                            IndexSequence<I...>) {
+    return HashArgumentValues(hash, std::addressof(std::get<I>(args))...);
+  }
+
+  // Like the scan in FindMatchingExpectationLocked(), but only tries the
+  // expectations that can match args: the unhashed ones, and the hashed
+  // ones with the same hash as args.  Tries them from the newest to the
+  // oldest, so newer expectations still override older ones.
+  std::shared_ptr<ExpectationBase> FindIndexedExpectationLocked(
+      const ArgumentTuple& args) const
+      GTEST_EXCLUSIVE_LOCK_REQUIRED_(*expectations_mutex()) {
+    UpdateExpectationIndexLocked();
+    auto bucket = expectations_by_hash_.end();
+    size_t hash;
+    if (!expectations_by_hash_.empty() &&
+        HashArguments(args, &hash, IndexSequenceFor<Args...>())) {
+      bucket = expectations_by_hash_.find(hash);
+    }
+    std::vector<size_t>* const hashed =
+        bucket == expectations_by_hash_.end() ? nullptr : &bucket->second;
+
+    TypedExpectation<F>* match = nullptr;
+    size_t match_position = 0;
+    size_t hashed_left = hashed == nullptr ? 0 : hashed->size();
+    size_t unhashed_left = unhashed_expectations_.size();
+    size_t retired_hashed = 0;
+    size_t retired_unhashed = 0;
+    while (match == nullptr && (hashed_left > 0 || unhashed_left > 0)) {
+      const bool is_hashed =
+          unhashed_left == 0 ||
+          (hashed_left > 0 && (*hashed)[hashed_left - 1] >
+                                  unhashed_expectations_[unhashed_left - 1]);
+      const size_t position = is_hashed
+                                  ? (*hashed)[--hashed_left]
+                                  : unhashed_expectations_[--unhashed_left];
+      TypedExpectation<F>* const exp = ExpectationAt(position);
+      if (exp->ShouldHandleArguments(args)) {
+        match = exp;
+        match_position = position;
+      } else if (exp->is_retired()) {
+        ++(is_hashed ? retired_hashed : retired_unhashed);
+      }
+    }
+
+    // A retired expectation never handles a call again, but stays in
+    // untyped_expectations_ to be verified.  We drop the ones we walked
+    // past from the index, which costs no more than the walk did, so that
+    // later calls only walk past live expectations.
+    if (retired_hashed > 0) {
+      RemoveRetiredExpectationsLocked(hashed, hashed_left);
+      if (hashed->empty()) expectations_by_hash_.erase(bucket);
+    }
+    if (retired_unhashed > 0) {
+      RemoveRetiredExpectationsLocked(&unhashed_expectations_, unhashed_left);
+    }
+    if (match == nullptr) return nullptr;
+    return untyped_expectations_[match_position];
+  }
+
+  // Removes the positions of retired expectations from the given index
+  // list, starting at the given element.
+  void RemoveRetiredExpectationsLocked(std::vector<size_t>* positions,
+                                       size_t from) const
+      GTEST_EXCLUSIVE_LOCK_REQUIRED_(*expectations_mutex()) {
+    const auto begin = positions->begin() + static_cast<std::ptrdiff_t>(from);
+    positions->erase(std::remove_if(begin, positions->end(),
+                                    [this](size_t position) {
+                                      return ExpectationAt(position)
+                                          ->is_retired();
+                                    }),
+                     positions->end());
+  }
+
+  // Returns the expectation at the given position in
+  // untyped_expectations_.
+  TypedExpectation<F>* ExpectationAt(size_t position) const {
+    // See the definition of untyped_expectations_ for why access to
+    // it is unprotected here.
+    return static_cast<TypedExpectation<F>*>(
+        untyped_expectations_[position].get());
+  }
+
+  // Adds the expectations set since the last call to the index.
+  void UpdateExpectationIndexLocked() const
+      GTEST_EXCLUSIVE_LOCK_REQUIRED_(*expectations_mutex()) {
+    for (; indexed_expectation_count_ < untyped_expectations_.size();
+         ++indexed_expectation_count_) {
+      size_t hash;
+      if (ExpectationAt(indexed_expectation_count_)->HashEqualOperands(&hash)) {
+        expectations_by_hash_[hash].push_back(indexed_expectation_count_);
+      } else {
+        unhashed_expectations_.push_back(indexed_expectation_count_);
+      }
+    }
+  }
+
   // Returns a message that the arguments don't match any expectation.
   void FormatUnexpectedCallMessageLocked(const ArgumentTuple& args,
                                          ::std::ostream* os,
                                          ::std::ostream* why) const
-      GTEST_EXCLUSIVE_LOCK_REQUIRED_(g_gmock_mutex) {
-    g_gmock_mutex.AssertHeld();
+      GTEST_EXCLUSIVE_LOCK_REQUIRED_(*expectations_mutex()) {
+    expectations_mutex()->AssertHeld();
     *os << "\nUnexpected mock function call - ";
     DescribeDefaultActionTo(args, os);
     PrintTriedExpectationsLocked(args, why);
@@ -1640,8 +2101,8 @@ class FunctionMocker<R(Args...)> final : public UntypedFunctionMockerBase {
   // current mock function call.
   void PrintTriedExpectationsLocked(const ArgumentTuple& args,
                                     ::std::ostream* why) const
-      GTEST_EXCLUSIVE_LOCK_REQUIRED_(g_gmock_mutex) {
-    g_gmock_mutex.AssertHeld();
+      GTEST_EXCLUSIVE_LOCK_REQUIRED_(*expectations_mutex()) {
+    expectations_mutex()->AssertHeld();
     const size_t count = untyped_expectations_.size();
     *why << "Google Mock tried the following " << count << " "
          << (count == 1 ? "expectation, but it didn't match"
@@ -1670,10 +2131,15 @@ class FunctionMocker<R(Args...)> final : public UntypedFunctionMockerBase {
       return PerformDefaultAction(std::move(args), call_description);
     }
 
-    // Make a copy of the action before performing it, in case the
-    // action deletes the mock object (and thus deletes itself).
-    const Action<F> action = *static_cast<const Action<F>*>(untyped_action);
-    return action.Perform(std::move(args));
+    // The action belongs to the expectation the call matched, which the
+    // caller co-owns, so it outlives the call even if it deletes the mock
+    // object.  This saves copying the action on every call, unless the
+    // action could change its state, which each call has to start afresh
+    // from, and which concurrent calls would race on.
+    const Action<F>& action = *static_cast<const Action<F>*>(untyped_action);
+    if (action.CanPerformInPlace()) return action.Perform(std::move(args));
+    const Action<F> action_copy = action;
+    return action_copy.Perform(std::move(args));
   }
 
   // Is it possible to store an object of the supplied type in a local variable
@@ -1711,6 +2177,108 @@ class FunctionMocker<R(Args...)> final : public UntypedFunctionMockerBase {
     return PerformAction(untyped_action, std::move(args), call_description);
   }
 
+  // Writes the description of a call that's reported to what, and the
+  // location of the expectation it matches to loc, unless it's unexpected
+  // or excessive.
+  void DescribeCallTo(const ExpectationBase* untyped_expectation,
+                      bool is_excessive, const ArgumentTuple& args,
+                      ::std::ostream* what, ::std::ostream* loc) const {
+    if (untyped_expectation != nullptr && !is_excessive) {
+      *what << "Mock function call matches "
+            << untyped_expectation->source_text() << "...\n";
+      untyped_expectation->DescribeLocationTo(loc);
+    }
+
+    *what << "    Function call: " << Name();
+    this->UntypedPrintArgs(&args, what);
+  }
+
+  // Reports a call described by DescribeCallTo(): fails if it's unexpected
+  // or excessive, and logs it otherwise.
+  static void ReportCall(const ExpectationBase* untyped_expectation,
+                         bool is_excessive, const std::string& loc,
+                         const std::string& what) {
+    if (untyped_expectation == nullptr) {
+      // No expectation matches this call - reports a failure.
+      Expect(false, nullptr, -1, what);
+    } else if (is_excessive) {
+      // We had an upper-bound violation and the failure message is in what.
+      Expect(false, untyped_expectation->file(), untyped_expectation->line(),
+             what);
+    } else {
+      // We had an expected call and the matching expectation is
+      // described in what.
+      Log(kInfo, loc + what, 3);
+    }
+  }
+
+  // The arguments of a call, as recorded by a SpyMock.
+  using RecordedArgumentTuple = std::tuple<typename std::decay<Args>::type...>;
+
+  // Whether an argument of type T can be recorded: it's passed by value,
+  // and its type is recordable.  An argument passed by reference is matched
+  // when the call is made, as matchers like Ref() look at its address.
+  // Calls to this mock function can be recorded if all its arguments can.
+  template <typename T>
+  using IsRecordable =
+      conjunction<std::is_same<T, typename std::decay<T>::type>,
+                  IsRecordableArgument<typename std::decay<T>::type>>;
+  using ArgumentsAreRecordable = conjunction<IsRecordable<Args>...>;
+
+  // A call to this mock function recorded by a SpyMock.
+  class RecordedCallImpl : public RecordedCall {
+   public:
+    RecordedCallImpl(FunctionMocker* mocker, const ArgumentTuple& args)
+        : mocker_(mocker), args_(args) {}
+
+    void Replay() override {
+      mocker_->ReplayCall(&args_, IndexSequenceFor<Args...>());
+    }
+
+   private:
+    FunctionMocker* const mocker_;
+    RecordedArgumentTuple args_;
+  };
+
+  // Records the call instead of matching it now if this mock function
+  // belongs to a SpyMock, unless an expectation on it specifies an action.
+  // Returns true if and only if the call is recorded.
+  bool MaybeRecordCall(const ArgumentTuple& args,
+                       std::true_type /* recordable */) {
+    if (expectations_specify_actions_ || !RecordsCalls()) return false;
+    RecordCall(std::unique_ptr<RecordedCall>(new RecordedCallImpl(this, args)));
+    return true;
+  }
+  bool MaybeRecordCall(const ArgumentTuple&, std::false_type) { return false; }
+
+  // Replays a recorded call with the arguments it was made with.
+  template <size_t... I>
+  void ReplayCall(RecordedArgumentTuple* args, IndexSequence<I...>) {
+    static_cast<void>(args);  // Unused if the function has no arguments.
+    ReplayCall(ArgumentTuple(static_cast<Args&&>(std::get<I>(*args))...));
+  }
+
+  // Matches a call recorded by a SpyMock against the expectations on this
+  // mock function, and reports it like InvokeWith() does when a call is
+  // made, less its result.
+  void ReplayCall(ArgumentTuple&& args) GTEST_LOCK_EXCLUDED_(g_gmock_mutex) {
+    bool is_excessive = false;
+    LazyStringStream what;
+    LazyStringStream why;
+    const void* untyped_action = nullptr;
+    const std::shared_ptr<const ExpectationBase> untyped_expectation =
+        this->UntypedFindMatchingExpectation(&args, &untyped_action,
+                                             &is_excessive, &what, &why);
+    const bool found = untyped_expectation != nullptr;
+    if (found && !is_excessive && !LogIsVisible(kInfo)) return;
+
+    ::std::ostream& ss = *what.get();
+    ::std::stringstream loc;
+    DescribeCallTo(untyped_expectation.get(), is_excessive, args, &ss, &loc);
+    ss << "\n" << why.str();
+    ReportCall(untyped_expectation.get(), is_excessive, loc.str(), what.str());
+  }
+
   // Returns the result of invoking this mock function with the given
   // arguments. This function can be safely called from multiple
   // threads concurrently.
@@ -1732,8 +2300,7 @@ R FunctionMocker<R(Args...)>::InvokeWith(ArgumentTuple&& args)
     // made on this mock object BEFORE performing the action,
     // because the action may DELETE the mock object and make the
     // following expression meaningless.
-    const CallReaction reaction =
-        Mock::GetReactionOnUninterestingCalls(MockObject());
+    const CallReaction reaction = ReactionOnUninterestingCalls();
 
     // True if and only if we need to print this call's arguments and return
     // value.  This definition must be kept in sync with
@@ -1772,18 +2339,33 @@ R FunctionMocker<R(Args...)>::InvokeWith(ArgumentTuple&& args)
     return PerformActionAndPrintResult(nullptr, std::move(args), ss.str(), ss);
   }
 
+  // On a SpyMock, the call is matched against the expectations when they
+  // are verified, so all it does now is to record its arguments.
+  if (MaybeRecordCall(args, ArgumentsAreRecordable())) {
+    return this->PerformDefaultAction(
+        std::move(args), "Function call: " + std::string(Name()));
+  }
+
+  // The expectation this call matches may be ordered after one on a
+  // SpyMock, and the calls recorded on it have to be matched first.
+  if (sequenced_with_other_mockers_ && HasUnreplayedCalls()) {
+    ReplayRecordedCalls();
+  }
+
   bool is_excessive = false;
-  ::std::stringstream ss;
-  ::std::stringstream why;
-  ::std::stringstream loc;
+  // Expected calls that aren't logged don't need to be described, so the
+  // description is only allocated and formatted when needed.
+  LazyStringStream what;
+  LazyStringStream why;
   const void* untyped_action = nullptr;
 
   // The UntypedFindMatchingExpectation() function acquires and
-  // releases g_gmock_mutex.
+  // releases expectations_mutex().
 
-  const ExpectationBase* const untyped_expectation =
+  // Holding the expectation keeps untyped_action alive until we return.
+  const std::shared_ptr<const ExpectationBase> untyped_expectation =
       this->UntypedFindMatchingExpectation(&args, &untyped_action,
-                                           &is_excessive, &ss, &why);
+                                           &is_excessive, &what, &why);
   const bool found = untyped_expectation != nullptr;
 
   // True if and only if we need to print the call's arguments
@@ -1797,14 +2379,11 @@ R FunctionMocker<R(Args...)>::InvokeWith(ArgumentTuple&& args)
     return PerformAction(untyped_action, std::move(args), "");
   }
 
-  ss << "    Function call: " << Name();
-  this->UntypedPrintArgs(&args, &ss);
-
+  ::std::ostream& ss = *what.get();
+  ::std::stringstream loc;
   // In case the action deletes a piece of the expectation, we
   // generate the message beforehand.
-  if (found && !is_excessive) {
-    untyped_expectation->DescribeLocationTo(&loc);
-  }
+  DescribeCallTo(untyped_expectation.get(), is_excessive, args, &ss, &loc);
 
   // Perform the action, print the result, and then fail or log in whatever way
   // is appropriate.
@@ -1813,23 +2392,11 @@ R FunctionMocker<R(Args...)>::InvokeWith(ArgumentTuple&& args)
   // either case we can't assign it to a local variable.
   const Cleanup handle_failures([&] {
     ss << "\n" << why.str();
-
-    if (!found) {
-      // No expectation matches this call - reports a failure.
-      Expect(false, nullptr, -1, ss.str());
-    } else if (is_excessive) {
-      // We had an upper-bound violation and the failure message is in ss.
-      Expect(false, untyped_expectation->file(), untyped_expectation->line(),
-             ss.str());
-    } else {
-      // We had an expected call and the matching expectation is
-      // described in ss.
-      Log(kInfo, loc.str() + ss.str(), 2);
-    }
+    ReportCall(untyped_expectation.get(), is_excessive, loc.str(), what.str());
   });
 
-  return PerformActionAndPrintResult(untyped_action, std::move(args), ss.str(),
-                                     ss);
+  return PerformActionAndPrintResult(untyped_action, std::move(args),
+                                     what.str(), ss);
 }
 
 }  // namespace internal
@@ -61,97 +61,59 @@ GTEST_API_ std::string FormatMatcherDescription(
 
 // FindMaxBipartiteMatching and its helper class.
 //
-// Uses the well-known Ford-Fulkerson max flow method to find a maximum
-// bipartite matching. Flow is considered to be from left to right.
-// There is an implicit source node that is connected to all of the left
-// nodes, and an implicit sink node that is connected to all of the
-// right nodes. All edges have unit capacity.
+// Uses the Hopcroft-Karp algorithm to find a maximum bipartite matching
+// between the left nodes (elements) and the right nodes (matchers) in
+// O(E * sqrt(V)) time, where E is the number of edges in the graph and V
+// the number of nodes.
 //
-// Neither the flow graph nor the residual flow graph are represented
-// explicitly. Instead, they are implied by the information in 'graph' and
-// a vector<int> called 'left_' whose elements are initialized to the
-// value kUnused. This represents the initial state of the algorithm,
-// where the flow graph is empty, and the residual flow graph has the
-// following edges:
-//   - An edge from source to each left_ node
-//   - An edge from each right_ node to sink
-//   - An edge from each left_ node to each right_ node, if the
-//     corresponding edge exists in 'graph'.
-//
-// When the TryAugment() method adds a flow, it sets left_[l] = r for some
-// nodes l and r. This induces the following changes:
-//   - The edges (source, l), (l, r), and (r, sink) are added to the
-//     flow graph.
-//   - The same three edges are removed from the residual flow graph.
-//   - The reverse edges (l, source), (r, l), and (sink, r) are added
-//     to the residual flow graph, which is a directional graph
-//     representing unused flow capacity.
-//
-// When the method augments a flow (moving left_[l] from some r1 to some
-// other r2), this can be thought of as "undoing" the above steps with
-// respect to r1 and "redoing" them with respect to r2.
-//
-// It bears repeating that the flow graph and residual flow graph are
-// never represented explicitly, but can be derived by looking at the
-// information in 'graph' and in left_.
-//
-// As an optimization, there is a second vector<int> called right_ which
-// does not provide any new information. Instead, it enables more
-// efficient queries about edges entering or leaving the right-side nodes
-// of the flow or residual flow graphs. The following invariants are
+// The matching is kept in a vector<size_t> called 'left_', holding the
+// right node each left node is matched to, and a vector<size_t> called
+// 'right_', holding the left node each right node is matched to.  Both
+// are initialized to kUnused, and the following invariants are
 // maintained:
 //
 // left[l] == kUnused or right[left[l]] == l
 // right[r] == kUnused or left[right[r]] == r
 //
-// . [ source ]                                        .
-// .   |||                                             .
-// .   |||                                             .
-// .   ||\--> left[0]=1  ---\    right[0]=-1 ----\     .
-// .   ||                   |                    |     .
-// .   |\---> left[1]=-1    \--> right[1]=0  ---\|     .
-// .   |                                        ||     .
-// .   \----> left[2]=2  ------> right[2]=2  --\||     .
-// .                                           |||     .
-// .         elements           matchers       vvv     .
-// .                                         [ sink ]  .
+// An augmenting path starts at an unmatched left node, goes to a right
+// node through an edge that isn't in the matching, back to a left node
+// through one that is, and so on, until it ends at an unmatched right
+// node.  Flipping the edges along it (putting those that weren't in the
+// matching in, and the others out) matches one more node on each side.
+// The matching is maximum when there is no augmenting path left [1].
+//
+// The algorithm works in phases.  Each phase first does a breadth-first
+// search from all the unmatched left nodes at once, which puts each left
+// node in the layer of its distance from them, and finds the length of
+// the shortest augmenting paths.  Then it does a depth-first search from
+// each unmatched left node, only following edges that lead to the next
+// layer, and flips the augmenting paths it finds, which are all of that
+// length.  Each phase takes O(E) time, and there are O(sqrt(V)) of them,
+// as the shortest augmenting path gets longer with each phase [2].
 //
 // See Also:
-//   [1] Cormen, et al (2001). "Section 26.2: The Ford-Fulkerson method".
-//       "Introduction to Algorithms (Second ed.)", pp. 651-664.
-//   [2] "Ford-Fulkerson algorithm", Wikipedia,
-//       'http://en.wikipedia.org/wiki/Ford%E2%80%93Fulkerson_algorithm'
+//   [1] Cormen, et al (2001). "Section 26.3: Maximum bipartite matching".
+//       "Introduction to Algorithms (Second ed.)", pp. 664-669.
+//   [2] Hopcroft, J. E.; Karp, R. M. (1973). "An n^5/2 algorithm for
+//       maximum matchings in bipartite graphs". SIAM Journal on
+//       Computing 2 (4): 225-231.
 class MaxBipartiteMatchState {
  public:
   explicit MaxBipartiteMatchState(const MatchMatrix& graph)
       : graph_(&graph),
         left_(graph_->LhsSize(), kUnused),
-        right_(graph_->RhsSize(), kUnused) {}
+        right_(graph_->RhsSize(), kUnused),
+        layer_(graph_->LhsSize(), kUnused),
+        next_edge_(graph_->LhsSize(), 0),
+        free_layer_(kUnused) {}
 
   // Returns the edges of a maximal match, each in the form {left, right}.
   ElementMatcherPairs Compute() {
-    // 'seen' is used for path finding { 0: unseen, 1: seen }.
-    ::std::vector<char> seen;
-    // Searches the residual flow graph for a path from each left node to
-    // the sink in the residual flow graph, and if one is found, add flow
-    // to the graph. It's okay to search through the left nodes once. The
-    // edge from the implicit source node to each previously-visited left
-    // node will have flow if that left node has any path to the sink
-    // whatsoever. Subsequent augmentations can only add flow to the
-    // network, and cannot take away that previous flow unit from the source.
-    // Since the source-to-left edge can only carry one flow unit (or,
-    // each element can be matched to only one matcher), there is no need
-    // to visit the left nodes more than once looking for augmented paths.
-    // The flow is known to be possible or impossible by looking at the
-    // node once.
-    for (size_t ilhs = 0; ilhs < graph_->LhsSize(); ++ilhs) {
-      // Reset the path-marking vector and try to find a path from
-      // source to sink starting at the left_[ilhs] node.
-      GTEST_CHECK_(left_[ilhs] == kUnused)
-          << "ilhs: " << ilhs << ", left_[ilhs]: " << left_[ilhs];
-      // 'seen' initialized to 'graph_->RhsSize()' copies of 0.
-      seen.assign(graph_->RhsSize(), 0);
-      TryAugment(ilhs, &seen);
+    while (FindLayers()) {
+      next_edge_.assign(graph_->LhsSize(), 0);
+      for (size_t ilhs = 0; ilhs < graph_->LhsSize(); ++ilhs) {
+        if (left_[ilhs] == kUnused) TryAugment(ilhs);
+      }
     }
     ElementMatcherPairs result;
     for (size_t ilhs = 0; ilhs < left_.size(); ++ilhs) {
@@ -165,62 +127,113 @@ class MaxBipartiteMatchState {
  private:
   static const size_t kUnused = static_cast<size_t>(-1);
 
-  // Perform a depth-first search from left node ilhs to the sink.  If a
-  // path is found, flow is added to the network by linking the left and
-  // right vector elements corresponding each segment of the path.
-  // Returns true if a path to sink was found, which means that a unit of
-  // flow was added to the network. The 'seen' vector elements correspond
-  // to right nodes and are marked to eliminate cycles from the search.
-  //
-  // Left nodes will only be explored at most once because they
-  // are accessible from at most one right node in the residual flow
-  // graph.
-  //
-  // Note that left_[ilhs] is the only element of left_ that TryAugment will
-  // potentially transition from kUnused to another value. Any other
-  // left_ element holding kUnused before TryAugment will be holding it
-  // when TryAugment returns.
+  // Performs a breadth-first search from all unmatched left nodes, setting
+  // layer_ to the distance of each left node from them (or kUnused if it
+  // is farther than the nearest unmatched right node), and free_layer_ to
+  // the distance of the nearest unmatched right node.  Returns true if
+  // and only if an augmenting path exists.
+  bool FindLayers() {
+    queue_.clear();
+    for (size_t ilhs = 0; ilhs < graph_->LhsSize(); ++ilhs) {
+      if (left_[ilhs] == kUnused) {
+        layer_[ilhs] = 0;
+        queue_.push_back(ilhs);
+      } else {
+        layer_[ilhs] = kUnused;
+      }
+    }
+    free_layer_ = kUnused;
+    // queue_ holds the left nodes in order of their layers, so we can stop
+    // at the first one that is as far as an unmatched right node.
+    for (size_t head = 0; head < queue_.size(); ++head) {
+      const size_t ilhs = queue_[head];
+      if (free_layer_ != kUnused && layer_[ilhs] + 1 >= free_layer_) break;
+      for (size_t irhs : graph_->EdgesOf(ilhs)) {
+        const size_t next = right_[irhs];
+        if (next == kUnused) {
+          free_layer_ = layer_[ilhs] + 1;
+        } else if (layer_[next] == kUnused) {
+          layer_[next] = layer_[ilhs] + 1;
+          queue_.push_back(next);
+        }
+      }
+    }
+    return free_layer_ != kUnused;
+  }
+
+  // Performs a depth-first search from the unmatched left node ilhs for a
+  // shortest augmenting path, going from each left node only to the next
+  // layer.  If one is found, flips it and returns true.
   //
-  bool TryAugment(size_t ilhs, ::std::vector<char>* seen) {
-    for (size_t irhs = 0; irhs < graph_->RhsSize(); ++irhs) {
-      if ((*seen)[irhs]) continue;
-      if (!graph_->HasEdge(ilhs, irhs)) continue;
-      // There's an available edge from ilhs to irhs.
-      (*seen)[irhs] = 1;
-      // Next a search is performed to determine whether
-      // this edge is a dead end or leads to the sink.
-      //
-      // right_[irhs] == kUnused means that there is residual flow from
-      // right node irhs to the sink, so we can use that to finish this
-      // flow path and return success.
-      //
-      // Otherwise there is residual flow to some ilhs. We push flow
-      // along that path and call ourselves recursively to see if this
-      // ultimately leads to sink.
-      if (right_[irhs] == kUnused || TryAugment(right_[irhs], seen)) {
-        // Add flow from left_[ilhs] to right_[irhs].
-        left_[ilhs] = irhs;
-        right_[irhs] = ilhs;
-        return true;
+  // The search is iterative, as a path may be as long as the number of
+  // nodes.  path_ holds the left nodes on the current path, and
+  // next_edge_[l] the next edge of left node l to follow, so that each
+  // edge is followed at most once per phase.  The right node the path
+  // goes through after left node l is thus the one edge next_edge_[l] - 1
+  // leads to.  A left node from which no path leads to an unmatched right
+  // node is taken out of its layer, so that it's not searched again.
+  bool TryAugment(size_t ilhs) {
+    path_.assign(1, ilhs);
+    while (!path_.empty()) {
+      const size_t from = path_.back();
+      const ::std::vector<size_t>& edges = graph_->EdgesOf(from);
+      bool advanced = false;
+      while (next_edge_[from] < edges.size()) {
+        const size_t irhs = edges[next_edge_[from]++];
+        const size_t next = right_[irhs];
+        if (next == kUnused) {
+          if (layer_[from] + 1 == free_layer_) {
+            Flip(irhs);
+            return true;
+          }
+        } else if (layer_[next] == layer_[from] + 1) {
+          path_.push_back(next);
+          advanced = true;
+          break;
+        }
+      }
+      if (!advanced) {
+        layer_[from] = kUnused;
+        path_.pop_back();
       }
     }
     return false;
   }
 
+  // Flips the augmenting path made of the left nodes in path_ and the
+  // unmatched right node last_irhs.
+  void Flip(size_t last_irhs) {
+    size_t irhs = last_irhs;
+    for (size_t i = path_.size(); i-- > 0;) {
+      const size_t ilhs = path_[i];
+      left_[ilhs] = irhs;
+      right_[irhs] = ilhs;
+      if (i > 0) {
+        irhs = graph_->EdgesOf(path_[i - 1])[next_edge_[path_[i - 1]] - 1];
+      }
+    }
+  }
+
   const MatchMatrix* graph_;  // not owned
   // Each element of the left_ vector represents a left hand side node
   // (i.e. an element) and each element of right_ is a right hand side
   // node (i.e. a matcher). The values in the left_ vector indicate
-  // outflow from that node to a node on the right_ side. The values
-  // in the right_ indicate inflow, and specify which left_ node is
-  // feeding that right_ node, if any. For example, left_[3] == 1 means
-  // there's a flow from element #3 to matcher #1. Such a flow would also
-  // be redundantly represented in the right_ vector as right_[1] == 3.
+  // the matcher each element is matched to, and the values in the right_
+  // vector the element each matcher is matched to, if any. For example,
+  // left_[3] == 1 means element #3 is matched to matcher #1, which is
+  // redundantly represented in the right_ vector as right_[1] == 3.
   // Elements of left_ and right_ are either kUnused or mutually
   // referent. Mutually referent means that left_[right_[i]] = i and
   // right_[left_[i]] = i.
   ::std::vector<size_t> left_;
   ::std::vector<size_t> right_;
+
+  // The state of the current phase (see FindLayers() and TryAugment()).
+  ::std::vector<size_t> layer_;
+  ::std::vector<size_t> next_edge_;
+  size_t free_layer_;
+  ::std::vector<size_t> queue_;
+  ::std::vector<size_t> path_;
 };
 
 const size_t MaxBipartiteMatchState::kUnused;
@@ -247,12 +260,11 @@ static void LogElementMatcherPairVec(const ElementMatcherPairs& pairs,
 bool MatchMatrix::NextGraph() {
   for (size_t ilhs = 0; ilhs < LhsSize(); ++ilhs) {
     for (size_t irhs = 0; irhs < RhsSize(); ++irhs) {
-      char& b = matched_[SpaceIndex(ilhs, irhs)];
-      if (!b) {
-        b = 1;
+      if (!HasEdge(ilhs, irhs)) {
+        SetEdge(ilhs, irhs, true);
         return true;
       }
-      b = 0;
+      SetEdge(ilhs, irhs, false);
     }
   }
   return false;
@@ -260,9 +272,9 @@ bool MatchMatrix::NextGraph() {
 
 void MatchMatrix::Randomize() {
   for (size_t ilhs = 0; ilhs < LhsSize(); ++ilhs) {
+    edges_[ilhs].clear();
     for (size_t irhs = 0; irhs < RhsSize(); ++irhs) {
-      char& b = matched_[SpaceIndex(ilhs, irhs)];
-      b = static_cast<char>(rand() & 1);  // NOLINT
+      if (rand() & 1) edges_[ilhs].push_back(irhs);  // NOLINT
     }
   }
 }
@@ -375,10 +387,9 @@ bool UnorderedElementsAreMatcherImplBase::VerifyMatchMatrix(
   ::std::vector<char> matcher_matched(matrix.RhsSize(), 0);
 
   for (size_t ilhs = 0; ilhs < matrix.LhsSize(); ilhs++) {
-    for (size_t irhs = 0; irhs < matrix.RhsSize(); irhs++) {
-      char matched = matrix.HasEdge(ilhs, irhs);
-      element_matched[ilhs] |= matched;
-      matcher_matched[irhs] |= matched;
+    for (size_t irhs : matrix.EdgesOf(ilhs)) {
+      element_matched[ilhs] = 1;
+      matcher_matched[irhs] = 1;
     }
   }
 
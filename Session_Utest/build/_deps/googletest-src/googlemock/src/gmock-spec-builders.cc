@@ -36,12 +36,15 @@
 
 #include <stdlib.h>
 
+#include <algorithm>
+#include <functional>
 #include <iostream>  // NOLINT
-#include <map>
+#include <iterator>
 #include <memory>
 #include <set>
 #include <string>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 #include "gmock/gmock.h"
@@ -54,6 +57,9 @@
 #if GTEST_OS_QURT
 #include <qurt_event.h>
 #endif
+#if GTEST_IS_THREADSAFE
+#include <thread>  // NOLINT
+#endif  // GTEST_IS_THREADSAFE
 
 // Silence C4800 (C4800: 'int *const ': forcing value
 // to bool 'true' or 'false') for MSVC 15
@@ -67,8 +73,9 @@
 namespace testing {
 namespace internal {
 
-// Protects the mock object registry (in class Mock), all function
-// mockers, and all expectations.
+// Protects verifying and clearing mock objects (in class Mock), and the
+// expectations of function mockers that are sequenced with each other.
+// The registry of mock objects has locks of its own.
 GTEST_API_ GTEST_DEFINE_STATIC_MUTEX_(g_gmock_mutex);
 
 // Logs a message including file and line number information.
@@ -82,9 +89,12 @@ GTEST_API_ void LogWithLocation(testing::internal::LogSeverity severity,
 }
 
 // Constructs an ExpectationBase object.
-ExpectationBase::ExpectationBase(const char* a_file, int a_line,
+ExpectationBase::ExpectationBase(UntypedFunctionMockerBase* owner,
+                                 const char* a_file, int a_line,
                                  const std::string& a_source_text)
-    : file_(a_file),
+    : untyped_owner_(owner),
+      sequenced_with_other_mockers_(false),
+      file_(a_file),
       line_(a_line),
       source_text_(a_source_text),
       cardinality_specified_(false),
@@ -107,9 +117,29 @@ void ExpectationBase::SpecifyCardinality(const Cardinality& a_cardinality) {
   cardinality_ = a_cardinality;
 }
 
+// Makes prerequisite an immediate pre-requisite of this expectation.
+void ExpectationBase::AddPrerequisite(const Expectation& prerequisite) {
+  immediate_prerequisites_ += prerequisite;
+
+  ExpectationBase* const other = prerequisite.expectation_base().get();
+  if (other == nullptr || other->untyped_owner_ == untyped_owner_) return;
+
+  // A call to either mock function may now read or change the state of
+  // an expectation on the other one, so both have to be sequenced with
+  // g_gmock_mutex.  Expectations reachable from these two through
+  // pre-requisites on the same mock function are covered by that
+  // function being sequenced.
+  sequenced_with_other_mockers_ = true;
+  other->sequenced_with_other_mockers_ = true;
+  if (untyped_owner_ != nullptr) untyped_owner_->SequenceWithOtherMockers();
+  if (other->untyped_owner_ != nullptr) {
+    other->untyped_owner_->SequenceWithOtherMockers();
+  }
+}
+
 // Retires all pre-requisites of this expectation.
 void ExpectationBase::RetireAllPreRequisites()
-    GTEST_EXCLUSIVE_LOCK_REQUIRED_(g_gmock_mutex) {
+    GTEST_EXCLUSIVE_LOCK_REQUIRED_(*state_mutex()) {
   if (is_retired()) {
     // We can take this short-cut as we never retire an expectation
     // until we have retired all its pre-requisites.
@@ -136,8 +166,8 @@ void ExpectationBase::RetireAllPreRequisites()
 // Returns true if and only if all pre-requisites of this expectation
 // have been satisfied.
 bool ExpectationBase::AllPrerequisitesAreSatisfied() const
-    GTEST_EXCLUSIVE_LOCK_REQUIRED_(g_gmock_mutex) {
-  g_gmock_mutex.AssertHeld();
+    GTEST_EXCLUSIVE_LOCK_REQUIRED_(*state_mutex()) {
+  state_mutex()->AssertHeld();
   ::std::vector<const ExpectationBase*> expectations(1, this);
   while (!expectations.empty()) {
     const ExpectationBase* exp = expectations.back();
@@ -156,8 +186,8 @@ bool ExpectationBase::AllPrerequisitesAreSatisfied() const
 
 // Adds unsatisfied pre-requisites of this expectation to 'result'.
 void ExpectationBase::FindUnsatisfiedPrerequisites(ExpectationSet* result) const
-    GTEST_EXCLUSIVE_LOCK_REQUIRED_(g_gmock_mutex) {
-  g_gmock_mutex.AssertHeld();
+    GTEST_EXCLUSIVE_LOCK_REQUIRED_(*state_mutex()) {
+  state_mutex()->AssertHeld();
   ::std::vector<const ExpectationBase*> expectations(1, this);
   while (!expectations.empty()) {
     const ExpectationBase* exp = expectations.back();
@@ -187,8 +217,8 @@ void ExpectationBase::FindUnsatisfiedPrerequisites(ExpectationSet* result) const
 // Describes how many times a function call matching this
 // expectation has occurred.
 void ExpectationBase::DescribeCallCountTo(::std::ostream* os) const
-    GTEST_EXCLUSIVE_LOCK_REQUIRED_(g_gmock_mutex) {
-  g_gmock_mutex.AssertHeld();
+    GTEST_EXCLUSIVE_LOCK_REQUIRED_(*state_mutex()) {
+  state_mutex()->AssertHeld();
 
   // Describes how many times the function is expected to be called.
   *os << "         Expected: to be ";
@@ -309,7 +339,13 @@ void ReportUninterestingCall(CallReaction reaction, const std::string& msg) {
 }
 
 UntypedFunctionMockerBase::UntypedFunctionMockerBase()
-    : mock_obj_(nullptr), name_("") {}
+    : mock_obj_(nullptr),
+      name_(""),
+      indexed_on_call_spec_count_(0),
+      cached_reaction_(0),
+      sequenced_with_other_mockers_(false),
+      expectations_specify_actions_(false),
+      indexed_expectation_count_(0) {}
 
 UntypedFunctionMockerBase::~UntypedFunctionMockerBase() {}
 
@@ -319,10 +355,7 @@ UntypedFunctionMockerBase::~UntypedFunctionMockerBase() {}
 // method.
 void UntypedFunctionMockerBase::RegisterOwner(const void* mock_obj)
     GTEST_LOCK_EXCLUDED_(g_gmock_mutex) {
-  {
-    MutexLock l(&g_gmock_mutex);
-    mock_obj_ = mock_obj;
-  }
+  mock_obj_.store(mock_obj, std::memory_order_relaxed);
   Mock::Register(mock_obj, this);
 }
 
@@ -332,27 +365,20 @@ void UntypedFunctionMockerBase::RegisterOwner(const void* mock_obj)
 void UntypedFunctionMockerBase::SetOwnerAndName(const void* mock_obj,
                                                 const char* name)
     GTEST_LOCK_EXCLUDED_(g_gmock_mutex) {
-  // We protect name_ under g_gmock_mutex in case this mock function
-  // is called from two threads concurrently.
-  MutexLock l(&g_gmock_mutex);
-  mock_obj_ = mock_obj;
-  name_ = name;
+  // This is done on every call, so it doesn't take any lock; the values
+  // stored by concurrent calls are the same anyway.
+  mock_obj_.store(mock_obj, std::memory_order_relaxed);
+  name_.store(name, std::memory_order_relaxed);
 }
 
 // Returns the name of the function being mocked.  Must be called
 // after RegisterOwner() or SetOwnerAndName() has been called.
 const void* UntypedFunctionMockerBase::MockObject() const
     GTEST_LOCK_EXCLUDED_(g_gmock_mutex) {
-  const void* mock_obj;
-  {
-    // We protect mock_obj_ under g_gmock_mutex in case this mock
-    // function is called from two threads concurrently.
-    MutexLock l(&g_gmock_mutex);
-    Assert(mock_obj_ != nullptr, __FILE__, __LINE__,
-           "MockObject() must not be called before RegisterOwner() or "
-           "SetOwnerAndName() has been called.");
-    mock_obj = mock_obj_;
-  }
+  const void* const mock_obj = mock_obj_.load(std::memory_order_relaxed);
+  Assert(mock_obj != nullptr, __FILE__, __LINE__,
+         "MockObject() must not be called before RegisterOwner() or "
+         "SetOwnerAndName() has been called.");
   return mock_obj;
 }
 
@@ -360,16 +386,10 @@ const void* UntypedFunctionMockerBase::MockObject() const
 // SetOwnerAndName() has been called.
 const char* UntypedFunctionMockerBase::Name() const
     GTEST_LOCK_EXCLUDED_(g_gmock_mutex) {
-  const char* name;
-  {
-    // We protect name_ under g_gmock_mutex in case this mock
-    // function is called from two threads concurrently.
-    MutexLock l(&g_gmock_mutex);
-    Assert(name_ != nullptr, __FILE__, __LINE__,
-           "Name() must not be called before SetOwnerAndName() has "
-           "been called.");
-    name = name_;
-  }
+  const char* const name = name_.load(std::memory_order_relaxed);
+  Assert(name != nullptr, __FILE__, __LINE__,
+         "Name() must not be called before SetOwnerAndName() has "
+         "been called.");
   return name;
 }
 
@@ -397,6 +417,11 @@ Expectation UntypedFunctionMockerBase::GetHandleOf(ExpectationBase* exp) {
 bool UntypedFunctionMockerBase::VerifyAndClearExpectationsLocked()
     GTEST_EXCLUSIVE_LOCK_REQUIRED_(g_gmock_mutex) {
   g_gmock_mutex.AssertHeld();
+  // Unless this mock function is sequenced with other ones, calls to it
+  // only lock its own mutex, which we need as well.
+  GMockMutex* const mutex = expectations_mutex();
+  if (mutex != &g_gmock_mutex) mutex->Lock();
+
   bool expectations_met = true;
   for (UntypedExpectations::const_iterator it = untyped_expectations_.begin();
        it != untyped_expectations_.end(); ++it) {
@@ -430,6 +455,18 @@ bool UntypedFunctionMockerBase::VerifyAndClearExpectationsLocked()
   // copied set outside of it.
   UntypedExpectations expectations_to_delete;
   untyped_expectations_.swap(expectations_to_delete);
+  expectations_specify_actions_ = false;
+  expectations_by_hash_.clear();
+  unhashed_expectations_.clear();
+  indexed_expectation_count_ = 0;
+
+  // Some of the expectations may live on as pre-requisites of
+  // expectations on other mock functions.
+  for (const std::shared_ptr<ExpectationBase>& expectation :
+       expectations_to_delete) {
+    expectation->untyped_owner_ = nullptr;
+  }
+  if (mutex != &g_gmock_mutex) mutex->Unlock();
 
   g_gmock_mutex.Unlock();
   expectations_to_delete.clear();
@@ -445,6 +482,154 @@ static CallReaction intToCallReaction(int mock_behavior) {
   return kWarn;
 }
 
+namespace {
+
+// A call recorded by a SpyMock, numbered in the order calls were made.
+typedef std::pair<uint64_t, std::unique_ptr<RecordedCall>> NumberedCall;
+typedef std::vector<NumberedCall> NumberedCalls;
+
+// The numbers of calls recorded and replayed so far.
+std::atomic<uint64_t> g_recorded_call_count(0);
+std::atomic<uint64_t> g_replayed_call_count(0);
+
+// Makes ReplayRecordedCalls() replay the calls in order when it's called
+// from several threads.
+GTEST_DEFINE_STATIC_MUTEX_(g_replay_mutex);
+
+// Protects RecordedCallLogs() and OrphanedCalls().
+GTEST_DEFINE_STATIC_MUTEX_(g_recorded_call_logs_mutex);
+
+class RecordedCallLog;
+
+// The logs of all threads that have recorded calls.
+std::set<RecordedCallLog*>& RecordedCallLogs() {
+  static auto* logs = new std::set<RecordedCallLog*>;
+  return *logs;
+}
+
+// Calls recorded on threads that have exited since.
+NumberedCalls& OrphanedCalls() {
+  static auto* calls = new NumberedCalls;
+  return *calls;
+}
+
+// The calls recorded on one thread that haven't been replayed yet.  Only
+// that thread appends to the log, so locking its mutex is cheap.
+class RecordedCallLog {
+ public:
+  RecordedCallLog() {
+    MutexLock l(&g_recorded_call_logs_mutex);
+    RecordedCallLogs().insert(this);
+  }
+
+  // Called when the thread exits.  Its calls are replayed later on.
+  ~RecordedCallLog() {
+    MutexLock l(&g_recorded_call_logs_mutex);
+    RecordedCallLogs().erase(this);
+    MoveCallsTo(&OrphanedCalls());
+  }
+
+  void Append(uint64_t number, std::unique_ptr<RecordedCall> call) {
+    MutexLock l(&mutex_);
+    calls_.emplace_back(number, std::move(call));
+  }
+
+  void MoveCallsTo(NumberedCalls* calls) {
+    MutexLock l(&mutex_);
+    for (NumberedCall& call : calls_) calls->push_back(std::move(call));
+    calls_.clear();
+  }
+
+ private:
+  Mutex mutex_;
+  NumberedCalls calls_;
+};
+
+ThreadLocal<RecordedCallLog>& ThreadRecordedCallLog() {
+  static auto* log = new ThreadLocal<RecordedCallLog>;
+  return *log;
+}
+
+}  // namespace
+
+// Appends the given call to the log of calls recorded on the current
+// thread.
+void RecordCall(std::unique_ptr<RecordedCall> call) {
+  const uint64_t number =
+      g_recorded_call_count.fetch_add(1, std::memory_order_acq_rel);
+  ThreadRecordedCallLog().pointer()->Append(number, std::move(call));
+}
+
+// Returns true if and only if some recorded calls haven't been replayed
+// yet.
+bool HasUnreplayedCalls() {
+  return g_replayed_call_count.load(std::memory_order_acquire) !=
+         g_recorded_call_count.load(std::memory_order_acquire);
+}
+
+// Replays the calls recorded on all threads so far, in the order they
+// were made.
+void ReplayRecordedCalls() GTEST_LOCK_EXCLUDED_(g_gmock_mutex) {
+  MutexLock replay_lock(&g_replay_mutex);
+  const auto by_number = [](const NumberedCall& lhs, const NumberedCall& rhs) {
+    return lhs.first < rhs.first;
+  };
+
+  // A call is numbered before it's appended to the log of its thread, so a
+  // call being made on another thread may be missing while later ones are
+  // there.  The calls are replayed up to the first missing one, which is
+  // then waited for: the caller may be about to verify or destroy the mock
+  // function it was made on, and every call numbered before this replay
+  // started has to be matched by then.
+  const uint64_t recorded_count =
+      g_recorded_call_count.load(std::memory_order_acquire);
+  uint64_t next_number = g_replayed_call_count.load(std::memory_order_acquire);
+  NumberedCalls calls;
+  while (next_number < recorded_count) {
+    {
+      MutexLock l(&g_recorded_call_logs_mutex);
+      NumberedCalls& orphaned_calls = OrphanedCalls();
+      std::move(orphaned_calls.begin(), orphaned_calls.end(),
+                std::back_inserter(calls));
+      orphaned_calls.clear();
+      for (RecordedCallLog* log : RecordedCallLogs()) log->MoveCallsTo(&calls);
+    }
+
+    // The calls of each thread are in order, so they usually are already
+    // unless several threads made calls.
+    if (!std::is_sorted(calls.begin(), calls.end(), by_number)) {
+      std::sort(calls.begin(), calls.end(), by_number);
+    }
+
+    size_t replayable = 0;
+    while (replayable < calls.size() &&
+           calls[replayable].first == next_number) {
+      ++replayable;
+      ++next_number;
+    }
+    if (replayable == 0) {
+      // The missing call is being appended right now.
+#if GTEST_IS_THREADSAFE
+      std::this_thread::yield();
+#endif  // GTEST_IS_THREADSAFE
+      continue;
+    }
+    NumberedCalls ready(std::make_move_iterator(calls.begin()),
+                        std::make_move_iterator(calls.begin() + replayable));
+    calls.erase(calls.begin(), calls.begin() + replayable);
+    g_replayed_call_count.store(next_number, std::memory_order_release);
+    for (NumberedCall& call : ready) call.second->Replay();
+  }
+
+  // Calls numbered after the replay started, and found after a gap, are
+  // replayed next time.
+  if (!calls.empty()) {
+    MutexLock l(&g_recorded_call_logs_mutex);
+    NumberedCalls& orphaned_calls = OrphanedCalls();
+    for (NumberedCall& call : calls) orphaned_calls.push_back(std::move(call));
+  }
+}
+
 }  // namespace internal
 
 // Class Mock.
@@ -470,15 +655,71 @@ struct MockObjectState {
   FunctionMockers function_mockers;  // All registered methods of the object.
 };
 
-// A global registry holding the state of all mock objects that are
-// alive.  A mock object is added to this registry the first time
-// Mock::AllowLeak(), ON_CALL(), or EXPECT_CALL() is called on it.  It
-// is removed from the registry in the mock object's destructor.
+// A shard of the global registry of mock objects, holding the mock
+// objects whose addresses map to it.  Looking up, registering and
+// unregistering a mock object only lock its shard, so that tests creating
+// and destroying many mock objects, possibly on many threads, don't
+// contend for g_gmock_mutex or a single lock.  Locked after g_gmock_mutex
+// when both are needed.
+struct MockObjectRegistryShard {
+  internal::Mutex mutex;
+
+  // Maps a mock object (identified by its address) to its state.  A mock
+  // object is added here the first time Mock::AllowLeak(), ON_CALL(), or
+  // EXPECT_CALL() is called on it.  It is removed when its last mock
+  // method is destroyed.
+  std::unordered_map<const void*, MockObjectState> states;
+
+  // Maps a mock object to the reaction Google Mock should have when an
+  // uninteresting method is called.
+  std::unordered_map<uintptr_t, internal::CallReaction> reactions;
+
+  // The mock objects that are SpyMocks.
+  std::unordered_set<uintptr_t> spies;
+
+  // Incremented under the lock whenever reactions or spies change, which
+  // invalidates the state of mock objects in this shard cached by function
+  // mockers.  Starts at 1, as a cached state of 0 means none.
+  std::atomic<uint64_t> reaction_generation{1};
+};
+
+constexpr size_t kMockObjectRegistryShards = 32;
+
+// Returns the shards of the mock object registry.  They are never
+// destroyed, so that mock objects destroyed after the leak check at
+// program exit can still unregister themselves.
+MockObjectRegistryShard* MockObjectRegistryShards() {
+  static auto* shards = new MockObjectRegistryShard[kMockObjectRegistryShards];
+  return shards;
+}
+
+// Returns the shard of the mock object registry holding the given mock
+// object.
+MockObjectRegistryShard& RegistryShardOf(uintptr_t mock_obj) {
+  // The lowest bits vary little between objects, due to their alignment.
+  return MockObjectRegistryShards()[(mock_obj >> 4) %
+                                    kMockObjectRegistryShards];
+}
+
+MockObjectRegistryShard& RegistryShardOf(const void* mock_obj) {
+  return RegistryShardOf(reinterpret_cast<uintptr_t>(mock_obj));
+}
+
+// Returns the mock methods registered for the given mock object.  Returns
+// a copy, as the caller may verify them, which may destroy other mock
+// objects and thus lock the shards holding them.
+FunctionMockers FunctionMockersOf(const void* mock_obj) {
+  MockObjectRegistryShard& shard = RegistryShardOf(mock_obj);
+  internal::MutexLock l(&shard.mutex);
+  const auto it = shard.states.find(mock_obj);
+  return it == shard.states.end() ? FunctionMockers()
+                                  : it->second.function_mockers;
+}
+
+// Checks the global registry for mock objects that are still alive when
+// the program exits.
 class MockObjectRegistry {
  public:
-  // Maps a mock object (identified by its address) to its state.
-  typedef std::map<const void*, MockObjectState> StateMap;
-
   // This destructor will be called when a program exits, after all
   // tests in it have been run.  By then, there should be no mock
   // object alive.  Therefore we report any living object as test
@@ -486,16 +727,29 @@ class MockObjectRegistry {
   ~MockObjectRegistry() {
     if (!GMOCK_FLAG_GET(catch_leaked_mocks)) return;
 
-    int leaked_count = 0;
-    for (StateMap::const_iterator it = states_.begin(); it != states_.end();
-         ++it) {
-      if (it->second.leakable)  // The user said it's fine to leak this object.
-        continue;
+    // The leaked objects are reported by address, regardless of the
+    // shards they are in.
+    std::vector<std::pair<const void*, const MockObjectState*>> leaked;
+    for (size_t i = 0; i < kMockObjectRegistryShards; ++i) {
+      MockObjectRegistryShard& shard = MockObjectRegistryShards()[i];
+      internal::MutexLock l(&shard.mutex);
+      for (const auto& entry : shard.states) {
+        // The user said it's fine to leak this object.
+        if (entry.second.leakable) continue;
+        leaked.emplace_back(entry.first, &entry.second);
+      }
+    }
+    std::sort(leaked.begin(), leaked.end(),
+              [](const std::pair<const void*, const MockObjectState*>& a,
+                 const std::pair<const void*, const MockObjectState*>& b) {
+                return std::less<const void*>()(a.first, b.first);
+              });
 
+    for (const auto& entry : leaked) {
       // FIXME: Print the type of the leaked object.
       // This can help the user identify the leaked object.
       std::cout << "\n";
-      const MockObjectState& state = it->second;
+      const MockObjectState& state = *entry.second;
       std::cout << internal::FormatFileLocation(state.first_used_file,
                                                 state.first_used_line);
       std::cout << " ERROR: this mock object";
@@ -504,9 +758,9 @@ class MockObjectRegistry {
                   << state.first_used_test << ")";
       }
       std::cout << " should be deleted but never is. Its address is @"
-                << it->first << ".";
-      leaked_count++;
+                << entry.first << ".";
     }
+    const size_t leaked_count = leaked.size();
     if (leaked_count > 0) {
       std::cout << "\nERROR: " << leaked_count << " leaked mock "
                 << (leaked_count == 1 ? "object" : "objects")
@@ -530,31 +784,19 @@ class MockObjectRegistry {
 #endif
     }
   }
-
-  StateMap& states() { return states_; }
-
- private:
-  StateMap states_;
 };
 
-// Protected by g_gmock_mutex.
 MockObjectRegistry g_mock_object_registry;
 
-// Maps a mock object to the reaction Google Mock should have when an
-// uninteresting method is called.  Protected by g_gmock_mutex.
-std::unordered_map<uintptr_t, internal::CallReaction>&
-UninterestingCallReactionMap() {
-  static auto* map = new std::unordered_map<uintptr_t, internal::CallReaction>;
-  return *map;
-}
-
 // Sets the reaction Google Mock should have when an uninteresting
 // method of the given mock object is called.
 void SetReactionOnUninterestingCalls(uintptr_t mock_obj,
                                      internal::CallReaction reaction)
     GTEST_LOCK_EXCLUDED_(internal::g_gmock_mutex) {
-  internal::MutexLock l(&internal::g_gmock_mutex);
-  UninterestingCallReactionMap()[mock_obj] = reaction;
+  MockObjectRegistryShard& shard = RegistryShardOf(mock_obj);
+  internal::MutexLock l(&shard.mutex);
+  shard.reactions[mock_obj] = reaction;
+  shard.reaction_generation.fetch_add(1, std::memory_order_release);
 }
 
 }  // namespace
@@ -584,29 +826,110 @@ void Mock::FailUninterestingCalls(uintptr_t mock_obj)
 // entry in the call-reaction table should be removed.
 void Mock::UnregisterCallReaction(uintptr_t mock_obj)
     GTEST_LOCK_EXCLUDED_(internal::g_gmock_mutex) {
-  internal::MutexLock l(&internal::g_gmock_mutex);
-  UninterestingCallReactionMap().erase(static_cast<uintptr_t>(mock_obj));
+  MockObjectRegistryShard& shard = RegistryShardOf(mock_obj);
+  internal::MutexLock l(&shard.mutex);
+  shard.reactions.erase(mock_obj);
+  shard.reaction_generation.fetch_add(1, std::memory_order_release);
+}
+
+// Tells Google Mock to record calls on the given mock object, and to
+// match them against expectations when they are verified.
+void Mock::RecordCalls(uintptr_t mock_obj)
+    GTEST_LOCK_EXCLUDED_(internal::g_gmock_mutex) {
+  MockObjectRegistryShard& shard = RegistryShardOf(mock_obj);
+  internal::MutexLock l(&shard.mutex);
+  shard.spies.insert(mock_obj);
+  shard.reaction_generation.fetch_add(1, std::memory_order_release);
+}
+
+// Tells Google Mock the given mock object is being destroyed and its
+// entry in the table of SpyMocks should be removed.
+void Mock::UnregisterCallRecording(uintptr_t mock_obj)
+    GTEST_LOCK_EXCLUDED_(internal::g_gmock_mutex) {
+  MockObjectRegistryShard& shard = RegistryShardOf(mock_obj);
+  internal::MutexLock l(&shard.mutex);
+  shard.spies.erase(mock_obj);
+  shard.reaction_generation.fetch_add(1, std::memory_order_release);
 }
 
 // Returns the reaction Google Mock will have on uninteresting calls
 // made on the given mock object.
 internal::CallReaction Mock::GetReactionOnUninterestingCalls(
     const void* mock_obj) GTEST_LOCK_EXCLUDED_(internal::g_gmock_mutex) {
-  internal::MutexLock l(&internal::g_gmock_mutex);
-  return (UninterestingCallReactionMap().count(
-              reinterpret_cast<uintptr_t>(mock_obj)) == 0)
+  MockObjectRegistryShard& shard = RegistryShardOf(mock_obj);
+  internal::MutexLock l(&shard.mutex);
+  const auto it = shard.reactions.find(reinterpret_cast<uintptr_t>(mock_obj));
+  return it == shard.reactions.end()
              ? internal::intToCallReaction(
                    GMOCK_FLAG_GET(default_mock_behavior))
-             : UninterestingCallReactionMap()[reinterpret_cast<uintptr_t>(
-                   mock_obj)];
+             : it->second;
+}
+
+namespace internal {
+
+namespace {
+
+// Bits of the state of a mock object cached by function mockers, below
+// its generation.
+constexpr uint64_t kReactionBits = 3;
+constexpr uint64_t kRecordsCallsBit = 4;
+constexpr int kGenerationShift = 3;
+
+// The reaction bits when no reaction is set for the mock object, and the
+// --gmock_default_mock_behavior flag decides.
+constexpr uint64_t kUseFlag = 3;
+
+}  // namespace
+
+// Returns the state of the mock object this mock method belongs to, as
+// cached in cached_reaction_: its generation shifted left by 3 bits, plus
+// kRecordsCallsBit if it's a SpyMock, plus its reaction on uninteresting
+// calls or kUseFlag.
+uint64_t UntypedFunctionMockerBase::CachedMockObjectState() const
+    GTEST_LOCK_EXCLUDED_(g_gmock_mutex) {
+  const uintptr_t mock_obj = reinterpret_cast<uintptr_t>(MockObject());
+  MockObjectRegistryShard& shard = RegistryShardOf(mock_obj);
+  uint64_t cached = cached_reaction_.load(std::memory_order_relaxed);
+  if (cached >> kGenerationShift !=
+      shard.reaction_generation.load(std::memory_order_acquire)) {
+    MutexLock l(&shard.mutex);
+    const auto it = shard.reactions.find(mock_obj);
+    cached = shard.reaction_generation.load(std::memory_order_relaxed)
+                 << kGenerationShift |
+             (shard.spies.count(mock_obj) != 0 ? kRecordsCallsBit : 0) |
+             (it == shard.reactions.end() ? kUseFlag
+                                          : static_cast<uint64_t>(it->second));
+    cached_reaction_.store(cached, std::memory_order_relaxed);
+  }
+  return cached;
+}
+
+// Returns the reaction on uninteresting calls made on the mock object
+// this mock method belongs to.
+CallReaction UntypedFunctionMockerBase::ReactionOnUninterestingCalls() const
+    GTEST_LOCK_EXCLUDED_(g_gmock_mutex) {
+  const uint64_t reaction = CachedMockObjectState() & kReactionBits;
+  return reaction == kUseFlag
+             ? intToCallReaction(GMOCK_FLAG_GET(default_mock_behavior))
+             : static_cast<CallReaction>(reaction);
+}
+
+// Returns true if and only if the mock object this mock method belongs
+// to records calls.
+bool UntypedFunctionMockerBase::RecordsCalls() const
+    GTEST_LOCK_EXCLUDED_(g_gmock_mutex) {
+  return (CachedMockObjectState() & kRecordsCallsBit) != 0;
 }
 
+}  // namespace internal
+
 // Tells Google Mock to ignore mock_obj when checking for leaked mock
 // objects.
 void Mock::AllowLeak(const void* mock_obj)
     GTEST_LOCK_EXCLUDED_(internal::g_gmock_mutex) {
-  internal::MutexLock l(&internal::g_gmock_mutex);
-  g_mock_object_registry.states()[mock_obj].leakable = true;
+  MockObjectRegistryShard& shard = RegistryShardOf(mock_obj);
+  internal::MutexLock l(&shard.mutex);
+  shard.states[mock_obj].leakable = true;
 }
 
 // Verifies and clears all expectations on the given mock object.  If
@@ -614,6 +937,8 @@ void Mock::AllowLeak(const void* mock_obj)
 // Test non-fatal failures and returns false.
 bool Mock::VerifyAndClearExpectations(void* mock_obj)
     GTEST_LOCK_EXCLUDED_(internal::g_gmock_mutex) {
+  // Calls recorded by SpyMocks count toward the expectations.
+  if (internal::HasUnreplayedCalls()) internal::ReplayRecordedCalls();
   internal::MutexLock l(&internal::g_gmock_mutex);
   return VerifyAndClearExpectationsLocked(mock_obj);
 }
@@ -623,6 +948,7 @@ bool Mock::VerifyAndClearExpectations(void* mock_obj)
 // verification was successful.
 bool Mock::VerifyAndClear(void* mock_obj)
     GTEST_LOCK_EXCLUDED_(internal::g_gmock_mutex) {
+  if (internal::HasUnreplayedCalls()) internal::ReplayRecordedCalls();
   internal::MutexLock l(&internal::g_gmock_mutex);
   ClearDefaultActionsLocked(mock_obj);
   return VerifyAndClearExpectationsLocked(mock_obj);
@@ -634,25 +960,17 @@ bool Mock::VerifyAndClear(void* mock_obj)
 bool Mock::VerifyAndClearExpectationsLocked(void* mock_obj)
     GTEST_EXCLUSIVE_LOCK_REQUIRED_(internal::g_gmock_mutex) {
   internal::g_gmock_mutex.AssertHeld();
-  if (g_mock_object_registry.states().count(mock_obj) == 0) {
-    // No EXPECT_CALL() was set on the given mock object.
-    return true;
-  }
 
   // Verifies and clears the expectations on each mock method in the
-  // given mock object.
+  // given mock object, if any EXPECT_CALL() was set on it.
   bool expectations_met = true;
-  FunctionMockers& mockers =
-      g_mock_object_registry.states()[mock_obj].function_mockers;
+  const FunctionMockers mockers = FunctionMockersOf(mock_obj);
   for (FunctionMockers::const_iterator it = mockers.begin();
        it != mockers.end(); ++it) {
     if (!(*it)->VerifyAndClearExpectationsLocked()) {
       expectations_met = false;
     }
   }
-
-  // We don't clear the content of mockers, as they may still be
-  // needed by ClearDefaultActionsLocked().
   return expectations_met;
 }
 
@@ -668,13 +986,20 @@ bool Mock::IsStrict(void* mock_obj)
     GTEST_LOCK_EXCLUDED_(internal::g_gmock_mutex) {
   return Mock::GetReactionOnUninterestingCalls(mock_obj) == internal::kFail;
 }
+bool Mock::IsSpy(void* mock_obj)
+    GTEST_LOCK_EXCLUDED_(internal::g_gmock_mutex) {
+  MockObjectRegistryShard& shard = RegistryShardOf(mock_obj);
+  internal::MutexLock l(&shard.mutex);
+  return shard.spies.count(reinterpret_cast<uintptr_t>(mock_obj)) != 0;
+}
 
 // Registers a mock object and a mock method it owns.
 void Mock::Register(const void* mock_obj,
                     internal::UntypedFunctionMockerBase* mocker)
     GTEST_LOCK_EXCLUDED_(internal::g_gmock_mutex) {
-  internal::MutexLock l(&internal::g_gmock_mutex);
-  g_mock_object_registry.states()[mock_obj].function_mockers.insert(mocker);
+  MockObjectRegistryShard& shard = RegistryShardOf(mock_obj);
+  internal::MutexLock l(&shard.mutex);
+  shard.states[mock_obj].function_mockers.insert(mocker);
 }
 
 // Tells Google Mock where in the source code mock_obj is used in an
@@ -683,8 +1008,9 @@ void Mock::Register(const void* mock_obj,
 void Mock::RegisterUseByOnCallOrExpectCall(const void* mock_obj,
                                            const char* file, int line)
     GTEST_LOCK_EXCLUDED_(internal::g_gmock_mutex) {
-  internal::MutexLock l(&internal::g_gmock_mutex);
-  MockObjectState& state = g_mock_object_registry.states()[mock_obj];
+  MockObjectRegistryShard& shard = RegistryShardOf(mock_obj);
+  internal::MutexLock l(&shard.mutex);
+  MockObjectState& state = shard.states[mock_obj];
   if (state.first_used_file == nullptr) {
     state.first_used_file = file;
     state.first_used_line = line;
@@ -697,24 +1023,21 @@ void Mock::RegisterUseByOnCallOrExpectCall(const void* mock_obj,
   }
 }
 
-// Unregisters a mock method; removes the owning mock object from the
-// registry when the last mock method associated with it has been
-// unregistered.  This is called only in the destructor of
-// FunctionMockerBase.
-void Mock::UnregisterLocked(internal::UntypedFunctionMockerBase* mocker)
-    GTEST_EXCLUSIVE_LOCK_REQUIRED_(internal::g_gmock_mutex) {
-  internal::g_gmock_mutex.AssertHeld();
-  for (MockObjectRegistry::StateMap::iterator it =
-           g_mock_object_registry.states().begin();
-       it != g_mock_object_registry.states().end(); ++it) {
-    FunctionMockers& mockers = it->second.function_mockers;
-    if (mockers.erase(mocker) > 0) {
-      // mocker was in mockers and has been just removed.
-      if (mockers.empty()) {
-        g_mock_object_registry.states().erase(it);
-      }
-      return;
-    }
+// Unregisters a mock method of the given mock object; removes the mock
+// object from the registry when the last mock method associated with it
+// has been unregistered.  This is called only in the destructor of
+// FunctionMocker.
+void Mock::Unregister(const void* mock_obj,
+                      internal::UntypedFunctionMockerBase* mocker)
+    GTEST_LOCK_EXCLUDED_(internal::g_gmock_mutex) {
+  MockObjectRegistryShard& shard = RegistryShardOf(mock_obj);
+  internal::MutexLock l(&shard.mutex);
+  const auto it = shard.states.find(mock_obj);
+  if (it == shard.states.end()) return;
+  FunctionMockers& mockers = it->second.function_mockers;
+  if (mockers.erase(mocker) > 0 && mockers.empty()) {
+    // mocker was the last mock method of the object.
+    shard.states.erase(it);
   }
 }
 
@@ -723,22 +1046,13 @@ void Mock::ClearDefaultActionsLocked(void* mock_obj)
     GTEST_EXCLUSIVE_LOCK_REQUIRED_(internal::g_gmock_mutex) {
   internal::g_gmock_mutex.AssertHeld();
 
-  if (g_mock_object_registry.states().count(mock_obj) == 0) {
-    // No ON_CALL() was set on the given mock object.
-    return;
-  }
-
   // Clears the default actions for each mock method in the given mock
-  // object.
-  FunctionMockers& mockers =
-      g_mock_object_registry.states()[mock_obj].function_mockers;
+  // object, if any ON_CALL() was set on it.
+  const FunctionMockers mockers = FunctionMockersOf(mock_obj);
   for (FunctionMockers::const_iterator it = mockers.begin();
        it != mockers.end(); ++it) {
     (*it)->ClearDefaultActionsLocked();
   }
-
-  // We don't clear the content of mockers, as they may still be
-  // needed by VerifyAndClearExpectationsLocked().
 }
 
 Expectation::Expectation() {}
@@ -753,8 +1067,7 @@ Expectation::~Expectation() {}
 void Sequence::AddExpectation(const Expectation& expectation) const {
   if (*last_expectation_ != expectation) {
     if (last_expectation_->expectation_base() != nullptr) {
-      expectation.expectation_base()->immediate_prerequisites_ +=
-          *last_expectation_;
+      expectation.expectation_base()->AddPrerequisite(*last_expectation_);
     }
     *last_expectation_ = expectation;
   }
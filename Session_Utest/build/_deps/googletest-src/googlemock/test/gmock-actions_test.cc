@@ -574,6 +574,22 @@ TEST(ActionTest, IsCopyable) {
   EXPECT_EQ(0, a2.Perform(std::make_tuple(false, 1)));
 }
 
+// Tests that an Action<F> can be performed in place only if performing
+// a copy of it would have the same effect.
+TEST(ActionTest, CanPerformInPlaceIfCallsCantChangeItsState) {
+  EXPECT_TRUE(Action<MyGlobalFunction>(new MyActionImpl).CanPerformInPlace());
+  EXPECT_TRUE(Action<int()>(Return(1)).CanPerformInPlace());
+  EXPECT_TRUE(Action<int(int)>([](int n) { return n; }).CanPerformInPlace());
+  const std::string name = "name";
+  EXPECT_TRUE(
+      Action<size_t()>([name] { return name.size(); }).CanPerformInPlace());
+
+  EXPECT_FALSE(
+      Action<int()>([n = 0]() mutable { return ++n; }).CanPerformInPlace());
+  EXPECT_FALSE(Action<int()>(std::function<int()>([] { return 1; }))
+                   .CanPerformInPlace());
+}
+
 // Tests that an Action<From> object can be converted to a
 // compatible Action<To> object.
 
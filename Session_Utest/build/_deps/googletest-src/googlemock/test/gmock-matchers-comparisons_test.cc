@@ -834,6 +834,34 @@ TEST(EqTest, IsPolymorphic) {
   EXPECT_FALSE(m2.Matches('a'));
 }
 
+// Tests that a matcher exposes the value it compares with only if it's
+// Eq(value) with a value of the argument type.
+TEST(EqTest, ExposesEqualOperandOfArgumentType) {
+  Matcher<int> m1 = Eq(5);
+  ASSERT_NE(nullptr, m1.GetEqualOperand());
+  EXPECT_EQ(5, *m1.GetEqualOperand());
+
+  Matcher<int> m2 = 6;
+  ASSERT_NE(nullptr, m2.GetEqualOperand());
+  EXPECT_EQ(6, *m2.GetEqualOperand());
+
+  Matcher<const std::string&> m3 = "hi";
+  ASSERT_NE(nullptr, m3.GetEqualOperand());
+  EXPECT_EQ("hi", *m3.GetEqualOperand());
+
+  Matcher<char> m4 = Eq(1);  // Compares with an int.
+  EXPECT_EQ(nullptr, m4.GetEqualOperand());
+
+  Matcher<int> m5 = Ne(5);
+  EXPECT_EQ(nullptr, m5.GetEqualOperand());
+
+  Matcher<int> m6 = _;
+  EXPECT_EQ(nullptr, m6.GetEqualOperand());
+
+  Matcher<int> m7;
+  EXPECT_EQ(nullptr, m7.GetEqualOperand());
+}
+
 // Tests that TypedEq<T>(v) matches values of type T that's equal to v.
 TEST(TypedEqTest, ChecksEqualityForGivenType) {
   Matcher<char> m1 = TypedEq<char>('a');
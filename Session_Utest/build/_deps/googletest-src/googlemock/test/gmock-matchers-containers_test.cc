@@ -1907,6 +1907,47 @@ TEST(UnorderedElementsAreArrayTest, WorksWithMoveOnly) {
   helper.Call(MakeUniquePtrs({2, 1}));
 }
 
+// Tests that matching values by hash, which the matchers do when they are
+// all Eq() matchers and the result needn't be explained, agrees with
+// matching each element against each matcher.
+TEST(UnorderedElementsAreArrayTest, MatchingByHashAgreesWithExplanation) {
+  std::vector<std::vector<int>> vectors = {{}};
+  for (size_t i = 0; i < vectors.size() && vectors[i].size() < 3; ++i) {
+    for (int value = 0; value < 3; ++value) {
+      vectors.push_back(vectors[i]);
+      vectors.back().push_back(value);
+    }
+  }
+
+  for (const std::vector<int>& actual : vectors) {
+    for (const std::vector<int>& expected : vectors) {
+      const Matcher<const std::vector<int>&> matchers[] = {
+          UnorderedElementsAreArray(expected), IsSupersetOf(expected),
+          IsSubsetOf(expected)};
+      for (const auto& m : matchers) {
+        StringMatchResultListener listener;
+        EXPECT_EQ(m.MatchAndExplain(actual, &listener), m.Matches(actual))
+            << "actual: " << PrintToString(actual)
+            << ", matcher: " << Describe(m);
+      }
+    }
+  }
+}
+
+TEST(UnorderedElementsAreArrayTest, WorksForLargeContainers) {
+  std::vector<std::string> expected;
+  for (int i = 0; i < 10000; ++i) {
+    expected.push_back(std::to_string(i % 100));
+  }
+  std::vector<std::string> actual(expected.rbegin(), expected.rend());
+  EXPECT_THAT(actual, UnorderedElementsAreArray(expected));
+  EXPECT_THAT(actual, IsSupersetOf(expected));
+
+  actual.back() = "different";
+  EXPECT_THAT(actual, Not(UnorderedElementsAreArray(expected)));
+  EXPECT_THAT(actual, Not(IsSubsetOf(expected)));
+}
+
 class UnorderedElementsAreTest : public testing::Test {
  protected:
   typedef std::vector<int> IntVec;
@@ -2358,6 +2399,64 @@ TEST(PointwiseTest, WorksWithMoveOnly) {
   helper.Call(MakeUniquePtrs({1, 2}));
 }
 
+// Arrays of numbers are matched in bulk, lists aren't; the results and the
+// explanations must not differ.
+template <typename M, typename T>
+void ExpectSameResultForArrayAndList(const M& m, const std::vector<T>& lhs) {
+  const std::list<T> lhs_list(lhs.begin(), lhs.end());
+  StringMatchResultListener array_listener, list_listener;
+  EXPECT_EQ(ExplainMatchResult(m, lhs_list, &list_listener),
+            ExplainMatchResult(m, lhs, &array_listener));
+  EXPECT_EQ(list_listener.str(), array_listener.str());
+}
+
+TEST(PointwiseTest, MatchesArraysOfNumbersLikeOtherContainers) {
+  const double kNan = std::numeric_limits<double>::quiet_NaN();
+  const double kInf = std::numeric_limits<double>::infinity();
+  std::vector<double> rhs;
+  for (int i = 0; i < 200; ++i) rhs.push_back(i / 7.0 - 10);
+  rhs[100] = kNan;
+  rhs[101] = kInf;
+  rhs[102] = 0.0;
+
+  for (size_t pos : {0, 63, 64, 100, 101, 102, 199}) {
+    const double value = rhs[pos];
+    for (double actual :
+         {value, std::nextafter(value, kInf), value + 1e-10, value + 0.01,
+          value + 1, -value, kNan, kInf}) {
+      std::vector<double> lhs = rhs;
+      lhs[pos] = actual;
+      ExpectSameResultForArrayAndList(Pointwise(Eq(), rhs), lhs);
+      ExpectSameResultForArrayAndList(Pointwise(Le(), rhs), lhs);
+      ExpectSameResultForArrayAndList(Pointwise(DoubleEq(), rhs), lhs);
+      ExpectSameResultForArrayAndList(Pointwise(NanSensitiveDoubleEq(), rhs),
+                                      lhs);
+      ExpectSameResultForArrayAndList(Pointwise(DoubleNear(0.1), rhs), lhs);
+      ExpectSameResultForArrayAndList(
+          Pointwise(NanSensitiveDoubleNear(0.1), rhs), lhs);
+      ExpectSameResultForArrayAndList(Pointwise(DoubleNear(0.0), rhs), lhs);
+    }
+  }
+}
+
+TEST(PointwiseTest, MatchesArraysOfFloats) {
+  std::vector<float> rhs(1000, 0.5f);
+  std::vector<float> lhs = rhs;
+  EXPECT_THAT(lhs, Pointwise(FloatEq(), rhs));
+  EXPECT_THAT(lhs, Pointwise(FloatNear(0.0f), rhs));
+
+  lhs[999] = std::nextafter(0.5f, 1.0f);
+  EXPECT_THAT(lhs, Pointwise(FloatEq(), rhs));
+  EXPECT_THAT(lhs, Not(Pointwise(FloatNear(0.0f), rhs)));
+  EXPECT_THAT(lhs, Not(Pointwise(Eq(), rhs)));
+
+  lhs[700] = 0.75f;
+  EXPECT_EQ(
+      "where the value pair (0.75, 0.5) at index #700 don't match, "
+      "which is -0.25 from 0.75",
+      Explain(Pointwise(FloatNear(0.1f), rhs), lhs));
+}
+
 TEST(UnorderedPointwiseTest, DescribesSelf) {
   vector<int> rhs;
   rhs.push_back(1);
@@ -2969,6 +3068,32 @@ TEST(ElementsAreArrayTest, WorksWithNativeArray) {
   EXPECT_THAT(a, Not(ElementsAreArray(b, 1)));
 }
 
+TEST(ElementsAreArrayTest, MatchesArraysOfNumbersLikeOtherContainers) {
+  std::vector<int> expected;
+  for (int i = 0; i < 200; ++i) expected.push_back(i);
+
+  for (size_t pos : {0, 63, 64, 199}) {
+    std::vector<int> actual = expected;
+    actual[pos] = -1;
+    ExpectSameResultForArrayAndList(ElementsAreArray(expected), actual);
+  }
+  ExpectSameResultForArrayAndList(ElementsAreArray(expected), expected);
+  ExpectSameResultForArrayAndList(
+      ElementsAreArray(expected),
+      std::vector<int>(expected.begin(), expected.end() - 1));
+  std::vector<int> longer = expected;
+  longer.push_back(200);
+  ExpectSameResultForArrayAndList(ElementsAreArray(expected), longer);
+
+  std::vector<Matcher<int>> matchers(expected.begin(), expected.end());
+  matchers[100] = Ge(100);
+  std::vector<int> actual = expected;
+  actual[100] = 99;
+  ExpectSameResultForArrayAndList(ElementsAreArray(matchers), actual);
+  EXPECT_EQ("whose element #100 doesn't match",
+            Explain(ElementsAreArray(matchers), actual));
+}
+
 TEST(ElementsAreArrayTest, SourceLifeSpan) {
   const int a[] = {1, 2, 3};
   vector<int> test_vector(std::begin(a), std::end(a));
@@ -517,6 +517,22 @@ TEST_P(BipartiteTest, Exhaustive) {
 INSTANTIATE_TEST_SUITE_P(AllGraphs, BipartiteTest,
                          ::testing::Range(size_t{0}, size_t{5}));
 
+// Tests a graph where pairing up the last element takes a path through
+// all the others, too long to search recursively.
+TEST_F(BipartiteTest, FindsLongAugmentingPath) {
+  const size_t nodes = 100000;
+  MatchMatrix graph(nodes, nodes);
+  ElementMatcherPairs expected;
+  for (size_t i = 0; i + 1 < nodes; ++i) {
+    graph.SetEdge(i, i, true);
+    graph.SetEdge(i, i + 1, true);
+    expected.push_back(ElementMatcherPair(i, i + 1));
+  }
+  graph.SetEdge(nodes - 1, 0, true);
+  expected.push_back(ElementMatcherPair(nodes - 1, 0));
+  EXPECT_TRUE(internal::FindMaxBipartiteMatching(graph) == expected);
+}
+
 // Parameterized by a pair interpreted as (LhsSize, RhsSize).
 class BipartiteNonSquareTest
     : public ::testing::TestWithParam<std::pair<size_t, size_t>> {};
@@ -29,6 +29,7 @@
 
 #include "gmock/gmock-nice-strict.h"
 
+#include <memory>
 #include <string>
 #include <utility>
 
@@ -55,6 +56,7 @@ namespace gmock_nice_strict_test {
 using testing::HasSubstr;
 using testing::NaggyMock;
 using testing::NiceMock;
+using testing::SpyMock;
 using testing::StrictMock;
 
 #if GTEST_HAS_STREAM_REDIRECTION
@@ -123,6 +125,15 @@ class MockBar {
   MockBar& operator=(const MockBar&) = delete;
 };
 
+class MockLogger {
+ public:
+  MOCK_METHOD(void, Log, (const char* message));
+  MOCK_METHOD(void, Count, (int n, const std::string& name));
+  MOCK_METHOD(void, Name, (std::string name));
+  MOCK_METHOD(void, Watch, (const int& n));
+  MOCK_METHOD(void, Point, (const int* p));
+};
+
 class MockBaz {
  public:
   class MoveOnly {
@@ -537,5 +548,158 @@ TEST(StrictMockTest, IsNaggy_IsNice_IsStrict) {
   EXPECT_TRUE(Mock::IsStrict(&strict_foo));
 }
 
+// Tests that a spy mock matches calls when its expectations are verified.
+TEST(SpyMockTest, MatchesCallsWhenVerified) {
+  SpyMock<MockFoo> spy_foo;
+
+  EXPECT_CALL(spy_foo, DoThat(true)).Times(3);
+  EXPECT_CALL(spy_foo, DoThis());
+  spy_foo.DoThat(true);
+  spy_foo.DoThis();
+  spy_foo.DoThat(true);
+  spy_foo.DoThat(true);
+
+  EXPECT_TRUE(Mock::VerifyAndClearExpectations(&spy_foo));
+}
+
+// Tests that an unexpected call on a spy mock is reported when its
+// expectations are verified, and not when it's made.
+TEST(SpyMockTest, ReportsUnexpectedCallWhenVerified) {
+  SpyMock<MockFoo> spy_foo;
+
+  EXPECT_CALL(spy_foo, DoThat(true)).Times(AnyNumber());
+  spy_foo.DoThat(false);
+  EXPECT_NONFATAL_FAILURE(Mock::VerifyAndClearExpectations(&spy_foo),
+                          "Function call: DoThat(false)");
+}
+
+// Tests that an excessive call on a spy mock is reported when its
+// expectations are verified.
+TEST(SpyMockTest, ReportsExcessiveCallWhenVerified) {
+  SpyMock<MockFoo> spy_foo;
+
+  EXPECT_CALL(spy_foo, DoThis());
+  spy_foo.DoThis();
+  spy_foo.DoThis();
+  EXPECT_NONFATAL_FAILURE(Mock::VerifyAndClearExpectations(&spy_foo),
+                          "called more times than expected");
+}
+
+// Tests that a spy mock verifies calls when it's destroyed.
+TEST(SpyMockTest, ReportsUnexpectedCallWhenDestroyed) {
+  EXPECT_NONFATAL_FAILURE(
+      {
+        SpyMock<MockFoo> spy_foo;
+        EXPECT_CALL(spy_foo, DoThat(true)).Times(AnyNumber());
+        spy_foo.DoThat(false);
+      },
+      "Unexpected mock function call");
+}
+
+// Tests that a spy mock matches calls in the order they were made.
+TEST(SpyMockTest, MatchesCallsInOrder) {
+  SpyMock<MockFoo> spy_foo;
+  {
+    InSequence s;
+    EXPECT_CALL(spy_foo, DoThis());
+    EXPECT_CALL(spy_foo, DoThat(true)).Times(AnyNumber());
+  }
+
+  spy_foo.DoThat(true);
+  spy_foo.DoThis();
+  spy_foo.DoThat(true);
+  EXPECT_NONFATAL_FAILURE(Mock::VerifyAndClearExpectations(&spy_foo),
+                          "Unexpected mock function call");
+}
+
+// Tests that calls recorded before an expectation is set aren't matched
+// against it.
+TEST(SpyMockTest, MatchesCallsAgainstEarlierExpectations) {
+  SpyMock<MockFoo> spy_foo;
+
+  EXPECT_CALL(spy_foo, DoThis());
+  spy_foo.DoThis();
+  EXPECT_CALL(spy_foo, DoThis());
+  spy_foo.DoThis();
+
+  EXPECT_TRUE(Mock::VerifyAndClearExpectations(&spy_foo));
+}
+
+// Tests that a spy mock performs default actions when it's called.
+TEST(SpyMockTest, PerformsDefaultActionsWhenCalled) {
+  SpyMock<MockFoo> spy_foo;
+
+  ON_CALL(spy_foo, DoThat(_)).WillByDefault(Return(2));
+  EXPECT_CALL(spy_foo, DoThat(true));
+  EXPECT_EQ(2, spy_foo.DoThat(true));
+}
+
+// Tests that calls to a mock method of a spy mock are matched when they
+// are made if an expectation on the method has an action.
+TEST(SpyMockTest, MatchesCallsWithExpectedActionsWhenMade) {
+  SpyMock<MockFoo> spy_foo;
+
+  EXPECT_CALL(spy_foo, DoThat(true)).WillOnce(Return(3));
+  EXPECT_EQ(3, spy_foo.DoThat(true));
+  EXPECT_NONFATAL_FAILURE(spy_foo.DoThat(true),
+                          "called more times than expected");
+}
+
+// Tests that a spy mock records copies of strings passed by value, but
+// matches calls taking C strings or references when they are made.
+TEST(SpyMockTest, RecordsStringsPassedByValue) {
+  SpyMock<MockLogger> spy_logger;
+
+  EXPECT_CALL(spy_logger, Name("one")).Times(AnyNumber());
+  spy_logger.Name("two");
+  EXPECT_NONFATAL_FAILURE(Mock::VerifyAndClearExpectations(&spy_logger),
+                          "Function call: Name(\"two\")");
+
+  EXPECT_CALL(spy_logger, Log(HasSubstr("one"))).Times(0);
+  EXPECT_NONFATAL_FAILURE(spy_logger.Log("one"),
+                          "called more times than expected");
+
+  EXPECT_CALL(spy_logger, Count(1, "one")).Times(0);
+  EXPECT_NONFATAL_FAILURE(spy_logger.Count(1, "one"),
+                          "called more times than expected");
+}
+
+// Tests that matchers of arguments passed by reference see the arguments
+// themselves.
+TEST(SpyMockTest, MatchesReferencesWhenCalled) {
+  SpyMock<MockLogger> spy_logger;
+  int n = 1;
+
+  EXPECT_CALL(spy_logger, Watch(Ref(n)));
+  spy_logger.Watch(n);
+  EXPECT_TRUE(Mock::VerifyAndClearExpectations(&spy_logger));
+}
+
+// Tests that matchers of pointer arguments look at the objects while they
+// are still alive.
+TEST(SpyMockTest, MatchesPointersWhenCalled) {
+  SpyMock<MockLogger> spy_logger;
+
+  EXPECT_CALL(spy_logger, Point(Pointee(1)));
+  {
+    std::unique_ptr<int> n(new int(1));
+    spy_logger.Point(n.get());
+  }
+  EXPECT_TRUE(Mock::VerifyAndClearExpectations(&spy_logger));
+}
+
+TEST(SpyMockTest, IsSpy) {
+  SpyMock<MockFoo> spy_foo;
+  EXPECT_TRUE(Mock::IsSpy(&spy_foo));
+  EXPECT_TRUE(Mock::IsNaggy(&spy_foo));
+
+  SpyMock<NiceMock<MockFoo>> nice_spy_foo;
+  EXPECT_TRUE(Mock::IsSpy(&nice_spy_foo));
+  EXPECT_TRUE(Mock::IsNice(&nice_spy_foo));
+
+  MockFoo raw_foo;
+  EXPECT_FALSE(Mock::IsSpy(&raw_foo));
+}
+
 }  // namespace gmock_nice_strict_test
 }  // namespace testing
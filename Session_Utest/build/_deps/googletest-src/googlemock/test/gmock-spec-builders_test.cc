@@ -45,6 +45,21 @@
 #include "gtest/gtest.h"
 #include "gtest/internal/gtest-port.h"
 
+// A key type whose values all have the same hash.
+struct CollidingKey {
+  int value;
+  bool operator==(const CollidingKey& other) const {
+    return value == other.value;
+  }
+};
+
+namespace std {
+template <>
+struct hash<CollidingKey> {
+  size_t operator()(const CollidingKey&) const { return 0; }
+};
+}  // namespace std
+
 namespace testing {
 namespace {
 
@@ -710,6 +725,35 @@ TEST(OnCallTest, PicksLastMatchingOnCall) {
   EXPECT_EQ(2, b.DoB(2));
 }
 
+// Tests that the last matching ON_CALL() action is taken when a mock
+// function has enough ON_CALL()s to look them up by argument value.
+TEST(OnCallTest, PicksLastMatchingOnCallAmongMany) {
+  NiceMock<MockB> b;
+  ON_CALL(b, DoB(Lt(0))).WillByDefault(Return(-1));
+  for (int k = 0; k < 1000; ++k) {
+    ON_CALL(b, DoB(k)).WillByDefault(Return(k));
+  }
+  ON_CALL(b, DoB(Gt(900))).WillByDefault(Return(-2));
+  ON_CALL(b, DoB(950)).WillByDefault(Return(-3));
+
+  for (int k = 0; k <= 900; ++k) {
+    EXPECT_EQ(k, b.DoB(k));
+  }
+  EXPECT_EQ(-1, b.DoB(-5));
+  EXPECT_EQ(-2, b.DoB(901));
+  EXPECT_EQ(-2, b.DoB(5000));
+  EXPECT_EQ(-3, b.DoB(950));
+
+  Mock::VerifyAndClear(&b);
+  for (int k = 0; k < 20; ++k) {
+    ON_CALL(b, DoB(k)).WillByDefault(Return(k + 100));
+  }
+  ON_CALL(b, DoB(2)).With(_).WillByDefault(Return(-4));
+  EXPECT_EQ(103, b.DoB(3));
+  EXPECT_EQ(-4, b.DoB(2));
+  EXPECT_EQ(0, b.DoB(30));
+}
+
 // Tests the semantics of EXPECT_CALL().
 
 // Tests that any call is allowed when no EXPECT_CALL() is specified.
@@ -734,6 +778,107 @@ TEST(ExpectCallTest, PicksLastMatchingExpectCall) {
   EXPECT_EQ(1, b.DoB(1));
 }
 
+// Tests that the last matching EXPECT_CALL() fires when a mock function
+// has enough expectations for calls to look them up by argument value.
+TEST(ExpectCallTest, PicksLastMatchingExpectCallAmongMany) {
+  MockB b;
+  EXPECT_CALL(b, DoB(Lt(0))).WillRepeatedly(Return(-1));
+  for (int k = 0; k < 10000; ++k) {
+    EXPECT_CALL(b, DoB(Eq(k))).WillRepeatedly(Return(k));
+  }
+  EXPECT_CALL(b, DoB(Gt(9000))).WillRepeatedly(Return(-2));
+  EXPECT_CALL(b, DoB(9500)).WillRepeatedly(Return(-3));
+
+  for (int k = 0; k <= 9000; ++k) {
+    EXPECT_EQ(k, b.DoB(k));
+  }
+  EXPECT_EQ(-1, b.DoB(-5));
+  EXPECT_EQ(-2, b.DoB(9001));
+  EXPECT_EQ(-2, b.DoB(20000));
+  EXPECT_EQ(-3, b.DoB(9500));
+}
+
+// Tests that a retired EXPECT_CALL() exposes the older ones matching the
+// same value when a mock function has many expectations.
+TEST(ExpectCallTest, SkipsRetiredExpectCallAmongMany) {
+  MockB b;
+  EXPECT_CALL(b, DoB(7)).WillOnce(Return(1));
+  for (int k = 100; k < 120; ++k) {
+    EXPECT_CALL(b, DoB(k)).Times(AnyNumber());
+  }
+  EXPECT_CALL(b, DoB(7)).WillOnce(Return(2)).RetiresOnSaturation();
+
+  EXPECT_EQ(2, b.DoB(7));
+  EXPECT_EQ(1, b.DoB(7));
+}
+
+// Tests that many retired EXPECT_CALL()s don't handle calls and are still
+// verified.
+TEST(ExpectCallTest, SkipsManyRetiredExpectCalls) {
+  MockB b;
+  EXPECT_CALL(b, DoB(_)).WillRepeatedly(Return(-1));
+  for (int k = 999; k >= 0; --k) {
+    EXPECT_CALL(b, DoB(_)).WillOnce(Return(k)).RetiresOnSaturation();
+  }
+  for (int k = 99; k >= 0; --k) {
+    EXPECT_CALL(b, DoB(7)).WillOnce(Return(k + 1000)).RetiresOnSaturation();
+  }
+
+  for (int k = 0; k < 100; ++k) {
+    EXPECT_EQ(k + 1000, b.DoB(7));
+  }
+  for (int k = 0; k < 1000; ++k) {
+    EXPECT_EQ(k, b.DoB(7));
+  }
+  EXPECT_EQ(-1, b.DoB(7));
+  EXPECT_EQ(-1, b.DoB(8));
+  EXPECT_TRUE(Mock::VerifyAndClearExpectations(&b));
+}
+
+class MockCollidingKey {
+ public:
+  MockCollidingKey() {}
+
+  MOCK_METHOD(int, Get, (CollidingKey key));
+  MOCK_METHOD(int, Get, (CollidingKey key, int n));
+
+ private:
+  MockCollidingKey(const MockCollidingKey&) = delete;
+  MockCollidingKey& operator=(const MockCollidingKey&) = delete;
+};
+
+// Tests that expectations with colliding argument hashes are told apart.
+TEST(ExpectCallTest, PicksMatchingExpectCallWhenHashesCollide) {
+  MockCollidingKey mock;
+  for (int k = 0; k < 50; ++k) {
+    EXPECT_CALL(mock, Get(CollidingKey{k})).WillRepeatedly(Return(k));
+    EXPECT_CALL(mock, Get(CollidingKey{k}, k)).WillRepeatedly(Return(-k));
+  }
+
+  for (int k = 0; k < 50; ++k) {
+    EXPECT_EQ(k, mock.Get(CollidingKey{k}));
+    EXPECT_EQ(-k, mock.Get(CollidingKey{k}, k));
+  }
+}
+
+// Tests that expectations set after the expectations of a mock function
+// are verified and cleared are looked up correctly.
+TEST(ExpectCallTest, PicksLastMatchingExpectCallAfterVerifyAndClear) {
+  MockB b;
+  for (int k = 0; k < 20; ++k) {
+    EXPECT_CALL(b, DoB(k)).WillRepeatedly(Return(k));
+  }
+  EXPECT_EQ(3, b.DoB(3));
+  ASSERT_TRUE(Mock::VerifyAndClearExpectations(&b));
+
+  for (int k = 0; k < 20; ++k) {
+    EXPECT_CALL(b, DoB(k)).WillRepeatedly(Return(k + 100));
+  }
+  EXPECT_CALL(b, DoB(2)).With(_).WillRepeatedly(Return(-1));
+  EXPECT_EQ(103, b.DoB(3));
+  EXPECT_EQ(-1, b.DoB(2));
+}
+
 // Tests lower-bound violation.
 TEST(ExpectCallTest, CatchesTooFewCalls) {
   EXPECT_NONFATAL_FAILURE(
@@ -803,6 +948,17 @@ TEST(ExpectCallTest, InfersCardinality1WhenThereIsWillRepeatedly) {
       "to be called at least once");
 }
 
+// Tests that each call performs a fresh copy of an action that changes its
+// state when performed.
+TEST(ExpectCallTest, PerformsCopyOfStatefulRepeatedAction) {
+  MockB b;
+  EXPECT_CALL(b, DoB()).WillRepeatedly([n = 0]() mutable { return ++n; });
+
+  EXPECT_EQ(1, b.DoB());
+  EXPECT_EQ(1, b.DoB());
+  EXPECT_EQ(1, b.DoB());
+}
+
 #if defined(__cplusplus) && __cplusplus >= 201703L
 
 // It should be possible to return a non-moveable type from a mock action in
@@ -947,6 +1103,30 @@ TEST(UninterestingCallTest, DoesDefaultAction) {
   EXPECT_EQ(0, b.DoB());
 }
 
+#if GTEST_HAS_STREAM_REDIRECTION
+
+// Tests that the reaction on uninteresting calls follows changes of the
+// flag that decides it after the mock function has been called.
+TEST(UninterestingCallTest, FollowsChangesOfDefaultMockBehavior) {
+  const int original_behavior = GMOCK_FLAG_GET(default_mock_behavior);
+  MockA a;
+
+  GMOCK_FLAG_SET(default_mock_behavior, kAllow);
+  CaptureStdout();
+  a.DoA(0);
+  EXPECT_EQ("", GetCapturedStdout());
+
+  GMOCK_FLAG_SET(default_mock_behavior, kWarn);
+  CaptureStdout();
+  a.DoA(0);
+  EXPECT_PRED_FORMAT2(IsSubstring, "Uninteresting mock function call",
+                      GetCapturedStdout());
+
+  GMOCK_FLAG_SET(default_mock_behavior, original_behavior);
+}
+
+#endif  // GTEST_HAS_STREAM_REDIRECTION
+
 // Tests that an unexpected call performs the default action.
 TEST(UnexpectedCallTest, DoesDefaultAction) {
   // When there is an ON_CALL() statement, the action specified by it
@@ -1799,6 +1979,18 @@ TEST(DeletingMockEarlyTest, CanDeleteSelfInActionReturningValue) {
   a->ReturnResult(42);  // This will cause a to be deleted.
 }
 
+// Tests that an action can still use its own state after deleting the
+// mock object that owns it.
+TEST(DeletingMockEarlyTest, ActionOutlivesMockDeletedInIt) {
+  MockA* const a = new MockA;
+  const std::string name = "a name too long for the small buffer";
+  EXPECT_CALL(*a, ReturnInt(_, _)).WillRepeatedly([a, name](int x, int) {
+    delete a;
+    return x + static_cast<int>(name.size());
+  });
+  EXPECT_EQ(1 + static_cast<int>(name.size()), a->ReturnInt(1, 2));
+}
+
 // Tests that calls that violate the original spec yield failures.
 TEST(DeletingMockEarlyTest, Failure1) {
   MockB* const b1 = new MockB;
@@ -0,0 +1,246 @@
+// Copyright 2026, Google LLC.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+//
+// Measures the throughput of expected mock function calls that aren't
+// logged, the common case in tests, for void and value-returning methods.
+//
+// GTEST_MOCK_CALL_BENCHMARK_ITERATIONS overrides the number of calls made
+// by each benchmark.
+
+#include <stdio.h>
+
+#include <chrono>  // NOLINT
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace {
+
+using ::testing::_;
+using ::testing::AnyNumber;
+using ::testing::NiceMock;
+using ::testing::Return;
+using ::testing::ReturnRef;
+using ::testing::SpyMock;
+
+class MockFoo {
+ public:
+  MOCK_METHOD(void, Notify, (int n));
+  MOCK_METHOD(int, Get, (int n));
+  MOCK_METHOD(const std::string&, Name, ());
+};
+
+int Iterations() {
+  return static_cast<int>(::testing::internal::Int32FromGTestEnv(
+      "mock_call_benchmark_iterations", 1000000));
+}
+
+void Report(const char* benchmark, int iterations,
+            std::chrono::steady_clock::duration elapsed) {
+  const double total_ms =
+      std::chrono::duration<double, std::milli>(elapsed).count();
+  printf("%-24s %10d calls %10.1f ms %8.1f ns/call\n", benchmark, iterations,
+         total_ms, total_ms * 1e6 / iterations);
+  fflush(stdout);
+}
+
+TEST(MockCallBenchmark, VoidMethod) {
+  MockFoo foo;
+  EXPECT_CALL(foo, Notify(_)).Times(AnyNumber());
+  const int iterations = Iterations();
+  const auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < iterations; ++i) {
+    foo.Notify(i);
+  }
+  Report("VoidMethod", iterations, std::chrono::steady_clock::now() - start);
+}
+
+TEST(MockCallBenchmark, IntMethod) {
+  MockFoo foo;
+  EXPECT_CALL(foo, Get(_)).WillRepeatedly(Return(1));
+  const int iterations = Iterations();
+  int sum = 0;
+  const auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < iterations; ++i) {
+    sum += foo.Get(i);
+  }
+  Report("IntMethod", iterations, std::chrono::steady_clock::now() - start);
+  EXPECT_EQ(iterations, sum);
+}
+
+TEST(MockCallBenchmark, IntMethodWithDefaultAction) {
+  MockFoo foo;
+  EXPECT_CALL(foo, Get(_)).Times(AnyNumber());
+  const int iterations = Iterations();
+  int sum = 0;
+  const auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < iterations; ++i) {
+    sum += foo.Get(i);
+  }
+  Report("IntMethodWithDefault", iterations,
+         std::chrono::steady_clock::now() - start);
+  EXPECT_EQ(0, sum);
+}
+
+TEST(MockCallBenchmark, ReferenceMethod) {
+  MockFoo foo;
+  const std::string name = "a name too long for the small buffer";
+  EXPECT_CALL(foo, Name()).WillRepeatedly(ReturnRef(name));
+  const int iterations = Iterations();
+  size_t length = 0;
+  const auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < iterations; ++i) {
+    length += foo.Name().size();
+  }
+  Report("ReferenceMethod", iterations,
+         std::chrono::steady_clock::now() - start);
+  EXPECT_EQ(iterations * name.size(), length);
+}
+
+// A lambda capturing enough state that copying it allocates.
+TEST(MockCallBenchmark, InvokeLambda) {
+  MockFoo foo;
+  const std::string name = "a name too long for the small buffer";
+  const int offset = 1;
+  EXPECT_CALL(foo, Get(_)).WillRepeatedly([name, offset](int n) {
+    return n * 0 + offset + static_cast<int>(name.size()) * 0;
+  });
+  const int iterations = Iterations();
+  int sum = 0;
+  const auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < iterations; ++i) {
+    sum += foo.Get(i);
+  }
+  Report("InvokeLambda", iterations, std::chrono::steady_clock::now() - start);
+  EXPECT_EQ(iterations, sum);
+}
+
+// A nice mock used as a stub, with no expectations.
+TEST(MockCallBenchmark, NiceMockStub) {
+  NiceMock<MockFoo> foo;
+  ON_CALL(foo, Get(_)).WillByDefault(Return(1));
+  const int iterations = Iterations();
+  int sum = 0;
+  const auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < iterations; ++i) {
+    sum += foo.Get(i);
+  }
+  Report("NiceMockStub", iterations, std::chrono::steady_clock::now() - start);
+  EXPECT_EQ(iterations, sum);
+}
+
+// A nice mock used as a stub with an ON_CALL for each of many values.
+TEST(MockCallBenchmark, NiceMockTableStub) {
+  NiceMock<MockFoo> foo;
+  for (int i = 0; i < 1000; ++i) {
+    ON_CALL(foo, Get(i)).WillByDefault(Return(1));
+  }
+  const int iterations = Iterations();
+  int sum = 0;
+  const auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < iterations; ++i) {
+    sum += foo.Get(i % 1000);
+  }
+  Report("NiceMockTableStub", iterations,
+         std::chrono::steady_clock::now() - start);
+  EXPECT_EQ(iterations, sum);
+}
+
+// Each call retires one of many expectations, as in long simulations
+// driven by mocks.
+TEST(MockCallBenchmark, RetiringExpectations) {
+  MockFoo foo;
+  const int iterations = Iterations() / 10;
+  for (int i = 0; i < iterations; ++i) {
+    EXPECT_CALL(foo, Get(_)).WillOnce(Return(1)).RetiresOnSaturation();
+  }
+  int sum = 0;
+  const auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < iterations; ++i) {
+    sum += foo.Get(i);
+  }
+  Report("RetiringExpectations", iterations,
+         std::chrono::steady_clock::now() - start);
+  EXPECT_EQ(iterations, sum);
+}
+
+// Like IntMethodWithDefaultAction, but on a spy mock, so that calls are
+// only recorded, and matched against the expectation when it's verified.
+TEST(MockCallBenchmark, SpyMockIntMethod) {
+  SpyMock<MockFoo> foo;
+  EXPECT_CALL(foo, Get(_)).Times(AnyNumber());
+  const int iterations = Iterations();
+  int sum = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < iterations; ++i) {
+    sum += foo.Get(i);
+  }
+  Report("SpyMockIntMethod", iterations,
+         std::chrono::steady_clock::now() - start);
+  EXPECT_EQ(0, sum);
+
+  start = std::chrono::steady_clock::now();
+  EXPECT_TRUE(::testing::Mock::VerifyAndClearExpectations(&foo));
+  Report("SpyMockVerification", iterations,
+         std::chrono::steady_clock::now() - start);
+}
+
+// Creates a mock object, sets an expectation on it, calls it, and
+// destroys it, the given number of times.
+void CreateShortLivedMocks(const char* benchmark, int iterations) {
+  int sum = 0;
+  const auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < iterations; ++i) {
+    MockFoo foo;
+    EXPECT_CALL(foo, Get(i)).WillOnce(Return(1));
+    sum += foo.Get(i);
+  }
+  Report(benchmark, iterations, std::chrono::steady_clock::now() - start);
+  EXPECT_EQ(iterations, sum);
+}
+
+TEST(MockCallBenchmark, ShortLivedMock) {
+  CreateShortLivedMocks("ShortLivedMock", Iterations());
+}
+
+// Like ShortLivedMock, while many other mock objects are alive.
+TEST(MockCallBenchmark, ShortLivedMockAmongMany) {
+  std::vector<std::unique_ptr<NiceMock<MockFoo>>> others;
+  for (int i = 0; i < 1000; ++i) {
+    others.emplace_back(new NiceMock<MockFoo>);
+    ON_CALL(*others.back(), Get(_)).WillByDefault(Return(i));
+  }
+  CreateShortLivedMocks("ShortLivedMockAmongMany", Iterations());
+}
+
+}  // namespace
@@ -0,0 +1,222 @@
+// Copyright 2026, Google LLC.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+//
+// Measures how long container matchers take on large containers.
+//
+// GTEST_MATCHERS_BENCHMARK_ELEMENTS overrides the number of elements in
+// the containers.
+
+#include <stdio.h>
+
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <random>
+#include <string>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace {
+
+using ::testing::AnyOf;
+using ::testing::DoubleEq;
+using ::testing::ElementsAreArray;
+using ::testing::FloatNear;
+using ::testing::IsSupersetOf;
+using ::testing::Matcher;
+using ::testing::Pointwise;
+using ::testing::UnorderedElementsAreArray;
+using ::testing::internal::ElementMatcherPairs;
+using ::testing::internal::FindMaxBipartiteMatching;
+using ::testing::internal::MatchMatrix;
+
+size_t Elements() {
+  return static_cast<size_t>(::testing::internal::Int32FromGTestEnv(
+      "matchers_benchmark_elements", 100000));
+}
+
+void Report(const char* benchmark, size_t elements,
+            std::chrono::steady_clock::duration elapsed) {
+  printf("%-36s %10zu elements %10.1f ms\n", benchmark, elements,
+         std::chrono::duration<double, std::milli>(elapsed).count());
+  fflush(stdout);
+}
+
+// Returns 0, 1, ..., n - 1 in a random order.
+std::vector<size_t> Permutation(size_t n) {
+  std::vector<size_t> permutation(n);
+  for (size_t i = 0; i < n; ++i) permutation[i] = i;
+  std::shuffle(permutation.begin(), permutation.end(), std::mt19937(42));
+  return permutation;
+}
+
+TEST(MatchersBenchmark, UnorderedElementsAreArrayOfInts) {
+  const size_t elements = Elements();
+  std::vector<int> expected;
+  for (size_t i = 0; i < elements; ++i) {
+    expected.push_back(static_cast<int>(i % 1000));
+  }
+  std::vector<int> actual;
+  for (size_t i : Permutation(elements)) actual.push_back(expected[i]);
+
+  const auto start = std::chrono::steady_clock::now();
+  EXPECT_THAT(actual, UnorderedElementsAreArray(expected));
+  Report("UnorderedElementsAreArrayOfInts", elements,
+         std::chrono::steady_clock::now() - start);
+}
+
+TEST(MatchersBenchmark, IsSupersetOfStrings) {
+  const size_t elements = Elements();
+  std::vector<std::string> actual;
+  for (size_t i : Permutation(elements)) {
+    actual.push_back("element " + std::to_string(i));
+  }
+  std::vector<std::string> expected;
+  for (size_t i = 0; i < elements; i += 2) {
+    expected.push_back("element " + std::to_string(i));
+  }
+
+  const auto start = std::chrono::steady_clock::now();
+  EXPECT_THAT(actual, IsSupersetOf(expected));
+  Report("IsSupersetOfStrings", elements,
+         std::chrono::steady_clock::now() - start);
+}
+
+// Matchers other than Eq() are matched against every element, which
+// takes quadratic time, so this uses fewer elements.
+TEST(MatchersBenchmark, UnorderedElementsAreArrayOfMatchers) {
+  const size_t elements = std::min<size_t>(Elements(), 1000);
+  // Element i matches matchers i and i + 1, except for the last, which
+  // matches matcher 0, so that pairing it up takes a path through all
+  // the others.
+  std::vector<Matcher<int>> matchers;
+  std::vector<int> actual;
+  for (size_t i = 0; i < elements; ++i) {
+    const int n = static_cast<int>(i);
+    matchers.push_back(AnyOf(n, n - 1));
+    actual.push_back(i + 1 == elements ? -1 : n);
+  }
+
+  const auto start = std::chrono::steady_clock::now();
+  EXPECT_THAT(actual, UnorderedElementsAreArray(matchers));
+  Report("UnorderedElementsAreArrayOfMatchers", elements,
+         std::chrono::steady_clock::now() - start);
+}
+
+TEST(MatchersBenchmark, PointwiseFloatNear) {
+  const size_t elements = Elements();
+  std::vector<float> expected;
+  for (size_t i = 0; i < elements; ++i) {
+    expected.push_back(static_cast<float>(i % 1000) / 8);
+  }
+  std::vector<float> actual;
+  for (float value : expected) actual.push_back(value + 0.01f);
+
+  const Matcher<const std::vector<float>&> matcher =
+      Pointwise(FloatNear(0.1f), expected);
+  const auto start = std::chrono::steady_clock::now();
+  EXPECT_THAT(actual, matcher);
+  Report("PointwiseFloatNear", elements,
+         std::chrono::steady_clock::now() - start);
+}
+
+TEST(MatchersBenchmark, PointwiseDoubleEq) {
+  const size_t elements = Elements();
+  std::vector<double> expected;
+  for (size_t i = 0; i < elements; ++i) {
+    expected.push_back(static_cast<double>(i % 1000) / 3);
+  }
+  const std::vector<double> actual = expected;
+
+  const Matcher<const std::vector<double>&> matcher =
+      Pointwise(DoubleEq(), expected);
+  const auto start = std::chrono::steady_clock::now();
+  EXPECT_THAT(actual, matcher);
+  Report("PointwiseDoubleEq", elements,
+         std::chrono::steady_clock::now() - start);
+}
+
+TEST(MatchersBenchmark, ElementsAreArrayOfInts) {
+  const size_t elements = Elements();
+  std::vector<int> expected;
+  for (size_t i = 0; i < elements; ++i) {
+    expected.push_back(static_cast<int>(i % 1000));
+  }
+  const std::vector<int> actual = expected;
+
+  const Matcher<const std::vector<int>&> matcher = ElementsAreArray(expected);
+  const auto start = std::chrono::steady_clock::now();
+  EXPECT_THAT(actual, matcher);
+  Report("ElementsAreArrayOfInts", elements,
+         std::chrono::steady_clock::now() - start);
+}
+
+// A graph where the first element to be paired up greedily takes the
+// only matcher of the last one, which then takes a path through all the
+// others.
+TEST(MatchersBenchmark, FindMaxBipartiteMatchingLongPath) {
+  const size_t elements = Elements();
+  MatchMatrix graph(elements, elements);
+  for (size_t i = 0; i + 1 < elements; ++i) {
+    graph.SetEdge(i, i, true);
+    graph.SetEdge(i, i + 1, true);
+  }
+  graph.SetEdge(elements - 1, 0, true);
+
+  const auto start = std::chrono::steady_clock::now();
+  const ElementMatcherPairs matches = FindMaxBipartiteMatching(graph);
+  Report("FindMaxBipartiteMatchingLongPath", elements,
+         std::chrono::steady_clock::now() - start);
+  EXPECT_EQ(elements, matches.size());
+}
+
+// A random graph where each element has a few edges, one of which is in
+// a perfect matching.
+TEST(MatchersBenchmark, FindMaxBipartiteMatchingRandom) {
+  const size_t elements = Elements();
+  const std::vector<size_t> permutation = Permutation(elements);
+  std::mt19937 random(42);
+  MatchMatrix graph(elements, elements);
+  for (size_t i = 0; i < elements; ++i) {
+    graph.SetEdge(i, permutation[i], true);
+    for (int edge = 0; edge < 3; ++edge) {
+      graph.SetEdge(i, random() % elements, true);
+    }
+  }
+
+  const auto start = std::chrono::steady_clock::now();
+  const ElementMatcherPairs matches = FindMaxBipartiteMatching(graph);
+  Report("FindMaxBipartiteMatchingRandom", elements,
+         std::chrono::steady_clock::now() - start);
+  EXPECT_EQ(elements, matches.size());
+}
+
+}  // namespace
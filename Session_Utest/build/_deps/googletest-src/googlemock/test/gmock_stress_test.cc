@@ -30,6 +30,11 @@
 // Tests that Google Mock constructs can be used in a large number of
 // threads concurrently.
 
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <thread>  // NOLINT
+#include <vector>
+
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 
@@ -180,12 +185,44 @@ void TestPartiallyOrderedExpectationsWithThreads(Dummy /* dummy */) {
   foo.Bar(4);
 }
 
+// Tests calling mock objects in multiple threads when expectations on
+// different mock objects are ordered.
+
+void Helper3(MockFoo* foo) {
+  for (int i = 0; i < kRepeat; i++) {
+    EXPECT_EQ(1, foo->Bar(1));
+  }
+}
+
+// This should generate no Google Test failures.
+void TestExpectationsOrderedAcrossMocksWithThreads(Dummy /* dummy */) {
+  MockFoo foo1;
+  MockFoo foo2;
+  const Expectation first = EXPECT_CALL(foo1, Bar(0));
+  EXPECT_CALL(foo1, Bar(1)).Times(kRepeat).WillRepeatedly(Return(1));
+  EXPECT_CALL(foo2, Bar(1))
+      .Times(2 * kRepeat)
+      .After(first)
+      .WillRepeatedly(Return(1));
+
+  foo1.Bar(0);
+
+  ThreadWithParam<MockFoo*>* const t1 =
+      new ThreadWithParam<MockFoo*>(Helper3, &foo1, nullptr);
+  ThreadWithParam<MockFoo*>* const t2 =
+      new ThreadWithParam<MockFoo*>(Helper3, &foo2, nullptr);
+  Helper3(&foo2);
+  JoinAndDelete(t1);
+  JoinAndDelete(t2);
+}
+
 // Tests using Google Mock constructs in many threads concurrently.
 TEST(StressTest, CanUseGMockWithThreads) {
   void (*test_routines[])(Dummy dummy) = {
       &TestConcurrentMockObjects,
       &TestConcurrentCallsOnSameObject,
       &TestPartiallyOrderedExpectationsWithThreads,
+      &TestExpectationsOrderedAcrossMocksWithThreads,
   };
 
   const int kRoutines = sizeof(test_routines) / sizeof(test_routines[0]);
@@ -213,6 +250,187 @@ TEST(StressTest, CanUseGMockWithThreads) {
       << result.total_part_count();
 }
 
+void CallSpyMock(MockFoo* foo) {
+  for (int i = 0; i < kRepeat; i++) {
+    EXPECT_EQ(1, foo->Bar(1));
+  }
+  foo->Bar(2);
+}
+
+// Tests that a spy mock matches the calls recorded on all threads,
+// including those that have exited, when it's verified.
+TEST(StressTest, SpyMockMatchesCallsFromManyThreads) {
+  SpyMock<MockFoo> foo;
+  ON_CALL(foo, Bar(_)).WillByDefault(Return(1));
+  EXPECT_CALL(foo, Bar(1)).Times(kMaxTestThreads * kRepeat);
+  EXPECT_CALL(foo, Bar(2)).Times(kMaxTestThreads);
+
+  std::vector<ThreadWithParam<MockFoo*>*> threads;
+  for (int i = 0; i < kMaxTestThreads; i++) {
+    threads.push_back(
+        new ThreadWithParam<MockFoo*>(CallSpyMock, &foo, nullptr));
+  }
+  for (ThreadWithParam<MockFoo*>* thread : threads) {
+    JoinAndDelete(thread);
+  }
+
+  GTEST_CHECK_(Mock::VerifyAndClearExpectations(&foo));
+  const TestResult& result =
+      *UnitTest::GetInstance()->current_test_info()->result();
+  GTEST_CHECK_(result.total_part_count() == 0)
+      << "Expected no failures, but got " << result.total_part_count();
+}
+
+// A spy mock that a thread keeps calling until it's told to stop.
+struct BusySpyMock {
+  SpyMock<MockFoo> foo;
+  std::atomic<bool> stop{false};
+};
+
+void CallSpyMockUntilStopped(BusySpyMock* busy) {
+  // Bounded, as the calls are kept until they are replayed.
+  for (int i = 0; i < kRepeat * kRepeat * kRepeat && !busy->stop.load();
+       i++) {
+    busy->foo.Bar(1);
+  }
+}
+
+// Tests that a spy mock destroyed while another thread records calls on
+// another spy mock matches all its calls, and that none of its calls is
+// replayed after it's gone.
+TEST(StressTest, SpyMockCanBeDestroyedWhileOthersAreCalled) {
+  BusySpyMock busy;
+  EXPECT_CALL(busy.foo, Bar(1)).Times(AnyNumber());
+  ThreadWithParam<BusySpyMock*> thread(CallSpyMockUntilStopped, &busy,
+                                       nullptr);
+
+  for (int i = 0; i < kRepeat; i++) {
+    SpyMock<MockFoo> foo;
+    EXPECT_CALL(foo, Bar(2)).Times(kRepeat);
+    for (int j = 0; j < kRepeat; j++) foo.Bar(2);
+    std::this_thread::yield();
+  }
+  busy.stop.store(true);
+  thread.Join();
+
+  GTEST_CHECK_(Mock::VerifyAndClearExpectations(&busy.foo));
+  const TestResult& result =
+      *UnitTest::GetInstance()->current_test_info()->result();
+  GTEST_CHECK_(result.total_part_count() == 0)
+      << "Expected no failures, but got " << result.total_part_count();
+}
+
+void CallStatefulAction(MockFoo* foo) {
+  for (int i = 0; i < kRepeat; i++) {
+    EXPECT_EQ(1, foo->Bar(i));
+  }
+}
+
+// Tests that calls made concurrently each perform their own copy of an
+// action that changes its state.
+TEST(StressTest, CallsPerformCopiesOfStatefulActionConcurrently) {
+  MockFoo foo;
+  EXPECT_CALL(foo, Bar(_)).WillRepeatedly([n = 0](int) mutable {
+    return ++n;
+  });
+
+  std::vector<ThreadWithParam<MockFoo*>*> threads;
+  for (int i = 0; i < kMaxTestThreads; i++) {
+    threads.push_back(
+        new ThreadWithParam<MockFoo*>(CallStatefulAction, &foo, nullptr));
+  }
+  for (ThreadWithParam<MockFoo*>* thread : threads) {
+    JoinAndDelete(thread);
+  }
+}
+
+// Creates and destroys mock objects of each kind, which register and
+// unregister themselves and their reaction on uninteresting calls.
+void CreateAndDestroyMocks(Dummy /* dummy */) {
+  for (int i = 0; i < kRepeat; i++) {
+    NiceMock<MockFoo> nice;
+    MockFoo naggy;
+    StrictMock<MockFoo> strict;
+    EXPECT_CALL(naggy, Bar(i)).WillOnce(Return(i));
+    EXPECT_CALL(strict, Bar(i)).WillOnce(Return(i));
+    EXPECT_TRUE(Mock::IsNice(&nice));
+    EXPECT_TRUE(Mock::IsNaggy(&naggy));
+    EXPECT_TRUE(Mock::IsStrict(&strict));
+    EXPECT_EQ(0, nice.Bar(i));
+    EXPECT_EQ(i, naggy.Bar(i));
+    EXPECT_EQ(i, strict.Bar(i));
+  }
+}
+
+// Tests that mock objects can be created and destroyed on many threads
+// concurrently.
+TEST(StressTest, CanCreateAndDestroyMocksOnManyThreads) {
+  std::vector<ThreadWithParam<Dummy>*> threads;
+  for (int i = 0; i < kMaxTestThreads; i++) {
+    threads.push_back(
+        new ThreadWithParam<Dummy>(CreateAndDestroyMocks, Dummy(), nullptr));
+  }
+  for (ThreadWithParam<Dummy>* thread : threads) {
+    JoinAndDelete(thread);
+  }
+
+  const TestResult& result =
+      *UnitTest::GetInstance()->current_test_info()->result();
+  GTEST_CHECK_(result.total_part_count() == 0)
+      << "Expected no failures, but got " << result.total_part_count();
+}
+
+// The maximum number of threads, and the number of calls each of them
+// makes, when measuring how calls to independent mocks scale.
+const int kMaxBenchmarkThreads = 16;
+const int kBenchmarkCalls = 20000;
+
+// Calls a mock object of its own the given number of times.
+void CallIndependentMock(int calls) {
+  MockFoo foo;
+  EXPECT_CALL(foo, Bar(_)).WillRepeatedly(Return(1));
+  int sum = 0;
+  for (int i = 0; i < calls; i++) {
+    sum += foo.Bar(i);
+  }
+  EXPECT_EQ(calls, sum);
+}
+
+// Returns how many mock calls per second the given number of threads
+// make in total when each calls a mock object of its own.
+double IndependentMockCallsPerSecond(int threads) {
+  const auto start = std::chrono::steady_clock::now();
+  std::vector<ThreadWithParam<int>*> workers;
+  for (int i = 0; i < threads; i++) {
+    workers.push_back(
+        new ThreadWithParam<int>(CallIndependentMock, kBenchmarkCalls, nullptr));
+  }
+  for (ThreadWithParam<int>* worker : workers) {
+    JoinAndDelete(worker);
+  }
+  const std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+  return threads * kBenchmarkCalls / elapsed.count();
+}
+
+// Measures how calls to independent mock objects scale with the number
+// of threads making them.  Such calls only lock their own mock
+// function, so the throughput should grow with the number of threads up
+// to the number of cores.  The numbers depend on the machine, so they
+// are only logged.
+TEST(StressTest, CallsToIndependentMocksScaleWithThreads) {
+  const double baseline = IndependentMockCallsPerSecond(1);
+  GTEST_LOG_(INFO) << "1 thread: " << static_cast<int64_t>(baseline)
+                   << " calls/s";
+  for (int threads = 2; threads <= kMaxBenchmarkThreads; threads *= 2) {
+    const double calls_per_second = IndependentMockCallsPerSecond(threads);
+    GTEST_LOG_(INFO) << threads
+                     << " threads: " << static_cast<int64_t>(calls_per_second)
+                     << " calls/s (" << calls_per_second / baseline
+                     << "x of 1 thread)";
+  }
+}
+
 }  // namespace
 }  // namespace testing
 
@@ -257,6 +257,17 @@ struct SharedPayload : SharedPayloadBase {
   T value;
 };
 
+template <typename Rhs>
+class EqMatcher;
+
+// EqualOperand<T, M>::Get(m) returns the value matcher m compares its
+// argument with if m is an EqMatcher<T>, and nullptr otherwise.  The
+// specialization for EqMatcher<T> follows the definition of EqMatcher.
+template <typename T, typename M>
+struct EqualOperand {
+  static const T* Get(const M&) { return nullptr; }
+};
+
 // An internal class for implementing Matcher<T>, which will derive
 // from it.  We put functionalities common to all Matcher<T>
 // specializations here to avoid code duplication.
@@ -302,6 +313,15 @@ class MatcherBase : private MatcherDescriberInterface {
     return vtable_->get_describer(*this);
   }
 
+  // If this matcher is Eq(value) and value has the matcher's argument type
+  // (modulo const and reference), returns a pointer to value, which is
+  // valid as long as this matcher is alive.  Otherwise returns nullptr.
+  // Google Mock uses this to look up expectations by argument value.
+  const GTEST_REMOVE_REFERENCE_AND_CONST_(T) * GetEqualOperand() const {
+    if (vtable_ == nullptr) return nullptr;
+    return vtable_->get_equal_operand(*this);
+  }
+
  protected:
   MatcherBase() : vtable_(nullptr), buffer_() {}
 
@@ -356,6 +376,8 @@ class MatcherBase : private MatcherDescriberInterface {
     // Returns the captured object if it implements the interface, otherwise
     // returns the MatcherBase itself.
     const MatcherDescriberInterface* (*get_describer)(const MatcherBase&);
+    const GTEST_REMOVE_REFERENCE_AND_CONST_(T) * (*get_equal_operand)(
+        const MatcherBase&);
     // Called on shared instances when the reference count reaches 0.
     void (*shared_destroy)(SharedPayloadBase*);
   };
@@ -405,11 +427,19 @@ class MatcherBase : private MatcherDescriberInterface {
             : 0)>(std::make_tuple(&m, &P::Get(m)));
   }
 
+  template <typename P>
+  static const GTEST_REMOVE_REFERENCE_AND_CONST_(T) *
+      GetEqualOperandImpl(const MatcherBase& m) {
+    return EqualOperand<GTEST_REMOVE_REFERENCE_AND_CONST_(T),
+                        typename std::decay<decltype(P::Get(m))>::type>::
+        Get(P::Get(m));
+  }
+
   template <typename P>
   const VTable* GetVTable() {
-    static constexpr VTable kVTable = {&MatchAndExplainImpl<P>,
-                                       &DescribeImpl<P>, &GetDescriberImpl<P>,
-                                       P::shared_destroy};
+    static constexpr VTable kVTable = {
+        &MatchAndExplainImpl<P>, &DescribeImpl<P>, &GetDescriberImpl<P>,
+        &GetEqualOperandImpl<P>, P::shared_destroy};
     return &kVTable;
   }
 
@@ -754,6 +784,9 @@ class ComparisonBase {
     return v;
   }
 
+  template <typename T, typename M>
+  friend struct EqualOperand;
+
   Rhs rhs_;
 };
 
@@ -765,6 +798,11 @@ class EqMatcher : public ComparisonBase<EqMatcher<Rhs>, Rhs, AnyEq> {
   static const char* Desc() { return "is equal to"; }
   static const char* NegatedDesc() { return "isn't equal to"; }
 };
+
+template <typename T>
+struct EqualOperand<T, EqMatcher<T>> {
+  static const T* Get(const EqMatcher<T>& m) { return &m.rhs_; }
+};
 template <typename Rhs>
 class NeMatcher : public ComparisonBase<NeMatcher<Rhs>, Rhs, AnyNe> {
  public:
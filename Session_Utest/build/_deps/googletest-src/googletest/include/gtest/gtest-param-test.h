@@ -407,6 +407,46 @@ internal::CartesianProductHolder<Generator...> Combine(const Generator&... g) {
   return internal::CartesianProductHolder<Generator...>(g...);
 }
 
+// Covering() allows the user to cover every combination of values of any
+// `strength` parameters without running the full Cartesian product that
+// Combine() produces. It returns a sequence of std::tuple's forming a
+// covering array of the given strength over the values of the component
+// generators.
+//
+// Synopsis:
+// Covering(strength, gen1, gen2, ..., genN)
+//   - returns a generator producing sequences with elements coming from
+//     the Cartesian product of elements from the sequences generated by
+//     gen1, gen2, ..., genN, chosen so that every combination of values of
+//     any `strength` of the N generators appears in at least one element.
+//     The sequence is built once with a greedy in-parameter-order strategy
+//     and is usually orders of magnitude shorter than the full product.
+//     When `strength` is at least N, it is the same sequence that
+//     Combine(gen1, gen2, ..., genN) produces.
+// Pairwise(gen1, gen2, ..., genN)
+//   - is the same as Covering(2, gen1, gen2, ..., genN).
+//
+// The sequence is deterministic: the same generators, strength and seed
+// always give the same elements in the same order. The seed defaults to 0
+// and only breaks ties and fills in values that do not matter for coverage;
+// use WithSeed() to explore a different covering array:
+//
+// INSTANTIATE_TEST_SUITE_P(Configurations, ServerTest,
+//                          Pairwise(Bool(), Values(1, 2, 4, 8),
+//                                   Values("tcp", "udp", "unix"),
+//                                   Range(0, 10)).WithSeed(42));
+//
+template <typename... Generator>
+internal::CoveringArrayHolder<Generator...> Covering(int strength,
+                                                     const Generator&... g) {
+  return internal::CoveringArrayHolder<Generator...>(strength, g...);
+}
+
+template <typename... Generator>
+internal::CoveringArrayHolder<Generator...> Pairwise(const Generator&... g) {
+  return internal::CoveringArrayHolder<Generator...>(2, g...);
+}
+
 // ConvertGenerator() wraps a parameter generator in order to cast each prduced
 // value through a known type before supplying it to the test suite
 //
@@ -0,0 +1,216 @@
+// Copyright 2026, Google LLC.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// The Google C++ Testing and Mocking Framework (Google Test)
+//
+// This file defines Pooled<T>, which lets the tests of a test suite reuse
+// objects that are expensive to construct, such as large preallocated
+// buffers or indexes held by a test fixture.
+
+// IWYU pragma: private, include "gtest/gtest.h"
+// IWYU pragma: friend gtest/.*
+// IWYU pragma: friend gmock/.*
+
+#ifndef GOOGLETEST_INCLUDE_GTEST_GTEST_POOLED_H_
+#define GOOGLETEST_INCLUDE_GTEST_GTEST_POOLED_H_
+
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "gtest/internal/gtest-internal.h"
+#include "gtest/internal/gtest-port.h"
+
+GTEST_DECLARE_bool_(check_pooled_reset);
+
+namespace testing {
+
+namespace internal {
+
+// Registers clear as a function that empties an object pool.  All pools
+// are emptied after each test suite has run.
+GTEST_API_ void RegisterObjectPool(void (*clear)());
+
+// Reports a failure of the current test for a pooled object of the given
+// type that Reset() did not return to the state of a newly constructed one.
+GTEST_API_ void ReportPooledObjectNotReset(const std::string& type_name);
+
+// HasResetMethod<T>::value is true if and only if T has a method Reset()
+// that can be called without arguments and returns void.
+template <typename T>
+class HasResetMethod {
+ private:
+  template <typename C>
+  static auto CheckReset(C*) ->
+      typename std::is_same<void, decltype(std::declval<C&>().Reset())>::type;
+  template <typename>
+  static std::false_type CheckReset(...);
+
+ public:
+  static constexpr bool value = decltype(CheckReset<T>(nullptr))::value;
+};
+
+template <typename T>
+constexpr bool HasResetMethod<T>::value;
+
+// IsEqualityComparable<T>::value is true if and only if two const T
+// objects can be compared with ==.
+template <typename T>
+class IsEqualityComparable {
+ private:
+  template <typename C>
+  static auto CheckEqual(C*) -> typename std::is_convertible<
+      decltype(std::declval<const C&>() == std::declval<const C&>()),
+      bool>::type;
+  template <typename>
+  static std::false_type CheckEqual(...);
+
+ public:
+  static constexpr bool value = decltype(CheckEqual<T>(nullptr))::value;
+};
+
+template <typename T>
+constexpr bool IsEqualityComparable<T>::value;
+
+// Holds the T objects that Pooled<T> objects have given back.
+template <typename T>
+class ObjectPool {
+ public:
+  // Takes an object from the pool, or constructs one if the pool is empty.
+  static std::unique_ptr<T> Take() {
+    Pool& pool = Get();
+    {
+      MutexLock lock(&pool.mutex);
+      if (!pool.objects.empty()) {
+        std::unique_ptr<T> object = std::move(pool.objects.back());
+        pool.objects.pop_back();
+        return object;
+      }
+    }
+    return std::unique_ptr<T>(new T());
+  }
+
+  // Resets object and puts it into the pool.  With --gtest_check_pooled_reset
+  // an object that then differs from a newly constructed T is reported and
+  // destroyed instead.
+  static void Give(std::unique_ptr<T> object) {
+    object->Reset();
+    if (GTEST_FLAG_GET(check_pooled_reset) &&
+        !IsReset(*object,
+                 std::integral_constant<bool,
+                                        IsEqualityComparable<T>::value>())) {
+      ReportPooledObjectNotReset(GetTypeName<T>());
+      return;
+    }
+    Pool& pool = Get();
+    MutexLock lock(&pool.mutex);
+    pool.objects.push_back(std::move(object));
+  }
+
+ private:
+  struct Pool {
+    Mutex mutex;
+    std::vector<std::unique_ptr<T>> objects;
+  };
+
+  // The pool is never deleted, so that objects can be given back during
+  // static destruction.
+  static Pool& Get() {
+    static Pool* const pool = Register(new Pool);
+    return *pool;
+  }
+
+  static Pool* Register(Pool* pool) {
+    RegisterObjectPool(&Clear);
+    return pool;
+  }
+
+  // Destroys the pooled objects outside of the lock, as their destructors
+  // may use other pools.
+  static void Clear() {
+    Pool& pool = Get();
+    std::vector<std::unique_ptr<T>> objects;
+    {
+      MutexLock lock(&pool.mutex);
+      objects.swap(pool.objects);
+    }
+  }
+
+  static bool IsReset(const T& object, std::true_type /* comparable */) {
+    return object == T();
+  }
+  static bool IsReset(const T&, std::false_type /* comparable */) {
+    return true;
+  }
+};
+
+}  // namespace internal
+
+// A Pooled<T> holds a T that is reused by the tests of a test suite instead
+// of being constructed and destroyed for each of them.  It is meant to be a
+// member of a test fixture:
+//
+//   class IndexTest : public testing::Test {
+//    protected:
+//     testing::Pooled<Index> index_;  // Index has a void Reset() method.
+//   };
+//
+// Constructing a Pooled<T> takes a T from a pool kept for the type, or
+// default-constructs one if the pool is empty.  Destroying it calls the T's
+// Reset() method, which is required and must bring it back to the state of
+// a newly constructed T, and puts it into the pool.  The pools are emptied
+// after each test suite.  With --gtest_check_pooled_reset, the reset object
+// is compared with a newly constructed T if T has an operator==, and the
+// current test fails if they differ.
+template <typename T>
+class Pooled {
+  static_assert(internal::HasResetMethod<T>::value,
+                "Pooled<T> requires T to have a void Reset() method that "
+                "returns it to the state of a newly constructed T.");
+
+ public:
+  Pooled() : object_(internal::ObjectPool<T>::Take()) {}
+  ~Pooled() { internal::ObjectPool<T>::Give(std::move(object_)); }
+
+  Pooled(const Pooled&) = delete;
+  Pooled& operator=(const Pooled&) = delete;
+
+  T& operator*() const { return *object_; }
+  T* operator->() const { return object_.get(); }
+  T* get() const { return object_.get(); }
+
+ private:
+  std::unique_ptr<T> object_;
+};
+
+}  // namespace testing
+
+#endif  // GOOGLETEST_INCLUDE_GTEST_GTEST_POOLED_H_
@@ -52,6 +52,7 @@
 #include <cstddef>
 #include <limits>
 #include <memory>
+#include <new>
 #include <ostream>
 #include <type_traits>
 #include <vector>
@@ -61,6 +62,7 @@
 #include "gtest/gtest-matchers.h"
 #include "gtest/gtest-message.h"
 #include "gtest/gtest-param-test.h"
+#include "gtest/gtest-pooled.h"
 #include "gtest/gtest-printers.h"
 #include "gtest/gtest-test-part.h"
 #include "gtest/gtest-typed-test.h"
@@ -173,6 +175,7 @@ const int kMaxStackTraceDepth = 100;
 namespace internal {
 
 class AssertHelper;
+class AsyncTestEventForwarder;
 class DefaultGlobalTestPartResultReporter;
 class ExecDeathTest;
 class NoExecDeathTest;
@@ -185,6 +188,8 @@ class TestEventRepeater;
 class UnitTestRecordPropertyTestHelper;
 class WindowsDeathTest;
 class FuchsiaDeathTest;
+class ZygoteDeathTest;
+class ConcurrentDeathTest;
 class UnitTestImpl* GetUnitTestImpl();
 void ReportFailureInUnknownLocation(TestPartResult::Type result_type,
                                     const std::string& message);
@@ -355,6 +360,7 @@ class GTEST_API_ Test {
 };
 
 typedef internal::TimeInMillis TimeInMillis;
+typedef internal::TimeInNanos TimeInNanos;
 
 // A copyable object representing a user specified test property which can be
 // output as a key/value string pair.
@@ -421,7 +427,10 @@ class GTEST_API_ TestResult {
   bool HasNonfatalFailure() const;
 
   // Returns the elapsed time, in milliseconds.
-  TimeInMillis elapsed_time() const { return elapsed_time_; }
+  TimeInMillis elapsed_time() const { return elapsed_time_ns_ / 1000000; }
+
+  // Returns the elapsed time, in nanoseconds.
+  TimeInNanos elapsed_time_ns() const { return elapsed_time_ns_; }
 
   // Gets the time of the test case start, in ms from the start of the
   // UNIX epoch.
@@ -440,11 +449,14 @@ class GTEST_API_ TestResult {
   friend class TestInfo;
   friend class TestSuite;
   friend class UnitTest;
+  friend class internal::AsyncTestEventForwarder;
   friend class internal::DefaultGlobalTestPartResultReporter;
   friend class internal::ExecDeathTest;
   friend class internal::TestResultAccessor;
   friend class internal::UnitTestImpl;
   friend class internal::WindowsDeathTest;
+  friend class internal::ZygoteDeathTest;
+  friend class internal::ConcurrentDeathTest;
   friend class internal::FuchsiaDeathTest;
 
   // Gets the vector of TestPartResults.
@@ -460,8 +472,8 @@ class GTEST_API_ TestResult {
   // Sets the start time.
   void set_start_timestamp(TimeInMillis start) { start_timestamp_ = start; }
 
-  // Sets the elapsed time.
-  void set_elapsed_time(TimeInMillis elapsed) { elapsed_time_ = elapsed; }
+  // Sets the elapsed time, in nanoseconds.
+  void set_elapsed_time_ns(TimeInNanos elapsed) { elapsed_time_ns_ = elapsed; }
 
   // Adds a test property to the list. The property is validated and may add
   // a non-fatal failure if invalid (e.g., if it conflicts with reserved
@@ -505,8 +517,8 @@ class GTEST_API_ TestResult {
   int death_test_count_;
   // The start time, in milliseconds since UNIX Epoch.
   TimeInMillis start_timestamp_;
-  // The elapsed time, in milliseconds.
-  TimeInMillis elapsed_time_;
+  // The elapsed time, in nanoseconds.
+  TimeInNanos elapsed_time_ns_;
 
   // We disallow copying TestResult.
   TestResult(const TestResult&) = delete;
@@ -598,6 +610,7 @@ class GTEST_API_ TestInfo {
 #endif  // GTEST_HAS_DEATH_TEST
   friend class Test;
   friend class TestSuite;
+  friend class internal::AsyncTestEventForwarder;
   friend class internal::UnitTestImpl;
   friend class internal::StreamingListenerTest;
   friend TestInfo* internal::MakeAndRegisterTestInfo(
@@ -730,7 +743,10 @@ class GTEST_API_ TestSuite {
   }
 
   // Returns the elapsed time, in milliseconds.
-  TimeInMillis elapsed_time() const { return elapsed_time_; }
+  TimeInMillis elapsed_time() const { return elapsed_time_ns_ / 1000000; }
+
+  // Returns the elapsed time, in nanoseconds.
+  TimeInNanos elapsed_time_ns() const { return elapsed_time_ns_; }
 
   // Gets the time of the test suite start, in ms from the start of the
   // UNIX epoch.
@@ -746,6 +762,7 @@ class GTEST_API_ TestSuite {
 
  private:
   friend class Test;
+  friend class internal::AsyncTestEventForwarder;
   friend class internal::UnitTestImpl;
 
   // Gets the (mutable) vector of TestInfos in this TestSuite.
@@ -859,8 +876,8 @@ class GTEST_API_ TestSuite {
   bool should_run_;
   // The start time, in milliseconds since UNIX Epoch.
   TimeInMillis start_timestamp_;
-  // Elapsed time, in milliseconds.
-  TimeInMillis elapsed_time_;
+  // Elapsed time, in nanoseconds.
+  TimeInNanos elapsed_time_ns_;
   // Holds test properties recorded during execution of SetUpTestSuite and
   // TearDownTestSuite.
   TestResult ad_hoc_test_result_;
@@ -1023,6 +1040,14 @@ class GTEST_API_ TestEventListeners {
   // the test program finishes).
   void Append(TestEventListener* listener);
 
+  // Like Append, but the listener receives its events on a dedicated
+  // thread, so that a slow listener does not hold up the tests.  Events
+  // about a test or a test suite are delivered in order, with snapshots of
+  // the objects taken when the event happened.  Events about the whole
+  // UnitTest wait for the queued events and are then delivered on the
+  // calling thread.  Behaves like Append where threads are not supported.
+  void AppendAsync(TestEventListener* listener);
+
   // Removes the given event listener from the list and returns it.  It then
   // becomes the caller's responsibility to delete the listener. Returns
   // NULL if the listener is not found in the list.
@@ -1195,6 +1220,9 @@ class GTEST_API_ UnitTest {
   // Gets the elapsed time, in milliseconds.
   TimeInMillis elapsed_time() const;
 
+  // Gets the elapsed time, in nanoseconds.
+  TimeInNanos elapsed_time_ns() const;
+
   // Returns true if and only if the unit test passed (i.e. all test suites
   // passed).
   bool Passed() const;
@@ -2048,10 +2076,11 @@ class GTEST_API_ ScopedTrace {
   // a trace stack maintained by Google Test.
 
   // Template version. Uses Message() to convert the values into strings.
-  // Slow, but flexible.
+  // Slow, but flexible.  Numbers and enums, as in SCOPED_TRACE(i), are
+  // copied and only converted if a failure is reported within the scope.
   template <typename T>
   ScopedTrace(const char* file, int line, const T& message) {
-    PushTrace(file, line, (Message() << message).GetString());
+    PushTrace(file, line, message, IsFormattedLazily<T>());
   }
 
   // Optimize for some known types.
@@ -2070,8 +2099,40 @@ class GTEST_API_ ScopedTrace {
   ~ScopedTrace();
 
  private:
+  // Whether a message of type T is copied into value_ and formatted lazily.
+  template <typename T>
+  using IsFormattedLazily = std::integral_constant<
+      bool, (std::is_arithmetic<T>::value || std::is_enum<T>::value) &&
+                sizeof(T) <= sizeof(long double)>;
+
   void PushTrace(const char* file, int line, std::string message);
 
+  // Pushes a trace whose message is format(value), computed on demand.
+  void PushLazyTrace(const char* file, int line,
+                     std::string (*format)(const void* value),
+                     const void* value);
+
+  template <typename T>
+  void PushTrace(const char* file, int line, const T& message,
+                 std::false_type /* formatted lazily */) {
+    PushTrace(file, line, (Message() << message).GetString());
+  }
+
+  template <typename T>
+  void PushTrace(const char* file, int line, const T& message,
+                 std::true_type /* formatted lazily */) {
+    new (value_) T(message);
+    PushLazyTrace(file, line, &Format<T>, value_);
+  }
+
+  template <typename T>
+  static std::string Format(const void* value) {
+    return (Message() << *static_cast<const T*>(value)).GetString();
+  }
+
+  // A copy of the message while it is formatted lazily.
+  alignas(long double) unsigned char value_[sizeof(long double)];
+
   ScopedTrace(const ScopedTrace&) = delete;
   ScopedTrace& operator=(const ScopedTrace&) = delete;
 } GTEST_ATTRIBUTE_UNUSED_;  // A ScopedTrace object does its job in its
@@ -42,6 +42,8 @@
 #include <stdio.h>
 
 #include <memory>
+#include <ostream>
+#include <string>
 
 #include "gtest/gtest-matchers.h"
 #include "gtest/internal/gtest-internal.h"
@@ -54,6 +56,8 @@ namespace internal {
 // Names of the flags (needed for parsing Google Test flags).
 const char kDeathTestStyleFlag[] = "death_test_style";
 const char kDeathTestUseFork[] = "death_test_use_fork";
+const char kDeathTestUseZygote[] = "death_test_use_zygote";
+const char kDeathTestOutputLimit[] = "death_test_output_limit";
 const char kInternalRunDeathTestFlag[] = "internal_run_death_test";
 
 #if GTEST_HAS_DEATH_TEST
@@ -169,19 +173,42 @@ class DefaultDeathTestFactory : public DeathTestFactory {
 // by a signal, or exited normally with a nonzero exit code.
 GTEST_API_ bool ExitedUnsuccessfully(int exit_status);
 
+// The matcher a regex passed to EXPECT_DEATH (etc.) is turned into.  It
+// behaves exactly like ContainsRegex(), but lets the death test search the
+// output of the child process for the regex while reading it, so that
+// output exceeding --gtest_death_test_output_limit need not be kept.  Its
+// virtual functions are defined in gtest-death-test.cc, so that its vtable
+// carries type information even in code compiled without RTTI.
+class GTEST_API_ DeathTestRegexMatcher
+    : public MatcherInterface<const ::std::string&> {
+ public:
+  explicit DeathTestRegexMatcher(const ::std::string& regex) : regex_(regex) {}
+
+  bool MatchAndExplain(const ::std::string& output,
+                       MatchResultListener* listener) const override;
+  void DescribeTo(::std::ostream* os) const override;
+  void DescribeNegationTo(::std::ostream* os) const override;
+
+  const RE& regex() const { return regex_; }
+
+ private:
+  const RE regex_;
+};
+
 // A string passed to EXPECT_DEATH (etc.) is caught by one of these overloads
 // and interpreted as a regex (rather than an Eq matcher) for legacy
 // compatibility.
 inline Matcher<const ::std::string&> MakeDeathTestMatcher(
     ::testing::internal::RE regex) {
-  return ContainsRegex(regex.pattern());
+  return Matcher<const ::std::string&>(
+      new DeathTestRegexMatcher(regex.pattern()));
 }
 inline Matcher<const ::std::string&> MakeDeathTestMatcher(const char* regex) {
-  return ContainsRegex(regex);
+  return Matcher<const ::std::string&>(new DeathTestRegexMatcher(regex));
 }
 inline Matcher<const ::std::string&> MakeDeathTestMatcher(
     const ::std::string& regex) {
-  return ContainsRegex(regex);
+  return Matcher<const ::std::string&>(new DeathTestRegexMatcher(regex));
 }
 
 // If a Matcher<const ::std::string&> is passed to EXPECT_DEATH (etc.), it's
@@ -298,6 +325,17 @@ class InternalRunDeathTestFlag {
 // the flag is specified; otherwise returns NULL.
 InternalRunDeathTestFlag* ParseInternalRunDeathTestFlag();
 
+// Starts the helper process from which threadsafe-style death tests fork
+// their children if --gtest_death_test_use_zygote is set.  Returns in the
+// calling process and, with the death test flags set, in every death test
+// child forked by that helper.
+void StartDeathTestZygoteIfRequested();
+
+// Kills the threadsafe-style death test children that were started ahead of
+// time (see --gtest_death_test_concurrency) but not used by the test that
+// just finished.
+void DiscardPrefetchedDeathTestChildren();
+
 #endif  // GTEST_HAS_DEATH_TEST
 
 }  // namespace internal
@@ -39,6 +39,7 @@
 #include <ctype.h>
 
 #include <cassert>
+#include <functional>
 #include <iterator>
 #include <memory>
 #include <set>
@@ -447,13 +448,21 @@ class TestMetaFactory
   TestMetaFactory& operator=(const TestMetaFactory&) = delete;
 };
 
+// INTERNAL IMPLEMENTATION - DO NOT USE IN USER CODE.
+//
+// Decides from the names of a test suite and of a test in it whether a
+// value-parameterized test gets registered.
+using ParameterizedTestSelector =
+    std::function<bool(const std::string& test_suite_name,
+                       const std::string& test_name)>;
+
 // INTERNAL IMPLEMENTATION - DO NOT USE IN USER CODE.
 //
 // ParameterizedTestSuiteInfoBase is a generic interface
 // to ParameterizedTestSuiteInfo classes. ParameterizedTestSuiteInfoBase
 // accumulates test information provided by TEST_P macro invocations
 // and generators provided by INSTANTIATE_TEST_SUITE_P macro invocations
-// and uses that information to register all resulting test instances
+// and uses that information to register the resulting test instances
 // in RegisterTests method. The ParameterizeTestSuiteRegistry class holds
 // a collection of pointers to the ParameterizedTestSuiteInfo objects
 // and calls RegisterTests() on each of them when asked.
@@ -467,9 +476,10 @@ class ParameterizedTestSuiteInfoBase {
   virtual TypeId GetTestSuiteTypeId() const = 0;
   // UnitTest class invokes this method to register tests in this
   // test suite right before running them in RUN_ALL_TESTS macro.
-  // This method should not be called more than once on any single
-  // instance of a ParameterizedTestSuiteInfoBase derived class.
-  virtual void RegisterTests() = 0;
+  // Only the tests that is_selected selects are registered; the others
+  // are kept as a name and a parameter value, and a later call registers
+  // those of them that it selects then.
+  virtual void RegisterTests(const ParameterizedTestSelector& is_selected) = 0;
 
  protected:
   ParameterizedTestSuiteInfoBase() {}
@@ -544,10 +554,18 @@ class ParameterizedTestSuiteInfo : public ParameterizedTestSuiteInfoBase {
   }
   // UnitTest class invokes this method to register tests in this test suite
   // right before running tests in RUN_ALL_TESTS macro.
-  // This method should not be called more than once on any single
-  // instance of a ParameterizedTestSuiteInfoBase derived class.
-  // UnitTest has a guard to prevent from calling this method more than once.
-  void RegisterTests() override {
+  // The first call expands the generators, which checks the names of all
+  // tests.  Naming a test takes its parameter value, but printing the
+  // value and creating the TestInfo and the factory of the test are left
+  // until is_selected selects it, which saves their cost for the tests
+  // that a filter excludes.  UnitTest calls this method again when the
+  // filter has changed since the last call.
+  void RegisterTests(const ParameterizedTestSelector& is_selected) override {
+    if (expanded_) {
+      RegisterPendingTests(is_selected);
+      return;
+    }
+    expanded_ = true;
     bool generated_instantiations = false;
 
     for (typename TestInfoContainer::iterator test_it = tests_.begin();
@@ -562,10 +580,10 @@ class ParameterizedTestSuiteInfo : public ParameterizedTestSuiteInfoBase {
         const char* file = gen_it->file;
         int line = gen_it->line;
 
-        std::string test_suite_name;
+        ExpandedTests expanded(test_info.get(), &*gen_it);
         if (!instantiation_name.empty())
-          test_suite_name = instantiation_name + "/";
-        test_suite_name += test_info->test_suite_base_name;
+          expanded.test_suite_name = instantiation_name + "/";
+        expanded.test_suite_name += test_info->test_suite_base_name;
 
         size_t i = 0;
         std::set<std::string> test_param_names;
@@ -593,17 +611,18 @@ class ParameterizedTestSuiteInfo : public ParameterizedTestSuiteInfoBase {
             test_name_stream << test_info->test_base_name << "/";
           }
           test_name_stream << param_name;
-          MakeAndRegisterTestInfo(
-              test_suite_name.c_str(), test_name_stream.GetString().c_str(),
-              nullptr,  // No type parameter.
-              PrintToString(*param_it).c_str(), test_info->code_location,
-              GetTestSuiteTypeId(),
-              SuiteApiResolver<TestSuite>::GetSetUpCaseOrSuite(file, line),
-              SuiteApiResolver<TestSuite>::GetTearDownCaseOrSuite(file, line),
-              test_info->test_meta_factory->CreateTestFactory(*param_it));
+          const std::string test_name = test_name_stream.GetString();
+          if (is_selected(expanded.test_suite_name, test_name)) {
+            RegisterTest(expanded, test_name, *param_it);
+          } else {
+            expanded.pending_tests.emplace_back(test_name, *param_it);
+          }
         }  // for param_it
-      }    // for gen_it
-    }      // for test_it
+        if (!expanded.pending_tests.empty()) {
+          expanded_tests_.push_back(std::move(expanded));
+        }
+      }  // for gen_it
+    }    // for test_it
 
     if (!generated_instantiations) {
       // There are no generaotrs, or they all generate nothing ...
@@ -651,6 +670,50 @@ class ParameterizedTestSuiteInfo : public ParameterizedTestSuiteInfoBase {
     int line;
   };
   typedef ::std::vector<InstantiationInfo> InstantiationContainer;
+  // The tests that a TEST_P pattern and an INSTANTIATE_TEST_SUITE_P
+  // generator expand to, with the name and the parameter value of each
+  // test that has not been registered yet.
+  struct ExpandedTests {
+    ExpandedTests(const TestInfo* test_info_in,
+                  const InstantiationInfo* instantiation_in)
+        : test_info(test_info_in), instantiation(instantiation_in) {}
+
+    const TestInfo* test_info;
+    const InstantiationInfo* instantiation;
+    std::string test_suite_name;
+    std::vector<std::pair<std::string, ParamType>> pending_tests;
+  };
+
+  void RegisterTest(const ExpandedTests& expanded,
+                    const std::string& test_name, const ParamType& param) {
+    const char* file = expanded.instantiation->file;
+    const int line = expanded.instantiation->line;
+    MakeAndRegisterTestInfo(
+        expanded.test_suite_name.c_str(), test_name.c_str(),
+        nullptr,  // No type parameter.
+        PrintToString(param).c_str(), expanded.test_info->code_location,
+        GetTestSuiteTypeId(),
+        SuiteApiResolver<TestSuite>::GetSetUpCaseOrSuite(file, line),
+        SuiteApiResolver<TestSuite>::GetTearDownCaseOrSuite(file, line),
+        expanded.test_info->test_meta_factory->CreateTestFactory(param));
+  }
+
+  // Registers the tests that earlier calls of RegisterTests() left out and
+  // that is_selected selects now.  They are added after the tests of their
+  // test suites that are already registered.
+  void RegisterPendingTests(const ParameterizedTestSelector& is_selected) {
+    for (ExpandedTests& expanded : expanded_tests_) {
+      std::vector<std::pair<std::string, ParamType>> still_pending;
+      for (auto& test : expanded.pending_tests) {
+        if (is_selected(expanded.test_suite_name, test.first)) {
+          RegisterTest(expanded, test.first, test.second);
+        } else {
+          still_pending.push_back(std::move(test));
+        }
+      }
+      expanded.pending_tests.swap(still_pending);
+    }
+  }
 
   static bool IsValidParamName(const std::string& name) {
     // Check for empty string
@@ -668,6 +731,9 @@ class ParameterizedTestSuiteInfo : public ParameterizedTestSuiteInfoBase {
   CodeLocation code_location_;
   TestInfoContainer tests_;
   InstantiationContainer instantiations_;
+  // Whether RegisterTests() has expanded the generators.
+  bool expanded_ = false;
+  std::vector<ExpandedTests> expanded_tests_;
 
   ParameterizedTestSuiteInfo(const ParameterizedTestSuiteInfo&) = delete;
   ParameterizedTestSuiteInfo& operator=(const ParameterizedTestSuiteInfo&) =
@@ -726,9 +792,9 @@ class ParameterizedTestSuiteRegistry {
     }
     return typed_test_info;
   }
-  void RegisterTests() {
+  void RegisterTests(const ParameterizedTestSelector& is_selected) {
     for (auto& test_suite_info : test_suite_infos_) {
-      test_suite_info->RegisterTests();
+      test_suite_info->RegisterTests(is_selected);
     }
   }
 //  Legacy API is deprecated but still available
@@ -950,6 +1016,129 @@ class CartesianProductHolder {
   std::tuple<Gen...> generators_;
 };
 
+// Returns the rows of a covering array of the given strength: a list of
+// rows, each holding one value index per column, such that every
+// combination of values of any `strength` columns appears in at least one
+// row. value_counts[i] is the number of values column i can take. The
+// result is deterministic for a given seed, which only breaks ties and
+// fills in values that don't matter for coverage. When strength is at least
+// the number of columns, the result is the full Cartesian product in the
+// order Combine() produces it. Returns no rows when any column is empty.
+GTEST_API_ std::vector<std::vector<size_t>> BuildCoveringArray(
+    const std::vector<size_t>& value_counts, int strength, uint32_t seed);
+
+template <typename... T>
+class CoveringArrayGenerator
+    : public ParamGeneratorInterface<::std::tuple<T...>> {
+ public:
+  typedef ::std::tuple<T...> ParamType;
+
+  CoveringArrayGenerator(const std::tuple<ParamGenerator<T>...>& g,
+                         int strength, uint32_t seed)
+      : CoveringArrayGenerator(g, strength, seed, Indices()) {}
+  ~CoveringArrayGenerator() override {}
+
+  ParamIteratorInterface<ParamType>* Begin() const override {
+    return new Iterator(this, 0);
+  }
+  ParamIteratorInterface<ParamType>* End() const override {
+    return new Iterator(this, rows_.size());
+  }
+
+ private:
+  using Indices = typename MakeIndexSequence<sizeof...(T)>::type;
+
+  template <size_t... I>
+  CoveringArrayGenerator(const std::tuple<ParamGenerator<T>...>& g,
+                         int strength, uint32_t seed, IndexSequence<I...>)
+      : values_(Materialize(std::get<I>(g))...),
+        rows_(BuildCoveringArray({std::get<I>(values_).size()...}, strength,
+                                 seed)) {}
+
+  template <typename U>
+  static std::vector<U> Materialize(const ParamGenerator<U>& generator) {
+    std::vector<U> values;
+    for (const U& value : generator) values.push_back(value);
+    return values;
+  }
+
+  template <size_t... I>
+  ParamType* MakeValue(size_t row, IndexSequence<I...>) const {
+    return new ParamType(std::get<I>(values_)[rows_[row][I]]...);
+  }
+
+  class Iterator : public ParamIteratorInterface<ParamType> {
+   public:
+    Iterator(const CoveringArrayGenerator* base, size_t row)
+        : base_(base), row_(row) {
+      ComputeCurrentValue();
+    }
+    ~Iterator() override {}
+
+    const ParamGeneratorInterface<ParamType>* BaseGenerator() const override {
+      return base_;
+    }
+    void Advance() override {
+      assert(row_ < base_->rows_.size());
+      ++row_;
+      ComputeCurrentValue();
+    }
+    ParamIteratorInterface<ParamType>* Clone() const override {
+      return new Iterator(*this);
+    }
+    const ParamType* Current() const override { return current_value_.get(); }
+    bool Equals(const ParamIteratorInterface<ParamType>& other) const override {
+      // Having the same base generator guarantees that the other
+      // iterator is of the same type and we can downcast.
+      GTEST_CHECK_(BaseGenerator() == other.BaseGenerator())
+          << "The program attempted to compare iterators "
+          << "from different generators." << std::endl;
+      return row_ == CheckedDowncastToActualType<const Iterator>(&other)->row_;
+    }
+
+   private:
+    void ComputeCurrentValue() {
+      if (row_ < base_->rows_.size())
+        current_value_.reset(base_->MakeValue(row_, Indices()));
+    }
+
+    const CoveringArrayGenerator* const base_;
+    size_t row_;
+    std::shared_ptr<ParamType> current_value_;
+  };
+
+  // The component values are materialized once, so that each test parameter
+  // is built straight from its row instead of by walking the generators.
+  std::tuple<std::vector<T>...> values_;
+  std::vector<std::vector<size_t>> rows_;
+};
+
+template <class... Gen>
+class CoveringArrayHolder {
+ public:
+  CoveringArrayHolder(int strength, const Gen&... g)
+      : strength_(strength), seed_(0), generators_(g...) {}
+
+  // Returns a copy of this holder that uses the given seed to break ties
+  // and fill in unconstrained values.
+  CoveringArrayHolder WithSeed(uint32_t seed) const {
+    CoveringArrayHolder holder(*this);
+    holder.seed_ = seed;
+    return holder;
+  }
+
+  template <typename... T>
+  operator ParamGenerator<::std::tuple<T...>>() const {
+    return ParamGenerator<::std::tuple<T...>>(
+        new CoveringArrayGenerator<T...>(generators_, strength_, seed_));
+  }
+
+ private:
+  int strength_;
+  uint32_t seed_;
+  std::tuple<Gen...> generators_;
+};
+
 template <typename From, typename To>
 class ParamGeneratorConverter : public ParamGeneratorInterface<To> {
  public:
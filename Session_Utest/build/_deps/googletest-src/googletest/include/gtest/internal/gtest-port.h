@@ -76,6 +76,8 @@
 //                              are enabled.
 //   GTEST_HAS_POSIX_RE       - Define it to 1/0 to indicate that POSIX regular
 //                              expressions are/aren't available.
+//   GTEST_HAS_POSIX_SPAWN    - Define it to 1/0 to indicate that
+//                              posix_spawn(3) is/isn't available.
 //   GTEST_HAS_PTHREAD        - Define it to 1/0 to indicate that <pthread.h>
 //                              is/isn't available.
 //   GTEST_HAS_RTTI           - Define it to 1/0 to indicate that RTTI is/isn't
@@ -235,10 +237,14 @@
 //   CaptureStderr()     - starts capturing stderr.
 //   GetCapturedStderr() - stops capturing stderr and returns the captured
 //                         string.
+//   CaptureStderrToFile() - starts capturing stderr into a temporary file.
+//   ConsumeCapturedStderr() - stops capturing stderr and passes the
+//                         captured output to a function piece by piece.
 //
 // Integer types:
 //   TypeWithSize   - maps an integer to a int type.
 //   TimeInMillis   - integers of known sizes.
+//   TimeInNanos    - integers of known sizes.
 //   BiggestInt     - the biggest signed integer type.
 //
 // Command-line utilities:
@@ -264,6 +270,7 @@
 #include <cerrno>
 // #include <condition_variable>  // Guarded by GTEST_IS_THREADSAFE below
 #include <cstdint>
+#include <functional>
 #include <iostream>
 #include <limits>
 #include <locale>
@@ -576,6 +583,21 @@ typedef struct _RTL_CRITICAL_SECTION GTEST_CRITICAL_SECTION;
 
 #endif  // GTEST_HAS_CLONE
 
+// Determines whether to support posix_spawn(3), which death tests prefer
+// over fork(2) and clone(2) as it does not copy the page tables of the
+// test program.
+#ifndef GTEST_HAS_POSIX_SPAWN
+// The user didn't tell us, so we need to figure it out.
+
+#if (GTEST_OS_LINUX && !GTEST_OS_LINUX_ANDROID) || GTEST_OS_MAC || \
+    GTEST_OS_FREEBSD || GTEST_OS_NETBSD || GTEST_OS_OPENBSD
+#define GTEST_HAS_POSIX_SPAWN 1
+#else
+#define GTEST_HAS_POSIX_SPAWN 0
+#endif
+
+#endif  // GTEST_HAS_POSIX_SPAWN
+
 // Determines whether to support stream redirection. This is used to test
 // output correctness and to implement death tests.
 #ifndef GTEST_HAS_STREAM_REDIRECTION
@@ -623,6 +645,27 @@ typedef struct _RTL_CRITICAL_SECTION GTEST_CRITICAL_SECTION;
 #define GTEST_CAN_STREAM_RESULTS_ 1
 #endif
 
+// Determines whether tests can be run in forked child processes, as
+// --gtest_isolation does.
+#if GTEST_HAS_DEATH_TEST && !GTEST_OS_WINDOWS && !GTEST_OS_FUCHSIA
+#define GTEST_CAN_ISOLATE_TESTS_ 1
+#endif
+
+// Determines whether buffered console output can be written from a handler
+// for the signals that terminate the program, as --gtest_output_buffering
+// does.  This needs __fpending() to tell how much of the buffer is pending.
+#if GTEST_OS_LINUX && !GTEST_OS_LINUX_ANDROID
+#define GTEST_CAN_FLUSH_OUTPUT_ON_SIGNAL_ 1
+#endif
+
+// Determines whether the time stamp counter of the CPU can be read, as
+// --gtest_clock=tsc does.  Whether the counter is invariant is checked at
+// run time.
+#if (defined(__x86_64__) || defined(__i386__)) && \
+    (defined(__GNUC__) || defined(__clang__))
+#define GTEST_CAN_READ_TSC_ 1
+#endif
+
 // Defines some utility macros.
 
 // The GNU compiler emits a warning if nested "if" statements are followed by
@@ -1137,11 +1180,21 @@ Derived* CheckedDowncastToActualType(Base* base) {
 //   GetCapturedStdout - stops capturing stdout and returns the captured string.
 //   CaptureStderr     - starts capturing stderr.
 //   GetCapturedStderr - stops capturing stderr and returns the captured string.
+//   CaptureStderrToFile - starts capturing stderr into a temporary file even
+//                       where it would be captured in memory, for output
+//                       that may be large.
+//   ConsumeCapturedStderr - stops capturing stderr and calls consumer with
+//                       consecutive pieces of the captured output, so that
+//                       it never has to be held in memory as a whole.
+//                       --gtest_captured_output_limit does not apply.
 //
 GTEST_API_ void CaptureStdout();
 GTEST_API_ std::string GetCapturedStdout();
 GTEST_API_ void CaptureStderr();
 GTEST_API_ std::string GetCapturedStderr();
+GTEST_API_ void CaptureStderrToFile();
+GTEST_API_ void ConsumeCapturedStderr(
+    const std::function<void(const char* data, size_t size)>& consumer);
 
 #endif  // GTEST_HAS_STREAM_REDIRECTION
 // Returns the size (in bytes) of a file.
@@ -2182,6 +2235,7 @@ class TypeWithSize<8> {
 
 // Integer types of known sizes.
 using TimeInMillis = int64_t;  // Represents time in milliseconds.
+using TimeInNanos = int64_t;   // Represents time in nanoseconds.
 
 // Utilities for command line flags and environment variables.
 
@@ -32,7 +32,9 @@
 
 #include "gtest/gtest-death-test.h"
 
+#include <algorithm>
 #include <functional>
+#include <map>
 #include <utility>
 
 #include "gtest/internal/custom/gtest.h"
@@ -58,12 +60,14 @@
 #include <windows.h>
 #else
 #include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
 #include <sys/wait.h>
 #endif  // GTEST_OS_WINDOWS
 
-#if GTEST_OS_QNX
+#if GTEST_OS_QNX || GTEST_HAS_POSIX_SPAWN
 #include <spawn.h>
-#endif  // GTEST_OS_QNX
+#endif  // GTEST_OS_QNX || GTEST_HAS_POSIX_SPAWN
 
 #if GTEST_OS_FUCHSIA
 #include <lib/fdio/fd.h>
@@ -120,6 +124,42 @@ GTEST_DEFINE_bool_(
     "work in 99% of the cases. Once valgrind is fixed, this flag will "
     "most likely be removed.");
 
+GTEST_DEFINE_bool_(
+    death_test_use_posix_spawn,
+    testing::internal::BoolFromGTestEnv("death_test_use_posix_spawn", true),
+    "Instructs threadsafe-style death tests to start their child processes "
+    "with posix_spawn() where it is available and can set up the child, "
+    "instead of clone() or fork().  posix_spawn() does not copy the page "
+    "tables of the test program.  --gtest_death_test_use_fork takes "
+    "precedence.");
+
+GTEST_DEFINE_bool_(
+    death_test_use_zygote,
+    testing::internal::BoolFromGTestEnv("death_test_use_zygote", false),
+    "Instructs threadsafe-style death tests to fork their child processes "
+    "from a helper process that is started during initialization, while "
+    "the test program is still single-threaded, instead of re-executing "
+    "the test program for every death test.  Ignored on platforms without "
+    "fork().");
+
+GTEST_DEFINE_int32_(
+    death_test_concurrency,
+    testing::internal::Int32FromGTestEnv("death_test_concurrency", 1),
+    "The maximum number of child processes a threadsafe-style death test "
+    "may have running at once.  Values greater than 1 let the children of "
+    "the following death tests in the same test start while the current "
+    "one runs.  Each child has its own stderr capture, and outcomes are "
+    "still reported in declaration order.");
+
+GTEST_DEFINE_int32_(
+    death_test_output_limit,
+    testing::internal::Int32FromGTestEnv("death_test_output_limit",
+                                         1024 * 1024),
+    "The number of bytes of a death test child's stderr that are kept for "
+    "matching and reporting.  Beyond it only the beginning and the end of "
+    "the output are kept, while a regex given to the death test is "
+    "searched for in the output as it is read.  0 keeps all output.");
+
 GTEST_DEFINE_string_(
     internal_run_death_test, "",
     "Indicates the file, line number, temporal index of "
@@ -396,12 +436,205 @@ void DeathTest::set_last_death_test_message(const std::string& message) {
 
 std::string DeathTest::last_death_test_message_;
 
+bool DeathTestRegexMatcher::MatchAndExplain(
+    const ::std::string& output, MatchResultListener* /* listener */) const {
+  return RE::PartialMatch(output, regex_);
+}
+
+void DeathTestRegexMatcher::DescribeTo(::std::ostream* os) const {
+  *os << "contains regular expression ";
+  UniversalPrinter<::std::string>::Print(regex_.pattern(), os);
+}
+
+void DeathTestRegexMatcher::DescribeNegationTo(::std::ostream* os) const {
+  *os << "doesn't contain regular expression ";
+  UniversalPrinter<::std::string>::Print(regex_.pattern(), os);
+}
+
+// Returns the regex matcher the death test was given, or nullptr if it was
+// given another kind of matcher or RTTI is unavailable.
+static const DeathTestRegexMatcher* GetDeathTestRegexMatcher(
+    const Matcher<const std::string&>& matcher) {
+#if GTEST_HAS_RTTI
+  return dynamic_cast<const DeathTestRegexMatcher*>(matcher.GetDescriber());
+#else
+  static_cast<void>(matcher);
+  return nullptr;
+#endif  // GTEST_HAS_RTTI
+}
+
+// Death test output that exceeds --gtest_death_test_output_limit is
+// searched for a regex in windows of kRegexWindow bytes, which overlap by
+// kRegexOverlap bytes.
+static const size_t kRegexWindow = 64 * 1024;
+static const size_t kRegexOverlap = 4 * 1024;
+
+// Collects the stderr output of a death test child process in bounded
+// memory.  Up to limit bytes are kept as they are.  Beyond that, only the
+// first limit / 2 and the last limit - limit / 2 bytes are kept, and the
+// regex, if any, is searched for in the output as it arrives, in windows
+// that overlap by kRegexOverlap bytes.  A match longer than the overlap
+// that straddles two windows is missed.  Patterns anchored with ^ are only
+// searched for in the beginning of the output, and those anchored with $
+// only in its end, as a window boundary is not the start or the end of the
+// output.  A pattern anchored at both ends has to be matched against all
+// of the output, and where an anchor is combined with alternation or a
+// group, as in "^a|b", it may apply to part of the pattern only; in either
+// case all of the output is kept and searched.
+class DeathTestOutput {
+ public:
+  DeathTestOutput(size_t limit, const RE* regex)
+      : limit_(limit),
+        regex_(regex),
+        anchored_at_start_(false),
+        anchored_at_end_(false),
+        keeps_all_(false),
+        size_(0),
+        truncated_(false),
+        matched_(false) {
+    if (regex_ != nullptr) FindAnchors(regex_->pattern());
+  }
+
+  void Append(const char* data, size_t size) {
+    size_ += size;
+    if (!truncated_) {
+      text_.append(data, size);
+      if (limit_ > 0 && !keeps_all_ && text_.size() > limit_) Truncate();
+      return;
+    }
+
+    tail_.append(data, size);
+    if (tail_.size() > 2 * TailLimit()) {
+      tail_.erase(0, tail_.size() - TailLimit());
+    }
+    if (ScansWindows() && !matched_) {
+      window_.append(data, size);
+      if (window_.size() >= kRegexWindow) ScanWindow();
+    }
+  }
+
+  // Returns true if and only if the output exceeded the limit, so that only
+  // part of it was kept.
+  bool truncated() const { return truncated_; }
+
+  // Returns true if and only if the regex was found in the output.  May
+  // only be called once all output has been appended and the output was
+  // truncated.
+  bool RegexMatched() {
+    if (matched_) return true;
+    if (ScansWindows()) {
+      ScanWindow();
+    } else if (anchored_at_end_ && !anchored_at_start_) {
+      matched_ = RE::PartialMatch(Tail(), *regex_);
+    }
+    return matched_;
+  }
+
+  // Returns the output, with the part that was not kept replaced by a note.
+  std::string GetText() const {
+    if (!truncated_) return text_;
+    const std::string tail = Tail();
+    return text_ + "\n[... " +
+           StreamableToString(size_ - text_.size() - tail.size()) +
+           " bytes of output omitted ...]\n" + tail;
+  }
+
+ private:
+  size_t TailLimit() const { return limit_ - limit_ / 2; }
+
+  std::string Tail() const {
+    return tail_.size() > TailLimit() ? tail_.substr(tail_.size() - TailLimit())
+                                      : tail_;
+  }
+
+  bool ScansWindows() const {
+    return regex_ != nullptr && !anchored_at_start_ && !anchored_at_end_;
+  }
+
+  // Called when the output first exceeds the limit.  Searches what has been
+  // kept so far, and moves all but the head of it to the tail.
+  void Truncate() {
+    truncated_ = true;
+    if (regex_ != nullptr && !anchored_at_end_) {
+      matched_ = RE::PartialMatch(text_, *regex_);
+    }
+    const size_t head_size = limit_ / 2;
+    if (ScansWindows() && !matched_) {
+      window_ = text_.substr(text_.size() - (std::min)(text_.size(),
+                                                         kRegexOverlap));
+    }
+    tail_ = text_.substr(head_size);
+    text_.resize(head_size);
+  }
+
+  void ScanWindow() {
+    matched_ = RE::PartialMatch(window_, *regex_);
+    if (matched_) {
+      window_.clear();
+    } else if (window_.size() > kRegexOverlap) {
+      window_.erase(0, window_.size() - kRegexOverlap);
+    }
+  }
+
+  // Notes whether the pattern has a ^ or $ anchor outside of a bracket
+  // expression, and whether an anchor may apply to only part of it.
+  void FindAnchors(const std::string& pattern) {
+    bool in_brackets = false;
+    bool has_alternation_or_group = false;
+    for (size_t i = 0; i < pattern.size(); ++i) {
+      const char c = pattern[i];
+      if (c == '\\') {
+        ++i;
+      } else if (in_brackets) {
+        if (c == ']') in_brackets = false;
+      } else if (c == '[') {
+        in_brackets = true;
+        // A ] right after [ or [^ is part of the bracket expression.
+        if (i + 1 < pattern.size() && pattern[i + 1] == '^') ++i;
+        if (i + 1 < pattern.size() && pattern[i + 1] == ']') ++i;
+      } else if (c == '^') {
+        anchored_at_start_ = true;
+      } else if (c == '$') {
+        anchored_at_end_ = true;
+      } else if (c == '|' || c == '(') {
+        has_alternation_or_group = true;
+      }
+    }
+    keeps_all_ = (anchored_at_start_ && anchored_at_end_) ||
+                 (has_alternation_or_group &&
+                  (anchored_at_start_ || anchored_at_end_));
+  }
+
+  const size_t limit_;
+  const RE* const regex_;
+  bool anchored_at_start_;
+  bool anchored_at_end_;
+  // Whether the output is never truncated, as the anchors of the pattern
+  // can't be relied on.
+  bool keeps_all_;
+  // The total number of bytes appended.
+  size_t size_;
+  bool truncated_;
+  // All output while it is within the limit, its head afterwards.
+  std::string text_;
+  // The end of the output, holding up to twice TailLimit() bytes.
+  std::string tail_;
+  // The output that has not been searched for the regex yet, preceded by
+  // the last kRegexOverlap bytes that have.
+  std::string window_;
+  bool matched_;
+};
+
 // Provides cross platform implementation for some death functionality.
 class DeathTestImpl : public DeathTest {
  protected:
   DeathTestImpl(const char* a_statement, Matcher<const std::string&> matcher)
       : statement_(a_statement),
         matcher_(std::move(matcher)),
+        regex_matcher_(GetDeathTestRegexMatcher(matcher_)),
+        output_(static_cast<size_t>(
+                    (std::max)(GTEST_FLAG_GET(death_test_output_limit), 0)),
+                regex_matcher_ == nullptr ? nullptr : &regex_matcher_->regex()),
         spawned_(false),
         status_(-1),
         outcome_(IN_PROGRESS),
@@ -432,8 +665,10 @@ class DeathTestImpl : public DeathTest {
   // case of unexpected codes.
   void ReadAndInterpretStatusByte();
 
-  // Returns stderr output from the child process.
-  virtual std::string GetErrorLogs();
+  // Reads the stderr output of the child process into output().
+  virtual void ReadErrorLogs();
+
+  DeathTestOutput* output() { return &output_; }
 
  private:
   // The textual content of the code this object is testing.  This class
@@ -441,6 +676,10 @@ class DeathTestImpl : public DeathTest {
   const char* const statement_;
   // A matcher that's expected to match the stderr output by the child process.
   Matcher<const std::string&> matcher_;
+  // matcher_ if it was made from a regex, otherwise nullptr.
+  const DeathTestRegexMatcher* const regex_matcher_;
+  // The stderr output of the child process.
+  DeathTestOutput output_;
   // True if the death test child process has been successfully spawned.
   bool spawned_;
   // The exit status of the child process.
@@ -502,7 +741,11 @@ void DeathTestImpl::ReadAndInterpretStatusByte() {
   set_read_fd(-1);
 }
 
-std::string DeathTestImpl::GetErrorLogs() { return GetCapturedStderr(); }
+void DeathTestImpl::ReadErrorLogs() {
+  ConsumeCapturedStderr([this](const char* data, size_t size) {
+    output_.Append(data, size);
+  });
+}
 
 // Signals that the death test code which should have exited, didn't.
 // Should be called only in a death test child process.
@@ -570,7 +813,8 @@ static ::std::string FormatDeathTestOutput(const ::std::string& output) {
 bool DeathTestImpl::Passed(bool status_ok) {
   if (!spawned()) return false;
 
-  const std::string error_message = GetErrorLogs();
+  ReadErrorLogs();
+  const std::string error_message = output_.GetText();
 
   bool success = false;
   Message buffer;
@@ -594,7 +838,11 @@ bool DeathTestImpl::Passed(bool status_ok) {
       break;
     case DIED:
       if (status_ok) {
-        if (matcher_.Matches(error_message)) {
+        // When the output was truncated, a regex was searched for in all
+        // of it while it was read; other matchers only see what was kept.
+        if ((output_.truncated() && regex_matcher_ != nullptr)
+                ? output_.RegexMatched()
+                : matcher_.Matches(error_message)) {
           success = true;
         } else {
           std::ostringstream stream;
@@ -779,7 +1027,7 @@ DeathTest::TestRole WindowsDeathTest::AssumeRole() {
 
   DeathTest::set_last_death_test_message("");
 
-  CaptureStderr();
+  CaptureStderrToFile();
   // Flush the log buffers since the log streams are shared with the child.
   FlushInfoLog();
 
@@ -821,15 +1069,13 @@ class FuchsiaDeathTest : public DeathTestImpl {
   // All of these virtual functions are inherited from DeathTest.
   int Wait() override;
   TestRole AssumeRole() override;
-  std::string GetErrorLogs() override;
+  void ReadErrorLogs() override {}  // Wait() reads the output.
 
  private:
   // The name of the file in which the death test is located.
   const char* const file_;
   // The line number on which the death test is located.
   const int line_;
-  // The stderr data captured by the child process.
-  std::string captured_stderr_;
 
   zx::process child_process_;
   zx::channel exception_channel_;
@@ -920,14 +1166,11 @@ int FuchsiaDeathTest::Wait() {
       if (packet.signal.observed & ZX_SOCKET_READABLE) {
         // Read data from the socket.
         constexpr size_t kBufferSize = 1024;
+        char buffer[kBufferSize];
         do {
-          size_t old_length = captured_stderr_.length();
           size_t bytes_read = 0;
-          captured_stderr_.resize(old_length + kBufferSize);
-          status_zx =
-              stderr_socket_.read(0, &captured_stderr_.front() + old_length,
-                                  kBufferSize, &bytes_read);
-          captured_stderr_.resize(old_length + bytes_read);
+          status_zx = stderr_socket_.read(0, buffer, kBufferSize, &bytes_read);
+          if (status_zx == ZX_OK) output()->Append(buffer, bytes_read);
         } while (status_zx == ZX_OK);
         if (status_zx == ZX_ERR_PEER_CLOSED) {
           socket_closed = true;
@@ -1050,8 +1293,6 @@ DeathTest::TestRole FuchsiaDeathTest::AssumeRole() {
   return OVERSEE_TEST;
 }
 
-std::string FuchsiaDeathTest::GetErrorLogs() { return captured_stderr_; }
-
 #else  // We are neither on Windows, nor on Fuchsia.
 
 // ForkingDeathTest provides implementations for most of the abstract
@@ -1103,6 +1344,7 @@ class NoExecDeathTest : public ForkingDeathTest {
 // The AssumeRole process for a fork-and-run death test.  It implements a
 // straightforward fork, with a simple pipe to transmit the status byte.
 DeathTest::TestRole NoExecDeathTest::AssumeRole() {
+  StopBackgroundThreads();
   const size_t thread_count = GetThreadCount();
   if (thread_count != 1) {
     GTEST_LOG_(WARNING) << DeathTestThreadWarning(thread_count);
@@ -1112,7 +1354,7 @@ DeathTest::TestRole NoExecDeathTest::AssumeRole() {
   GTEST_DEATH_TEST_CHECK_(pipe(pipe_fd) != -1);
 
   DeathTest::set_last_death_test_message("");
-  CaptureStderr();
+  CaptureStderrToFile();
   // When we fork the process below, the log file buffers are copied, but the
   // file descriptors are shared.  We flush all log files here so that closing
   // the file descriptors in the child process doesn't throw off the
@@ -1145,6 +1387,18 @@ DeathTest::TestRole NoExecDeathTest::AssumeRole() {
   }
 }
 
+// Returns the command line that a re-executed death test child starts
+// with, before the death test flags are added.
+static ::std::vector<std::string> GetArgvsForDeathTestChildProcess() {
+  ::std::vector<std::string> args = GetInjectableArgvs();
+#if defined(GTEST_EXTRA_DEATH_TEST_COMMAND_LINE_ARGS_)
+  ::std::vector<std::string> extra_args =
+      GTEST_EXTRA_DEATH_TEST_COMMAND_LINE_ARGS_();
+  args.insert(args.end(), extra_args.begin(), extra_args.end());
+#endif  // defined(GTEST_EXTRA_DEATH_TEST_COMMAND_LINE_ARGS_)
+  return args;
+}
+
 // A concrete death test class that forks and re-executes the main
 // program from the beginning, with command-line flags set that cause
 // only this specific death test to be run.
@@ -1158,15 +1412,6 @@ class ExecDeathTest : public ForkingDeathTest {
   TestRole AssumeRole() override;
 
  private:
-  static ::std::vector<std::string> GetArgvsForDeathTestChildProcess() {
-    ::std::vector<std::string> args = GetInjectableArgvs();
-#if defined(GTEST_EXTRA_DEATH_TEST_COMMAND_LINE_ARGS_)
-    ::std::vector<std::string> extra_args =
-        GTEST_EXTRA_DEATH_TEST_COMMAND_LINE_ARGS_();
-    args.insert(args.end(), extra_args.begin(), extra_args.end());
-#endif  // defined(GTEST_EXTRA_DEATH_TEST_COMMAND_LINE_ARGS_)
-    return args;
-  }
   // The name of the file in which the death test is located.
   const char* const file_;
   // The line number on which the death test is located.
@@ -1206,6 +1451,7 @@ class Arguments {
 struct ExecDeathTestArgs {
   char* const* argv;  // Command-line arguments for the child's call to exec
   int close_fd;       // File descriptor to close; the read end of a pipe
+  int stderr_fd;      // Descriptor to redirect stderr to, or -1 to keep it
 };
 
 #if GTEST_OS_QNX
@@ -1217,6 +1463,10 @@ extern "C" char** environ;
 static int ExecDeathTestChildMain(void* child_arg) {
   ExecDeathTestArgs* const args = static_cast<ExecDeathTestArgs*>(child_arg);
   GTEST_DEATH_TEST_CHECK_SYSCALL_(close(args->close_fd));
+  // dup2() is a direct system call, too.
+  if (args->stderr_fd != -1) {
+    GTEST_DEATH_TEST_CHECK_SYSCALL_(dup2(args->stderr_fd, STDERR_FILENO));
+  }
 
   // We need to execute the test program in the same environment where
   // it was originally invoked.  Therefore we change to the original
@@ -1278,15 +1528,81 @@ static bool StackGrowsDown() {
 }
 #endif  // GTEST_HAS_CLONE
 
+#if GTEST_HAS_POSIX_SPAWN
+#if !GTEST_OS_MAC
+extern "C" char** environ;
+#endif  // !GTEST_OS_MAC
+
+// posix_spawn_file_actions_addchdir_np() appeared in glibc 2.29.
+#if defined(__GLIBC__) && \
+    (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 29))
+#define GTEST_INTERNAL_HAS_POSIX_SPAWN_ADDCHDIR_ 1
+#else
+#define GTEST_INTERNAL_HAS_POSIX_SPAWN_ADDCHDIR_ 0
+#endif
+
+// Starts the child process described by args with posix_spawn(3).  Unlike
+// fork(2), posix_spawn() does not copy the page tables of the test program,
+// so its cost does not grow with the memory the program uses.  Returns -1
+// without starting anything if the child needs a working directory change
+// that posix_spawn() cannot make on this platform.
+static pid_t PosixSpawnDeathTestChild(const ExecDeathTestArgs& args) {
+  const char* const original_dir =
+      UnitTest::GetInstance()->original_working_dir();
+  const bool needs_chdir =
+      FilePath::GetCurrentDir().string() != std::string(original_dir);
+#if !GTEST_INTERNAL_HAS_POSIX_SPAWN_ADDCHDIR_
+  if (needs_chdir) return -1;
+#endif  // !GTEST_INTERNAL_HAS_POSIX_SPAWN_ADDCHDIR_
+
+  posix_spawn_file_actions_t file_actions;
+  GTEST_DEATH_TEST_CHECK_(posix_spawn_file_actions_init(&file_actions) == 0);
+  GTEST_DEATH_TEST_CHECK_(
+      posix_spawn_file_actions_addclose(&file_actions, args.close_fd) == 0);
+  if (args.stderr_fd != -1) {
+    GTEST_DEATH_TEST_CHECK_(posix_spawn_file_actions_adddup2(
+                                &file_actions, args.stderr_fd,
+                                STDERR_FILENO) == 0);
+  }
+#if GTEST_INTERNAL_HAS_POSIX_SPAWN_ADDCHDIR_
+  if (needs_chdir) {
+    GTEST_DEATH_TEST_CHECK_(posix_spawn_file_actions_addchdir_np(
+                                &file_actions, original_dir) == 0);
+  }
+#endif  // GTEST_INTERNAL_HAS_POSIX_SPAWN_ADDCHDIR_
+
+#if GTEST_OS_MAC
+  char** const env = *_NSGetEnviron();
+#else
+  char** const env = environ;
+#endif  // GTEST_OS_MAC
+  pid_t child_pid = -1;
+  const int error = posix_spawn(&child_pid, args.argv[0], &file_actions,
+                                nullptr, args.argv, env);
+  GTEST_DEATH_TEST_CHECK_(posix_spawn_file_actions_destroy(&file_actions) ==
+                          0);
+  if (error != 0) {
+    errno = error;
+    DeathTestAbort(std::string("posix_spawn(") + args.argv[0] + ", ...) in " +
+                   original_dir + " failed: " + GetLastErrnoDescription());
+  }
+  return child_pid;
+}
+#endif  // GTEST_HAS_POSIX_SPAWN
+
 // Spawns a child process with the same executable as the current process in
 // a thread-safe manner and instructs it to run the death test.  The
-// implementation uses fork(2) + exec.  On systems where clone(2) is
-// available, it is used instead, being slightly more thread-safe.  On QNX,
-// fork supports only single-threaded environments, so this function uses
-// spawn(2) there instead.  The function dies with an error message if
-// anything goes wrong.
-static pid_t ExecDeathTestSpawnChild(char* const* argv, int close_fd) {
-  ExecDeathTestArgs args = {argv, close_fd};
+// implementation uses posix_spawn(3) where available, as it is the cheapest
+// option for large test programs.  Otherwise, or when
+// --gtest_death_test_use_fork is set, it uses fork(2) + exec.  On systems
+// where clone(2) is available, it is used instead of fork(2), being slightly
+// more thread-safe.  On QNX, fork supports only single-threaded
+// environments, so this function uses spawn(2) there instead.  Unless
+// stderr_fd is -1, the child's stderr is redirected to it (not supported on
+// QNX).  The function dies with an error message if anything goes wrong.
+static pid_t ExecDeathTestSpawnChild(char* const* argv, int close_fd,
+                                     int stderr_fd) {
+  ExecDeathTestArgs args = {argv, close_fd, stderr_fd};
   pid_t child_pid = -1;
 
 #if GTEST_OS_QNX
@@ -1333,10 +1649,17 @@ static pid_t ExecDeathTestSpawnChild(char* const* argv, int close_fd) {
       sigaction(SIGPROF, &ignore_sigprof_action, &saved_sigprof_action));
 #endif  // GTEST_OS_LINUX
 
+#if GTEST_HAS_POSIX_SPAWN
+  if (!GTEST_FLAG_GET(death_test_use_fork) &&
+      GTEST_FLAG_GET(death_test_use_posix_spawn)) {
+    child_pid = PosixSpawnDeathTestChild(args);
+  }
+#endif  // GTEST_HAS_POSIX_SPAWN
+
 #if GTEST_HAS_CLONE
   const bool use_fork = GTEST_FLAG_GET(death_test_use_fork);
 
-  if (!use_fork) {
+  if (!use_fork && child_pid == -1) {
     static const bool stack_grows_down = StackGrowsDown();
     const auto stack_size = static_cast<size_t>(getpagesize() * 2);
     // MMAP_ANONYMOUS is not defined on Mac, so we use MAP_ANON instead.
@@ -1363,7 +1686,7 @@ static pid_t ExecDeathTestSpawnChild(char* const* argv, int close_fd) {
     GTEST_DEATH_TEST_CHECK_(munmap(stack, stack_size) != -1);
   }
 #else
-  const bool use_fork = true;
+  const bool use_fork = child_pid == -1;
 #endif  // GTEST_HAS_CLONE
 
   if (use_fork && (child_pid = fork()) == 0) {
@@ -1417,12 +1740,13 @@ DeathTest::TestRole ExecDeathTest::AssumeRole() {
 
   DeathTest::set_last_death_test_message("");
 
-  CaptureStderr();
+  CaptureStderrToFile();
   // See the comment in NoExecDeathTest::AssumeRole for why the next line
   // is necessary.
   FlushInfoLog();
 
-  const pid_t child_pid = ExecDeathTestSpawnChild(args.Argv(), pipe_fd[0]);
+  const pid_t child_pid =
+      ExecDeathTestSpawnChild(args.Argv(), pipe_fd[0], -1);
   GTEST_DEATH_TEST_CHECK_SYSCALL_(close(pipe_fd[1]));
   set_child_pid(child_pid);
   set_read_fd(pipe_fd[0]);
@@ -1430,8 +1754,535 @@ DeathTest::TestRole ExecDeathTest::AssumeRole() {
   return OVERSEE_TEST;
 }
 
+// Writes exactly size bytes from buffer to fd, retrying on EINTR and on
+// short writes.  Returns false on any other error.
+static bool WriteFully(int fd, const void* buffer, size_t size) {
+  const char* data = static_cast<const char*>(buffer);
+  while (size > 0) {
+    const ssize_t written = write(fd, data, size);
+    if (written == -1 && errno == EINTR) continue;
+    if (written <= 0) return false;
+    data += written;
+    size -= static_cast<size_t>(written);
+  }
+  return true;
+}
+
+// Reads exactly size bytes from fd into buffer, retrying on EINTR and on
+// short reads.  Returns false on EOF or on any other error.
+static bool ReadFully(int fd, void* buffer, size_t size) {
+  char* data = static_cast<char*>(buffer);
+  while (size > 0) {
+    const ssize_t num_read = read(fd, data, size);
+    if (num_read == -1 && errno == EINTR) continue;
+    if (num_read <= 0) return false;
+    data += num_read;
+    size -= static_cast<size_t>(num_read);
+  }
+  return true;
+}
+
+// DeathTestZygote manages a helper process (the "zygote") that is forked
+// by StartDeathTestZygoteIfRequested() while the test program is still
+// single-threaded and before any test has run.  The zygote then sits idle
+// and, on request, forks a child that continues as if the test program had
+// been re-executed with the --gtest_filter and
+// --gtest_internal_run_death_test flags of a threadsafe-style death test.
+// This gives the child the clean process state of an exec-style child
+// without paying for exec(), dynamic linking and static initialization on
+// every death test.
+//
+// The parent and the zygote talk over a Unix domain socket.  A request is
+// a length-prefixed "filter\0file|line|index" payload that carries the
+// status pipe and the parent's current stdout and stderr as SCM_RIGHTS
+// ancillary data.  The zygote replies with the pid of the new child and,
+// once it has reaped the child, with its wait(2) status.
+class DeathTestZygote {
+ public:
+  // Returns the zygote of this process, or NULL if none is running.
+  static DeathTestZygote* Get() { return instance_; }
+
+  // Forks the zygote.  Returns in the parent process and, with the death
+  // test flags set, in every death test child the zygote forks later.
+  static void Start();
+
+  // Asks the zygote to fork a child running the death test at location
+  // ("file|line|index") of the test named by filter.  The child writes its
+  // status byte to status_fd.  Returns the pid of the child.
+  pid_t SpawnChild(const std::string& filter, const std::string& location,
+                   int status_fd);
+
+  // Blocks until the zygote reports the wait(2) status of the child most
+  // recently spawned, and returns it.
+  int WaitForChild();
+
+ private:
+  explicit DeathTestZygote(int socket_fd) : socket_fd_(socket_fd) {}
+
+  // The request loop of the zygote process.  Returns only in a newly
+  // forked death test child.
+  static void ServeRequests(int socket_fd);
+
+  static DeathTestZygote* instance_;
+
+  // The parent's end of the socket connected to the zygote.
+  const int socket_fd_;
+};
+
+DeathTestZygote* DeathTestZygote::instance_ = nullptr;
+
+// The number of descriptors passed with every zygote request: the write end
+// of the status pipe, stdout, and stderr, in this order.
+static const int kZygoteRequestFdCount = 3;
+
+void DeathTestZygote::Start() {
+  int socket_fds[2];
+  GTEST_DEATH_TEST_CHECK_SYSCALL_(
+      socketpair(AF_UNIX, SOCK_STREAM, 0, socket_fds));
+  // Exec-style death test children must not keep the zygote alive.
+  GTEST_DEATH_TEST_CHECK_SYSCALL_(fcntl(socket_fds[0], F_SETFD, FD_CLOEXEC));
+
+  // Buffered output would otherwise be flushed again by every child.
+  fflush(stdout);
+  fflush(stderr);
+
+  const pid_t zygote_pid = fork();
+  GTEST_DEATH_TEST_CHECK_(zygote_pid != -1);
+  if (zygote_pid == 0) {
+    GTEST_DEATH_TEST_CHECK_SYSCALL_(close(socket_fds[0]));
+    ServeRequests(socket_fds[1]);
+    return;
+  }
+  GTEST_DEATH_TEST_CHECK_SYSCALL_(close(socket_fds[1]));
+  instance_ = new DeathTestZygote(socket_fds[0]);
+}
+
+void DeathTestZygote::ServeRequests(int socket_fd) {
+  for (;;) {
+    uint32_t payload_size = 0;
+    char control[CMSG_SPACE(sizeof(int) * kZygoteRequestFdCount)];
+    struct iovec iov = {&payload_size, sizeof(payload_size)};
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+
+    ssize_t received;
+    do {
+      received = recvmsg(socket_fd, &msg, 0);
+    } while (received == -1 && errno == EINTR);
+    // The parent has exited or closed its end: the zygote is done.
+    if (received != static_cast<ssize_t>(sizeof(payload_size))) _exit(0);
+
+    const struct cmsghdr* const cmsg = CMSG_FIRSTHDR(&msg);
+    if (cmsg == nullptr || cmsg->cmsg_type != SCM_RIGHTS ||
+        cmsg->cmsg_len != CMSG_LEN(sizeof(int) * kZygoteRequestFdCount)) {
+      _exit(1);
+    }
+    int fds[kZygoteRequestFdCount];
+    memcpy(fds, CMSG_DATA(cmsg), sizeof(fds));
+
+    std::string payload(payload_size, '\0');
+    if (!ReadFully(socket_fd, &payload[0], payload_size)) _exit(1);
+    const size_t separator = payload.find('\0');
+    if (separator == std::string::npos) _exit(1);
+
+    const pid_t child_pid = fork();
+    if (child_pid == 0) {
+      // We are the death test child.  Take over the parent's standard
+      // streams, then return into the test program with the same flags an
+      // exec-style child would have been started with.
+      close(socket_fd);
+      if (dup2(fds[1], STDOUT_FILENO) == -1 ||
+          dup2(fds[2], STDERR_FILENO) == -1) {
+        _exit(1);
+      }
+      close(fds[1]);
+      close(fds[2]);
+      const char* const original_dir =
+          UnitTest::GetInstance()->original_working_dir();
+      if (chdir(original_dir) != 0) {
+        DeathTestAbort(std::string("chdir(\"") + original_dir +
+                       "\") failed: " + GetLastErrnoDescription());
+      }
+      GTEST_FLAG_SET(filter, payload.substr(0, separator));
+      GTEST_FLAG_SET(internal_run_death_test,
+                     payload.substr(separator + 1) + "|" +
+                         StreamableToString(fds[0]));
+      return;
+    }
+
+    for (int fd : fds) close(fd);
+    const int32_t reported_pid = static_cast<int32_t>(child_pid);
+    if (!WriteFully(socket_fd, &reported_pid, sizeof(reported_pid))) _exit(1);
+    if (child_pid == -1) continue;
+
+    int status_value = 0;
+    pid_t waited;
+    do {
+      waited = waitpid(child_pid, &status_value, 0);
+    } while (waited == -1 && errno == EINTR);
+    const int32_t reported_status = static_cast<int32_t>(status_value);
+    if (!WriteFully(socket_fd, &reported_status, sizeof(reported_status))) {
+      _exit(1);
+    }
+  }
+}
+
+pid_t DeathTestZygote::SpawnChild(const std::string& filter,
+                                  const std::string& location, int status_fd) {
+  std::string payload = filter;
+  payload.push_back('\0');
+  payload += location;
+  uint32_t payload_size = static_cast<uint32_t>(payload.size());
+
+  const int fds[kZygoteRequestFdCount] = {status_fd, STDOUT_FILENO,
+                                          STDERR_FILENO};
+  char control[CMSG_SPACE(sizeof(fds))];
+  memset(control, 0, sizeof(control));
+  struct iovec iov = {&payload_size, sizeof(payload_size)};
+  struct msghdr msg;
+  memset(&msg, 0, sizeof(msg));
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = control;
+  msg.msg_controllen = sizeof(control);
+  struct cmsghdr* const cmsg = CMSG_FIRSTHDR(&msg);
+  cmsg->cmsg_level = SOL_SOCKET;
+  cmsg->cmsg_type = SCM_RIGHTS;
+  cmsg->cmsg_len = CMSG_LEN(sizeof(fds));
+  memcpy(CMSG_DATA(cmsg), fds, sizeof(fds));
+
+  ssize_t sent;
+  do {
+    sent = sendmsg(socket_fd_, &msg, 0);
+  } while (sent == -1 && errno == EINTR);
+  GTEST_DEATH_TEST_CHECK_(sent == static_cast<ssize_t>(sizeof(payload_size)));
+  GTEST_DEATH_TEST_CHECK_(
+      WriteFully(socket_fd_, payload.data(), payload.size()));
+
+  int32_t child_pid = -1;
+  GTEST_DEATH_TEST_CHECK_(ReadFully(socket_fd_, &child_pid, sizeof(child_pid)));
+  GTEST_DEATH_TEST_CHECK_(child_pid != -1);
+  return static_cast<pid_t>(child_pid);
+}
+
+int DeathTestZygote::WaitForChild() {
+  int32_t status_value = 0;
+  GTEST_DEATH_TEST_CHECK_(
+      ReadFully(socket_fd_, &status_value, sizeof(status_value)));
+  return static_cast<int>(status_value);
+}
+
+// A threadsafe-style death test whose child process is forked by the
+// death test zygote instead of being re-executed.
+class ZygoteDeathTest : public DeathTestImpl {
+ public:
+  ZygoteDeathTest(const char* a_statement, Matcher<const std::string&> matcher,
+                  const char* file, int line)
+      : DeathTestImpl(a_statement, std::move(matcher)),
+        file_(file),
+        line_(line) {}
+
+  // All of these virtual functions are inherited from DeathTest.
+  int Wait() override;
+  TestRole AssumeRole() override;
+
+ private:
+  // The name of the file in which the death test is located.
+  const char* const file_;
+  // The line number on which the death test is located.
+  const int line_;
+};
+
+// Waits for the child in a death test to exit, returning its exit
+// status, or 0 if no child process exists.  As a side effect, sets the
+// outcome data member.
+int ZygoteDeathTest::Wait() {
+  if (!spawned()) return 0;
+
+  ReadAndInterpretStatusByte();
+  set_status(DeathTestZygote::Get()->WaitForChild());
+  return status();
+}
+
+// The AssumeRole process for a zygote death test.  It has the zygote fork
+// a child that behaves like the re-executed program of an exec-style
+// death test.  Inside that child the test is created as an ExecDeathTest,
+// which executes the statement.
+DeathTest::TestRole ZygoteDeathTest::AssumeRole() {
+  const TestInfo* const info = GetUnitTestImpl()->current_test_info();
+  const int death_test_index = info->result()->death_test_count();
+
+  int pipe_fd[2];
+  GTEST_DEATH_TEST_CHECK_(pipe(pipe_fd) != -1);
+
+  const std::string filter =
+      std::string(info->test_suite_name()) + "." + info->name();
+  const std::string location = std::string(file_) + "|" +
+                               StreamableToString(line_) + "|" +
+                               StreamableToString(death_test_index);
+
+  DeathTest::set_last_death_test_message("");
+
+  CaptureStderrToFile();
+  // See the comment in NoExecDeathTest::AssumeRole for why the next line
+  // is necessary.
+  FlushInfoLog();
+
+  DeathTestZygote::Get()->SpawnChild(filter, location, pipe_fd[1]);
+  GTEST_DEATH_TEST_CHECK_SYSCALL_(close(pipe_fd[1]));
+  set_read_fd(pipe_fd[0]);
+  set_spawned(true);
+  return OVERSEE_TEST;
+}
+
+// Returns the record a speculatively started death test child writes to its
+// status pipe once it reaches its death test, ahead of the status byte.  The
+// parent compares it with the location of the death test it is about to run.
+static std::string DeathTestLocationRecord(const char* file, int line) {
+  return std::string(file) + "|" + StreamableToString(line) + "\n";
+}
+
+// A death test child process started by ConcurrentDeathTest.
+struct DeathTestChild {
+  pid_t pid;
+  // The parent's end of the status pipe.
+  int status_fd;
+  // An unlinked temporary file holding the child's stderr.
+  int stderr_fd;
+};
+
+// Creates an unlinked temporary file for the stderr of a death test child.
+static int CreateDeathTestStderrFile() {
+  std::string name = TempDir() + "gtest_death_test_stderr.XXXXXX";
+  const int fd = mkstemp(&name[0]);
+  GTEST_DEATH_TEST_CHECK_(fd != -1);
+  GTEST_DEATH_TEST_CHECK_SYSCALL_(unlink(name.c_str()));
+  // Children started later must not inherit the descriptor.
+  GTEST_DEATH_TEST_CHECK_SYSCALL_(fcntl(fd, F_SETFD, FD_CLOEXEC));
+  return fd;
+}
+
+// Re-executes the test program to run the death test at index of the
+// current test.  An empty file names no particular death test: the child
+// then runs whichever death test it reaches at that index and reports its
+// location with DeathTestLocationRecord() first.
+static DeathTestChild SpawnDeathTestChild(const TestInfo& info,
+                                          const char* file, int line,
+                                          int index) {
+  int pipe_fd[2];
+  GTEST_DEATH_TEST_CHECK_(pipe(pipe_fd) != -1);
+  // Only the child being spawned may hold the write end, and no child may
+  // hold the read end: other children of this test may still be running.
+  GTEST_DEATH_TEST_CHECK_SYSCALL_(fcntl(pipe_fd[0], F_SETFD, FD_CLOEXEC));
+
+  const std::string filter_flag = std::string("--") + GTEST_FLAG_PREFIX_ +
+                                  "filter=" + info.test_suite_name() + "." +
+                                  info.name();
+  const std::string internal_flag = std::string("--") + GTEST_FLAG_PREFIX_ +
+                                    "internal_run_death_test=" + file + "|" +
+                                    StreamableToString(line) + "|" +
+                                    StreamableToString(index) + "|" +
+                                    StreamableToString(pipe_fd[1]);
+  Arguments args;
+  args.AddArguments(GetArgvsForDeathTestChildProcess());
+  args.AddArgument(filter_flag.c_str());
+  args.AddArgument(internal_flag.c_str());
+
+  DeathTestChild child;
+  child.stderr_fd = CreateDeathTestStderrFile();
+  child.pid =
+      ExecDeathTestSpawnChild(args.Argv(), pipe_fd[0], child.stderr_fd);
+  GTEST_DEATH_TEST_CHECK_SYSCALL_(close(pipe_fd[1]));
+  child.status_fd = pipe_fd[0];
+  return child;
+}
+
+// Kills a death test child that will not be used and releases its
+// resources.
+static void DiscardDeathTestChild(const DeathTestChild& child) {
+  kill(child.pid, SIGKILL);
+  GTEST_DEATH_TEST_CHECK_SYSCALL_(waitpid(child.pid, nullptr, 0));
+  GTEST_DEATH_TEST_CHECK_SYSCALL_(close(child.status_fd));
+  GTEST_DEATH_TEST_CHECK_SYSCALL_(close(child.stderr_fd));
+}
+
+// Holds the death test children started ahead of time for the death tests
+// that follow the current one in the running test, keyed by death test
+// index.
+class DeathTestChildPool {
+ public:
+  static DeathTestChildPool* Get() {
+    static DeathTestChildPool* const pool = new DeathTestChildPool;
+    return pool;
+  }
+
+  // Removes the child started ahead of time for the death test at index of
+  // the test described by info and stores it in *child.  Returns false if
+  // there is no such child.
+  bool Take(const TestInfo* info, int index, DeathTestChild* child) {
+    if (info != test_info_) {
+      DiscardAll();
+      test_info_ = info;
+    }
+    const auto it = children_.find(index);
+    if (it == children_.end()) return false;
+    *child = it->second;
+    children_.erase(it);
+    return true;
+  }
+
+  // Makes sure children are running for the count death tests that follow
+  // the one at index.
+  void Prefetch(const TestInfo& info, int index, int count) {
+    for (int i = index + 1; i <= index + count; ++i) {
+      if (children_.count(i) == 0) {
+        children_[i] = SpawnDeathTestChild(info, "", 0, i);
+      }
+    }
+  }
+
+  // Discards every child started ahead of time.
+  void DiscardAll() {
+    for (const auto& entry : children_) DiscardDeathTestChild(entry.second);
+    children_.clear();
+    test_info_ = nullptr;
+  }
+
+ private:
+  DeathTestChildPool() : test_info_(nullptr) {}
+
+  const TestInfo* test_info_;
+  std::map<int, DeathTestChild> children_;
+};
+
+// A threadsafe-style death test that, while its own child runs, already
+// re-executes the test program for the death tests that follow it in the
+// same test.  Such a child is started without knowing the location of the
+// death test it will reach; it reports that location before running the
+// statement, and is replaced by a fresh child if it does not match.  Every
+// child writes its stderr to a file of its own.
+class ConcurrentDeathTest : public ForkingDeathTest {
+ public:
+  ConcurrentDeathTest(const char* a_statement,
+                      Matcher<const std::string&> matcher, const char* file,
+                      int line)
+      : ForkingDeathTest(a_statement, std::move(matcher)),
+        file_(file),
+        line_(line),
+        stderr_fd_(-1) {}
+  ~ConcurrentDeathTest() override {
+    if (stderr_fd_ != -1) posix::Close(stderr_fd_);
+  }
+
+  TestRole AssumeRole() override;
+
+ private:
+  void ReadErrorLogs() override;
+
+  // The name of the file in which the death test is located.
+  const char* const file_;
+  // The line number on which the death test is located.
+  const int line_;
+  // The file holding the stderr of the child process.
+  int stderr_fd_;
+};
+
+// The AssumeRole process for a concurrent death test.  It takes the child
+// started ahead of time for this death test, or spawns one, and starts the
+// children for up to --gtest_death_test_concurrency - 1 of the following
+// death tests.  Their number grows with the number of death tests the test
+// has run so far, so that tests with a single death test spawn no extra
+// children.
+DeathTest::TestRole ConcurrentDeathTest::AssumeRole() {
+  const TestInfo* const info = GetUnitTestImpl()->current_test_info();
+  const int death_test_index = info->result()->death_test_count();
+
+  DeathTest::set_last_death_test_message("");
+  // See the comment in NoExecDeathTest::AssumeRole for why the next line
+  // is necessary.
+  FlushInfoLog();
+
+  DeathTestChildPool* const pool = DeathTestChildPool::Get();
+  DeathTestChild child;
+  const bool prefetched = pool->Take(info, death_test_index, &child);
+  if (!prefetched) {
+    child = SpawnDeathTestChild(*info, file_, line_, death_test_index);
+  }
+  pool->Prefetch(*info, death_test_index,
+                 (std::min)(GTEST_FLAG_GET(death_test_concurrency) - 1,
+                            death_test_index - 1));
+
+  if (prefetched) {
+    const std::string expected = DeathTestLocationRecord(file_, line_);
+    std::string actual(expected.size(), '\0');
+    if (!ReadFully(child.status_fd, &actual[0], actual.size()) ||
+        actual != expected) {
+      // The child reached a different death test at this index, or none.
+      DiscardDeathTestChild(child);
+      child = SpawnDeathTestChild(*info, file_, line_, death_test_index);
+    }
+  }
+
+  set_child_pid(child.pid);
+  set_read_fd(child.status_fd);
+  stderr_fd_ = child.stderr_fd;
+  set_spawned(true);
+  return OVERSEE_TEST;
+}
+
+// Reads the stderr output of the child process from its file.
+void ConcurrentDeathTest::ReadErrorLogs() {
+  GTEST_DEATH_TEST_CHECK_SYSCALL_(lseek(stderr_fd_, 0, SEEK_SET));
+  char buffer[64 * 1024];
+  for (;;) {
+    const int bytes_read = posix::Read(stderr_fd_, buffer, sizeof(buffer));
+    if (bytes_read == -1 && errno == EINTR) continue;
+    GTEST_DEATH_TEST_CHECK_(bytes_read != -1);
+    if (bytes_read == 0) break;
+    output()->Append(buffer, static_cast<size_t>(bytes_read));
+  }
+}
+
 #endif  // !GTEST_OS_WINDOWS
 
+// Starts the death test zygote if --gtest_death_test_use_zygote is set and
+// this process is not itself a death test child.  Must be called before any
+// test runs.  When the zygote later forks a death test child, this function
+// returns a second time, in that child, with the death test flags set.
+void StartDeathTestZygoteIfRequested() {
+#if !GTEST_OS_WINDOWS && !GTEST_OS_FUCHSIA
+  if (!GTEST_FLAG_GET(death_test_use_zygote) ||
+      !GTEST_FLAG_GET(internal_run_death_test).empty() ||
+      DeathTestZygote::Get() != nullptr) {
+    return;
+  }
+
+  StopBackgroundThreads();
+  const size_t thread_count = GetThreadCount();
+  if (thread_count > 1) {
+    GTEST_LOG_(WARNING) << "Not starting the death test zygote, as "
+                        << thread_count << " threads are already running. "
+                        << "Threadsafe-style death tests will re-execute "
+                        << "the test program instead.";
+    return;
+  }
+
+  DeathTestZygote::Start();
+#endif  // !GTEST_OS_WINDOWS && !GTEST_OS_FUCHSIA
+}
+
+// Kills the death test children that were started ahead of time for the
+// test that just finished and turned out not to be needed.
+void DiscardPrefetchedDeathTestChildren() {
+#if !GTEST_OS_WINDOWS && !GTEST_OS_FUCHSIA
+  DeathTestChildPool::Get()->DiscardAll();
+#endif  // !GTEST_OS_WINDOWS && !GTEST_OS_FUCHSIA
+}
+
 // Creates a concrete DeathTest-derived class that depends on the
 // --gtest_death_test_style flag, and sets the pointer pointed to
 // by the "test" argument to its address.  If the test should be
@@ -1456,8 +2307,20 @@ bool DefaultDeathTestFactory::Create(const char* statement,
       return false;
     }
 
-    if (!(flag->file() == file && flag->line() == line &&
-          flag->index() == death_test_index)) {
+    bool is_requested_death_test = flag->file() == file &&
+                                   flag->line() == line &&
+                                   flag->index() == death_test_index;
+#if !GTEST_OS_WINDOWS && !GTEST_OS_FUCHSIA
+    // A child started ahead of time by ConcurrentDeathTest runs whatever
+    // death test it reaches at its index, after telling the parent which.
+    if (flag->file().empty() && flag->index() == death_test_index) {
+      const std::string record = DeathTestLocationRecord(file, line);
+      GTEST_DEATH_TEST_CHECK_(
+          WriteFully(flag->write_fd(), record.data(), record.size()));
+      is_requested_death_test = true;
+    }
+#endif  // !GTEST_OS_WINDOWS && !GTEST_OS_FUCHSIA
+    if (!is_requested_death_test) {
       *test = nullptr;
       return true;
     }
@@ -1480,7 +2343,17 @@ bool DefaultDeathTestFactory::Create(const char* statement,
 #else
 
   if (GTEST_FLAG_GET(death_test_style) == "threadsafe") {
-    *test = new ExecDeathTest(statement, std::move(matcher), file, line);
+    if (DeathTestZygote::Get() != nullptr) {
+      *test = new ZygoteDeathTest(statement, std::move(matcher), file, line);
+#if !GTEST_OS_QNX
+    } else if (flag == nullptr &&
+               GTEST_FLAG_GET(death_test_concurrency) > 1) {
+      *test =
+          new ConcurrentDeathTest(statement, std::move(matcher), file, line);
+#endif  // !GTEST_OS_QNX
+    } else {
+      *test = new ExecDeathTest(statement, std::move(matcher), file, line);
+    }
   } else if (GTEST_FLAG_GET(death_test_style) == "fast") {
     *test = new NoExecDeathTest(statement, std::move(matcher));
   }
@@ -43,8 +43,10 @@
 
 #include <algorithm>
 #include <cstdint>
+#include <functional>
 #include <memory>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include "gtest/internal/gtest-port.h"
@@ -52,6 +54,11 @@
 #if GTEST_CAN_STREAM_RESULTS_
 #include <arpa/inet.h>  // NOLINT
 #include <netdb.h>      // NOLINT
+
+#include <atomic>
+#if GTEST_IS_THREADSAFE
+#include <thread>  // NOLINT
+#endif  // GTEST_IS_THREADSAFE
 #endif
 
 #if GTEST_OS_WINDOWS
@@ -69,7 +76,16 @@ GTEST_DISABLE_MSC_WARNINGS_PUSH_(4251 \
 // We don't want the users to modify this flag in the code, but want
 // Google Test's own unit tests to be able to access it. Therefore we
 // declare it here as opposed to in gtest.h.
+GTEST_DECLARE_int32_(captured_output_limit);
+GTEST_DECLARE_string_(clock);
 GTEST_DECLARE_bool_(death_test_use_fork);
+GTEST_DECLARE_bool_(death_test_use_posix_spawn);
+GTEST_DECLARE_bool_(death_test_use_zygote);
+GTEST_DECLARE_int32_(death_test_concurrency);
+GTEST_DECLARE_int32_(death_test_output_limit);
+GTEST_DECLARE_string_(isolation);
+GTEST_DECLARE_bool_(output_buffering);
+GTEST_DECLARE_int32_(time_precision);
 
 namespace testing {
 namespace internal {
@@ -88,12 +104,33 @@ GTEST_API_ extern bool g_help_flag;
 // Returns the current time in milliseconds.
 GTEST_API_ TimeInMillis GetTimeInMillis();
 
+// The clocks that GetMonotonicTimeInNanos() can read, as selected by
+// --gtest_clock.
+enum class MonotonicClock {
+  kSteady,  // std::chrono::steady_clock.
+  kTsc,     // The invariant time stamp counter of x86 CPUs.
+};
+
+// Makes GetMonotonicTimeInNanos() read the given clock, calibrating it
+// first if needed.  Returns false and leaves the clock unchanged if the
+// clock is not available on this system.  Not thread safe.
+GTEST_API_ bool SetMonotonicClock(MonotonicClock clock);
+
+// Returns a reading of a monotonic clock in nanoseconds.  The readings are
+// only meaningful relative to each other.
+GTEST_API_ TimeInNanos GetMonotonicTimeInNanos();
+
 // Returns true if and only if Google Test should use colors in the output.
 GTEST_API_ bool ShouldUseColor(bool stdout_is_tty);
 
 // Formats the given time in milliseconds as seconds.
 GTEST_API_ std::string FormatTimeInMillisAsSeconds(TimeInMillis ms);
 
+// Formats the given time in nanoseconds as seconds, with at most precision
+// digits after the decimal point and without trailing zeros.
+GTEST_API_ std::string FormatTimeInNanosAsSeconds(TimeInNanos ns,
+                                                  int precision);
+
 // Converts the given time in milliseconds to a date string in the ISO 8601
 // format, without the timezone information.  N.B.: due to the use the
 // non-reentrant localtime() function, this function is not thread safe.  Do
@@ -141,16 +178,25 @@ class GTestFlagSaver {
   GTestFlagSaver() {
     also_run_disabled_tests_ = GTEST_FLAG_GET(also_run_disabled_tests);
     break_on_failure_ = GTEST_FLAG_GET(break_on_failure);
+    captured_output_limit_ = GTEST_FLAG_GET(captured_output_limit);
     catch_exceptions_ = GTEST_FLAG_GET(catch_exceptions);
+    check_pooled_reset_ = GTEST_FLAG_GET(check_pooled_reset);
+    clock_ = GTEST_FLAG_GET(clock);
     color_ = GTEST_FLAG_GET(color);
     death_test_style_ = GTEST_FLAG_GET(death_test_style);
     death_test_use_fork_ = GTEST_FLAG_GET(death_test_use_fork);
+    death_test_use_posix_spawn_ = GTEST_FLAG_GET(death_test_use_posix_spawn);
+    death_test_use_zygote_ = GTEST_FLAG_GET(death_test_use_zygote);
+    death_test_concurrency_ = GTEST_FLAG_GET(death_test_concurrency);
+    death_test_output_limit_ = GTEST_FLAG_GET(death_test_output_limit);
     fail_fast_ = GTEST_FLAG_GET(fail_fast);
     filter_ = GTEST_FLAG_GET(filter);
     internal_run_death_test_ = GTEST_FLAG_GET(internal_run_death_test);
+    isolation_ = GTEST_FLAG_GET(isolation);
     list_tests_ = GTEST_FLAG_GET(list_tests);
     output_ = GTEST_FLAG_GET(output);
     brief_ = GTEST_FLAG_GET(brief);
+    output_buffering_ = GTEST_FLAG_GET(output_buffering);
     print_time_ = GTEST_FLAG_GET(print_time);
     print_utf8_ = GTEST_FLAG_GET(print_utf8);
     random_seed_ = GTEST_FLAG_GET(random_seed);
@@ -161,22 +207,32 @@ class GTestFlagSaver {
     stack_trace_depth_ = GTEST_FLAG_GET(stack_trace_depth);
     stream_result_to_ = GTEST_FLAG_GET(stream_result_to);
     throw_on_failure_ = GTEST_FLAG_GET(throw_on_failure);
+    time_precision_ = GTEST_FLAG_GET(time_precision);
   }
 
   // The d'tor is not virtual.  DO NOT INHERIT FROM THIS CLASS.
   ~GTestFlagSaver() {
     GTEST_FLAG_SET(also_run_disabled_tests, also_run_disabled_tests_);
     GTEST_FLAG_SET(break_on_failure, break_on_failure_);
+    GTEST_FLAG_SET(captured_output_limit, captured_output_limit_);
     GTEST_FLAG_SET(catch_exceptions, catch_exceptions_);
+    GTEST_FLAG_SET(check_pooled_reset, check_pooled_reset_);
+    GTEST_FLAG_SET(clock, clock_);
     GTEST_FLAG_SET(color, color_);
     GTEST_FLAG_SET(death_test_style, death_test_style_);
     GTEST_FLAG_SET(death_test_use_fork, death_test_use_fork_);
+    GTEST_FLAG_SET(death_test_use_posix_spawn, death_test_use_posix_spawn_);
+    GTEST_FLAG_SET(death_test_use_zygote, death_test_use_zygote_);
+    GTEST_FLAG_SET(death_test_concurrency, death_test_concurrency_);
+    GTEST_FLAG_SET(death_test_output_limit, death_test_output_limit_);
     GTEST_FLAG_SET(filter, filter_);
     GTEST_FLAG_SET(fail_fast, fail_fast_);
     GTEST_FLAG_SET(internal_run_death_test, internal_run_death_test_);
+    GTEST_FLAG_SET(isolation, isolation_);
     GTEST_FLAG_SET(list_tests, list_tests_);
     GTEST_FLAG_SET(output, output_);
     GTEST_FLAG_SET(brief, brief_);
+    GTEST_FLAG_SET(output_buffering, output_buffering_);
     GTEST_FLAG_SET(print_time, print_time_);
     GTEST_FLAG_SET(print_utf8, print_utf8_);
     GTEST_FLAG_SET(random_seed, random_seed_);
@@ -187,22 +243,32 @@ class GTestFlagSaver {
     GTEST_FLAG_SET(stack_trace_depth, stack_trace_depth_);
     GTEST_FLAG_SET(stream_result_to, stream_result_to_);
     GTEST_FLAG_SET(throw_on_failure, throw_on_failure_);
+    GTEST_FLAG_SET(time_precision, time_precision_);
   }
 
  private:
   // Fields for saving the original values of flags.
   bool also_run_disabled_tests_;
   bool break_on_failure_;
+  int32_t captured_output_limit_;
   bool catch_exceptions_;
+  bool check_pooled_reset_;
+  std::string clock_;
   std::string color_;
   std::string death_test_style_;
   bool death_test_use_fork_;
+  bool death_test_use_posix_spawn_;
+  bool death_test_use_zygote_;
+  int32_t death_test_concurrency_;
+  int32_t death_test_output_limit_;
   bool fail_fast_;
   std::string filter_;
   std::string internal_run_death_test_;
+  std::string isolation_;
   bool list_tests_;
   std::string output_;
   bool brief_;
+  bool output_buffering_;
   bool print_time_;
   bool print_utf8_;
   int32_t random_seed_;
@@ -212,6 +278,7 @@ class GTestFlagSaver {
   int32_t stack_trace_depth_;
   std::string stream_result_to_;
   bool throw_on_failure_;
+  int32_t time_precision_;
 } GTEST_ATTRIBUTE_UNUSED_;
 
 // Converts a Unicode code point to a narrow string in UTF-8 encoding.
@@ -237,6 +304,9 @@ GTEST_API_ std::string CodePointToUtf8(uint32_t code_point);
 // will be encoded as individual Unicode characters from Basic Normal Plane.
 GTEST_API_ std::string WideStringToUtf8(const wchar_t* str, int num_chars);
 
+// Empties the object pools of Pooled<T>.  Called after each test suite.
+void ClearObjectPools();
+
 // Reads the GTEST_SHARD_STATUS_FILE environment variable, and creates the file
 // if the variable is present. If a file already exists at this location, this
 // function will write over it. If the variable is present, but the file cannot
@@ -439,6 +509,13 @@ class OsStackTraceGetter : public OsStackTraceGetterInterface {
 
  private:
 #if GTEST_HAS_ABSL
+  // Returns the symbol for the given code address, or "(unknown)".
+  // Symbolizing is much slower than capturing the raw stack, and a test
+  // that fails in a loop fails from the same few addresses over and over,
+  // so the result is cached for later failures.
+  const std::string& Symbolize(void* address)
+      GTEST_EXCLUSIVE_LOCK_REQUIRED_(mutex_);
+
   Mutex mutex_;  // Protects all internal state.
 
   // We save the stack frame below the frame that calls user code.
@@ -446,6 +523,9 @@ class OsStackTraceGetter : public OsStackTraceGetterInterface {
   // the user code changes between the call to UponLeavingGTest()
   // and any calls to the stack trace code from within the user code.
   void* caller_frame_ = nullptr;
+
+  // The symbols of the addresses that appeared in earlier stack traces.
+  std::unordered_map<void*, std::string> symbol_cache_;
 #endif  // GTEST_HAS_ABSL
 
   OsStackTraceGetter(const OsStackTraceGetter&) = delete;
@@ -457,6 +537,15 @@ struct TraceInfo {
   const char* file;
   int line;
   std::string message;
+  // If not null, the message is format(value) instead, where value belongs
+  // to the ScopedTrace that pushed the trace point.
+  std::string (*format)(const void* value) = nullptr;
+  const void* value = nullptr;
+
+  // Returns the message, formatting it if needed.
+  std::string MessageText() const {
+    return format != nullptr ? format(value) : message;
+  }
 };
 
 // This is the default global test part result reporter used in UnitTestImpl.
@@ -497,6 +586,29 @@ class DefaultPerThreadTestPartResultReporter
       const DefaultPerThreadTestPartResultReporter&) = delete;
 };
 
+// Base class of the objects that run a thread of Google Test in the
+// background, such as the one forwarding events to an asynchronous
+// listener.  The thread starts when needed, and StopBackgroundThreads()
+// stops it before the process forks, so that death tests and
+// --gtest_isolation don't fork a multi-threaded process.
+class GTEST_API_ BackgroundThreadOwner {
+ public:
+  BackgroundThreadOwner();
+  virtual ~BackgroundThreadOwner();
+
+  // Stops the thread after it has done the work it was given, if it runs.
+  // It starts again when there is more work.  Must not be called on the
+  // thread itself.
+  virtual void StopBackgroundThread() = 0;
+
+ private:
+  BackgroundThreadOwner(const BackgroundThreadOwner&) = delete;
+  BackgroundThreadOwner& operator=(const BackgroundThreadOwner&) = delete;
+};
+
+// Stops the threads of all BackgroundThreadOwners.
+GTEST_API_ void StopBackgroundThreads();
+
 // The private implementation of the UnitTest class.  We don't protect
 // the methods under a mutex, as this class is not accessible by a
 // user and the UnitTest class that delegates work to this class does
@@ -569,7 +681,10 @@ class GTEST_API_ UnitTestImpl {
   TimeInMillis start_timestamp() const { return start_timestamp_; }
 
   // Gets the elapsed time, in milliseconds.
-  TimeInMillis elapsed_time() const { return elapsed_time_; }
+  TimeInMillis elapsed_time() const { return elapsed_time_ns_ / 1000000; }
+
+  // Gets the elapsed time, in nanoseconds.
+  TimeInNanos elapsed_time_ns() const { return elapsed_time_ns_; }
 
   // Returns true if and only if the unit test passed (i.e. all test suites
   // passed).
@@ -717,12 +832,13 @@ class GTEST_API_ UnitTestImpl {
     current_test_info_ = a_current_test_info;
   }
 
-  // Registers all parameterized tests defined using TEST_P and
-  // INSTANTIATE_TEST_SUITE_P, creating regular tests for each test/parameter
-  // combination. This method can be called more then once; it has guards
-  // protecting from registering the tests more then once.  If
-  // value-parameterized tests are disabled, RegisterParameterizedTests is
-  // present but does nothing.
+  // Registers the parameterized tests defined using TEST_P and
+  // INSTANTIATE_TEST_SUITE_P that match --gtest_filter, creating regular
+  // tests for each selected test/parameter combination. This method can be
+  // called more then once; it has guards protecting from registering the
+  // tests more then once, and registers the tests that a changed filter
+  // selects.  If value-parameterized tests are disabled,
+  // RegisterParameterizedTests is present but does nothing.
   void RegisterParameterizedTests();
 
   // Runs all tests in this UnitTest object, prints the result, and
@@ -800,6 +916,10 @@ class GTEST_API_ UnitTestImpl {
   // UnitTestOptions. Must not be called before InitGoogleTest.
   void ConfigureXmlOutput();
 
+  // Selects the clock that measures test times as --gtest_clock asks.
+  // Must not be called before InitGoogleTest.
+  void ConfigureClock();
+
 #if GTEST_CAN_STREAM_RESULTS_
   // Initializes the event listener for streaming test results to a socket.
   // Must not be called before InitGoogleTest.
@@ -830,6 +950,17 @@ class GTEST_API_ UnitTestImpl {
   // UnitTest::Run() starts.
   bool catch_exceptions() const { return catch_exceptions_; }
 
+  // Calls run in a child process forked for --gtest_isolation and replays
+  // the events of the tests it runs, which the child sends through a pipe,
+  // to the listeners.  test_info is the current test if run runs just that
+  // test, or nullptr if run runs all tests of the current test suite.
+  // Records the time the fork and the pipe added as the
+  // "isolation_overhead_us" property of the test or the test suite, and
+  // returns the elapsed time, in nanoseconds, of the test or the test suite
+  // as measured in the child.  Where fork() is not available, simply calls run.
+  TimeInNanos RunIsolated(TestInfo* test_info,
+                          const std::function<void()>& run);
+
  private:
   friend class ::testing::UnitTest;
 
@@ -886,6 +1017,10 @@ class GTEST_API_ UnitTestImpl {
   // Indicates whether RegisterParameterizedTests() has been called already.
   bool parameterized_tests_registered_;
 
+  // The --gtest_filter that the last call of RegisterParameterizedTests()
+  // selected parameterized tests with.
+  std::string parameterized_tests_filter_;
+
   // Index of the last death test suite registered.  Initially -1.
   int last_death_test_suite_;
 
@@ -934,8 +1069,8 @@ class GTEST_API_ UnitTestImpl {
   // UNIX epoch.
   TimeInMillis start_timestamp_;
 
-  // How long the test took to run, in milliseconds.
-  TimeInMillis elapsed_time_;
+  // How long the test took to run, in nanoseconds.
+  TimeInNanos elapsed_time_ns_;
 
 #if GTEST_HAS_DEATH_TEST
   // The decomposed components of the gtest_internal_run_death_test flag,
@@ -1070,47 +1205,93 @@ class StreamingListener : public EmptyTestEventListener {
     void SendLn(const std::string& message) { Send(message + "\n"); }
   };
 
-  // Concrete class for actually writing strings to a socket.
-  class SocketWriter : public AbstractSocketWriter {
+  // Concrete class for actually writing strings to a socket.  Connects to
+  // host:port over TCP, or to the Unix domain socket at port if host is
+  // "unix".
+  //
+  // Send() only appends to a buffer.  A background thread writes the buffer
+  // to the non-blocking socket in batches, when enough of it has built up or
+  // at regular intervals, so that the tests neither make a system call per
+  // event nor wait for a slow receiver.  Only if the receiver falls so far
+  // behind that the buffer fills up does Send() wait for it, so that no
+  // result is lost.  If the connection fails or is lost, the thread tries to
+  // reconnect a few times, backing off between attempts, and then discards
+  // the results; a dead receiver never blocks the tests.
+  class SocketWriter : public AbstractSocketWriter,
+                       public BackgroundThreadOwner {
    public:
-    SocketWriter(const std::string& host, const std::string& port)
-        : sockfd_(-1), host_name_(host), port_num_(port) {
-      MakeConnection();
-    }
+    SocketWriter(const std::string& host, const std::string& port);
+    ~SocketWriter() override;
 
-    ~SocketWriter() override {
-      if (sockfd_ != -1) CloseConnection();
-    }
+    // Queues a string for the socket, first waiting for room in the buffer
+    // if it is full.  Drops what is buffered if the receiver stalls.
+    void Send(const std::string& message) override;
 
-    // Sends a string to the socket.
-    void Send(const std::string& message) override {
-      GTEST_CHECK_(sockfd_ != -1)
-          << "Send() can be called only when there is a connection.";
-
-      const auto len = static_cast<size_t>(message.length());
-      if (write(sockfd_, message.c_str(), len) != static_cast<ssize_t>(len)) {
-        GTEST_LOG_(WARNING) << "stream_result_to: failed to stream to "
-                            << host_name_ << ":" << port_num_;
-      }
-    }
+    // Stops the thread writing the buffer.  What it holds is written once
+    // the thread starts again.
+    void StopBackgroundThread() override;
 
    private:
     // Creates a client socket and connects to the server.
     void MakeConnection();
 
-    // Closes the socket.
-    void CloseConnection() override {
-      GTEST_CHECK_(sockfd_ != -1)
-          << "CloseConnection() can be called only when there is a connection.";
+    // Writes what is still buffered, waiting at most a few seconds for the
+    // receiver, and closes the socket.
+    void CloseConnection() override;
 
-      close(sockfd_);
-      sockfd_ = -1;
-    }
+    // Connects if not connected, subject to the reconnect policy.  Returns
+    // whether there is a connection.  A closing writer does not wait for
+    // the backoff delay.
+    bool EnsureConnection(bool closing);
+
+    // Writes the start of *data to the socket, waiting at most timeout_ms
+    // for the receiver to accept more, and removes what was written from
+    // *data.  Returns false if the connection is lost.
+    bool Write(std::string* data, int timeout_ms);
+
+    // Writes *data, reconnecting if needed.
+    void Flush(std::string* data, bool closing);
+
+    // Warns that the receiver stalled, and clears *data.
+    void DropStalledData(std::string* data);
+
+#if GTEST_IS_THREADSAFE
+    // Starts the thread that writes the buffer unless it runs, or is being
+    // stopped.  Must be called with mutex_ held.
+    void StartThreadIfStopped();
+
+    // The body of the thread that writes the buffer.
+    void FlushLoop();
+#endif  // GTEST_IS_THREADSAFE
 
     int sockfd_;  // socket file descriptor
     const std::string host_name_;
     const std::string port_num_;
 
+    // Consecutive failed connection attempts, and when the next one may be
+    // made.  Only used by the thread that writes to the socket.
+    int failed_attempts_;
+    TimeInMillis next_attempt_;
+
+    // The strings that have been sent but not written yet, whether
+    // CloseConnection() was called, and whether the thread is being
+    // stopped.  Protected by mutex_.
+    std::string buffer_;
+    bool closing_;
+    bool stopping_;
+    // Whether the writer gave up on the receiver.  Send() is then a no-op.
+    std::atomic<bool> gave_up_;
+    // What the thread took from buffer_ but could not write yet.  The thread
+    // takes more only once this has been written.
+    std::string pending_;
+#if GTEST_IS_THREADSAFE
+    std::mutex mutex_;
+    std::condition_variable wake_up_;
+    // Notified when the thread takes the buffer.
+    std::condition_variable buffer_taken_;
+    std::thread thread_;
+#endif  // GTEST_IS_THREADSAFE
+
     SocketWriter(const SocketWriter&) = delete;
     SocketWriter& operator=(const SocketWriter&) = delete;
   };  // class SocketWriter
@@ -34,6 +34,7 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include <algorithm>
 #include <cstdint>
 #include <fstream>
 #include <memory>
@@ -65,6 +66,11 @@
 #endif
 #endif
 
+#if GTEST_OS_LINUX
+#include <errno.h>
+#include <sys/syscall.h>
+#endif  // GTEST_OS_LINUX
+
 #if GTEST_OS_QNX
 #include <devctl.h>
 #include <fcntl.h>
@@ -1030,11 +1036,79 @@ GTEST_DISABLE_MSC_DEPRECATED_PUSH_()
 
 #if GTEST_HAS_STREAM_REDIRECTION
 
+// memfd_create(2) appeared in Linux 3.17.  The system call is used directly
+// as glibc only wraps it since 2.27.
+#if GTEST_OS_LINUX && defined(SYS_memfd_create)
+#define GTEST_INTERNAL_HAS_MEMFD_CREATE_ 1
+#else
+#define GTEST_INTERNAL_HAS_MEMFD_CREATE_ 0
+#endif
+
+// Appends the note that replaces captured output beyond
+// --gtest_captured_output_limit.
+static void AppendOmittedOutputNote(size_t omitted_size, std::string* output) {
+  *output += "\n[... " + StreamableToString(omitted_size) +
+             " more bytes of captured output omitted ...]\n";
+}
+
+// Returns how many bytes to keep of total_size bytes of captured output,
+// per --gtest_captured_output_limit.
+static size_t KeptCapturedOutputSize(size_t total_size) {
+  const int32_t limit = GTEST_FLAG_GET(captured_output_limit);
+  return limit > 0 ? (std::min)(total_size, static_cast<size_t>(limit))
+                   : total_size;
+}
+
+#if GTEST_INTERNAL_HAS_MEMFD_CREATE_
+// Returns the captured output read from fd, limited to
+// --gtest_captured_output_limit bytes.  Only the kept bytes are read.
+static std::string ReadCapturedOutput(int fd) {
+  const off_t size = lseek(fd, 0, SEEK_END);
+  GTEST_CHECK_(size != -1) << "Failed to seek in captured stream.";
+  const size_t total_size = static_cast<size_t>(size);
+  const size_t kept_size = KeptCapturedOutputSize(total_size);
+
+  std::string content(kept_size, '\0');
+  size_t bytes_read = 0;
+  while (bytes_read < kept_size) {
+    const ssize_t n = pread(fd, &content[bytes_read], kept_size - bytes_read,
+                            static_cast<off_t>(bytes_read));
+    if (n == -1 && errno == EINTR) continue;
+    if (n <= 0) break;
+    bytes_read += static_cast<size_t>(n);
+  }
+  content.resize(bytes_read);
+  if (kept_size < total_size) {
+    AppendOmittedOutputNote(total_size - kept_size, &content);
+  }
+  return content;
+}
+#endif  // GTEST_INTERNAL_HAS_MEMFD_CREATE_
+
 // Object that captures an output stream (stdout/stderr).
 class CapturedStream {
  public:
-  // The ctor redirects the stream to a temporary file.
-  explicit CapturedStream(int fd) : fd_(fd), uncaptured_fd_(dup(fd)) {
+  // The ctor redirects the stream to an anonymous in-memory file if
+  // in_memory is true and memfd_create(2) is available, and to a temporary
+  // file otherwise.
+  CapturedStream(int fd, bool in_memory)
+      : fd_(fd), uncaptured_fd_(dup(fd)), captured_fd_(-1) {
+#if GTEST_INTERNAL_HAS_MEMFD_CREATE_
+    // Falls back to a temporary file if the kernel lacks memfd_create(2).
+    const unsigned int kMfdCloexec = 1;  // MFD_CLOEXEC
+    if (in_memory) {
+      captured_fd_ = static_cast<int>(
+          syscall(SYS_memfd_create, "gtest_captured_stream", kMfdCloexec));
+    }
+    if (captured_fd_ != -1) {
+      fflush(nullptr);
+      dup2(captured_fd_, fd_);
+      return;
+    }
+#else
+    static_cast<void>(in_memory);
+#endif  // GTEST_INTERNAL_HAS_MEMFD_CREATE_
+
 #if GTEST_OS_WINDOWS
     char temp_dir_path[MAX_PATH + 1] = {'\0'};   // NOLINT
     char temp_file_path[MAX_PATH + 1] = {'\0'};  // NOLINT
@@ -1112,31 +1186,87 @@ class CapturedStream {
     close(captured_fd);
   }
 
-  ~CapturedStream() { remove(filename_.c_str()); }
+  ~CapturedStream() {
+    if (captured_fd_ != -1) {
+      close(captured_fd_);
+    } else {
+      remove(filename_.c_str());
+    }
+  }
 
   std::string GetCapturedString() {
-    if (uncaptured_fd_ != -1) {
-      // Restores the original stream.
-      fflush(nullptr);
-      dup2(uncaptured_fd_, fd_);
-      close(uncaptured_fd_);
-      uncaptured_fd_ = -1;
-    }
+    RestoreStream();
+
+#if GTEST_INTERNAL_HAS_MEMFD_CREATE_
+    if (captured_fd_ != -1) return ReadCapturedOutput(captured_fd_);
+#endif  // GTEST_INTERNAL_HAS_MEMFD_CREATE_
 
     FILE* const file = posix::FOpen(filename_.c_str(), "r");
     if (file == nullptr) {
       GTEST_LOG_(FATAL) << "Failed to open tmp file " << filename_
                         << " for capturing stream.";
     }
-    const std::string content = ReadEntireFile(file);
+    // Like ReadCapturedOutput(), only reads the bytes that are kept.
+    const size_t total_size = GetFileSize(file);
+    const size_t kept_size = KeptCapturedOutputSize(total_size);
+    std::string content(kept_size, '\0');
+    fseek(file, 0, SEEK_SET);
+    content.resize(fread(&content[0], 1, kept_size, file));
     posix::FClose(file);
+    if (kept_size < total_size) {
+      AppendOmittedOutputNote(total_size - kept_size, &content);
+    }
     return content;
   }
 
+  // Passes the captured output to consumer in pieces of at most 64 KiB.
+  void ConsumeCapturedOutput(
+      const std::function<void(const char*, size_t)>& consumer) {
+    RestoreStream();
+
+    char buffer[64 * 1024];
+#if GTEST_INTERNAL_HAS_MEMFD_CREATE_
+    if (captured_fd_ != -1) {
+      for (off_t offset = 0;;) {
+        const ssize_t n = pread(captured_fd_, buffer, sizeof(buffer), offset);
+        if (n == -1 && errno == EINTR) continue;
+        GTEST_CHECK_(n != -1) << "Failed to read captured stream.";
+        if (n == 0) return;
+        consumer(buffer, static_cast<size_t>(n));
+        offset += n;
+      }
+    }
+#endif  // GTEST_INTERNAL_HAS_MEMFD_CREATE_
+
+    FILE* const file = posix::FOpen(filename_.c_str(), "r");
+    if (file == nullptr) {
+      GTEST_LOG_(FATAL) << "Failed to open tmp file " << filename_
+                        << " for capturing stream.";
+    }
+    size_t n;
+    while ((n = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+      consumer(buffer, n);
+    }
+    posix::FClose(file);
+  }
+
  private:
+  // Restores the original stream, if that has not been done yet.
+  void RestoreStream() {
+    if (uncaptured_fd_ != -1) {
+      fflush(nullptr);
+      dup2(uncaptured_fd_, fd_);
+      close(uncaptured_fd_);
+      uncaptured_fd_ = -1;
+    }
+  }
+
   const int fd_;  // A stream to capture.
   int uncaptured_fd_;
-  // Name of the temporary file holding the stderr output.
+  // The in-memory file holding the captured output, or -1 if a temporary
+  // file on disk is used.
+  int captured_fd_;
+  // Name of the temporary file holding the captured output.
   ::std::string filename_;
 
   CapturedStream(const CapturedStream&) = delete;
@@ -1150,12 +1280,12 @@ static CapturedStream* g_captured_stdout = nullptr;
 
 // Starts capturing an output stream (stdout/stderr).
 static void CaptureStream(int fd, const char* stream_name,
-                          CapturedStream** stream) {
+                          CapturedStream** stream, bool in_memory = true) {
   if (*stream != nullptr) {
     GTEST_LOG_(FATAL) << "Only one " << stream_name
                       << " capturer can exist at a time.";
   }
-  *stream = new CapturedStream(fd);
+  *stream = new CapturedStream(fd, in_memory);
 }
 
 // Stops capturing the output stream and returns the captured string.
@@ -1168,6 +1298,17 @@ static std::string GetCapturedStream(CapturedStream** captured_stream) {
   return content;
 }
 
+// Stops capturing the output stream and passes the captured output to
+// consumer piece by piece.
+static void ConsumeCapturedStream(
+    CapturedStream** captured_stream,
+    const std::function<void(const char*, size_t)>& consumer) {
+  (*captured_stream)->ConsumeCapturedOutput(consumer);
+
+  delete *captured_stream;
+  *captured_stream = nullptr;
+}
+
 #if defined(_MSC_VER) || defined(__BORLANDC__)
 // MSVC and C++Builder do not provide a definition of STDERR_FILENO.
 const int kStdOutFileno = 1;
@@ -1187,6 +1328,12 @@ void CaptureStderr() {
   CaptureStream(kStdErrFileno, "stderr", &g_captured_stderr);
 }
 
+// Starts capturing stderr into a temporary file.
+void CaptureStderrToFile() {
+  CaptureStream(kStdErrFileno, "stderr", &g_captured_stderr,
+                /* in_memory = */ false);
+}
+
 // Stops capturing stdout and returns the captured string.
 std::string GetCapturedStdout() {
   return GetCapturedStream(&g_captured_stdout);
@@ -1197,6 +1344,13 @@ std::string GetCapturedStderr() {
   return GetCapturedStream(&g_captured_stderr);
 }
 
+// Stops capturing stderr and passes the captured output to consumer piece
+// by piece.
+void ConsumeCapturedStderr(
+    const std::function<void(const char* data, size_t size)>& consumer) {
+  ConsumeCapturedStream(&g_captured_stderr, consumer);
+}
+
 #endif  // GTEST_HAS_STREAM_REDIRECTION
 
 size_t GetFileSize(FILE* file) {
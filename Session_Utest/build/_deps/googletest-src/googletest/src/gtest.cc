@@ -116,13 +116,37 @@
 
 #if GTEST_CAN_STREAM_RESULTS_
 #include <arpa/inet.h>   // NOLINT
+#include <fcntl.h>       // NOLINT
 #include <netdb.h>       // NOLINT
+#include <poll.h>        // NOLINT
 #include <sys/socket.h>  // NOLINT
 #include <sys/types.h>   // NOLINT
+#include <sys/un.h>      // NOLINT
 #endif
 
 #include "src/gtest-internal-inl.h"
 
+#if GTEST_IS_THREADSAFE
+#include <atomic>
+#include <thread>  // NOLINT
+#endif  // GTEST_IS_THREADSAFE
+
+#if GTEST_CAN_ISOLATE_TESTS_
+#include <sys/wait.h>  // NOLINT
+#include <unistd.h>    // NOLINT
+#endif  // GTEST_CAN_ISOLATE_TESTS_
+
+#if GTEST_CAN_FLUSH_OUTPUT_ON_SIGNAL_
+#include <signal.h>     // NOLINT
+#include <stdio_ext.h>  // NOLINT
+#include <unistd.h>     // NOLINT
+#endif  // GTEST_CAN_FLUSH_OUTPUT_ON_SIGNAL_
+
+#if GTEST_CAN_READ_TSC_
+#include <cpuid.h>      // NOLINT
+#include <x86intrin.h>  // NOLINT
+#endif  // GTEST_CAN_READ_TSC_
+
 #if GTEST_OS_WINDOWS
 #define vsnprintf _vsnprintf
 #endif  // GTEST_OS_WINDOWS
@@ -252,12 +276,33 @@ GTEST_DEFINE_bool_(
     "True if and only if a failed assertion should be a debugger "
     "break-point.");
 
+GTEST_DEFINE_int32_(
+    captured_output_limit,
+    testing::internal::Int32FromGTestEnv("captured_output_limit", 0),
+    "The maximum number of bytes of stdout or stderr output captured by "
+    "CaptureStdout() or CaptureStderr() that is kept.  Output beyond the "
+    "limit is replaced by a note.  0 means no limit.");
+
 GTEST_DEFINE_bool_(catch_exceptions,
                    testing::internal::BoolFromGTestEnv("catch_exceptions",
                                                        true),
                    "True if and only if " GTEST_NAME_
                    " should catch exceptions and treat them as test failures.");
 
+GTEST_DEFINE_bool_(
+    check_pooled_reset,
+    testing::internal::BoolFromGTestEnv("check_pooled_reset", false),
+    "True if and only if a test should fail when an object it used through "
+    "Pooled<T> differs from a newly constructed one after Reset(), which "
+    "means that its state would leak into the next test.");
+
+GTEST_DEFINE_string_(
+    clock, testing::internal::StringFromGTestEnv("clock", "steady"),
+    "The clock that test times are measured with.  Valid values: steady "
+    "and tsc.  'tsc' reads the time stamp counter of the CPU, which is "
+    "cheaper than the steady clock of the system; it falls back to 'steady' "
+    "where the CPU has no invariant time stamp counter.");
+
 GTEST_DEFINE_string_(
     color, testing::internal::StringFromGTestEnv("color", "auto"),
     "Whether to use colors in the output.  Valid values: yes, no, "
@@ -284,6 +329,14 @@ GTEST_DEFINE_bool_(
     "install a signal handler that dumps debugging information when fatal "
     "signals are raised.");
 
+GTEST_DEFINE_string_(
+    isolation, testing::internal::StringFromGTestEnv("isolation", "none"),
+    "Whether to run each test (\"test\") or each test suite (\"suite\") "
+    "in a child process forked after the global test environments have "
+    "been set up, so that changes it makes to the state of the process "
+    "don't affect other tests.  \"none\" runs all tests in the test "
+    "program's process.  The flag has no effect on systems without fork().");
+
 GTEST_DEFINE_bool_(list_tests, false, "List all tests without running them.");
 
 // The net priority order after flag processing is thus:
@@ -308,6 +361,14 @@ GTEST_DEFINE_bool_(
     brief, testing::internal::BoolFromGTestEnv("brief", false),
     "True if only test failures should be displayed in text output.");
 
+GTEST_DEFINE_bool_(
+    output_buffering,
+    testing::internal::BoolFromGTestEnv("output_buffering", false),
+    "True if and only if " GTEST_NAME_
+    " should buffer its text output and write it out in large batches: "
+    "on test failures, at the end of each iteration, at regular intervals, "
+    "and when the program exits or is killed by a signal.");
+
 GTEST_DEFINE_bool_(print_time,
                    testing::internal::BoolFromGTestEnv("print_time", true),
                    "True if and only if " GTEST_NAME_
@@ -361,8 +422,8 @@ GTEST_DEFINE_string_(
     stream_result_to,
     testing::internal::StringFromGTestEnv("stream_result_to", ""),
     "This flag specifies the host name and the port number on which to stream "
-    "test results. Example: \"localhost:555\". The flag is effective only on "
-    "Linux.");
+    "test results. Example: \"localhost:555\". Use \"unix:PATH\" to stream "
+    "to the Unix domain socket at PATH. The flag is effective only on Linux.");
 
 GTEST_DEFINE_bool_(
     throw_on_failure,
@@ -371,6 +432,12 @@ GTEST_DEFINE_bool_(
     "if exceptions are enabled or exit the program with a non-zero code "
     "otherwise. For use with an external test framework.");
 
+GTEST_DEFINE_int32_(
+    time_precision, testing::internal::Int32FromGTestEnv("time_precision", 3),
+    "The number of digits after the decimal point of the times, in seconds, "
+    "written to XML and JSON reports.  The valid range is 0 through 9, "
+    "inclusive; 9 writes them to the nanosecond.");
+
 #if GTEST_USE_OWN_FLAGFILE_FLAG_
 GTEST_DEFINE_string_(
     flagfile, testing::internal::StringFromGTestEnv("flagfile", ""),
@@ -542,6 +609,210 @@ void InsertSyntheticTestCase(const std::string& name, CodeLocation location,
       });
 }
 
+namespace {
+
+// The covered cells of one interaction between a set of already placed
+// columns and the column being added by BuildCoveringArray().
+struct CoveringInteraction {
+  std::vector<size_t> columns;
+  std::vector<bool> covered;
+  size_t uncovered;
+};
+
+constexpr size_t kDontCareValue = static_cast<size_t>(-1);
+
+// Returns the cell of `interaction` that `row` covers when `value` is put in
+// column `column`, or kDontCareValue if the row leaves one of the
+// interaction's columns open.
+size_t CoveredCell(const CoveringInteraction& interaction,
+                   const std::vector<size_t>& counts,
+                   const std::vector<size_t>& row, size_t column,
+                   size_t value) {
+  size_t cell = 0;
+  for (size_t c : interaction.columns) {
+    if (row[c] == kDontCareValue) return kDontCareValue;
+    cell = cell * counts[c] + row[c];
+  }
+  return cell * counts[column] + value;
+}
+
+// Marks every cell that `row` covers in the interactions of `column`.
+void MarkCoveredCells(std::vector<CoveringInteraction>* interactions,
+                      const std::vector<size_t>& counts,
+                      const std::vector<size_t>& row, size_t column) {
+  if (row[column] == kDontCareValue) return;
+  for (CoveringInteraction& interaction : *interactions) {
+    const size_t cell =
+        CoveredCell(interaction, counts, row, column, row[column]);
+    if (cell != kDontCareValue && !interaction.covered[cell]) {
+      interaction.covered[cell] = true;
+      --interaction.uncovered;
+    }
+  }
+}
+
+// Appends to `rows` the Cartesian product of the values of the first
+// `columns` columns, the last column varying fastest, leaving the remaining
+// ones open.
+void AppendCartesianProduct(const std::vector<size_t>& counts, size_t columns,
+                            std::vector<std::vector<size_t>>* rows) {
+  std::vector<size_t> row(counts.size(), kDontCareValue);
+  std::fill(row.begin(), row.begin() + static_cast<ptrdiff_t>(columns), 0);
+  for (;;) {
+    rows->push_back(row);
+    size_t c = columns;
+    while (c > 0 && ++row[c - 1] == counts[c - 1]) row[--c] = 0;
+    if (c == 0) return;
+  }
+}
+
+}  // namespace
+
+// Builds the covering array with the IPOG strategy (Lei et al., "IPOG: A
+// General Strategy for T-Way Software Testing"): starting from the full
+// product of the first `strength` columns, each further column is first
+// filled into the existing rows greedily (horizontal growth), and the
+// combinations still missing are then placed into open cells of existing
+// rows or into new rows (vertical growth). Columns are added in order of
+// decreasing size, which keeps the initial product and the result small.
+std::vector<std::vector<size_t>> BuildCoveringArray(
+    const std::vector<size_t>& value_counts, int strength, uint32_t seed) {
+  GTEST_CHECK_(strength >= 1)
+      << "The strength of a covering array must be positive, but is "
+      << strength << ".";
+  std::vector<std::vector<size_t>> rows;
+  const size_t num_columns = value_counts.size();
+  if (num_columns == 0 ||
+      std::find(value_counts.begin(), value_counts.end(), 0) !=
+          value_counts.end()) {
+    return rows;
+  }
+  if (static_cast<size_t>(strength) >= num_columns) {
+    AppendCartesianProduct(value_counts, num_columns, &rows);
+    return rows;
+  }
+  const size_t t = static_cast<size_t>(strength);
+
+  // order[i] is the original index of the i-th column placed.
+  std::vector<size_t> order(num_columns);
+  for (size_t i = 0; i < num_columns; ++i) order[i] = i;
+  std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+    return value_counts[a] > value_counts[b];
+  });
+  std::vector<size_t> counts(num_columns);
+  for (size_t i = 0; i < num_columns; ++i) counts[i] = value_counts[order[i]];
+
+  Random random(seed);
+  AppendCartesianProduct(counts, t, &rows);
+  for (size_t column = t; column < num_columns; ++column) {
+    // One interaction for each choice of t - 1 of the columns placed so far.
+    std::vector<CoveringInteraction> interactions;
+    std::vector<size_t> chosen(t - 1);
+    for (size_t i = 0; i < t - 1; ++i) chosen[i] = i;
+    for (;;) {
+      size_t cells = counts[column];
+      for (size_t c : chosen) cells *= counts[c];
+      interactions.push_back({chosen, std::vector<bool>(cells, false), cells});
+      size_t i = t - 1;
+      while (i > 0 && chosen[i - 1] == column - t + i) --i;
+      if (i == 0) break;
+      ++chosen[i - 1];
+      for (size_t j = i; j < t - 1; ++j) chosen[j] = chosen[j - 1] + 1;
+    }
+
+    // Horizontal growth: give each row the value covering the most new
+    // cells, scanning from a seeded offset so that ties vary with the seed.
+    for (std::vector<size_t>& row : rows) {
+      const size_t offset =
+          random.Generate(static_cast<uint32_t>(counts[column]));
+      size_t best_value = kDontCareValue;
+      size_t best_gain = 0;
+      for (size_t i = 0; i < counts[column]; ++i) {
+        const size_t value = (offset + i) % counts[column];
+        size_t gain = 0;
+        for (const CoveringInteraction& interaction : interactions) {
+          const size_t cell =
+              CoveredCell(interaction, counts, row, column, value);
+          if (cell != kDontCareValue && !interaction.covered[cell]) ++gain;
+        }
+        if (gain > best_gain) {
+          best_value = value;
+          best_gain = gain;
+        }
+      }
+      row[column] = best_value;
+      MarkCoveredCells(&interactions, counts, row, column);
+    }
+
+    // Vertical growth: place each missing cell into the first row whose
+    // columns are either open or already hold the cell's values.
+    std::vector<size_t> open_rows;
+    for (size_t r = 0; r < rows.size(); ++r) {
+      if (std::find(rows[r].begin(),
+                    rows[r].begin() + static_cast<ptrdiff_t>(column) + 1,
+                    kDontCareValue) !=
+          rows[r].begin() + static_cast<ptrdiff_t>(column) + 1) {
+        open_rows.push_back(r);
+      }
+    }
+    std::vector<size_t> values(t);
+    for (CoveringInteraction& interaction : interactions) {
+      for (size_t cell = 0; interaction.uncovered > 0 &&
+                            cell < interaction.covered.size();
+           ++cell) {
+        if (interaction.covered[cell]) continue;
+        size_t rest = cell;
+        values[t - 1] = rest % counts[column];
+        rest /= counts[column];
+        for (size_t i = t - 1; i > 0; --i) {
+          values[i - 1] = rest % counts[interaction.columns[i - 1]];
+          rest /= counts[interaction.columns[i - 1]];
+        }
+        size_t target = kDontCareValue;
+        for (size_t r : open_rows) {
+          const std::vector<size_t>& row = rows[r];
+          bool fits_row = row[column] == kDontCareValue ||
+                          row[column] == values[t - 1];
+          for (size_t i = 0; fits_row && i < t - 1; ++i) {
+            const size_t c = interaction.columns[i];
+            fits_row = row[c] == kDontCareValue || row[c] == values[i];
+          }
+          if (fits_row) {
+            target = r;
+            break;
+          }
+        }
+        if (target == kDontCareValue) {
+          target = rows.size();
+          rows.emplace_back(num_columns, kDontCareValue);
+          open_rows.push_back(target);
+        }
+        std::vector<size_t>& row = rows[target];
+        for (size_t i = 0; i < t - 1; ++i) {
+          row[interaction.columns[i]] = values[i];
+        }
+        row[column] = values[t - 1];
+        MarkCoveredCells(&interactions, counts, row, column);
+      }
+    }
+  }
+
+  // Fill the cells left open with seeded values, and restore the caller's
+  // column order.
+  std::vector<std::vector<size_t>> result(
+      rows.size(), std::vector<size_t>(num_columns));
+  for (size_t r = 0; r < rows.size(); ++r) {
+    for (size_t c = 0; c < num_columns; ++c) {
+      size_t value = rows[r][c];
+      if (value == kDontCareValue) {
+        value = random.Generate(static_cast<uint32_t>(counts[c]));
+      }
+      result[r][order[c]] = value;
+    }
+  }
+  return result;
+}
+
 void RegisterTypeParameterizedTestSuite(const char* test_suite_name,
                                         CodeLocation code_location) {
   GetUnitTestImpl()->type_parameterized_test_registry().RegisterTestSuite(
@@ -1120,20 +1391,99 @@ std::string UnitTestImpl::CurrentOsStackTraceExceptTop(int skip_count) {
   );  // NOLINT
 }
 
+namespace {
+
+TimeInNanos ReadSteadyClock() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+#if GTEST_CAN_READ_TSC_
+
+// The calibration of the time stamp counter: a reading of tsc ticks is
+// g_tsc_base_ns + (tsc - g_tsc_base) * g_tsc_nanos_per_tick on the steady
+// clock.
+uint64_t g_tsc_base = 0;
+TimeInNanos g_tsc_base_ns = 0;
+double g_tsc_nanos_per_tick = 0;
+
+TimeInNanos ReadTsc() {
+  // The counters of different CPUs may be slightly apart, so a reading can
+  // precede g_tsc_base; the difference is signed so as not to wrap around.
+  const int64_t ticks = static_cast<int64_t>(__rdtsc() - g_tsc_base);
+  return g_tsc_base_ns +
+         static_cast<TimeInNanos>(static_cast<double>(ticks) *
+                                  g_tsc_nanos_per_tick);
+}
+
+// Returns true if and only if the time stamp counter ticks at a constant
+// rate whatever the power state of the CPU, which makes it a clock.
+bool HasInvariantTsc() {
+  unsigned int eax, ebx, ecx, edx;
+  if (__get_cpuid_max(0x80000000, nullptr) < 0x80000007 ||
+      !__get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx)) {
+    return false;
+  }
+  return (edx & (1u << 8)) != 0;
+}
+
+// Measures the rate of the time stamp counter against the steady clock.
+// The 10 ms it spins for keep the error of the rate in the tens of ppm.
+bool CalibrateTsc() {
+  if (!HasInvariantTsc()) return false;
+  const TimeInNanos start_ns = ReadSteadyClock();
+  const uint64_t start = __rdtsc();
+  TimeInNanos end_ns;
+  do {
+    end_ns = ReadSteadyClock();
+  } while (end_ns - start_ns < 10000000);
+  const uint64_t end = __rdtsc();
+  if (end <= start) return false;
+  g_tsc_base = end;
+  g_tsc_base_ns = end_ns;
+  g_tsc_nanos_per_tick = static_cast<double>(end_ns - start_ns) /
+                         static_cast<double>(end - start);
+  return true;
+}
+
+#endif  // GTEST_CAN_READ_TSC_
+
+// The clock that GetMonotonicTimeInNanos() reads.  It is chosen before any
+// test runs, so reading it needs no synchronization.
+TimeInNanos (*g_monotonic_clock)() = &ReadSteadyClock;
+
+}  // namespace
+
+bool SetMonotonicClock(MonotonicClock clock) {
+  switch (clock) {
+    case MonotonicClock::kSteady:
+      g_monotonic_clock = &ReadSteadyClock;
+      return true;
+    case MonotonicClock::kTsc:
+#if GTEST_CAN_READ_TSC_
+      if (g_monotonic_clock == &ReadTsc || CalibrateTsc()) {
+        g_monotonic_clock = &ReadTsc;
+        return true;
+      }
+#endif  // GTEST_CAN_READ_TSC_
+      return false;
+  }
+  return false;
+}
+
+TimeInNanos GetMonotonicTimeInNanos() { return g_monotonic_clock(); }
+
 // A helper class for measuring elapsed times.
 class Timer {
  public:
-  Timer() : start_(std::chrono::steady_clock::now()) {}
+  Timer() : start_(GetMonotonicTimeInNanos()) {}
 
-  // Return time elapsed in milliseconds since the timer was created.
-  TimeInMillis Elapsed() {
-    return std::chrono::duration_cast<std::chrono::milliseconds>(
-               std::chrono::steady_clock::now() - start_)
-        .count();
-  }
+  // Return time elapsed in nanoseconds since the timer was created.
+  TimeInNanos ElapsedNanos() { return GetMonotonicTimeInNanos() - start_; }
 
  private:
-  std::chrono::steady_clock::time_point start_;
+  TimeInNanos start_;
 };
 
 // Returns a timestamp as milliseconds since the epoch. Note this time may jump
@@ -2219,7 +2569,7 @@ std::string AppendUserMessage(const std::string& gtest_msg,
 
 // Creates an empty TestResult.
 TestResult::TestResult()
-    : death_test_count_(0), start_timestamp_(0), elapsed_time_(0) {}
+    : death_test_count_(0), start_timestamp_(0), elapsed_time_ns_(0) {}
 
 // D'tor.
 TestResult::~TestResult() {}
@@ -2366,7 +2716,7 @@ void TestResult::Clear() {
   test_part_results_.clear();
   test_properties_.clear();
   death_test_count_ = 0;
-  elapsed_time_ = 0;
+  elapsed_time_ns_ = 0;
 }
 
 // Returns true off the test part was skipped.
@@ -2466,6 +2816,36 @@ void ReportFailureInUnknownLocation(TestPartResult::Type result_type,
       "");  // No stack trace, either.
 }
 
+// The functions that empty the object pools of Pooled<T>.
+static std::vector<void (*)()>* g_object_pool_clearers = nullptr;
+GTEST_DEFINE_STATIC_MUTEX_(g_object_pools_mutex);
+
+void RegisterObjectPool(void (*clear)()) {
+  MutexLock lock(&g_object_pools_mutex);
+  if (g_object_pool_clearers == nullptr) {
+    g_object_pool_clearers = new std::vector<void (*)()>;
+  }
+  g_object_pool_clearers->push_back(clear);
+}
+
+void ClearObjectPools() {
+  std::vector<void (*)()> clearers;
+  {
+    MutexLock lock(&g_object_pools_mutex);
+    if (g_object_pool_clearers == nullptr) return;
+    clearers = *g_object_pool_clearers;
+  }
+  for (void (*clear)() : clearers) clear();
+}
+
+void ReportPooledObjectNotReset(const std::string& type_name) {
+  ReportFailureInUnknownLocation(
+      TestPartResult::kNonFatalFailure,
+      "A pooled " + type_name +
+          " differs from a newly constructed one after Reset(), so its "
+          "state would leak into the next test that uses it.");
+}
+
 }  // namespace internal
 
 // Google Test requires all tests in the same test suite to use the same test
@@ -2819,14 +3199,48 @@ class TestNameIs {
 namespace internal {
 
 // This method expands all parameterized tests registered with macros TEST_P
-// and INSTANTIATE_TEST_SUITE_P into regular tests and registers those.
-// This will be done just once during the program runtime.
+// and INSTANTIATE_TEST_SUITE_P into regular tests and registers those that
+// match --gtest_filter.  The expansion is done just once during the program
+// runtime; later calls only register the tests that a filter changed since
+// then selects.
 void UnitTestImpl::RegisterParameterizedTests() {
+  const std::string& filter = GTEST_FLAG_GET(filter);
+  if (parameterized_tests_registered_ &&
+      filter == parameterized_tests_filter_) {
+    return;
+  }
+  const PositiveAndNegativeUnitTestFilter test_filter(filter);
+  parameterized_test_registry_.RegisterTests(
+      [&test_filter](const std::string& test_suite_name,
+                     const std::string& test_name) {
+        return test_filter.MatchesTest(test_suite_name, test_name);
+      });
   if (!parameterized_tests_registered_) {
-    parameterized_test_registry_.RegisterTests();
     type_parameterized_test_registry_.CheckForInstantiations();
     parameterized_tests_registered_ = true;
   }
+  parameterized_tests_filter_ = filter;
+}
+
+// The values of --gtest_isolation that fork a child process for each test
+// and for each test suite.
+static const char kIsolateEachTest[] = "test";
+static const char kIsolateEachTestSuite[] = "suite";
+
+// True if and only if this is a child process forked by RunIsolated().
+static bool g_in_isolated_child = false;
+
+// Returns true if and only if --gtest_isolation is set to granularity and
+// this is neither a child process forked for it nor a death test child
+// process.
+static bool ShouldIsolate(const char* granularity) {
+  if (g_in_isolated_child) return false;
+#if GTEST_HAS_DEATH_TEST
+  if (GetUnitTestImpl()->internal_run_death_test_flag() != nullptr) {
+    return false;
+  }
+#endif  // GTEST_HAS_DEATH_TEST
+  return GTEST_FLAG_GET(isolation) == granularity;
 }
 
 }  // namespace internal
@@ -2847,31 +3261,43 @@ void TestInfo::Run() {
   // Notifies the unit test event listeners that a test is about to start.
   repeater->OnTestStart(*this);
   result_.set_start_timestamp(internal::GetTimeInMillis());
-  internal::Timer timer;
-  impl->os_stack_trace_getter()->UponLeavingGTest();
 
-  // Creates the test object.
-  Test* const test = internal::HandleExceptionsInMethodIfSupported(
-      factory_, &internal::TestFactoryBase::CreateTest,
-      "the test fixture's constructor");
+  const auto run_test = [this, impl] {
+    impl->os_stack_trace_getter()->UponLeavingGTest();
 
-  // Runs the test if the constructor didn't generate a fatal failure or invoke
-  // GTEST_SKIP().
-  // Note that the object will not be null
-  if (!Test::HasFatalFailure() && !Test::IsSkipped()) {
-    // This doesn't throw as all user code that can throw are wrapped into
-    // exception handling code.
-    test->Run();
-  }
+    // Creates the test object.
+    Test* const test = internal::HandleExceptionsInMethodIfSupported(
+        factory_, &internal::TestFactoryBase::CreateTest,
+        "the test fixture's constructor");
+
+    // Runs the test if the constructor didn't generate a fatal failure or
+    // invoke GTEST_SKIP().
+    // Note that the object will not be null
+    if (!Test::HasFatalFailure() && !Test::IsSkipped()) {
+      // This doesn't throw as all user code that can throw are wrapped into
+      // exception handling code.
+      test->Run();
+    }
 
-  if (test != nullptr) {
-    // Deletes the test object.
-    impl->os_stack_trace_getter()->UponLeavingGTest();
-    internal::HandleExceptionsInMethodIfSupported(
-        test, &Test::DeleteSelf_, "the test fixture's destructor");
-  }
+    if (test != nullptr) {
+      // Deletes the test object.
+      impl->os_stack_trace_getter()->UponLeavingGTest();
+      internal::HandleExceptionsInMethodIfSupported(
+          test, &Test::DeleteSelf_, "the test fixture's destructor");
+    }
+
+#if GTEST_HAS_DEATH_TEST
+    internal::DiscardPrefetchedDeathTestChildren();
+#endif  // GTEST_HAS_DEATH_TEST
+  };
 
-  result_.set_elapsed_time(timer.Elapsed());
+  if (internal::ShouldIsolate(internal::kIsolateEachTest)) {
+    result_.set_elapsed_time_ns(impl->RunIsolated(this, run_test));
+  } else {
+    internal::Timer timer;
+    run_test();
+    result_.set_elapsed_time_ns(timer.ElapsedNanos());
+  }
 
   // Notifies the unit test event listener that a test has just finished.
   repeater->OnTestEnd(*this);
@@ -2963,7 +3389,7 @@ TestSuite::TestSuite(const char* a_name, const char* a_type_param,
       tear_down_tc_(tear_down_tc),
       should_run_(false),
       start_timestamp_(0),
-      elapsed_time_(0) {}
+      elapsed_time_ns_(0) {}
 
 // Destructor of TestSuite.
 TestSuite::~TestSuite() {
@@ -3008,33 +3434,43 @@ void TestSuite::Run() {
   repeater->OnTestCaseStart(*this);
 #endif  //  GTEST_REMOVE_LEGACY_TEST_CASEAPI_
 
-  impl->os_stack_trace_getter()->UponLeavingGTest();
-  internal::HandleExceptionsInMethodIfSupported(
-      this, &TestSuite::RunSetUpTestSuite, "SetUpTestSuite()");
+  const auto run_tests = [this, impl] {
+    impl->os_stack_trace_getter()->UponLeavingGTest();
+    internal::HandleExceptionsInMethodIfSupported(
+        this, &TestSuite::RunSetUpTestSuite, "SetUpTestSuite()");
 
-  const bool skip_all = ad_hoc_test_result().Failed();
+    const bool skip_all = ad_hoc_test_result().Failed();
 
-  start_timestamp_ = internal::GetTimeInMillis();
-  internal::Timer timer;
-  for (int i = 0; i < total_test_count(); i++) {
-    if (skip_all) {
-      GetMutableTestInfo(i)->Skip();
-    } else {
-      GetMutableTestInfo(i)->Run();
-    }
-    if (GTEST_FLAG_GET(fail_fast) &&
-        GetMutableTestInfo(i)->result()->Failed()) {
-      for (int j = i + 1; j < total_test_count(); j++) {
-        GetMutableTestInfo(j)->Skip();
+    start_timestamp_ = internal::GetTimeInMillis();
+    internal::Timer timer;
+    for (int i = 0; i < total_test_count(); i++) {
+      if (skip_all) {
+        GetMutableTestInfo(i)->Skip();
+      } else {
+        GetMutableTestInfo(i)->Run();
+      }
+      if (GTEST_FLAG_GET(fail_fast) &&
+          GetMutableTestInfo(i)->result()->Failed()) {
+        for (int j = i + 1; j < total_test_count(); j++) {
+          GetMutableTestInfo(j)->Skip();
+        }
+        break;
       }
-      break;
     }
-  }
-  elapsed_time_ = timer.Elapsed();
+    elapsed_time_ns_ = timer.ElapsedNanos();
 
-  impl->os_stack_trace_getter()->UponLeavingGTest();
-  internal::HandleExceptionsInMethodIfSupported(
-      this, &TestSuite::RunTearDownTestSuite, "TearDownTestSuite()");
+    impl->os_stack_trace_getter()->UponLeavingGTest();
+    internal::HandleExceptionsInMethodIfSupported(
+        this, &TestSuite::RunTearDownTestSuite, "TearDownTestSuite()");
+    internal::ClearObjectPools();
+  };
+
+  if (internal::ShouldIsolate(internal::kIsolateEachTestSuite)) {
+    start_timestamp_ = internal::GetTimeInMillis();
+    elapsed_time_ns_ = impl->RunIsolated(nullptr, run_tests);
+  } else {
+    run_tests();
+  }
 
   // Call both legacy and the new API
   repeater->OnTestSuiteEnd(*this);
@@ -3143,6 +3579,101 @@ namespace {
 enum class GTestColor { kDefault, kRed, kGreen, kYellow };
 }  // namespace
 
+// With --gtest_output_buffering, stdout gets a large buffer, and the result
+// printers only write it out on failures, at the end of an iteration, and
+// at most every kConsoleFlushIntervalMs otherwise, instead of after nearly
+// every event.  The C library writes what is left at exit; a handler for
+// the signals that terminate the program writes it when the program dies.
+namespace {
+
+constexpr size_t kConsoleBufferSize = 1024 * 1024;
+constexpr TimeInMillis kConsoleFlushIntervalMs = 250;
+
+// Whether BufferConsoleOutput() was called, and when stdout was last
+// flushed by FlushConsole().  Only used by the result printers.
+bool g_console_output_buffered = false;
+TimeInMillis g_last_console_flush = 0;
+
+#if GTEST_CAN_FLUSH_OUTPUT_ON_SIGNAL_
+// The buffer of stdout, the signals whose default action terminates the
+// program, and whether our handler took them over from that default.
+char* g_console_buffer = nullptr;
+const int kConsoleFlushSignals[] = {SIGABRT, SIGBUS,  SIGFPE, SIGHUP,
+                                    SIGILL,  SIGINT,  SIGQUIT, SIGSEGV,
+                                    SIGTERM};
+constexpr size_t kConsoleFlushSignalCount =
+    sizeof(kConsoleFlushSignals) / sizeof(kConsoleFlushSignals[0]);
+
+// Writes what stdout holds in its buffer, and lets the default action of
+// the signal terminate the program.  Only makes async-signal-safe calls:
+// the signal may have interrupted stdio while it held its lock, so the
+// pending bytes, which stdio keeps at the start of the buffer, are written
+// to the file descriptor directly.
+void FlushConsoleOnSignal(int signal_number) {
+  const char* data = g_console_buffer;
+  size_t left = __fpending(stdout);
+  if (left > kConsoleBufferSize) left = 0;
+  while (left > 0) {
+    const ssize_t written = write(STDOUT_FILENO, data, left);
+    if (written > 0) {
+      data += written;
+      left -= static_cast<size_t>(written);
+    } else if (written == -1 && errno != EINTR) {
+      break;
+    }
+  }
+  signal(signal_number, SIG_DFL);
+  // The signal is blocked while its handler runs, so the default action
+  // takes it once we return.
+  raise(signal_number);
+}
+#endif  // GTEST_CAN_FLUSH_OUTPUT_ON_SIGNAL_
+
+}  // namespace
+
+// Gives stdout a large buffer for --gtest_output_buffering.  Idempotent.
+static void BufferConsoleOutput() {
+  if (g_console_output_buffered) return;
+  g_console_output_buffered = true;
+
+  // Never freed, as stdout may be written to until the program exits.
+  static char* const buffer = new char[kConsoleBufferSize];
+  fflush(stdout);
+  setvbuf(stdout, buffer, _IOFBF, kConsoleBufferSize);
+  g_last_console_flush = GetTimeInMillis();
+
+#if GTEST_CAN_FLUSH_OUTPUT_ON_SIGNAL_
+  // Signals that have a handler of their own are left to it, as the
+  // program may go on, and stdio write the buffer again, after it returns.
+  g_console_buffer = buffer;
+  struct sigaction action;
+  memset(&action, 0, sizeof(action));
+  sigemptyset(&action.sa_mask);
+  action.sa_handler = &FlushConsoleOnSignal;
+  for (size_t i = 0; i < kConsoleFlushSignalCount; ++i) {
+    struct sigaction previous;
+    if (sigaction(kConsoleFlushSignals[i], nullptr, &previous) == 0 &&
+        (previous.sa_flags & SA_SIGINFO) == 0 &&
+        previous.sa_handler == SIG_DFL) {
+      sigaction(kConsoleFlushSignals[i], &action, nullptr);
+    }
+  }
+#endif  // GTEST_CAN_FLUSH_OUTPUT_ON_SIGNAL_
+}
+
+// Flushes stdout.  When console output is buffered, does so only if force
+// is true or stdout was last flushed kConsoleFlushIntervalMs ago.
+static void FlushConsole(bool force = false) {
+  if (g_console_output_buffered) {
+    const TimeInMillis now = GetTimeInMillis();
+    if (!force && now - g_last_console_flush < kConsoleFlushIntervalMs) {
+      return;
+    }
+    g_last_console_flush = now;
+  }
+  fflush(stdout);
+}
+
 // Prints a TestPartResult to an std::string.
 static std::string PrintTestPartResultToString(
     const TestPartResult& test_part_result) {
@@ -3159,7 +3690,7 @@ static std::string PrintTestPartResultToString(
 static void PrintTestPartResult(const TestPartResult& test_part_result) {
   const std::string& result = PrintTestPartResultToString(test_part_result);
   printf("%s\n", result.c_str());
-  fflush(stdout);
+  FlushConsole(true);
   // If the test program runs in Visual Studio or a debugger, the
   // following statements add the test part result message to the Output
   // window such that the user can double-click on it to jump to the
@@ -3422,14 +3953,14 @@ void PrettyUnitTestResultPrinter::OnTestIterationStart(
   printf("Running %s from %s.\n",
          FormatTestCount(unit_test.test_to_run_count()).c_str(),
          FormatTestSuiteCount(unit_test.test_suite_to_run_count()).c_str());
-  fflush(stdout);
+  FlushConsole();
 }
 
 void PrettyUnitTestResultPrinter::OnEnvironmentsSetUpStart(
     const UnitTest& /*unit_test*/) {
   ColoredPrintf(GTestColor::kGreen, "[----------] ");
   printf("Global test environment set-up.\n");
-  fflush(stdout);
+  FlushConsole();
 }
 
 #ifndef GTEST_REMOVE_LEGACY_TEST_CASEAPI_
@@ -3443,7 +3974,7 @@ void PrettyUnitTestResultPrinter::OnTestCaseStart(const TestCase& test_case) {
   } else {
     printf(", where %s = %s\n", kTypeParamLabel, test_case.type_param());
   }
-  fflush(stdout);
+  FlushConsole();
 }
 #else
 void PrettyUnitTestResultPrinter::OnTestSuiteStart(
@@ -3457,7 +3988,7 @@ void PrettyUnitTestResultPrinter::OnTestSuiteStart(
   } else {
     printf(", where %s = %s\n", kTypeParamLabel, test_suite.type_param());
   }
-  fflush(stdout);
+  FlushConsole();
 }
 #endif  // GTEST_REMOVE_LEGACY_TEST_CASEAPI_
 
@@ -3465,14 +3996,14 @@ void PrettyUnitTestResultPrinter::OnTestStart(const TestInfo& test_info) {
   ColoredPrintf(GTestColor::kGreen, "[ RUN      ] ");
   PrintTestName(test_info.test_suite_name(), test_info.name());
   printf("\n");
-  fflush(stdout);
+  FlushConsole();
 }
 
 void PrettyUnitTestResultPrinter::OnTestDisabled(const TestInfo& test_info) {
   ColoredPrintf(GTestColor::kYellow, "[ DISABLED ] ");
   PrintTestName(test_info.test_suite_name(), test_info.name());
   printf("\n");
-  fflush(stdout);
+  FlushConsole();
 }
 
 // Called after an assertion failure.
@@ -3486,7 +4017,7 @@ void PrettyUnitTestResultPrinter::OnTestPartResult(
       // Print failure message from the assertion
       // (e.g. expected this and got that).
       PrintTestPartResult(result);
-      fflush(stdout);
+      FlushConsole(true);
   }
 }
 
@@ -3508,7 +4039,7 @@ void PrettyUnitTestResultPrinter::OnTestEnd(const TestInfo& test_info) {
   } else {
     printf("\n");
   }
-  fflush(stdout);
+  FlushConsole(test_info.result()->Failed());
 }
 
 #ifndef GTEST_REMOVE_LEGACY_TEST_CASEAPI_
@@ -3520,7 +4051,7 @@ void PrettyUnitTestResultPrinter::OnTestCaseEnd(const TestCase& test_case) {
   ColoredPrintf(GTestColor::kGreen, "[----------] ");
   printf("%s from %s (%s ms total)\n\n", counts.c_str(), test_case.name(),
          internal::StreamableToString(test_case.elapsed_time()).c_str());
-  fflush(stdout);
+  FlushConsole();
 }
 #else
 void PrettyUnitTestResultPrinter::OnTestSuiteEnd(const TestSuite& test_suite) {
@@ -3531,7 +4062,7 @@ void PrettyUnitTestResultPrinter::OnTestSuiteEnd(const TestSuite& test_suite) {
   ColoredPrintf(GTestColor::kGreen, "[----------] ");
   printf("%s from %s (%s ms total)\n\n", counts.c_str(), test_suite.name(),
          internal::StreamableToString(test_suite.elapsed_time()).c_str());
-  fflush(stdout);
+  FlushConsole();
 }
 #endif  // GTEST_REMOVE_LEGACY_TEST_CASEAPI_
 
@@ -3539,7 +4070,7 @@ void PrettyUnitTestResultPrinter::OnEnvironmentsTearDownStart(
     const UnitTest& /*unit_test*/) {
   ColoredPrintf(GTestColor::kGreen, "[----------] ");
   printf("Global test environment tear-down\n");
-  fflush(stdout);
+  FlushConsole();
 }
 
 // Internal helper for printing the list of failed tests.
@@ -3649,7 +4180,7 @@ void PrettyUnitTestResultPrinter::OnTestIterationEnd(const UnitTest& unit_test,
                   num_disabled, num_disabled == 1 ? "TEST" : "TESTS");
   }
   // Ensure that Google Test output is printed before, e.g., heapchecker output.
-  fflush(stdout);
+  FlushConsole(true);
 }
 
 // End PrettyUnitTestResultPrinter
@@ -3704,7 +4235,7 @@ void BriefUnitTestResultPrinter::OnTestPartResult(
       // Print failure message from the assertion
       // (e.g. expected this and got that).
       PrintTestPartResult(result);
-      fflush(stdout);
+      FlushConsole(true);
   }
 }
 
@@ -3721,7 +4252,7 @@ void BriefUnitTestResultPrinter::OnTestEnd(const TestInfo& test_info) {
     } else {
       printf("\n");
     }
-    fflush(stdout);
+    FlushConsole(true);
   }
 }
 
@@ -3754,11 +4285,331 @@ void BriefUnitTestResultPrinter::OnTestIterationEnd(const UnitTest& unit_test,
                   num_disabled, num_disabled == 1 ? "TEST" : "TESTS");
   }
   // Ensure that Google Test output is printed before, e.g., heapchecker output.
-  fflush(stdout);
+  FlushConsole(true);
 }
 
 // End BriefUnitTestResultPrinter
 
+// The BackgroundThreadOwners that exist.
+static std::vector<BackgroundThreadOwner*>* g_background_thread_owners =
+    nullptr;
+GTEST_DEFINE_STATIC_MUTEX_(g_background_thread_owners_mutex);
+
+BackgroundThreadOwner::BackgroundThreadOwner() {
+  MutexLock lock(&g_background_thread_owners_mutex);
+  if (g_background_thread_owners == nullptr) {
+    g_background_thread_owners = new std::vector<BackgroundThreadOwner*>;
+  }
+  g_background_thread_owners->push_back(this);
+}
+
+BackgroundThreadOwner::~BackgroundThreadOwner() {
+  MutexLock lock(&g_background_thread_owners_mutex);
+  g_background_thread_owners->erase(
+      std::find(g_background_thread_owners->begin(),
+                g_background_thread_owners->end(), this));
+}
+
+void StopBackgroundThreads() {
+  // Holding the lock keeps the owners from being destroyed meanwhile.
+  MutexLock lock(&g_background_thread_owners_mutex);
+  if (g_background_thread_owners == nullptr) return;
+  for (BackgroundThreadOwner* owner : *g_background_thread_owners) {
+    owner->StopBackgroundThread();
+  }
+}
+
+// class AsyncTestEventForwarder
+
+#if GTEST_IS_THREADSAFE
+
+// Forwards events to a listener on a dedicated thread.  See
+// TestEventListeners::AppendAsync().
+//
+// The events are passed through a lock-free queue with a single consumer,
+// the thread, so that reporting an event never blocks on the listener.
+// Events about a test or a test suite carry snapshots of the objects they
+// refer to, as those keep changing while the tests run.  Events about the
+// whole UnitTest are barriers: they wait until the thread has delivered
+// everything queued before them, and then call the listener directly.  This
+// keeps the events in order, and leaves nothing queued once
+// OnTestProgramEnd returns.  The thread starts with the first event.
+class AsyncTestEventForwarder : public TestEventListener,
+                                public BackgroundThreadOwner {
+ public:
+  explicit AsyncTestEventForwarder(TestEventListener* listener)
+      : listener_(listener),
+        head_(&stub_),
+        tail_(&stub_),
+        waiting_(false),
+        thread_running_(false) {}
+
+  ~AsyncTestEventForwarder() override { StopBackgroundThread(); }
+
+  // The listener the events are forwarded to.
+  TestEventListener* listener() const { return listener_.get(); }
+
+  // Delivers the queued events, stops the thread, and returns the listener,
+  // which then belongs to the caller.
+  TestEventListener* Detach() {
+    StopBackgroundThread();
+    return listener_.release();
+  }
+
+  // Delivers the queued events and stops the thread.  The next event
+  // starts it again.
+  void StopBackgroundThread() override {
+    std::lock_guard<std::mutex> lock(thread_mutex_);
+    if (!thread_running_.load()) return;
+    Enqueue(new Event(Delivery()));
+    thread_.join();
+    thread_running_.store(false);
+    // Another thread may have queued an event after the one stopping the
+    // thread, while it still seemed to run.
+    if (HasEvents()) StartThread();
+  }
+
+  void OnTestProgramStart(const UnitTest& unit_test) override {
+    Drain();
+    listener_->OnTestProgramStart(unit_test);
+  }
+  void OnTestIterationStart(const UnitTest& unit_test, int iteration) override {
+    Drain();
+    listener_->OnTestIterationStart(unit_test, iteration);
+  }
+  void OnEnvironmentsSetUpStart(const UnitTest& unit_test) override {
+    Drain();
+    listener_->OnEnvironmentsSetUpStart(unit_test);
+  }
+  void OnEnvironmentsSetUpEnd(const UnitTest& unit_test) override {
+    Drain();
+    listener_->OnEnvironmentsSetUpEnd(unit_test);
+  }
+  void OnTestSuiteStart(const TestSuite& test_suite) override {
+    std::shared_ptr<const TestSuite> snapshot = Snapshot(test_suite);
+    Push([snapshot](TestEventListener* listener) {
+      listener->OnTestSuiteStart(*snapshot);
+    });
+  }
+#ifndef GTEST_REMOVE_LEGACY_TEST_CASEAPI_
+  void OnTestCaseStart(const TestCase& test_case) override {
+    std::shared_ptr<const TestSuite> snapshot = Snapshot(test_case);
+    Push([snapshot](TestEventListener* listener) {
+      listener->OnTestCaseStart(*snapshot);
+    });
+  }
+#endif  //  GTEST_REMOVE_LEGACY_TEST_CASEAPI_
+  void OnTestStart(const TestInfo& test_info) override {
+    std::shared_ptr<const TestInfo> snapshot = Snapshot(test_info);
+    Push([snapshot](TestEventListener* listener) {
+      listener->OnTestStart(*snapshot);
+    });
+  }
+  void OnTestDisabled(const TestInfo& test_info) override {
+    std::shared_ptr<const TestInfo> snapshot = Snapshot(test_info);
+    Push([snapshot](TestEventListener* listener) {
+      listener->OnTestDisabled(*snapshot);
+    });
+  }
+  void OnTestPartResult(const TestPartResult& result) override {
+    Push([result](TestEventListener* listener) {
+      listener->OnTestPartResult(result);
+    });
+  }
+  void OnTestEnd(const TestInfo& test_info) override {
+    std::shared_ptr<const TestInfo> snapshot = Snapshot(test_info);
+    Push([snapshot](TestEventListener* listener) {
+      listener->OnTestEnd(*snapshot);
+    });
+  }
+#ifndef GTEST_REMOVE_LEGACY_TEST_CASEAPI_
+  void OnTestCaseEnd(const TestCase& test_case) override {
+    std::shared_ptr<const TestSuite> snapshot = Snapshot(test_case);
+    Push([snapshot](TestEventListener* listener) {
+      listener->OnTestCaseEnd(*snapshot);
+    });
+  }
+#endif  //  GTEST_REMOVE_LEGACY_TEST_CASEAPI_
+  void OnTestSuiteEnd(const TestSuite& test_suite) override {
+    std::shared_ptr<const TestSuite> snapshot = Snapshot(test_suite);
+    Push([snapshot](TestEventListener* listener) {
+      listener->OnTestSuiteEnd(*snapshot);
+    });
+  }
+  void OnEnvironmentsTearDownStart(const UnitTest& unit_test) override {
+    Drain();
+    listener_->OnEnvironmentsTearDownStart(unit_test);
+  }
+  void OnEnvironmentsTearDownEnd(const UnitTest& unit_test) override {
+    Drain();
+    listener_->OnEnvironmentsTearDownEnd(unit_test);
+  }
+  void OnTestIterationEnd(const UnitTest& unit_test, int iteration) override {
+    Drain();
+    listener_->OnTestIterationEnd(unit_test, iteration);
+  }
+  void OnTestProgramEnd(const UnitTest& unit_test) override {
+    Drain();
+    listener_->OnTestProgramEnd(unit_test);
+  }
+
+ private:
+  using Delivery = std::function<void(TestEventListener*)>;
+
+  // A node of the queue.  An event without a delivery stops the thread.
+  struct Event {
+    explicit Event(Delivery a_deliver)
+        : next(nullptr), deliver(std::move(a_deliver)) {}
+
+    std::atomic<Event*> next;
+    Delivery deliver;
+  };
+
+  // Copies the parts of a TestResult that a listener can observe.
+  static void CopyResult(const TestResult& from, TestResult* to) {
+    to->test_part_results_ = from.test_part_results_;
+    to->test_properties_ = from.test_properties_;
+    to->death_test_count_ = from.death_test_count_;
+    to->start_timestamp_ = from.start_timestamp_;
+    to->elapsed_time_ns_ = from.elapsed_time_ns_;
+  }
+
+  static TestInfo* NewSnapshot(const TestInfo& test_info) {
+    // The snapshot has no factory, as it is never run.
+    TestInfo* const snapshot = new TestInfo(
+        test_info.test_suite_name_, test_info.name_, test_info.type_param(),
+        test_info.value_param(), test_info.location_,
+        test_info.fixture_class_id_, nullptr);
+    snapshot->should_run_ = test_info.should_run_;
+    snapshot->is_disabled_ = test_info.is_disabled_;
+    snapshot->matches_filter_ = test_info.matches_filter_;
+    snapshot->is_in_another_shard_ = test_info.is_in_another_shard_;
+    CopyResult(test_info.result_, &snapshot->result_);
+    return snapshot;
+  }
+
+  static std::shared_ptr<const TestInfo> Snapshot(const TestInfo& test_info) {
+    return std::shared_ptr<const TestInfo>(NewSnapshot(test_info));
+  }
+
+  static std::shared_ptr<const TestSuite> Snapshot(
+      const TestSuite& test_suite) {
+    TestSuite* const snapshot = new TestSuite(
+        test_suite.name(), test_suite.type_param(), nullptr, nullptr);
+    for (const TestInfo* test_info : test_suite.test_info_list_) {
+      snapshot->test_info_list_.push_back(NewSnapshot(*test_info));
+    }
+    snapshot->test_indices_ = test_suite.test_indices_;
+    snapshot->should_run_ = test_suite.should_run_;
+    snapshot->start_timestamp_ = test_suite.start_timestamp_;
+    snapshot->elapsed_time_ns_ = test_suite.elapsed_time_ns_;
+    CopyResult(test_suite.ad_hoc_test_result_, &snapshot->ad_hoc_test_result_);
+    return std::shared_ptr<const TestSuite>(snapshot);
+  }
+
+  // Adds an event to the queue, and starts the thread unless it runs.  Can
+  // be called from any thread.
+  void Push(Delivery deliver) {
+    Enqueue(new Event(std::move(deliver)));
+    if (!thread_running_.load()) {
+      std::lock_guard<std::mutex> lock(thread_mutex_);
+      if (!thread_running_.load()) StartThread();
+    }
+  }
+
+  // Must be called with thread_mutex_ held.
+  void StartThread() {
+    thread_ = std::thread(&AsyncTestEventForwarder::ThreadMain, this);
+    thread_running_.store(true);
+  }
+
+  void Enqueue(Event* event) {
+    Event* const previous = head_.exchange(event);
+    previous->next.store(event);
+    if (waiting_.load()) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      wake_up_.notify_one();
+    }
+  }
+
+  // Returns whether the queue holds an event, possibly one that is still
+  // being linked in.  Only called by the thread, or while it is stopped.
+  bool HasEvents() const { return tail_ != &stub_ || head_.load() != &stub_; }
+
+  // Removes the oldest event from the queue.  Returns NULL if the queue is
+  // empty, or if the next event is still being linked in.  Only called by
+  // the thread.
+  Event* Pop() {
+    Event* tail = tail_;
+    Event* next = tail->next.load();
+    if (tail == &stub_) {
+      if (next == nullptr) return nullptr;
+      tail_ = tail = next;
+      next = next->next.load();
+    }
+    if (next != nullptr) {
+      tail_ = next;
+      return tail;
+    }
+    if (tail != head_.load()) return nullptr;
+    // tail is the last event; put the stub back behind it so that tail_ can
+    // move past it.
+    stub_.next.store(nullptr);
+    Enqueue(&stub_);
+    next = tail->next.load();
+    if (next == nullptr) return nullptr;
+    tail_ = next;
+    return tail;
+  }
+
+  void ThreadMain() {
+    for (;;) {
+      Event* const event = Pop();
+      if (event == nullptr) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        waiting_.store(true);
+        wake_up_.wait(lock, [this] { return HasEvents(); });
+        waiting_.store(false);
+        continue;
+      }
+      const bool stop = !event->deliver;
+      if (!stop) event->deliver(listener_.get());
+      delete event;
+      if (stop) return;
+    }
+  }
+
+  // Waits until the thread has delivered all the events queued so far.
+  void Drain() {
+    Notification drained;
+    Push([&drained](TestEventListener*) { drained.Notify(); });
+    drained.WaitForNotification();
+  }
+
+  std::unique_ptr<TestEventListener> listener_;
+  // The queue, an intrusive multiple-producer single-consumer list.
+  // Producers add events at head_, and the thread removes them at tail_.
+  // stub_ keeps the list non-empty.
+  Event stub_{Delivery()};
+  std::atomic<Event*> head_;
+  Event* tail_;
+  // Whether the thread sleeps, or is about to, on wake_up_.
+  std::atomic<bool> waiting_;
+  std::mutex mutex_;
+  std::condition_variable wake_up_;
+  // Whether thread_ runs.  Changes with thread_mutex_ held.
+  std::atomic<bool> thread_running_;
+  std::mutex thread_mutex_;
+  std::thread thread_;
+
+  AsyncTestEventForwarder(const AsyncTestEventForwarder&) = delete;
+  AsyncTestEventForwarder& operator=(const AsyncTestEventForwarder&) = delete;
+};
+
+#endif  // GTEST_IS_THREADSAFE
+
+// End AsyncTestEventForwarder
+
 // class TestEventRepeater
 //
 // This class forwards events to other event listeners.
@@ -3767,6 +4618,7 @@ class TestEventRepeater : public TestEventListener {
   TestEventRepeater() : forwarding_enabled_(true) {}
   ~TestEventRepeater() override;
   void Append(TestEventListener* listener);
+  void AppendAsync(TestEventListener* listener);
   TestEventListener* Release(TestEventListener* listener);
 
   // Controls whether events will be forwarded to listeners_. Set to false
@@ -3774,6 +4626,13 @@ class TestEventRepeater : public TestEventListener {
   bool forwarding_enabled() const { return forwarding_enabled_; }
   void set_forwarding_enabled(bool enable) { forwarding_enabled_ = enable; }
 
+  // Forwards events to listener only.  The listeners it replaces are
+  // neither released nor deleted, so this is only for child processes that
+  // _exit() when they are done, as those of --gtest_isolation do.
+  void ReplaceListeners(TestEventListener* listener) {
+    listeners_.assign(1, listener);
+  }
+
   void OnTestProgramStart(const UnitTest& unit_test) override;
   void OnTestIterationStart(const UnitTest& unit_test, int iteration) override;
   void OnEnvironmentsSetUpStart(const UnitTest& unit_test) override;
@@ -3803,6 +4662,10 @@ class TestEventRepeater : public TestEventListener {
   bool forwarding_enabled_;
   // The list of listeners that receive events.
   std::vector<TestEventListener*> listeners_;
+#if GTEST_IS_THREADSAFE
+  // The elements of listeners_ that were appended with AppendAsync.
+  std::vector<AsyncTestEventForwarder*> async_forwarders_;
+#endif  // GTEST_IS_THREADSAFE
 
   TestEventRepeater(const TestEventRepeater&) = delete;
   TestEventRepeater& operator=(const TestEventRepeater&) = delete;
@@ -3816,6 +4679,17 @@ void TestEventRepeater::Append(TestEventListener* listener) {
   listeners_.push_back(listener);
 }
 
+void TestEventRepeater::AppendAsync(TestEventListener* listener) {
+#if GTEST_IS_THREADSAFE
+  AsyncTestEventForwarder* const forwarder =
+      new AsyncTestEventForwarder(listener);
+  async_forwarders_.push_back(forwarder);
+  listeners_.push_back(forwarder);
+#else
+  listeners_.push_back(listener);
+#endif  // GTEST_IS_THREADSAFE
+}
+
 TestEventListener* TestEventRepeater::Release(TestEventListener* listener) {
   for (size_t i = 0; i < listeners_.size(); ++i) {
     if (listeners_[i] == listener) {
@@ -3824,6 +4698,20 @@ TestEventListener* TestEventRepeater::Release(TestEventListener* listener) {
     }
   }
 
+#if GTEST_IS_THREADSAFE
+  for (size_t i = 0; i < async_forwarders_.size(); ++i) {
+    AsyncTestEventForwarder* const forwarder = async_forwarders_[i];
+    if (forwarder->listener() == listener) {
+      async_forwarders_.erase(async_forwarders_.begin() + static_cast<int>(i));
+      listeners_.erase(
+          std::find(listeners_.begin(), listeners_.end(), forwarder));
+      forwarder->Detach();
+      delete forwarder;
+      return listener;
+    }
+  }
+#endif  // GTEST_IS_THREADSAFE
+
   return nullptr;
 }
 
@@ -3892,6 +4780,351 @@ void TestEventRepeater::OnTestIterationEnd(const UnitTest& unit_test,
 
 // End TestEventRepeater
 
+#if GTEST_CAN_ISOLATE_TESTS_
+
+// The events that a child process forked by UnitTestImpl::RunIsolated()
+// sends to its parent.  Each event is a tag character followed by fields.
+// Numbers are written in decimal followed by ';', and strings as their
+// length followed by their characters.
+//
+//   T index                  The index-th test of the test suite starts.
+//   X index                  The index-th test of the test suite is disabled.
+//   P type file line message A test part result.  file is empty if unknown.
+//   R key value              A property of the current test, or of the test
+//                            suite outside of tests.
+//   E elapsed                The current test ends after elapsed ns.
+//   D elapsed run_us         The child is done.  elapsed is the elapsed
+//                            time of the test or the test suite in ns, and
+//                            run_us the time spent running it in us.
+
+// Sends the events of the tests that run in a child process forked by
+// RunIsolated() to the parent, which reports them to the listeners.  It is
+// the only listener in the child.
+class IsolatedChildEventWriter : public EmptyTestEventListener {
+ public:
+  IsolatedChildEventWriter(int fd, const TestSuite* test_suite)
+      : fd_(fd), test_suite_(test_suite) {}
+
+  void OnTestStart(const TestInfo& test_info) override {
+    buffer_ += 'T';
+    PutNumber(IndexOf(test_info));
+    Flush();
+  }
+
+  void OnTestDisabled(const TestInfo& test_info) override {
+    buffer_ += 'X';
+    PutNumber(IndexOf(test_info));
+    Flush();
+  }
+
+  void OnTestPartResult(const TestPartResult& result) override {
+    buffer_ += 'P';
+    PutNumber(static_cast<int64_t>(result.type()));
+    PutString(result.file_name() == nullptr ? "" : result.file_name());
+    PutNumber(result.line_number());
+    PutString(result.message());
+    Flush();
+  }
+
+  void OnTestEnd(const TestInfo& test_info) override {
+    PutProperties(*test_info.result());
+    buffer_ += 'E';
+    PutNumber(test_info.result()->elapsed_time_ns());
+    Flush();
+  }
+
+  // Sends the properties in result, which belongs to the test or the test
+  // suite that the child was forked for, and tells the parent that the
+  // child is done.
+  void Finish(const TestResult& result, TimeInNanos elapsed, int64_t run_us) {
+    PutProperties(result);
+    buffer_ += 'D';
+    PutNumber(elapsed);
+    PutNumber(run_us);
+    Flush();
+  }
+
+ private:
+  int64_t IndexOf(const TestInfo& test_info) const {
+    for (int i = 0; i < test_suite_->total_test_count(); ++i) {
+      if (test_suite_->GetTestInfo(i) == &test_info) return i;
+    }
+    return -1;
+  }
+
+  void PutProperties(const TestResult& result) {
+    for (int i = 0; i < result.test_property_count(); ++i) {
+      const TestProperty& property = result.GetTestProperty(i);
+      buffer_ += 'R';
+      PutString(property.key());
+      PutString(property.value());
+    }
+  }
+
+  void PutNumber(int64_t number) {
+    buffer_ += StreamableToString(number);
+    buffer_ += ';';
+  }
+
+  void PutString(const std::string& str) {
+    PutNumber(static_cast<int64_t>(str.size()));
+    buffer_ += str;
+  }
+
+  // Writes the buffered events to the pipe.  There is nobody to report to
+  // if that fails, so the child just exits.
+  void Flush() {
+    const char* data = buffer_.data();
+    size_t remaining = buffer_.size();
+    while (remaining > 0) {
+      const int written =
+          posix::Write(fd_, data, static_cast<unsigned int>(remaining));
+      if (written == -1) {
+        if (errno == EINTR) continue;
+        _exit(1);
+      }
+      data += written;
+      remaining -= static_cast<size_t>(written);
+    }
+    buffer_.clear();
+  }
+
+  const int fd_;
+  const TestSuite* const test_suite_;
+  std::string buffer_;
+};
+
+// Reads the events that IsolatedChildEventWriter writes.  The methods
+// return false at the end of the input or when it is malformed.
+class IsolatedChildEventReader {
+ public:
+  explicit IsolatedChildEventReader(int fd) : fd_(fd), pos_(0) {}
+
+  bool GetChar(char* c) {
+    if (pos_ == buffer_.size() && !Fill()) return false;
+    *c = buffer_[pos_++];
+    return true;
+  }
+
+  bool GetNumber(int64_t* number) {
+    bool negative = false;
+    bool has_digits = false;
+    int64_t value = 0;
+    for (char c; GetChar(&c);) {
+      if (c == ';') {
+        *number = negative ? -value : value;
+        return has_digits;
+      }
+      if (c == '-' && !negative && !has_digits) {
+        negative = true;
+      } else if (IsDigit(c)) {
+        value = value * 10 + (c - '0');
+        has_digits = true;
+      } else {
+        return false;
+      }
+    }
+    return false;
+  }
+
+  bool GetString(std::string* str) {
+    int64_t size;
+    if (!GetNumber(&size) || size < 0) return false;
+    str->clear();
+    while (str->size() < static_cast<size_t>(size)) {
+      if (pos_ == buffer_.size() && !Fill()) return false;
+      const size_t n = (std::min)(buffer_.size() - pos_,
+                                  static_cast<size_t>(size) - str->size());
+      str->append(buffer_, pos_, n);
+      pos_ += n;
+    }
+    return true;
+  }
+
+ private:
+  bool Fill() {
+    char chunk[4096];
+    for (;;) {
+      const int n = posix::Read(fd_, chunk, sizeof(chunk));
+      if (n == -1 && errno == EINTR) continue;
+      if (n <= 0) return false;
+      buffer_.assign(chunk, static_cast<size_t>(n));
+      pos_ = 0;
+      return true;
+    }
+  }
+
+  const int fd_;
+  std::string buffer_;
+  size_t pos_;
+};
+
+TimeInNanos UnitTestImpl::RunIsolated(TestInfo* test_info,
+                                      const std::function<void()>& run) {
+  TestSuite* const test_suite = current_test_suite_;
+  TestEventListener* const repeater = listeners()->repeater();
+
+  StopBackgroundThreads();
+  int pipe_fd[2];
+  GTEST_CHECK_(pipe(pipe_fd) != -1)
+      << "Failed to create a pipe for --gtest_isolation.";
+  const auto start = std::chrono::steady_clock::now();
+  // Output still buffered at the fork would be written by both processes.
+  fflush(nullptr);
+  const pid_t child_pid = fork();
+  GTEST_CHECK_(child_pid != -1)
+      << "Failed to fork a child process for --gtest_isolation.";
+  if (child_pid == 0) {
+    close(pipe_fd[0]);
+    g_in_isolated_child = true;
+    IsolatedChildEventWriter writer(pipe_fd[1], test_suite);
+    listeners()->repeater_->ReplaceListeners(&writer);
+
+    const auto run_start = std::chrono::steady_clock::now();
+    Timer timer;
+    run();
+    const TimeInNanos elapsed = test_info != nullptr
+                                    ? timer.ElapsedNanos()
+                                    : test_suite->elapsed_time_ns();
+    writer.Finish(test_info != nullptr ? test_info->result_
+                                       : test_suite->ad_hoc_test_result_,
+                  elapsed,
+                  std::chrono::duration_cast<std::chrono::microseconds>(
+                      std::chrono::steady_clock::now() - run_start)
+                      .count());
+    fflush(nullptr);
+    _exit(0);
+  }
+  close(pipe_fd[1]);
+
+  // The test whose events are being received, if any.
+  TestInfo* running_test = test_info;
+  // When the child runs a test suite, the index of the first of its tests
+  // that has not started.
+  int next_test = 0;
+  bool done = false;
+  int64_t elapsed = 0;
+  int64_t run_us = 0;
+  IsolatedChildEventReader reader(pipe_fd[0]);
+  for (char tag; !done && reader.GetChar(&tag);) {
+    bool ok = false;
+    switch (tag) {
+      case 'T':
+      case 'X': {
+        int64_t index;
+        ok = test_info == nullptr && reader.GetNumber(&index) && index >= 0 &&
+             index < test_suite->total_test_count();
+        if (!ok) break;
+        TestInfo* const info =
+            test_suite->GetMutableTestInfo(static_cast<int>(index));
+        if (tag == 'X') {
+          repeater->OnTestDisabled(*info);
+          break;
+        }
+        running_test = info;
+        next_test = static_cast<int>(index) + 1;
+        set_current_test_info(running_test);
+        running_test->result_.set_start_timestamp(GetTimeInMillis());
+        repeater->OnTestStart(*running_test);
+        break;
+      }
+      case 'P': {
+        int64_t type, line;
+        std::string file, message;
+        ok = reader.GetNumber(&type) && reader.GetString(&file) &&
+             reader.GetNumber(&line) && reader.GetString(&message);
+        if (!ok) break;
+        GetTestPartResultReporterForCurrentThread()->ReportTestPartResult(
+            TestPartResult(static_cast<TestPartResult::Type>(type),
+                           file.empty() ? nullptr : file.c_str(),
+                           static_cast<int>(line), message.c_str()));
+        break;
+      }
+      case 'R': {
+        std::string key, value;
+        ok = reader.GetString(&key) && reader.GetString(&value);
+        if (ok) RecordProperty(TestProperty(key, value));
+        break;
+      }
+      case 'E': {
+        int64_t test_elapsed;
+        ok = test_info == nullptr && running_test != nullptr &&
+             reader.GetNumber(&test_elapsed);
+        if (!ok) break;
+        running_test->result_.set_elapsed_time_ns(test_elapsed);
+        repeater->OnTestEnd(*running_test);
+        set_current_test_info(nullptr);
+        running_test = nullptr;
+        break;
+      }
+      case 'D':
+        ok = reader.GetNumber(&elapsed) && reader.GetNumber(&run_us);
+        done = ok;
+        break;
+    }
+    if (!ok) break;
+  }
+  // Closing the pipe first keeps a child with more to say from blocking.
+  close(pipe_fd[0]);
+
+  int status;
+  while (waitpid(child_pid, &status, 0) == -1) {
+    GTEST_CHECK_(errno == EINTR)
+        << "Failed to wait for a child process of --gtest_isolation.";
+  }
+  const int64_t wall_us =
+      std::chrono::duration_cast<std::chrono::microseconds>(
+          std::chrono::steady_clock::now() - start)
+          .count();
+
+  if (done && WIFEXITED(status) && WEXITSTATUS(status) == 0) {
+    RecordProperty(TestProperty(
+        "isolation_overhead_us",
+        StreamableToString((std::max)(wall_us - run_us, int64_t{0}))));
+    return elapsed;
+  }
+
+  Message message;
+  message << "The child process running the test"
+          << (test_info == nullptr ? " suite" : "");
+  if (WIFSIGNALED(status)) {
+    message << " was killed by signal " << WTERMSIG(status);
+  } else {
+    message << " exited with code " << WEXITSTATUS(status);
+  }
+  if (!done) message << " before it finished";
+  message << ".";
+  if (test_info == nullptr && next_test < test_suite->total_test_count()) {
+    message << "  Its remaining tests are skipped.";
+  }
+  GetTestPartResultReporterForCurrentThread()->ReportTestPartResult(
+      TestPartResult(TestPartResult::kFatalFailure, nullptr, -1,
+                     message.GetString().c_str()));
+
+  if (test_info == nullptr) {
+    if (running_test != nullptr) {
+      repeater->OnTestEnd(*running_test);
+      set_current_test_info(nullptr);
+    }
+    for (int i = next_test; i < test_suite->total_test_count(); ++i) {
+      test_suite->GetMutableTestInfo(i)->Skip();
+    }
+  }
+  return wall_us * 1000;
+}
+
+#else  // GTEST_CAN_ISOLATE_TESTS_
+
+TimeInNanos UnitTestImpl::RunIsolated(TestInfo* test_info,
+                                      const std::function<void()>& run) {
+  Timer timer;
+  run();
+  return test_info != nullptr ? timer.ElapsedNanos()
+                              : current_test_suite_->elapsed_time_ns();
+}
+
+#endif  // GTEST_CAN_ISOLATE_TESTS_
+
 // This class generates an XML output file.
 class XmlUnitTestResultPrinter : public EmptyTestEventListener {
  public:
@@ -4100,9 +5333,42 @@ std::string XmlUnitTestResultPrinter::RemoveInvalidXmlCharacters(
 
 // Formats the given time in milliseconds as seconds.
 std::string FormatTimeInMillisAsSeconds(TimeInMillis ms) {
-  ::std::stringstream ss;
-  ss << (static_cast<double>(ms) * 1e-3);
-  return ss.str();
+  return FormatTimeInNanosAsSeconds(ms * 1000000, 3);
+}
+
+// Formats the given time in nanoseconds as seconds, rounded to precision
+// digits after the decimal point.  Integer arithmetic keeps every digit
+// exact, which a double would not for long runs at full precision.
+std::string FormatTimeInNanosAsSeconds(TimeInNanos ns, int precision) {
+  precision = (std::max)(0, (std::min)(precision, 9));
+  uint64_t ns_per_unit = 1;
+  for (int i = precision; i < 9; ++i) ns_per_unit *= 10;
+  const uint64_t units_per_second = 1000000000 / ns_per_unit;
+
+  const uint64_t abs_ns = ns < 0 ? uint64_t{0} - static_cast<uint64_t>(ns)
+                                 : static_cast<uint64_t>(ns);
+  const uint64_t units = (abs_ns + ns_per_unit / 2) / ns_per_unit;
+  if (units == 0) return "0";
+
+  std::string fraction;
+  uint64_t fraction_units = units % units_per_second;
+  for (int i = 0; i < precision; ++i) {
+    fraction.insert(fraction.begin(),
+                    static_cast<char>('0' + fraction_units % 10));
+    fraction_units /= 10;
+  }
+  fraction.erase(fraction.find_last_not_of('0') + 1);
+
+  std::string result = ns < 0 ? "-" : "";
+  result += StreamableToString(units / units_per_second);
+  if (!fraction.empty()) result += "." + fraction;
+  return result;
+}
+
+// Formats the given elapsed time in nanoseconds as seconds with the
+// precision that --gtest_time_precision asks for.
+static std::string FormatElapsedTime(TimeInNanos ns) {
+  return FormatTimeInNanosAsSeconds(ns, GTEST_FLAG_GET(time_precision));
 }
 
 static bool PortableLocaltime(time_t seconds, struct tm* out) {
@@ -4186,7 +5452,7 @@ void XmlUnitTestResultPrinter::OutputXmlTestSuiteForTestResult(
   OutputXmlAttribute(stream, "testsuite", "skipped", "0");
   OutputXmlAttribute(stream, "testsuite", "errors", "0");
   OutputXmlAttribute(stream, "testsuite", "time",
-                     FormatTimeInMillisAsSeconds(result.elapsed_time()));
+                     FormatElapsedTime(result.elapsed_time_ns()));
   OutputXmlAttribute(
       stream, "testsuite", "timestamp",
       FormatEpochTimeInMillisAsIso8601(result.start_timestamp()));
@@ -4199,7 +5465,7 @@ void XmlUnitTestResultPrinter::OutputXmlTestSuiteForTestResult(
   OutputXmlAttribute(stream, "testcase", "result", "completed");
   OutputXmlAttribute(stream, "testcase", "classname", "");
   OutputXmlAttribute(stream, "testcase", "time",
-                     FormatTimeInMillisAsSeconds(result.elapsed_time()));
+                     FormatElapsedTime(result.elapsed_time_ns()));
   OutputXmlAttribute(
       stream, "testcase", "timestamp",
       FormatEpochTimeInMillisAsIso8601(result.start_timestamp()));
@@ -4249,7 +5515,7 @@ void XmlUnitTestResultPrinter::OutputXmlTestInfo(::std::ostream* stream,
                          ? (result.Skipped() ? "skipped" : "completed")
                          : "suppressed");
   OutputXmlAttribute(stream, kTestsuite, "time",
-                     FormatTimeInMillisAsSeconds(result.elapsed_time()));
+                     FormatElapsedTime(result.elapsed_time_ns()));
   OutputXmlAttribute(
       stream, kTestsuite, "timestamp",
       FormatEpochTimeInMillisAsIso8601(result.start_timestamp()));
@@ -4324,7 +5590,7 @@ void XmlUnitTestResultPrinter::PrintXmlTestSuite(std::ostream* stream,
     OutputXmlAttribute(stream, kTestsuite, "errors", "0");
 
     OutputXmlAttribute(stream, kTestsuite, "time",
-                       FormatTimeInMillisAsSeconds(test_suite.elapsed_time()));
+                       FormatElapsedTime(test_suite.elapsed_time_ns()));
     OutputXmlAttribute(
         stream, kTestsuite, "timestamp",
         FormatEpochTimeInMillisAsIso8601(test_suite.start_timestamp()));
@@ -4355,7 +5621,7 @@ void XmlUnitTestResultPrinter::PrintXmlUnitTest(std::ostream* stream,
       StreamableToString(unit_test.reportable_disabled_test_count()));
   OutputXmlAttribute(stream, kTestsuites, "errors", "0");
   OutputXmlAttribute(stream, kTestsuites, "time",
-                     FormatTimeInMillisAsSeconds(unit_test.elapsed_time()));
+                     FormatElapsedTime(unit_test.elapsed_time_ns()));
   OutputXmlAttribute(
       stream, kTestsuites, "timestamp",
       FormatEpochTimeInMillisAsIso8601(unit_test.start_timestamp()));
@@ -4562,11 +5828,9 @@ std::string JsonUnitTestResultPrinter::EscapeJson(const std::string& str) {
 // The following routines generate an JSON representation of a UnitTest
 // object.
 
-// Formats the given time in milliseconds as seconds.
-static std::string FormatTimeInMillisAsDuration(TimeInMillis ms) {
-  ::std::stringstream ss;
-  ss << (static_cast<double>(ms) * 1e-3) << "s";
-  return ss.str();
+// Formats the given elapsed time in nanoseconds as a duration in seconds.
+static std::string FormatTimeInNanosAsDuration(TimeInNanos ns) {
+  return FormatElapsedTime(ns) + "s";
 }
 
 // Converts the given epoch time in milliseconds to a date string in the
@@ -4634,7 +5898,7 @@ void JsonUnitTestResultPrinter::OutputJsonTestSuiteForTestResult(
     OutputJsonKey(stream, "testsuite", "skipped", 0, Indent(6));
     OutputJsonKey(stream, "testsuite", "errors", 0, Indent(6));
     OutputJsonKey(stream, "testsuite", "time",
-                  FormatTimeInMillisAsDuration(result.elapsed_time()),
+                  FormatTimeInNanosAsDuration(result.elapsed_time_ns()),
                   Indent(6));
     OutputJsonKey(stream, "testsuite", "timestamp",
                   FormatEpochTimeInMillisAsRFC3339(result.start_timestamp()),
@@ -4651,7 +5915,7 @@ void JsonUnitTestResultPrinter::OutputJsonTestSuiteForTestResult(
                 FormatEpochTimeInMillisAsRFC3339(result.start_timestamp()),
                 Indent(10));
   OutputJsonKey(stream, "testcase", "time",
-                FormatTimeInMillisAsDuration(result.elapsed_time()),
+                FormatTimeInNanosAsDuration(result.elapsed_time_ns()),
                 Indent(10));
   OutputJsonKey(stream, "testcase", "classname", "", Indent(10), false);
   *stream << TestPropertiesAsJson(result, Indent(10));
@@ -4703,7 +5967,7 @@ void JsonUnitTestResultPrinter::OutputJsonTestInfo(::std::ostream* stream,
                 FormatEpochTimeInMillisAsRFC3339(result.start_timestamp()),
                 kIndent);
   OutputJsonKey(stream, kTestsuite, "time",
-                FormatTimeInMillisAsDuration(result.elapsed_time()), kIndent);
+                FormatTimeInNanosAsDuration(result.elapsed_time_ns()), kIndent);
   OutputJsonKey(stream, kTestsuite, "classname", test_suite_name, kIndent,
                 false);
   *stream << TestPropertiesAsJson(result, kIndent);
@@ -4761,7 +6025,7 @@ void JsonUnitTestResultPrinter::PrintJsonTestSuite(
         FormatEpochTimeInMillisAsRFC3339(test_suite.start_timestamp()),
         kIndent);
     OutputJsonKey(stream, kTestsuite, "time",
-                  FormatTimeInMillisAsDuration(test_suite.elapsed_time()),
+                  FormatTimeInNanosAsDuration(test_suite.elapsed_time_ns()),
                   kIndent, false);
     *stream << TestPropertiesAsJson(test_suite.ad_hoc_test_result(), kIndent)
             << ",\n";
@@ -4805,8 +6069,8 @@ void JsonUnitTestResultPrinter::PrintJsonUnitTest(std::ostream* stream,
                 FormatEpochTimeInMillisAsRFC3339(unit_test.start_timestamp()),
                 kIndent);
   OutputJsonKey(stream, kTestsuites, "time",
-                FormatTimeInMillisAsDuration(unit_test.elapsed_time()), kIndent,
-                false);
+                FormatTimeInNanosAsDuration(unit_test.elapsed_time_ns()),
+                kIndent, false);
 
   *stream << TestPropertiesAsJson(unit_test.ad_hoc_test_result(), kIndent)
           << ",\n";
@@ -4907,45 +6171,323 @@ std::string StreamingListener::UrlEncode(const char* str) {
   return result;
 }
 
+namespace {
+
+// Send() flushes the buffer early once it holds this many bytes, and waits
+// for the receiver while it holds more than kMaxBufferedBytes, which only
+// happens when the receiver falls far behind.  A receiver that accepts
+// nothing for kStallTimeoutMs is taken to have stalled, and what is
+// buffered for it is dropped, so that it cannot hang the tests.
+constexpr size_t kFlushThresholdBytes = 64 * 1024;
+constexpr size_t kMaxBufferedBytes = 16 * 1024 * 1024;
+constexpr int kStallTimeoutMs = 5000;
+// How often the thread writes the buffer when it is not full.
+constexpr int kFlushIntervalMs = 50;
+// How long a write waits for the receiver to accept more bytes, while the
+// tests run and when the connection is closed.
+constexpr int kWriteTimeoutMs = 100;
+constexpr int kCloseTimeoutMs = 5000;
+// How often to try to connect before giving up, and the delay before the
+// first retry, which doubles with each further attempt.
+constexpr int kMaxConnectAttempts = 4;
+constexpr TimeInMillis kReconnectDelayMs = 100;
+
+#ifdef MSG_NOSIGNAL
+// Reports a lost connection as EPIPE rather than killing us with SIGPIPE.
+constexpr int kSendFlags = MSG_NOSIGNAL;
+#else
+constexpr int kSendFlags = 0;
+#endif  // MSG_NOSIGNAL
+
+}  // namespace
+
+StreamingListener::SocketWriter::SocketWriter(const std::string& host,
+                                              const std::string& port)
+    : sockfd_(-1),
+      host_name_(host),
+      port_num_(port),
+      failed_attempts_(0),
+      next_attempt_(0),
+      closing_(false),
+      stopping_(false),
+      gave_up_(false) {
+  EnsureConnection(false);
+}
+
+StreamingListener::SocketWriter::~SocketWriter() { CloseConnection(); }
+
+void StreamingListener::SocketWriter::Send(const std::string& message) {
+  if (gave_up_.load()) return;
+#if GTEST_IS_THREADSAFE
+  std::unique_lock<std::mutex> lock(mutex_);
+  StartThreadIfStopped();
+  if (!buffer_taken_.wait_for(
+          lock, std::chrono::milliseconds(kStallTimeoutMs), [this] {
+            return closing_ || gave_up_.load() ||
+                   buffer_.size() <= kMaxBufferedBytes;
+          })) {
+    // The thread is still writing pending_, so only buffer_, which holds
+    // whole messages, can be dropped.
+    DropStalledData(&buffer_);
+  }
+  if (gave_up_.load()) return;
+#else
+  const TimeInMillis start = GetTimeInMillis();
+  while (pending_.size() > kMaxBufferedBytes && !gave_up_.load()) {
+    if (GetTimeInMillis() - start >= kStallTimeoutMs) {
+      // Finish the message that was partly written, if any, so that the
+      // receiver does not get half of it joined to a later one.
+      const size_t end_of_message = pending_.find('\n');
+      const std::string rest =
+          end_of_message == std::string::npos
+              ? std::string()
+              : pending_.substr(0, end_of_message + 1);
+      DropStalledData(&pending_);
+      pending_ = rest;
+      break;
+    }
+    Flush(&pending_, false);
+  }
+#endif  // GTEST_IS_THREADSAFE
+  if (closing_) return;
+  buffer_.append(message);
+  if (buffer_.size() >= kFlushThresholdBytes) {
+#if GTEST_IS_THREADSAFE
+    wake_up_.notify_one();
+#else
+    pending_.append(buffer_);
+    buffer_.clear();
+    Flush(&pending_, false);
+#endif  // GTEST_IS_THREADSAFE
+  }
+}
+
+void StreamingListener::SocketWriter::DropStalledData(std::string* data) {
+  GTEST_LOG_(WARNING) << "stream_result_to: " << host_name_ << ":"
+                      << port_num_ << " accepted nothing for "
+                      << kStallTimeoutMs << " ms; dropping " << data->size()
+                      << " bytes of results";
+  data->clear();
+}
+
+void StreamingListener::SocketWriter::CloseConnection() {
+  {
+#if GTEST_IS_THREADSAFE
+    std::lock_guard<std::mutex> lock(mutex_);
+#endif  // GTEST_IS_THREADSAFE
+    if (closing_) return;
+#if GTEST_IS_THREADSAFE
+    // The thread writes what is left.
+    StartThreadIfStopped();
+#endif  // GTEST_IS_THREADSAFE
+    closing_ = true;
+#if GTEST_IS_THREADSAFE
+    wake_up_.notify_one();
+    buffer_taken_.notify_all();
+#endif  // GTEST_IS_THREADSAFE
+  }
+#if GTEST_IS_THREADSAFE
+  // The thread is gone if StopBackgroundThread() was called meanwhile.
+  if (thread_.joinable()) thread_.join();
+#else
+  pending_.append(buffer_);
+  buffer_.clear();
+  Flush(&pending_, true);
+#endif  // GTEST_IS_THREADSAFE
+
+  if (sockfd_ != -1) {
+    close(sockfd_);
+    sockfd_ = -1;
+  }
+}
+
+void StreamingListener::SocketWriter::StopBackgroundThread() {
+#if GTEST_IS_THREADSAFE
+  std::thread thread;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    // CloseConnection() joins the thread itself.
+    if (closing_ || !thread_.joinable()) return;
+    stopping_ = true;
+    thread = std::move(thread_);
+    wake_up_.notify_one();
+  }
+  thread.join();
+  std::lock_guard<std::mutex> lock(mutex_);
+  stopping_ = false;
+#endif  // GTEST_IS_THREADSAFE
+}
+
+#if GTEST_IS_THREADSAFE
+void StreamingListener::SocketWriter::StartThreadIfStopped() {
+  if (!thread_.joinable() && !stopping_ && !closing_) {
+    thread_ = std::thread(&SocketWriter::FlushLoop, this);
+  }
+}
+
+void StreamingListener::SocketWriter::FlushLoop() {
+  for (;;) {
+    bool closing;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      wake_up_.wait_for(lock, std::chrono::milliseconds(kFlushIntervalMs),
+                        [this] {
+                          return closing_ || stopping_ ||
+                                 (pending_.empty() &&
+                                  buffer_.size() >= kFlushThresholdBytes);
+                        });
+      // What is buffered stays for the next thread.
+      if (stopping_ && !closing_) return;
+      // Taking more than the receiver accepts would only move the backlog
+      // out of the reach of kMaxBufferedBytes.
+      if (pending_.empty() || closing_) {
+        pending_.append(buffer_);
+        buffer_.clear();
+        buffer_taken_.notify_all();
+      }
+      closing = closing_;
+    }
+    Flush(&pending_, closing);
+    if (closing) return;
+  }
+}
+#endif  // GTEST_IS_THREADSAFE
+
+void StreamingListener::SocketWriter::Flush(std::string* data, bool closing) {
+  while (!data->empty()) {
+    if (!EnsureConnection(closing)) {
+      // Keep the data for the next attempt, unless there will be none.
+      if (gave_up_.load() || closing) data->clear();
+      return;
+    }
+    if (Write(data, closing ? kCloseTimeoutMs : kWriteTimeoutMs)) {
+      // The receiver is merely slow if anything is left; the rest is
+      // written next time.
+      if (!closing) return;
+      if (!data->empty()) {
+        GTEST_LOG_(WARNING) << "stream_result_to: timed out streaming to "
+                            << host_name_ << ":" << port_num_;
+        data->clear();
+      }
+      return;
+    }
+    GTEST_LOG_(WARNING) << "stream_result_to: lost the connection to "
+                        << host_name_ << ":" << port_num_;
+    close(sockfd_);
+    sockfd_ = -1;
+  }
+}
+
+bool StreamingListener::SocketWriter::Write(std::string* data,
+                                            int timeout_ms) {
+  size_t written = 0;
+  bool connected = true;
+  while (written < data->size()) {
+    const ssize_t n = send(sockfd_, data->data() + written,
+                           data->size() - written, kSendFlags);
+    if (n > 0) {
+      written += static_cast<size_t>(n);
+    } else if (n == -1 && errno == EINTR) {
+      continue;
+    } else if (n == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+      pollfd poll_fd = {sockfd_, POLLOUT, 0};
+      if (poll(&poll_fd, 1, timeout_ms) <= 0) break;
+    } else {
+      connected = false;
+      break;
+    }
+  }
+  data->erase(0, written);
+  return connected;
+}
+
+bool StreamingListener::SocketWriter::EnsureConnection(bool closing) {
+  if (sockfd_ != -1) return true;
+  while (!gave_up_.load()) {
+    const TimeInMillis now = GetTimeInMillis();
+    if (now < next_attempt_ && !closing) return false;
+    MakeConnection();
+    if (sockfd_ != -1) {
+      failed_attempts_ = 0;
+      return true;
+    }
+    if (++failed_attempts_ == kMaxConnectAttempts) {
+      GTEST_LOG_(WARNING) << "stream_result_to: giving up on " << host_name_
+                          << ":" << port_num_ << " after "
+                          << kMaxConnectAttempts << " attempts to connect";
+      gave_up_.store(true);
+      return false;
+    }
+    next_attempt_ = now + (kReconnectDelayMs << (failed_attempts_ - 1));
+    if (!closing) return false;
+  }
+  return false;
+}
+
 void StreamingListener::SocketWriter::MakeConnection() {
   GTEST_CHECK_(sockfd_ == -1)
       << "MakeConnection() can't be called when there is already a connection.";
 
-  addrinfo hints;
-  memset(&hints, 0, sizeof(hints));
-  hints.ai_family = AF_UNSPEC;  // To allow both IPv4 and IPv6 addresses.
-  hints.ai_socktype = SOCK_STREAM;
-  addrinfo* servinfo = nullptr;
-
-  // Use the getaddrinfo() to get a linked list of IP addresses for
-  // the given host name.
-  const int error_num =
-      getaddrinfo(host_name_.c_str(), port_num_.c_str(), &hints, &servinfo);
-  if (error_num != 0) {
-    GTEST_LOG_(WARNING) << "stream_result_to: getaddrinfo() failed: "
-                        << gai_strerror(error_num);
-  }
-
-  // Loop through all the results and connect to the first we can.
-  for (addrinfo* cur_addr = servinfo; sockfd_ == -1 && cur_addr != nullptr;
-       cur_addr = cur_addr->ai_next) {
-    sockfd_ = socket(cur_addr->ai_family, cur_addr->ai_socktype,
-                     cur_addr->ai_protocol);
-    if (sockfd_ != -1) {
-      // Connect the client socket to the server socket.
-      if (connect(sockfd_, cur_addr->ai_addr, cur_addr->ai_addrlen) == -1) {
-        close(sockfd_);
-        sockfd_ = -1;
+  if (host_name_ == "unix") {
+    sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (port_num_.size() >= sizeof(address.sun_path)) {
+      GTEST_LOG_(WARNING) << "stream_result_to: socket path too long: "
+                          << port_num_;
+      return;
+    }
+    memcpy(address.sun_path, port_num_.c_str(), port_num_.size());
+    sockfd_ = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (sockfd_ != -1 &&
+        connect(sockfd_, reinterpret_cast<const sockaddr*>(&address),
+                sizeof(address)) == -1) {
+      close(sockfd_);
+      sockfd_ = -1;
+    }
+  } else {
+    addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;  // To allow both IPv4 and IPv6 addresses.
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo* servinfo = nullptr;
+
+    // Use the getaddrinfo() to get a linked list of IP addresses for
+    // the given host name.
+    const int error_num =
+        getaddrinfo(host_name_.c_str(), port_num_.c_str(), &hints, &servinfo);
+    if (error_num != 0) {
+      GTEST_LOG_(WARNING) << "stream_result_to: getaddrinfo() failed: "
+                          << gai_strerror(error_num);
+    }
+
+    // Loop through all the results and connect to the first we can.
+    for (addrinfo* cur_addr = servinfo; sockfd_ == -1 && cur_addr != nullptr;
+         cur_addr = cur_addr->ai_next) {
+      sockfd_ = socket(cur_addr->ai_family, cur_addr->ai_socktype,
+                       cur_addr->ai_protocol);
+      if (sockfd_ != -1) {
+        // Connect the client socket to the server socket.
+        if (connect(sockfd_, cur_addr->ai_addr, cur_addr->ai_addrlen) == -1) {
+          close(sockfd_);
+          sockfd_ = -1;
+        }
       }
     }
-  }
 
-  freeaddrinfo(servinfo);  // all done with this structure
+    freeaddrinfo(servinfo);  // all done with this structure
+  }
 
   if (sockfd_ == -1) {
     GTEST_LOG_(WARNING) << "stream_result_to: failed to connect to "
                         << host_name_ << ":" << port_num_;
+    return;
   }
+  // Writes must not block the thread for longer than it chooses to wait.
+  fcntl(sockfd_, F_SETFL, fcntl(sockfd_, F_GETFL, 0) | O_NONBLOCK);
+  // Child processes, such as those of death tests, must not keep the
+  // receiver waiting after we close the socket.
+  fcntl(sockfd_, F_SETFD, FD_CLOEXEC);
 }
 
 // End of class Streaming Listener
@@ -4967,34 +6509,25 @@ std::string OsStackTraceGetter::CurrentStackTrace(int max_depth, int skip_count)
 
   max_depth = std::min(max_depth, kMaxStackTraceDepth);
 
-  std::vector<void*> raw_stack(max_depth);
+  // Capturing the raw addresses is cheap; they are only symbolized below,
+  // once it is known which of them make it into the trace.
+  void* raw_stack[kMaxStackTraceDepth];
   // Skips the frames requested by the caller, plus this function.
   const int raw_stack_size =
-      absl::GetStackTrace(&raw_stack[0], max_depth, skip_count + 1);
-
-  void* caller_frame = nullptr;
-  {
-    MutexLock lock(&mutex_);
-    caller_frame = caller_frame_;
-  }
+      absl::GetStackTrace(raw_stack, max_depth, skip_count + 1);
 
+  MutexLock lock(&mutex_);
   for (int i = 0; i < raw_stack_size; ++i) {
-    if (raw_stack[i] == caller_frame &&
+    if (raw_stack[i] == caller_frame_ &&
         !GTEST_FLAG_GET(show_internal_stack_frames)) {
       // Add a marker to the trace and stop adding frames.
       absl::StrAppend(&result, kElidedFramesMarker, "\n");
       break;
     }
 
-    char tmp[1024];
-    const char* symbol = "(unknown)";
-    if (absl::Symbolize(raw_stack[i], tmp, sizeof(tmp))) {
-      symbol = tmp;
-    }
-
-    char line[1024];
-    snprintf(line, sizeof(line), "  %p: %s\n", raw_stack[i], symbol);
-    result += line;
+    char address[32];
+    snprintf(address, sizeof(address), "  %p: ", raw_stack[i]);
+    absl::StrAppend(&result, address, Symbolize(raw_stack[i]), "\n");
   }
 
   return result;
@@ -5006,6 +6539,19 @@ std::string OsStackTraceGetter::CurrentStackTrace(int max_depth, int skip_count)
 #endif  // GTEST_HAS_ABSL
 }
 
+#if GTEST_HAS_ABSL
+const std::string& OsStackTraceGetter::Symbolize(void* address) {
+  const auto it = symbol_cache_.find(address);
+  if (it != symbol_cache_.end()) return it->second;
+
+  char symbol[1024];
+  if (!absl::Symbolize(address, symbol, sizeof(symbol))) {
+    return symbol_cache_.emplace(address, "(unknown)").first->second;
+  }
+  return symbol_cache_.emplace(address, symbol).first->second;
+}
+#endif  // GTEST_HAS_ABSL
+
 void OsStackTraceGetter::UponLeavingGTest() GTEST_LOCK_EXCLUDED_(mutex_) {
 #if GTEST_HAS_ABSL
   void* caller_frame = nullptr;
@@ -5075,6 +6621,11 @@ void TestEventListeners::Append(TestEventListener* listener) {
   repeater_->Append(listener);
 }
 
+// Appends an event listener that receives its events on a dedicated thread.
+void TestEventListeners::AppendAsync(TestEventListener* listener) {
+  repeater_->AppendAsync(listener);
+}
+
 // Removes the given event listener from the list and returns it.  It then
 // becomes the caller's responsibility to delete the listener. Returns
 // NULL if the listener is not found in the list.
@@ -5235,6 +6786,11 @@ internal::TimeInMillis UnitTest::elapsed_time() const {
   return impl()->elapsed_time();
 }
 
+// Gets the elapsed time, in nanoseconds.
+internal::TimeInNanos UnitTest::elapsed_time_ns() const {
+  return impl()->elapsed_time_ns();
+}
+
 // Returns true if and only if the unit test passed (i.e. all test suites
 // passed).
 bool UnitTest::Passed() const { return impl()->Passed(); }
@@ -5303,18 +6859,26 @@ void UnitTest::AddTestPartResult(TestPartResult::Type result_type,
   Message msg;
   msg << message;
 
-  internal::MutexLock lock(&mutex_);
-  if (impl_->gtest_trace_stack().size() > 0) {
+  // Lazily formatted trace messages may call user-defined operator<<, so
+  // they are formatted without holding mutex_.
+  std::vector<internal::TraceInfo> trace_stack;
+  {
+    internal::MutexLock lock(&mutex_);
+    trace_stack = impl_->gtest_trace_stack();
+  }
+  if (trace_stack.size() > 0) {
     msg << "\n" << GTEST_NAME_ << " trace:";
 
-    for (size_t i = impl_->gtest_trace_stack().size(); i > 0; --i) {
-      const internal::TraceInfo& trace = impl_->gtest_trace_stack()[i - 1];
+    for (size_t i = trace_stack.size(); i > 0; --i) {
+      const internal::TraceInfo& trace = trace_stack[i - 1];
       msg << "\n"
           << internal::FormatFileLocation(trace.file, trace.line) << " "
-          << trace.message;
+          << trace.MessageText();
     }
   }
 
+  internal::MutexLock lock(&mutex_);
+
   if (os_stack_trace.c_str() != nullptr && !os_stack_trace.empty()) {
     msg << internal::kStackTraceMarker << os_stack_trace;
   }
@@ -5546,7 +7110,7 @@ UnitTestImpl::UnitTestImpl(UnitTest* parent)
       random_seed_(0),  // Will be overridden by the flag before first use.
       random_(0),       // Will be reseeded before first use.
       start_timestamp_(0),
-      elapsed_time_(0),
+      elapsed_time_ns_(0),
 #if GTEST_HAS_DEATH_TEST
       death_test_factory_(new DefaultDeathTestFactory),
 #endif
@@ -5612,6 +7176,27 @@ void UnitTestImpl::ConfigureXmlOutput() {
   }
 }
 
+// Selects the clock that measures test times as --gtest_clock asks.  Must
+// not be called before InitGoogleTest.
+void UnitTestImpl::ConfigureClock() {
+  const std::string& clock = GTEST_FLAG_GET(clock);
+  if (clock == "tsc") {
+#if GTEST_HAS_DEATH_TEST
+    // A death test child reports no times, so calibrating the counter again
+    // in each of them would only slow it down.
+    if (internal_run_death_test_flag_.get() != nullptr) return;
+#endif  // GTEST_HAS_DEATH_TEST
+    if (!SetMonotonicClock(MonotonicClock::kTsc)) {
+      GTEST_LOG_(WARNING) << "clock: the CPU has no invariant time stamp "
+                             "counter, using the steady clock instead.";
+    }
+  } else if (clock == "steady") {
+    SetMonotonicClock(MonotonicClock::kSteady);
+  } else {
+    GTEST_LOG_(WARNING) << "unrecognized clock \"" << clock << "\" ignored.";
+  }
+}
+
 #if GTEST_CAN_STREAM_RESULTS_
 // Initializes event listeners for streaming test results in string form.
 // Must not be called before InitGoogleTest.
@@ -5646,6 +7231,9 @@ void UnitTestImpl::PostFlagParsingInit() {
 #endif  // defined(GTEST_CUSTOM_TEST_EVENT_LISTENER_)
 
 #if GTEST_HAS_DEATH_TEST
+    // In a death test child forked by the zygote this returns with the
+    // death test flags set, so it must precede their parsing below.
+    StartDeathTestZygoteIfRequested();
     InitDeathTestSubprocessControlInfo();
     SuppressTestEventsIfInSubprocess();
 #endif  // GTEST_HAS_DEATH_TEST
@@ -5659,10 +7247,16 @@ void UnitTestImpl::PostFlagParsingInit() {
     // to shut down the default XML output before invoking RUN_ALL_TESTS.
     ConfigureXmlOutput();
 
+    ConfigureClock();
+
     if (GTEST_FLAG_GET(brief)) {
       listeners()->SetDefaultResultPrinter(new BriefUnitTestResultPrinter);
     }
 
+    if (GTEST_FLAG_GET(output_buffering)) {
+      BufferConsoleOutput();
+    }
+
 #if GTEST_CAN_STREAM_RESULTS_
     // Configures listeners for streaming test results to the specified server.
     ConfigureStreamingOutput();
@@ -5772,6 +7366,10 @@ bool UnitTestImpl::RunAllTests() {
   // user didn't call InitGoogleTest.
   PostFlagParsingInit();
 
+  // Registers the parameterized tests that --gtest_filter selects if it was
+  // changed after InitGoogleTest.
+  RegisterParameterizedTests();
+
   // Even if sharding is not on, test runners may want to use the
   // GTEST_SHARD_STATUS_FILE to query whether the test supports the sharding
   // protocol.
@@ -5912,7 +7510,7 @@ bool UnitTestImpl::RunAllTests() {
       }
     }
 
-    elapsed_time_ = timer.Elapsed();
+    elapsed_time_ns_ = timer.ElapsedNanos();
 
     // Tells the unit test event listener that the tests have just finished.
     repeater->OnTestIterationEnd(*parent_, i);
@@ -6477,6 +8075,16 @@ static const char kColorEncodedHelpMessage[] =
     "recreate_environments_when_repeating@D\n"
     "      Sets up and tears down the global test environment on each repeat\n"
     "      of the test.\n"
+#if GTEST_CAN_ISOLATE_TESTS_
+    "  @G--" GTEST_FLAG_PREFIX_
+    "isolation=@Y(@Gnone@Y|@Gtest@Y|@Gsuite@Y)@D\n"
+    "      Run each test or test suite in a child process forked after the\n"
+    "      global test environment has been set up.\n"
+#endif  // GTEST_CAN_ISOLATE_TESTS_
+    "  @G--" GTEST_FLAG_PREFIX_
+    "clock=@Y(@Gsteady@Y|@Gtsc@Y)@D\n"
+    "      Measure test times with the steady clock of the system or with the\n"
+    "      calibrated time stamp counter of the CPU.\n"
     "\n"
     "Test Output:\n"
     "  @G--" GTEST_FLAG_PREFIX_
@@ -6489,22 +8097,52 @@ static const char kColorEncodedHelpMessage[] =
     "print_time=0@D\n"
     "      Don't print the elapsed time of each test.\n"
     "  @G--" GTEST_FLAG_PREFIX_
+    "output_buffering=1@D\n"
+    "      Write the text output in large batches instead of after each "
+    "event.\n"
+    "  @G--" GTEST_FLAG_PREFIX_
     "output=@Y(@Gjson@Y|@Gxml@Y)[@G:@YDIRECTORY_PATH@G" GTEST_PATH_SEP_
     "@Y|@G:@YFILE_PATH]@D\n"
     "      Generate a JSON or XML report in the given directory or with the "
     "given\n"
     "      file name. @YFILE_PATH@D defaults to @Gtest_detail.xml@D.\n"
+    "  @G--" GTEST_FLAG_PREFIX_
+    "time_precision=@Y[DIGITS]@D\n"
+    "      Write times to the report with DIGITS (0 to 9) digits after the\n"
+    "      decimal point. The default is @G3@D.\n"
 #if GTEST_CAN_STREAM_RESULTS_
     "  @G--" GTEST_FLAG_PREFIX_
-    "stream_result_to=@YHOST@G:@YPORT@D\n"
-    "      Stream test results to the given server.\n"
+    "stream_result_to=@YHOST@G:@YPORT@D|@Gunix:@YPATH@D\n"
+    "      Stream test results to the given server, or to the given Unix "
+    "domain\n"
+    "      socket.\n"
 #endif  // GTEST_CAN_STREAM_RESULTS_
+    "  @G--" GTEST_FLAG_PREFIX_
+    "captured_output_limit=@Y[BYTES]@D\n"
+    "      Keep at most BYTES of the output captured by CaptureStdout() or\n"
+    "      CaptureStderr().\n"
     "\n"
     "Assertion Behavior:\n"
 #if GTEST_HAS_DEATH_TEST && !GTEST_OS_WINDOWS
     "  @G--" GTEST_FLAG_PREFIX_
     "death_test_style=@Y(@Gfast@Y|@Gthreadsafe@Y)@D\n"
     "      Set the default death test style.\n"
+    "  @G--" GTEST_FLAG_PREFIX_
+    "death_test_use_posix_spawn=0@D\n"
+    "      Start threadsafe-style death test children with clone() or fork()\n"
+    "      instead of posix_spawn().\n"
+    "  @G--" GTEST_FLAG_PREFIX_
+    "death_test_use_zygote@D\n"
+    "      Fork threadsafe-style death tests from a helper process started at\n"
+    "      initialization instead of re-executing the test program.\n"
+    "  @G--" GTEST_FLAG_PREFIX_
+    "death_test_concurrency=@Y[NUMBER]@D\n"
+    "      Let up to NUMBER threadsafe-style death test children of a test\n"
+    "      run at once.\n"
+    "  @G--" GTEST_FLAG_PREFIX_
+    "death_test_output_limit=@Y[BYTES]@D\n"
+    "      Keep only the beginning and the end of death test output longer\n"
+    "      than BYTES, searching it for the expected regex while reading.\n"
 #endif  // GTEST_HAS_DEATH_TEST && !GTEST_OS_WINDOWS
     "  @G--" GTEST_FLAG_PREFIX_
     "break_on_failure@D\n"
@@ -6517,6 +8155,9 @@ static const char kColorEncodedHelpMessage[] =
     "catch_exceptions=0@D\n"
     "      Do not report exceptions as test failures. Instead, allow them\n"
     "      to crash the program or throw a pop-up (on Windows).\n"
+    "  @G--" GTEST_FLAG_PREFIX_
+    "check_pooled_reset@D\n"
+    "      Fail tests whose Pooled<T> objects are not as new after Reset().\n"
     "\n"
     "Except for @G--" GTEST_FLAG_PREFIX_
     "list_tests@D, you can alternatively set "
@@ -6548,16 +8189,25 @@ static bool ParseGoogleTestFlag(const char* const arg) {
 
   GTEST_INTERNAL_PARSE_FLAG(also_run_disabled_tests);
   GTEST_INTERNAL_PARSE_FLAG(break_on_failure);
+  GTEST_INTERNAL_PARSE_FLAG(captured_output_limit);
   GTEST_INTERNAL_PARSE_FLAG(catch_exceptions);
+  GTEST_INTERNAL_PARSE_FLAG(check_pooled_reset);
+  GTEST_INTERNAL_PARSE_FLAG(clock);
   GTEST_INTERNAL_PARSE_FLAG(color);
   GTEST_INTERNAL_PARSE_FLAG(death_test_style);
   GTEST_INTERNAL_PARSE_FLAG(death_test_use_fork);
+  GTEST_INTERNAL_PARSE_FLAG(death_test_use_posix_spawn);
+  GTEST_INTERNAL_PARSE_FLAG(death_test_use_zygote);
+  GTEST_INTERNAL_PARSE_FLAG(death_test_concurrency);
+  GTEST_INTERNAL_PARSE_FLAG(death_test_output_limit);
   GTEST_INTERNAL_PARSE_FLAG(fail_fast);
   GTEST_INTERNAL_PARSE_FLAG(filter);
   GTEST_INTERNAL_PARSE_FLAG(internal_run_death_test);
+  GTEST_INTERNAL_PARSE_FLAG(isolation);
   GTEST_INTERNAL_PARSE_FLAG(list_tests);
   GTEST_INTERNAL_PARSE_FLAG(output);
   GTEST_INTERNAL_PARSE_FLAG(brief);
+  GTEST_INTERNAL_PARSE_FLAG(output_buffering);
   GTEST_INTERNAL_PARSE_FLAG(print_time);
   GTEST_INTERNAL_PARSE_FLAG(print_utf8);
   GTEST_INTERNAL_PARSE_FLAG(random_seed);
@@ -6567,6 +8217,7 @@ static bool ParseGoogleTestFlag(const char* const arg) {
   GTEST_INTERNAL_PARSE_FLAG(stack_trace_depth);
   GTEST_INTERNAL_PARSE_FLAG(stream_result_to);
   GTEST_INTERNAL_PARSE_FLAG(throw_on_failure);
+  GTEST_INTERNAL_PARSE_FLAG(time_precision);
   return false;
 }
 
@@ -6802,6 +8453,20 @@ void ScopedTrace::PushTrace(const char* file, int line, std::string message) {
   UnitTest::GetInstance()->PushGTestTrace(trace);
 }
 
+// Pushes the given source file location onto the trace stack, with a message
+// that is only formatted if a failure is reported while the trace is active.
+void ScopedTrace::PushLazyTrace(const char* file, int line,
+                                std::string (*format)(const void* value),
+                                const void* value) {
+  internal::TraceInfo trace;
+  trace.file = file;
+  trace.line = line;
+  trace.format = format;
+  trace.value = value;
+
+  UnitTest::GetInstance()->PushGTestTrace(trace);
+}
+
 // Pops the info pushed by the c'tor.
 ScopedTrace::~ScopedTrace() GTEST_LOCK_EXCLUDED_(&UnitTest::mutex_) {
   UnitTest::GetInstance()->PopGTestTrace();
@@ -476,6 +476,19 @@ TEST_F(TestForDeathTest, ThreadsafeDeathTestInChangedDir) {
   ASSERT_DEATH(_exit(1), "");
 }
 
+#if GTEST_HAS_POSIX_SPAWN
+// Tests the clone()/fork() path that threadsafe-style death tests take when
+// posix_spawn() is not used.
+TEST_F(TestForDeathTest, ThreadsafeDeathTestWithoutPosixSpawn) {
+  GTEST_FLAG_SET(death_test_style, "threadsafe");
+  GTEST_FLAG_SET(death_test_use_posix_spawn, false);
+  EXPECT_EXIT(_exit(1), testing::ExitedWithCode(1), "");
+
+  ChangeToRootDir();
+  EXPECT_EXIT(_exit(2), testing::ExitedWithCode(2), "");
+}
+#endif  // GTEST_HAS_POSIX_SPAWN
+
 TEST_F(TestForDeathTest, MixedStyles) {
   GTEST_FLAG_SET(death_test_style, "threadsafe");
   EXPECT_DEATH(_exit(1), "");
@@ -880,6 +893,97 @@ TEST_F(TestForDeathTest, DeathTestFailedOutput) {
       "[  DEATH   ] death\n");
 }
 
+// Prints size bytes of filler lines to stderr, with marker at offset at and
+// markers at the start and the end, then dies.
+void DieWithLongOutput(size_t size, size_t at, const char* marker) {
+  std::string output = "start of output\n";
+  while (output.size() < size) output += "filler filler filler filler\n";
+  output.insert(at, marker);
+  output += "end of output\n";
+  DieWithMessage(output);
+}
+
+// Tests that a regex is searched for in all of the output of a child that
+// prints more than --gtest_death_test_output_limit bytes.
+TEST_F(TestForDeathTest, LongOutputIsSearchedForRegex) {
+  GTEST_FLAG_SET(death_test_output_limit, 16 * 1024);
+  const size_t kSize = 1024 * 1024;
+  GTEST_FLAG_SET(death_test_style, "fast");
+  EXPECT_DEATH(DieWithLongOutput(kSize, 100, "needle\n"), "needle");
+  EXPECT_DEATH(DieWithLongOutput(kSize, kSize / 2, "needle\n"), "ne+dle");
+  EXPECT_DEATH(DieWithLongOutput(kSize, kSize - 100, "needle\n"),
+               "needle");
+  EXPECT_DEATH(DieWithLongOutput(kSize, kSize / 2, "needle\n"),
+               "^start of output");
+  EXPECT_DEATH(DieWithLongOutput(kSize, kSize / 2, "needle\n"),
+               "end of output\n$");
+
+  GTEST_FLAG_SET(death_test_style, "threadsafe");
+  EXPECT_DEATH(DieWithLongOutput(kSize, kSize / 3, "needle\n"), "needle");
+  EXPECT_NONFATAL_FAILURE(
+      EXPECT_DEATH(DieWithLongOutput(kSize, kSize / 3, "needle\n"),
+                   "haystack"),
+      "died but not with expected error");
+}
+
+// Tests that a regex combining an anchor with alternation is searched for in
+// all of the output, as its anchor applies to one alternative only.
+TEST_F(TestForDeathTest, LongOutputIsSearchedForAnchoredAlternation) {
+  GTEST_FLAG_SET(death_test_style, "fast");
+  GTEST_FLAG_SET(death_test_output_limit, 16 * 1024);
+  const size_t kSize = 1024 * 1024;
+  EXPECT_DEATH(DieWithLongOutput(kSize, kSize / 2, "needle\n"),
+               "^haystack|needle");
+  EXPECT_DEATH(DieWithLongOutput(kSize, kSize / 2, "needle\n"),
+               "(hay|ne)(stack|edle)|output$");
+  EXPECT_NONFATAL_FAILURE(
+      EXPECT_DEATH(DieWithLongOutput(kSize, kSize / 2, "needle\n"),
+                   "^haystack|pin"),
+      "died but not with expected error");
+}
+
+// Tests that a regex anchored at both ends is matched against all of the
+// output.
+TEST_F(TestForDeathTest, LongOutputIsMatchedForRegexAnchoredAtBothEnds) {
+  GTEST_FLAG_SET(death_test_style, "fast");
+  GTEST_FLAG_SET(death_test_output_limit, 16 * 1024);
+  const size_t kSize = 1024 * 1024;
+  EXPECT_DEATH(DieWithLongOutput(kSize, kSize / 2, "needle\n"), "^.*$");
+  EXPECT_DEATH(DieWithLongOutput(kSize, kSize / 2, "needle\n"), "^[^x]*$");
+  EXPECT_NONFATAL_FAILURE(
+      EXPECT_DEATH(DieWithLongOutput(kSize, kSize / 2, "x\n"), "^[^x]*$"),
+      "died but not with expected error");
+}
+
+// Tests that only the beginning and the end of long output are reported.
+TEST_F(TestForDeathTest, LongOutputIsAbbreviated) {
+  GTEST_FLAG_SET(death_test_style, "fast");
+  GTEST_FLAG_SET(death_test_output_limit, 16 * 1024);
+  EXPECT_NONFATAL_FAILURE(
+      EXPECT_DEATH(DieWithLongOutput(1024 * 1024, 100, "needle\n"),
+                   "haystack"),
+      " bytes of output omitted ...]");
+  GTEST_FLAG_SET(death_test_output_limit, 0);
+  EXPECT_DEATH(DieWithLongOutput(1024 * 1024, 100, "needle\n"),
+               "needle(.|\n)*end of output");
+}
+
+// Tests that matchers other than a regex given to the death test only see
+// the beginning and the end of long output.
+TEST_F(TestForDeathTest, MatcherSeesBeginningAndEndOfLongOutput) {
+  GTEST_FLAG_SET(death_test_style, "fast");
+  GTEST_FLAG_SET(death_test_output_limit, 16 * 1024);
+  const size_t kSize = 1024 * 1024;
+  EXPECT_DEATH(DieWithLongOutput(kSize, 100, "needle\n"),
+               ContainsRegex("needle"));
+  EXPECT_DEATH(DieWithLongOutput(kSize, kSize - 100, "needle\n"),
+               ContainsRegex("needle"));
+  EXPECT_NONFATAL_FAILURE(
+      EXPECT_DEATH(DieWithLongOutput(kSize, kSize / 2, "needle\n"),
+                   ContainsRegex("needle")),
+      "died but not with expected error");
+}
+
 TEST_F(TestForDeathTest, DeathTestUnexpectedReturnOutput) {
   GTEST_FLAG_SET(death_test_style, "fast");
   EXPECT_NONFATAL_FAILURE(EXPECT_DEATH(
@@ -0,0 +1,85 @@
+#!/usr/bin/env python
+#
+# Copyright 2026, Google Inc.
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are
+# met:
+#
+#     * Redistributions of source code must retain the above copyright
+# notice, this list of conditions and the following disclaimer.
+#     * Redistributions in binary form must reproduce the above
+# copyright notice, this list of conditions and the following disclaimer
+# in the documentation and/or other materials provided with the
+# distribution.
+#     * Neither the name of Google Inc. nor the names of its
+# contributors may be used to endorse or promote products derived from
+# this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+# "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+# LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+# A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+# OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+# SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+# LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+# DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+# THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+"""Tests the --gtest_output_buffering flag.
+
+This script runs googletest-output-buffering-test_ with and without the flag
+and checks that buffering does not change the text output, and that the
+output is still written when the program is killed by a signal.
+"""
+
+import os
+import re
+from googletest.test import gtest_test_utils
+
+COMMAND = gtest_test_utils.GetTestExecutablePath(
+    'googletest-output-buffering-test_')
+OUTPUT_BUFFERING_FLAG = '--gtest_output_buffering'
+CAN_FLUSH_ON_SIGNAL = (
+    os.name == 'posix' and os.uname()[0] == 'Linux' and
+    'ANDROID_ROOT' not in os.environ)
+
+
+def Run(args):
+  """Runs the test program and returns its process."""
+  return gtest_test_utils.Subprocess([COMMAND, '--gtest_print_time=0'] + args)
+
+
+def Normalize(output):
+  """Removes the parts of the output that differ from run to run."""
+  return re.sub(r'\(\d+ ms total\)', '(? ms total)', output)
+
+
+class GTestOutputBufferingTest(gtest_test_utils.TestCase):
+  """Tests buffered console output."""
+
+  def testBufferingDoesNotChangeOutput(self):
+    unbuffered = Run([])
+    buffered = Run([OUTPUT_BUFFERING_FLAG])
+    self.assertEqual(1, buffered.exit_code)
+    self.assertIn('Expected failure.', buffered.output)
+    self.assertEqual(
+        Normalize(unbuffered.output), Normalize(buffered.output))
+
+  def testWritesOutputWhenKilledBySignal(self):
+    if not CAN_FLUSH_ON_SIGNAL:
+      return
+    p = Run([
+        OUTPUT_BUFFERING_FLAG, '--gtest_also_run_disabled_tests',
+        '--gtest_filter=PassingTest.*:CrashingTest.*'
+    ])
+    self.assertTrue(p.terminated_by_signal)
+    self.assertIn('[       OK ] PassingTest.B', p.output)
+    self.assertIn('[ RUN      ] CrashingTest.DISABLED_Aborts', p.output)
+
+
+if __name__ == '__main__':
+  gtest_test_utils.Main()
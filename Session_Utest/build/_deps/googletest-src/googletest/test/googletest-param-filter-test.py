@@ -0,0 +1,94 @@
+#!/usr/bin/env python
+#
+# Copyright 2026, Google Inc.
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are
+# met:
+#
+#     * Redistributions of source code must retain the above copyright
+# notice, this list of conditions and the following disclaimer.
+#     * Redistributions in binary form must reproduce the above
+# copyright notice, this list of conditions and the following disclaimer
+# in the documentation and/or other materials provided with the
+# distribution.
+#     * Neither the name of Google Inc. nor the names of its
+# contributors may be used to endorse or promote products derived from
+# this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+# "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+# LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+# A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+# OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+# SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+# LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+# DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+# THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+"""Tests that filtered out value-parameterized tests are not registered.
+
+This script runs googletest-param-filter-test_, which has a test with 1000
+parameter values, with various filters, and checks how many tests it
+registers and runs.
+"""
+
+import re
+from googletest.test import gtest_test_utils
+
+COMMAND = gtest_test_utils.GetTestExecutablePath('googletest-param-filter-test_')
+REGISTERED_REGEX = re.compile(
+    r'Registered (\d+) tests and printed (\d+) parameters\.')
+
+
+def Run(args):
+  """Runs the test program and returns its process."""
+  p = gtest_test_utils.Subprocess([COMMAND] + args)
+  assert p.exited and p.exit_code == 0, p.output
+  return p
+
+
+def RegisteredAndPrinted(output):
+  """Returns the numbers of registered tests and printed parameters."""
+  match = REGISTERED_REGEX.search(output)
+  return int(match.group(1)), int(match.group(2))
+
+
+def RanTests(output):
+  """Returns the names of the tests that ran."""
+  return re.findall(r'\[       OK \] (\S+)', output)
+
+
+class GTestParamFilterTest(gtest_test_utils.TestCase):
+  """Tests lazy registration of value-parameterized tests."""
+
+  def testRegistersAllTestsWithoutFilter(self):
+    p = Run([])
+    self.assertEqual((1000, 1000), RegisteredAndPrinted(p.output))
+    self.assertEqual(1000, len(RanTests(p.output)))
+
+  def testRegistersOnlyMatchingTests(self):
+    p = Run(['--gtest_filter=Seq/ManyParamsTest.Test/7:*.Test/99?'])
+    self.assertEqual((11, 11), RegisteredAndPrinted(p.output))
+    self.assertEqual(11, len(RanTests(p.output)))
+    self.assertIn('Seq/ManyParamsTest.Test/7', RanTests(p.output))
+
+  def testRegistersTestsSelectedByNegativeFilter(self):
+    p = Run(['--gtest_filter=-*.Test/?*?'])
+    self.assertEqual((10, 10), RegisteredAndPrinted(p.output))
+
+  def testRegistersTestsSelectedByLateFilter(self):
+    p = Run([
+        '--gtest_filter=Seq/ManyParamsTest.Test/1',
+        '--late_filter=Seq/ManyParamsTest.Test/1*'
+    ])
+    self.assertEqual((1, 1), RegisteredAndPrinted(p.output))
+    self.assertEqual(111, len(RanTests(p.output)))
+    self.assertIn('Seq/ManyParamsTest.Test/199', RanTests(p.output))
+
+
+if __name__ == '__main__':
+  gtest_test_utils.Main()
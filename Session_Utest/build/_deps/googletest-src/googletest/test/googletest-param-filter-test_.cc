@@ -0,0 +1,87 @@
+// Copyright 2026, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+// A test program for googletest-param-filter-test.py.
+
+#include <stdio.h>
+#include <string.h>
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace {
+
+// The number of parameter values that googletest has printed, which it does
+// for each value-parameterized test that it registers.
+int g_printed_params = 0;
+
+struct CountedParam {
+  int value;
+};
+
+void PrintTo(const CountedParam& param, std::ostream* os) {
+  ++g_printed_params;
+  *os << param.value;
+}
+
+std::vector<CountedParam> ManyParams() {
+  std::vector<CountedParam> params;
+  for (int i = 0; i < 1000; ++i) params.push_back(CountedParam{i});
+  return params;
+}
+
+class ManyParamsTest : public testing::TestWithParam<CountedParam> {};
+
+TEST_P(ManyParamsTest, Test) {}
+
+INSTANTIATE_TEST_SUITE_P(Seq, ManyParamsTest, testing::ValuesIn(ManyParams()));
+
+}  // namespace
+
+// Run with --late_filter=FILTER to change --gtest_filter to FILTER between
+// InitGoogleTest() and RUN_ALL_TESTS().
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+
+  printf("Registered %d tests and printed %d parameters.\n",
+         testing::UnitTest::GetInstance()->total_test_count(),
+         g_printed_params);
+
+  const char kLateFilterFlag[] = "--late_filter=";
+  for (int i = 1; i < argc; ++i) {
+    if (strncmp(argv[i], kLateFilterFlag, strlen(kLateFilterFlag)) == 0) {
+      GTEST_FLAG_SET(filter, argv[i] + strlen(kLateFilterFlag));
+    }
+  }
+  return RUN_ALL_TESTS();
+}
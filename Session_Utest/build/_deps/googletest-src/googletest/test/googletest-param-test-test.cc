@@ -53,7 +53,9 @@ using ::testing::AddGlobalTestEnvironment;
 using ::testing::Bool;
 using ::testing::Combine;
 using ::testing::ConvertGenerator;
+using ::testing::Covering;
 using ::testing::Message;
+using ::testing::Pairwise;
 using ::testing::Range;
 using ::testing::TestWithParam;
 using ::testing::Values;
@@ -525,6 +527,151 @@ TEST(CombineTest, NonDefaultConstructAssign) {
   EXPECT_TRUE(it == gen.end());
 }
 
+// Returns the values of a tuple of ints as a vector.
+template <typename Tuple, size_t... I>
+vector<int> TupleToVector(const Tuple& tuple,
+                          ::testing::internal::IndexSequence<I...>) {
+  return {std::get<I>(tuple)...};
+}
+
+// Returns the elements of a generator of tuples of ints as rows of values.
+template <typename... T>
+vector<vector<int>> GeneratorToRows(const ParamGenerator<std::tuple<T...>>& gen) {
+  vector<vector<int>> rows;
+  for (const std::tuple<T...>& value : gen) {
+    rows.push_back(TupleToVector(
+        value,
+        typename ::testing::internal::MakeIndexSequence<sizeof...(T)>::type()));
+  }
+  return rows;
+}
+
+// Returns the number of combinations of values of `strength` columns, column
+// i taking values in [0, counts[i]), that appear in none of the rows.
+size_t CountUncoveredCombinations(const vector<vector<int>>& rows,
+                                  const vector<int>& counts, size_t strength) {
+  size_t uncovered = 0;
+  vector<size_t> columns(strength);
+  for (size_t i = 0; i < strength; ++i) columns[i] = i;
+  for (;;) {
+    std::set<vector<int>> seen;
+    size_t combinations = 1;
+    for (size_t c : columns) combinations *= static_cast<size_t>(counts[c]);
+    for (const vector<int>& row : rows) {
+      vector<int> projection;
+      for (size_t c : columns) projection.push_back(row[c]);
+      seen.insert(projection);
+    }
+    uncovered += combinations - seen.size();
+
+    size_t i = strength;
+    while (i > 0 && columns[i - 1] == counts.size() - strength + i - 1) --i;
+    if (i == 0) return uncovered;
+    ++columns[i - 1];
+    for (size_t j = i; j < strength; ++j) columns[j] = columns[j - 1] + 1;
+  }
+}
+
+// Tests that Pairwise() covers every pair of values of any two parameters
+// with fewer elements than the Cartesian product.
+TEST(CoveringTest, PairwiseCoversAllPairs) {
+  const ParamGenerator<std::tuple<int, int, int, int>> gen =
+      Pairwise(Range(0, 3), Range(0, 3), Range(0, 3), Range(0, 3));
+  const vector<vector<int>> rows = GeneratorToRows(gen);
+
+  EXPECT_EQ(0u, CountUncoveredCombinations(rows, {3, 3, 3, 3}, 2));
+  EXPECT_GE(rows.size(), 9u);
+  EXPECT_LE(rows.size(), 15u);
+}
+
+// Tests that Covering() covers every combination of values of any three
+// parameters when the parameters have different numbers of values.
+TEST(CoveringTest, ThreeWayCoversAllTriples) {
+  const ParamGenerator<std::tuple<int, int, int, int, int, int>> gen =
+      Covering(3, Range(0, 2), Range(0, 4), Range(0, 3), Range(0, 2),
+               Range(0, 5), Range(0, 3));
+  const vector<vector<int>> rows = GeneratorToRows(gen);
+
+  EXPECT_EQ(0u, CountUncoveredCombinations(rows, {2, 4, 3, 2, 5, 3}, 3));
+  EXPECT_LT(rows.size(), 2u * 4 * 3 * 2 * 5 * 3 / 4);
+}
+
+// Tests that a pairwise covering array of many parameters is orders of
+// magnitude smaller than their Cartesian product.
+TEST(CoveringTest, PairwiseIsMuchSmallerThanCombine) {
+  const ParamGenerator<std::tuple<int, int, int, int, int, int, int, int>> gen =
+      Pairwise(Range(0, 10), Range(0, 10), Range(0, 10), Range(0, 10),
+               Range(0, 10), Range(0, 10), Range(0, 10), Range(0, 10));
+  const vector<vector<int>> rows = GeneratorToRows(gen);
+
+  EXPECT_EQ(0u, CountUncoveredCombinations(rows, vector<int>(8, 10), 2));
+  EXPECT_LE(rows.size(), 200u);
+}
+
+// Tests that Covering() with a strength of at least the number of
+// parameters generates the same sequence as Combine().
+TEST(CoveringTest, FullStrengthIsCombine) {
+  std::tuple<int, int, int> expected_values[] = {
+      std::make_tuple(0, 3, 5), std::make_tuple(0, 3, 6),
+      std::make_tuple(0, 4, 5), std::make_tuple(0, 4, 6),
+      std::make_tuple(1, 3, 5), std::make_tuple(1, 3, 6),
+      std::make_tuple(1, 4, 5), std::make_tuple(1, 4, 6)};
+
+  const ParamGenerator<std::tuple<int, int, int>> gen =
+      Covering(3, Values(0, 1), Values(3, 4), Values(5, 6));
+  VerifyGenerator(gen, expected_values);
+
+  const ParamGenerator<std::tuple<int, int, int>> gen2 =
+      Covering(5, Values(0, 1), Values(3, 4), Values(5, 6));
+  VerifyGenerator(gen2, expected_values);
+}
+
+// Tests that Pairwise() generates the same sequence every time, and that a
+// different seed still covers every pair.
+TEST(CoveringTest, IsDeterministicForASeed) {
+  const ParamGenerator<std::tuple<int, int, int, int, int>> gen =
+      Pairwise(Range(0, 4), Range(0, 3), Range(0, 4), Range(0, 2),
+               Range(0, 3));
+  const ParamGenerator<std::tuple<int, int, int, int, int>> gen2 =
+      Pairwise(Range(0, 4), Range(0, 3), Range(0, 4), Range(0, 2),
+               Range(0, 3));
+  EXPECT_EQ(GeneratorToRows(gen), GeneratorToRows(gen2));
+
+  const ParamGenerator<std::tuple<int, int, int, int, int>> seeded =
+      Pairwise(Range(0, 4), Range(0, 3), Range(0, 4), Range(0, 2),
+               Range(0, 3))
+          .WithSeed(42);
+  const ParamGenerator<std::tuple<int, int, int, int, int>> seeded2 =
+      Pairwise(Range(0, 4), Range(0, 3), Range(0, 4), Range(0, 2),
+               Range(0, 3))
+          .WithSeed(42);
+  const vector<vector<int>> rows = GeneratorToRows(seeded);
+  EXPECT_EQ(rows, GeneratorToRows(seeded2));
+  EXPECT_EQ(0u, CountUncoveredCombinations(rows, {4, 3, 4, 2, 3}, 2));
+}
+
+// Tests that when a parameter produces an empty sequence, Pairwise()
+// produces an empty sequence, too.
+TEST(CoveringTest, PairwiseWithEmptyRange) {
+  const ParamGenerator<std::tuple<int, int, int>> gen =
+      Pairwise(Values(0, 1), Range(1, 1), Values(0, 1));
+  VerifyGeneratorIsEmpty(gen);
+}
+
+TEST(CoveringTest, NonDefaultConstructAssign) {
+  const ParamGenerator<std::tuple<int, NonDefaultConstructAssignString, bool>>
+      gen = Pairwise(Values(0, 1),
+                     Values(NonDefaultConstructAssignString("A"),
+                            NonDefaultConstructAssignString("B")),
+                     Bool());
+
+  std::set<std::pair<int, std::string>> pairs;
+  for (const auto& value : gen) {
+    pairs.insert(std::make_pair(std::get<0>(value), std::get<1>(value).str()));
+  }
+  EXPECT_EQ(4u, pairs.size());
+}
+
 template <typename T>
 class ConstructFromT {
  public:
@@ -791,6 +938,17 @@ TEST_P(MultipleInstantiationTest, AllowsMultipleInstances) {}
 INSTANTIATE_TEST_SUITE_P(Sequence1, MultipleInstantiationTest, Values(1, 2));
 INSTANTIATE_TEST_SUITE_P(Sequence2, MultipleInstantiationTest, Range(3, 5));
 
+// Tests that a parameterized test case can be instantiated with a covering
+// array of its parameters.
+class PairwiseInstantiationTest
+    : public TestWithParam<std::tuple<bool, int, int>> {};
+TEST_P(PairwiseInstantiationTest, ValuesAreInRange) {
+  EXPECT_GE(std::get<1>(GetParam()), 0);
+  EXPECT_LT(std::get<2>(GetParam()), 3);
+}
+INSTANTIATE_TEST_SUITE_P(Pairwise, PairwiseInstantiationTest,
+                         Pairwise(Bool(), Range(0, 3), Range(0, 3)));
+
 // Tests that a parameterized test case can be instantiated
 // in multiple translation units. This test will be instantiated
 // here and in gtest-param-test_test2.cc.
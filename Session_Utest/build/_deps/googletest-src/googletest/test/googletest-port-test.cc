@@ -947,6 +947,27 @@ TEST(CaptureTest, CapturesStdoutAndStderr) {
   EXPECT_STREQ("stu", GetCapturedStderr().c_str());
 }
 
+TEST(CaptureTest, CapturesLargeOutput) {
+  const ::std::string line(1023, 'x');
+  CaptureStdout();
+  for (int i = 0; i < 1024; ++i) fprintf(stdout, "%s\n", line.c_str());
+  const ::std::string output = GetCapturedStdout();
+  EXPECT_EQ(1024u * 1024u, output.size());
+  EXPECT_EQ(line + "\n", output.substr(output.size() - 1024));
+}
+
+TEST(CaptureTest, KeepsOutputUpToLimit) {
+  GTEST_FLAG_SET(captured_output_limit, 4);
+  CaptureStdout();
+  fprintf(stdout, "abcdefghij");
+  EXPECT_EQ("abcd\n[... 6 more bytes of captured output omitted ...]\n",
+            GetCapturedStdout());
+
+  CaptureStderr();
+  fprintf(stderr, "abcd");
+  EXPECT_EQ("abcd", GetCapturedStderr());
+}
+
 TEST(CaptureDeathTest, CannotReenterStdoutCapture) {
   CaptureStdout();
   EXPECT_DEATH_IF_SUPPORTED(CaptureStdout(),
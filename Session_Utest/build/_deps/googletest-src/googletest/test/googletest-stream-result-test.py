@@ -0,0 +1,153 @@
+#!/usr/bin/env python
+#
+# Copyright 2026 Google Inc. All Rights Reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are
+# met:
+#
+#     * Redistributions of source code must retain the above copyright
+# notice, this list of conditions and the following disclaimer.
+#     * Redistributions in binary form must reproduce the above
+# copyright notice, this list of conditions and the following disclaimer
+# in the documentation and/or other materials provided with the
+# distribution.
+#     * Neither the name of Google Inc. nor the names of its
+# contributors may be used to endorse or promote products derived from
+# this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+# "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+# LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+# A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+# OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+# SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+# LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+# DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+# THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+"""Tests the --gtest_stream_result_to flag.
+
+This script runs googletest-shuffle-test_ with its results streamed to a
+receiver listening on a Unix domain socket or on TCP loopback, and checks
+what the receiver gets.
+"""
+
+import os
+import socket
+import threading
+import time
+from googletest.test import gtest_test_utils
+
+IS_LINUX = os.name == 'posix' and os.uname()[0] == 'Linux'
+
+COMMAND = gtest_test_utils.GetTestExecutablePath('googletest-shuffle-test_')
+STREAM_RESULT_TO_FLAG = '--gtest_stream_result_to'
+
+
+class Receiver(object):
+  """Accepts one connection and collects the lines sent over it."""
+
+  def __init__(self, family, address, delay=0):
+    self._delay = delay
+    self._socket = socket.socket(family, socket.SOCK_STREAM)
+    self._socket.bind(address)
+    self._socket.listen(1)
+    self._data = []
+    self._thread = threading.Thread(target=self._Receive)
+    self._thread.daemon = True
+    self._thread.start()
+
+  def Address(self):
+    return self._socket.getsockname()
+
+  def _Receive(self):
+    connection, _ = self._socket.accept()
+    time.sleep(self._delay)
+    while True:
+      data = connection.recv(65536)
+      if not data:
+        break
+      self._data.append(data)
+    connection.close()
+
+  def Lines(self):
+    """Waits for the sender to close the connection and returns the lines."""
+    self._thread.join(30)
+    self._socket.close()
+    return b''.join(self._data).decode().splitlines()
+
+
+def RunWithStreamTarget(target, extra_args=None):
+  return gtest_test_utils.Subprocess(
+      [COMMAND, '%s=%s' % (STREAM_RESULT_TO_FLAG, target)] +
+      (extra_args or []))
+
+
+class GTestStreamResultTest(gtest_test_utils.TestCase):
+  """Tests streaming test results to a socket."""
+
+  def AssertCompleteStream(self, lines):
+    self.assertEqual('gtest_streaming_protocol_version=1.0', lines[0])
+    self.assertEqual('event=TestProgramStart', lines[1])
+    self.assertEqual('event=TestProgramEnd&passed=1', lines[-1])
+    starts = [line for line in lines if line.startswith('event=TestStart&')]
+    ends = [line for line in lines if line.startswith('event=TestEnd&')]
+    self.assertTrue(starts)
+    self.assertEqual(len(starts), len(ends))
+
+  def testStreamsToUnixDomainSocket(self):
+    path = os.path.join(gtest_test_utils.GetTempDir(), 'stream_result.sock')
+    receiver = Receiver(socket.AF_UNIX, path)
+    p = RunWithStreamTarget('unix:' + path)
+    self.assertTrue(p.exited)
+    self.assertEqual(0, p.exit_code)
+    self.AssertCompleteStream(receiver.Lines())
+
+  def testStreamsToTcpLoopback(self):
+    receiver = Receiver(socket.AF_INET, ('127.0.0.1', 0))
+    p = RunWithStreamTarget('127.0.0.1:%d' % receiver.Address()[1])
+    self.assertTrue(p.exited)
+    self.assertEqual(0, p.exit_code)
+    self.AssertCompleteStream(receiver.Lines())
+
+  def testSlowReceiverGetsAllResults(self):
+    # Enough repetitions to stream more than the writer buffers.
+    path = os.path.join(gtest_test_utils.GetTempDir(), 'slow_receiver.sock')
+    receiver = Receiver(socket.AF_UNIX, path, delay=3)
+    p = RunWithStreamTarget('unix:' + path, ['--gtest_repeat=14000'])
+    self.assertTrue(p.exited)
+    self.assertEqual(0, p.exit_code)
+    lines = receiver.Lines()
+    self.assertEqual('event=TestProgramEnd&passed=1', lines[-1])
+    iterations = [line for line in lines
+                  if line.startswith('event=TestIterationEnd&')]
+    self.assertEqual(14000, len(iterations))
+
+  def testStalledReceiverDoesNotBlockTests(self):
+    # The receiver accepts the connection but reads nothing until the tests
+    # are long done.
+    path = os.path.join(gtest_test_utils.GetTempDir(), 'stalled.sock')
+    Receiver(socket.AF_UNIX, path, delay=60)
+    start = time.time()
+    p = RunWithStreamTarget('unix:' + path, ['--gtest_repeat=14000'])
+    self.assertTrue(p.exited)
+    self.assertEqual(0, p.exit_code)
+    self.assertIn('accepted nothing', p.output)
+    self.assertLess(time.time() - start, 40)
+
+  def testMissingReceiverDoesNotBlockTests(self):
+    path = os.path.join(gtest_test_utils.GetTempDir(), 'no_receiver.sock')
+    start = time.time()
+    p = RunWithStreamTarget('unix:' + path)
+    self.assertTrue(p.exited)
+    self.assertEqual(0, p.exit_code)
+    self.assertIn('giving up', p.output)
+    self.assertLess(time.time() - start, 10)
+
+
+if __name__ == '__main__':
+  if IS_LINUX:
+    gtest_test_utils.Main()
@@ -0,0 +1,145 @@
+// Copyright 2026, Google LLC.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+//
+// Measures the cost of spawning death test children.  Each configuration
+// is selected with the usual flags, so comparing them takes several runs:
+//
+//   gtest_death_test_benchmark --gtest_death_test_style=fast
+//   gtest_death_test_benchmark --gtest_death_test_style=threadsafe
+//   GTEST_DEATH_TEST_USE_ZYGOTE=1 gtest_death_test_benchmark
+//       --gtest_death_test_style=threadsafe
+//   gtest_death_test_benchmark --gtest_death_test_style=threadsafe
+//       --gtest_death_test_concurrency=4
+//   gtest_death_test_benchmark --gtest_death_test_style=threadsafe
+//       --gtest_death_test_use_posix_spawn=0
+//   gtest_death_test_benchmark --gtest_death_test_style=threadsafe
+//       --gtest_death_test_use_fork
+//
+// GTEST_DEATH_TEST_BENCHMARK_ITERATIONS overrides the number of death tests
+// run by each benchmark.  GTEST_DEATH_TEST_BENCHMARK_BALLAST_MB makes the
+// benchmark allocate and touch that much memory first, to show how the cost
+// of each way of spawning grows with the size of the test program.
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <chrono>  // NOLINT
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "src/gtest-internal-inl.h"
+
+#if GTEST_HAS_DEATH_TEST
+
+namespace {
+
+int Iterations() {
+  return static_cast<int>(::testing::internal::Int32FromGTestEnv(
+      "death_test_benchmark_iterations", 200));
+}
+
+// Allocates the memory requested by GTEST_DEATH_TEST_BENCHMARK_BALLAST_MB
+// once, in the test program but not in its death test children.
+void AllocateBallast() {
+  static std::vector<char>* ballast = nullptr;
+  if (ballast != nullptr || ::testing::internal::InDeathTestChild()) return;
+  const size_t megabytes = static_cast<size_t>(
+      ::testing::internal::Int32FromGTestEnv("death_test_benchmark_ballast_mb",
+                                             0));
+  ballast = new std::vector<char>(megabytes << 20, 1);
+}
+
+// Describes the way death test children are currently spawned.
+std::string SpawnMode() {
+  std::string mode = GTEST_FLAG_GET(death_test_style);
+  if (mode == "threadsafe") {
+    if (GTEST_FLAG_GET(death_test_use_zygote)) {
+      mode += " (zygote)";
+    } else if (GTEST_FLAG_GET(death_test_use_fork)) {
+      mode += " (fork + exec)";
+    } else if (GTEST_HAS_POSIX_SPAWN &&
+               GTEST_FLAG_GET(death_test_use_posix_spawn)) {
+      mode += " (posix_spawn)";
+    } else if (GTEST_HAS_CLONE) {
+      mode += " (clone + exec)";
+    } else {
+      mode += " (fork + exec)";
+    }
+    if (!GTEST_FLAG_GET(death_test_use_zygote) &&
+        GTEST_FLAG_GET(death_test_concurrency) > 1) {
+      mode += " x" + std::to_string(GTEST_FLAG_GET(death_test_concurrency));
+    }
+  }
+  return mode;
+}
+
+void Report(const char* benchmark, int iterations,
+            std::chrono::steady_clock::duration elapsed) {
+  // Children started ahead of time for death tests that never come run the
+  // whole benchmark.
+  if (::testing::internal::InDeathTestChild()) return;
+  const double total_ms =
+      std::chrono::duration<double, std::milli>(elapsed).count();
+  printf("%-24s %-28s %6d death tests %10.1f ms %8.3f ms/death test\n",
+         benchmark, SpawnMode().c_str(), iterations, total_ms,
+         total_ms / iterations);
+  fflush(stdout);
+}
+
+TEST(DeathTestBenchmark, Abort) {
+  AllocateBallast();
+  const int iterations = Iterations();
+  const auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < iterations; ++i) {
+    EXPECT_DEATH(abort(), "");
+  }
+  Report("Abort", iterations, std::chrono::steady_clock::now() - start);
+}
+
+TEST(DeathTestBenchmark, ExitWithMessage) {
+  AllocateBallast();
+  const int iterations = Iterations();
+  const auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < iterations; ++i) {
+    EXPECT_EXIT(
+        {
+          fprintf(stderr, "exiting with code 1\n");
+          exit(1);
+        },
+        ::testing::ExitedWithCode(1), "exiting with code 1");
+  }
+  Report("ExitWithMessage", iterations,
+         std::chrono::steady_clock::now() - start);
+}
+
+}  // namespace
+
+#endif  // GTEST_HAS_DEATH_TEST
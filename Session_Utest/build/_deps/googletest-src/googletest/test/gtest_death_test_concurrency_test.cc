@@ -0,0 +1,126 @@
+// Copyright 2026, Google LLC.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+//
+// Tests threadsafe-style death tests whose children are started ahead of
+// time (--gtest_death_test_concurrency).  Death test children run main()
+// again, so this program sets the flags in its own main().
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <string>
+
+#include "gtest/gtest.h"
+#include "src/gtest-internal-inl.h"
+
+#if GTEST_HAS_DEATH_TEST && !GTEST_OS_WINDOWS && !GTEST_OS_FUCHSIA && \
+    !GTEST_OS_QNX
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace {
+
+const char kBranchVariable[] = "GTEST_DEATH_TEST_CONCURRENCY_TEST_BRANCH";
+
+TEST(ConcurrentDeathTest, ReportsOutcomesInOrder) {
+  for (int i = 0; i < 8; ++i) {
+    EXPECT_EXIT(_exit(i), ::testing::ExitedWithCode(i), "");
+  }
+}
+
+TEST(ConcurrentDeathTest, CapturesStderrOfEachChild) {
+  for (int i = 0; i < 8; ++i) {
+    EXPECT_DEATH(
+        {
+          fprintf(stderr, "death test %d", i);
+          abort();
+        },
+        "^death test " + std::to_string(i) + "$");
+  }
+}
+
+TEST(ConcurrentDeathTest, ReportsChildThatDoesNotDie) {
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_DEATH(abort(), "");
+  }
+  EXPECT_NONFATAL_FAILURE(EXPECT_DEATH(static_cast<void>(0), ""),
+                          "failed to die");
+  EXPECT_DEATH(abort(), "");
+}
+
+// The child started ahead of time for the third death test takes the other
+// branch, as the environment variable is only set afterwards, and has to be
+// replaced.
+TEST(ConcurrentDeathTest, ReplacesChildThatReachesAnotherDeathTest) {
+  EXPECT_EXIT(_exit(1), ::testing::ExitedWithCode(1), "");
+  EXPECT_EXIT(_exit(1), ::testing::ExitedWithCode(1), "");
+  setenv(kBranchVariable, "1", 1);
+  if (getenv(kBranchVariable) != nullptr) {
+    EXPECT_EXIT(_exit(2), ::testing::ExitedWithCode(2), "");
+  } else {
+    EXPECT_EXIT(_exit(3), ::testing::ExitedWithCode(3), "");
+  }
+  unsetenv(kBranchVariable);
+}
+
+// Leaves children started ahead of time for death tests that never come.
+TEST(ConcurrentDeathTest, StopsAfterLastDeathTest) {
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_DEATH(abort(), "");
+  }
+}
+
+TEST(ConcurrentDeathTest, UnusedChildrenAreReaped) {
+  EXPECT_EQ(-1, waitpid(-1, nullptr, WNOHANG));
+  EXPECT_EQ(ECHILD, errno);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  GTEST_FLAG_SET(death_test_style, "threadsafe");
+  GTEST_FLAG_SET(death_test_concurrency, 4);
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
+
+#else
+
+TEST(ConcurrentDeathTest, NotSupported) {}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
+
+#endif  // GTEST_HAS_DEATH_TEST && !GTEST_OS_WINDOWS && !GTEST_OS_FUCHSIA &&
+        // !GTEST_OS_QNX
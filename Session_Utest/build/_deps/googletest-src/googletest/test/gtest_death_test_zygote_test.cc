@@ -0,0 +1,122 @@
+// Copyright 2026, Google LLC.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+//
+// Tests threadsafe-style death tests forked from the death test zygote
+// (--gtest_death_test_use_zygote).  The zygote has to be started by
+// InitGoogleTest(), so this program sets the flags in its own main().
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "gtest/gtest.h"
+#include "src/gtest-internal-inl.h"
+
+#if GTEST_HAS_DEATH_TEST && !GTEST_OS_WINDOWS && !GTEST_OS_FUCHSIA
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace {
+
+// The pid of the test program, recorded in main() before InitGoogleTest().
+// A re-executed child would record its own pid instead.
+pid_t g_test_program_pid = 0;
+
+// Incremented in main() after InitGoogleTest() returns.  Death test
+// children forked by the zygote run main() from that point on, just like a
+// re-executed test program does.
+int g_main_continued_count = 0;
+
+TEST(ZygoteDeathTest, DiesLikeAnExecStyleChild) {
+  EXPECT_DEATH(
+      {
+        fprintf(stderr, "dying in zygote child");
+        abort();
+      },
+      "dying in zygote child");
+}
+
+TEST(ZygoteDeathTest, ReportsExitCode) {
+  EXPECT_EXIT(_exit(3), ::testing::ExitedWithCode(3), "");
+  EXPECT_EXIT(exit(0), ::testing::ExitedWithCode(0), "");
+}
+
+TEST(ZygoteDeathTest, ReportsSignal) {
+  EXPECT_EXIT(raise(SIGKILL), ::testing::KilledBySignal(SIGKILL), "");
+}
+
+TEST(ZygoteDeathTest, ChildIsForkedByZygote) {
+  EXPECT_EXIT(
+      {
+        const bool forked_by_zygote = getpid() != g_test_program_pid &&
+                                      getppid() != g_test_program_pid;
+        _exit(forked_by_zygote && g_main_continued_count == 1 ? 0 : 1);
+      },
+      ::testing::ExitedWithCode(0), "");
+}
+
+TEST(ZygoteDeathTest, SeveralDeathTestsInOneTest) {
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_DEATH(abort(), "");
+  }
+  EXPECT_EXIT(_exit(7), ::testing::ExitedWithCode(7), "");
+}
+
+TEST(ZygoteDeathTest, ReportsChildThatDoesNotDie) {
+  EXPECT_NONFATAL_FAILURE(EXPECT_DEATH(static_cast<void>(0), ""),
+                          "failed to die");
+}
+
+TEST(ZygoteDeathTest, InDeathTestChild) {
+  EXPECT_EXIT(_exit(::testing::internal::InDeathTestChild() ? 0 : 1),
+              ::testing::ExitedWithCode(0), "");
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  g_test_program_pid = getpid();
+  GTEST_FLAG_SET(death_test_style, "threadsafe");
+  GTEST_FLAG_SET(death_test_use_zygote, true);
+  testing::InitGoogleTest(&argc, argv);
+  ++g_main_continued_count;
+  return RUN_ALL_TESTS();
+}
+
+#else
+
+TEST(ZygoteDeathTest, NotSupported) {}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
+
+#endif  // GTEST_HAS_DEATH_TEST && !GTEST_OS_WINDOWS && !GTEST_OS_FUCHSIA
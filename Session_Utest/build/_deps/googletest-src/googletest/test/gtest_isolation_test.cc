@@ -0,0 +1,208 @@
+// Copyright 2026, Google LLC.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+//
+// Tests running tests in forked child processes (--gtest_isolation).
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <string>
+
+#include "gtest/gtest.h"
+#include "src/gtest-internal-inl.h"
+
+#if GTEST_CAN_ISOLATE_TESTS_
+
+#include <unistd.h>
+
+namespace {
+
+// The process that runs RUN_ALL_TESTS().
+pid_t g_parent_pid;
+
+// The number of times the global environment has been set up.
+int g_set_up_count = 0;
+
+// Changed by a test, which must not affect the other tests.
+int g_global_state = 0;
+
+class CountingEnvironment : public testing::Environment {
+ public:
+  void SetUp() override { ++g_set_up_count; }
+};
+
+TEST(ChildProcessTest, RunsAfterEnvironmentSetUp) {
+  EXPECT_NE(g_parent_pid, getpid());
+  EXPECT_EQ(1, g_set_up_count);
+}
+
+TEST(GlobalStateTest, ChangesGlobalState) {
+  EXPECT_EQ(0, g_global_state);
+  g_global_state = 1;
+}
+
+TEST(OtherGlobalStateTest, DoesNotSeeChangedGlobalState) {
+  EXPECT_EQ(0, g_global_state);
+}
+
+TEST(ReportingTest, Fails) {
+  RecordProperty("key", "value");
+  ADD_FAILURE() << "Expected failure.";
+}
+
+TEST(ReportingTest, Exits) { _exit(3); }
+
+TEST(ReportingTest, RunsAfterExit) {}
+
+// Prints the message and aborts the program if condition is false.
+void Check(bool condition, const char* msg) {
+  if (!condition) {
+    printf("FAILED: %s\n", msg);
+    testing::internal::posix::Abort();
+  }
+}
+
+// Returns the result of the given test.
+const testing::TestResult& GetResult(const char* test_suite_name,
+                                     const char* test_name) {
+  const testing::UnitTest& unit_test = *testing::UnitTest::GetInstance();
+  for (int i = 0; i < unit_test.total_test_suite_count(); ++i) {
+    const testing::TestSuite& test_suite = *unit_test.GetTestSuite(i);
+    if (std::string(test_suite.name()) != test_suite_name) continue;
+    for (int j = 0; j < test_suite.total_test_count(); ++j) {
+      const testing::TestInfo& test_info = *test_suite.GetTestInfo(j);
+      if (std::string(test_info.name()) == test_name) {
+        return *test_info.result();
+      }
+    }
+  }
+  printf("FAILED: Test %s.%s not found\n", test_suite_name, test_name);
+  testing::internal::posix::Abort();
+}
+
+// Returns the result of the test suite outside of its tests.
+const testing::TestResult& GetAdHocResult(const char* test_suite_name) {
+  const testing::UnitTest& unit_test = *testing::UnitTest::GetInstance();
+  for (int i = 0; i < unit_test.total_test_suite_count(); ++i) {
+    const testing::TestSuite& test_suite = *unit_test.GetTestSuite(i);
+    if (std::string(test_suite.name()) == test_suite_name) {
+      return test_suite.ad_hoc_test_result();
+    }
+  }
+  printf("FAILED: Test suite %s not found\n", test_suite_name);
+  testing::internal::posix::Abort();
+}
+
+// Returns true if and only if result has a property with the given key.
+bool HasProperty(const testing::TestResult& result, const char* key) {
+  for (int i = 0; i < result.test_property_count(); ++i) {
+    if (std::string(result.GetTestProperty(i).key()) == key) return true;
+  }
+  return false;
+}
+
+// Returns true if and only if result failed with a single failure whose
+// message contains substr.
+bool FailedWith(const testing::TestResult& result, const char* substr) {
+  return result.Failed() && result.total_part_count() == 1 &&
+         std::string(result.GetTestPartResult(0).message()).find(substr) !=
+             std::string::npos;
+}
+
+// Runs the tests in child processes of the given granularity and checks
+// the results that they send back.
+void RunAndCheck(const char* isolation) {
+  GTEST_FLAG_SET(isolation, isolation);
+  g_set_up_count = 0;
+  Check(RUN_ALL_TESTS() != 0,
+        "RUN_ALL_TESTS() should return non-zero, as tests fail.");
+  Check(g_set_up_count == 1,
+        "The global environment should be set up once, in the parent.");
+  Check(g_global_state == 0,
+        "Tests should not change the global state of the parent.");
+
+  Check(GetResult("ChildProcessTest", "RunsAfterEnvironmentSetUp").Passed(),
+        "Tests should run in a child process after the environment is set "
+        "up.");
+  Check(GetResult("GlobalStateTest", "ChangesGlobalState").Passed() &&
+            GetResult("OtherGlobalStateTest", "DoesNotSeeChangedGlobalState")
+                .Passed(),
+        "A test should not see the global state changed by another test "
+        "suite.");
+
+  const testing::TestResult& fails = GetResult("ReportingTest", "Fails");
+  Check(FailedWith(fails, "Expected failure."),
+        "A failure in a child process should be reported.");
+  Check(fails.test_property_count() > 0 &&
+            std::string(fails.GetTestProperty(0).key()) == "key" &&
+            std::string(fails.GetTestProperty(0).value()) == "value",
+        "A property recorded in a child process should be reported.");
+
+  Check(FailedWith(GetResult("ReportingTest", "Exits"),
+                   "exited with code 3 before it finished"),
+        "A child process that exits early should be reported.");
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  testing::AddGlobalTestEnvironment(new CountingEnvironment);
+  g_parent_pid = getpid();
+
+  RunAndCheck("test");
+  Check(HasProperty(GetResult("ChildProcessTest", "RunsAfterEnvironmentSetUp"),
+                    "isolation_overhead_us"),
+        "The overhead of the child process of a test should be recorded.");
+  Check(GetResult("ReportingTest", "RunsAfterExit").Passed(),
+        "A test that exits should not affect the next test.");
+
+  RunAndCheck("suite");
+  Check(HasProperty(GetAdHocResult("ChildProcessTest"),
+                    "isolation_overhead_us"),
+        "The overhead of the child process of a test suite should be "
+        "recorded.");
+  Check(GetResult("ReportingTest", "RunsAfterExit").Skipped(),
+        "The tests after one that exits should be skipped.");
+
+  printf("PASS\n");
+  return 0;
+}
+
+#else
+
+TEST(IsolationTest, NotSupported) {}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
+
+#endif  // GTEST_CAN_ISOLATE_TESTS_
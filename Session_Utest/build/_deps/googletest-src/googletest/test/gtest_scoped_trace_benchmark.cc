@@ -0,0 +1,103 @@
+// Copyright 2026, Google LLC.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+//
+// Measures the cost of SCOPED_TRACE() in a loop whose assertions pass, so
+// that the trace messages are never needed.  Messages of arithmetic types
+// are copied and only formatted when a failure is reported; strings are
+// copied eagerly, for comparison.
+//
+// GTEST_SCOPED_TRACE_BENCHMARK_ITERATIONS overrides the number of loop
+// iterations run by each benchmark.
+
+#include <stdio.h>
+
+#include <chrono>  // NOLINT
+#include <string>
+
+#include "gtest/gtest.h"
+#include "src/gtest-internal-inl.h"
+
+namespace {
+
+int Iterations() {
+  return static_cast<int>(::testing::internal::Int32FromGTestEnv(
+      "scoped_trace_benchmark_iterations", 1000000));
+}
+
+void Report(const char* benchmark, int iterations,
+            std::chrono::steady_clock::duration elapsed) {
+  const double total_ms =
+      std::chrono::duration<double, std::milli>(elapsed).count();
+  printf("%-24s %10d iterations %10.1f ms %8.1f ns/iteration\n", benchmark,
+         iterations, total_ms, total_ms * 1e6 / iterations);
+  fflush(stdout);
+}
+
+TEST(ScopedTraceBenchmark, Untraced) {
+  const int iterations = Iterations();
+  const auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < iterations; ++i) {
+    EXPECT_GE(i, 0);
+  }
+  Report("Untraced", iterations, std::chrono::steady_clock::now() - start);
+}
+
+TEST(ScopedTraceBenchmark, TracedInt) {
+  const int iterations = Iterations();
+  const auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < iterations; ++i) {
+    SCOPED_TRACE(i);
+    EXPECT_GE(i, 0);
+  }
+  Report("TracedInt", iterations, std::chrono::steady_clock::now() - start);
+}
+
+TEST(ScopedTraceBenchmark, TracedDouble) {
+  const int iterations = Iterations();
+  const auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < iterations; ++i) {
+    SCOPED_TRACE(i * 0.5);
+    EXPECT_GE(i, 0);
+  }
+  Report("TracedDouble", iterations, std::chrono::steady_clock::now() - start);
+}
+
+TEST(ScopedTraceBenchmark, TracedString) {
+  const int iterations = Iterations();
+  const std::string message = "a message too long for the small buffer";
+  const auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < iterations; ++i) {
+    SCOPED_TRACE(message);
+    EXPECT_GE(i, 0);
+  }
+  Report("TracedString", iterations, std::chrono::steady_clock::now() - start);
+}
+
+}  // namespace
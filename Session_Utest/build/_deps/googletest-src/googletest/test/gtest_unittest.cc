@@ -58,10 +58,12 @@ TEST(CommandLineFlagsTest, CanBeAccessedInCodeOnceGTestHIsIncluded) {
 #include <string.h>
 #include <time.h>
 
+#include <chrono>  // NOLINT
 #include <cstdint>
 #include <map>
 #include <ostream>
 #include <string>
+#include <thread>  // NOLINT
 #include <type_traits>
 #include <unordered_set>
 #include <vector>
@@ -211,6 +213,7 @@ using testing::TestProperty;
 using testing::TestResult;
 using testing::TestSuite;
 using testing::TimeInMillis;
+using testing::TimeInNanos;
 using testing::UnitTest;
 using testing::internal::AlwaysFalse;
 using testing::internal::AlwaysTrue;
@@ -225,8 +228,10 @@ using testing::internal::FloatingPoint;
 using testing::internal::ForEach;
 using testing::internal::FormatEpochTimeInMillisAsIso8601;
 using testing::internal::FormatTimeInMillisAsSeconds;
+using testing::internal::FormatTimeInNanosAsSeconds;
 using testing::internal::GetCurrentOsStackTraceExceptTop;
 using testing::internal::GetElementOr;
+using testing::internal::GetMonotonicTimeInNanos;
 using testing::internal::GetNextRandomSeed;
 using testing::internal::GetRandomSeedFromFlag;
 using testing::internal::GetTestTypeId;
@@ -241,12 +246,14 @@ using testing::internal::IsContainerTest;
 using testing::internal::IsNotContainer;
 using testing::internal::kMaxRandomSeed;
 using testing::internal::kTestTypeIdInGoogleTest;
+using testing::internal::MonotonicClock;
 using testing::internal::NativeArray;
 using testing::internal::OsStackTraceGetter;
 using testing::internal::OsStackTraceGetterInterface;
 using testing::internal::ParseFlag;
 using testing::internal::RelationToSourceCopy;
 using testing::internal::RelationToSourceReference;
+using testing::internal::SetMonotonicClock;
 using testing::internal::ShouldRunTestOnShard;
 using testing::internal::ShouldShard;
 using testing::internal::ShouldUseColor;
@@ -400,6 +407,74 @@ TEST(FormatTimeInMillisAsSecondsTest, FormatsNegativeNumber) {
   EXPECT_EQ("-3", FormatTimeInMillisAsSeconds(-3000));
 }
 
+// Tests FormatTimeInNanosAsSeconds().
+
+TEST(FormatTimeInNanosAsSecondsTest, FormatsZero) {
+  EXPECT_EQ("0", FormatTimeInNanosAsSeconds(0, 3));
+  EXPECT_EQ("0", FormatTimeInNanosAsSeconds(0, 9));
+}
+
+TEST(FormatTimeInNanosAsSecondsTest, FormatsToTheGivenPrecision) {
+  EXPECT_EQ("1.234567891", FormatTimeInNanosAsSeconds(1234567891, 9));
+  EXPECT_EQ("1.234568", FormatTimeInNanosAsSeconds(1234567891, 6));
+  EXPECT_EQ("1.235", FormatTimeInNanosAsSeconds(1234567891, 3));
+  EXPECT_EQ("1", FormatTimeInNanosAsSeconds(1234567891, 0));
+  EXPECT_EQ("0.000042", FormatTimeInNanosAsSeconds(42000, 9));
+  EXPECT_EQ("0", FormatTimeInNanosAsSeconds(42000, 3));
+  EXPECT_EQ("86400.000000001", FormatTimeInNanosAsSeconds(86400000000001, 9));
+}
+
+TEST(FormatTimeInNanosAsSecondsTest, DropsTrailingZeros) {
+  EXPECT_EQ("0.2", FormatTimeInNanosAsSeconds(200000000, 9));
+  EXPECT_EQ("3", FormatTimeInNanosAsSeconds(2999999999, 6));
+}
+
+TEST(FormatTimeInNanosAsSecondsTest, FormatsNegativeNumber) {
+  EXPECT_EQ("-0.000001", FormatTimeInNanosAsSeconds(-1000, 9));
+  EXPECT_EQ("-1.5", FormatTimeInNanosAsSeconds(-1500000000, 3));
+}
+
+TEST(FormatTimeInNanosAsSecondsTest, ClampsThePrecision) {
+  EXPECT_EQ("0.000000001", FormatTimeInNanosAsSeconds(1, 12));
+  EXPECT_EQ("2", FormatTimeInNanosAsSeconds(1500000000, -1));
+}
+
+// Tests that GetMonotonicTimeInNanos() does not go back whichever clock it
+// reads.
+TEST(GetMonotonicTimeInNanosTest, IsMonotonic) {
+  for (MonotonicClock clock : {MonotonicClock::kSteady, MonotonicClock::kTsc}) {
+    if (!SetMonotonicClock(clock)) continue;
+    TimeInNanos last = GetMonotonicTimeInNanos();
+    for (int i = 0; i < 1000; ++i) {
+      const TimeInNanos now = GetMonotonicTimeInNanos();
+      ASSERT_LE(last, now);
+      last = now;
+    }
+  }
+  SetMonotonicClock(MonotonicClock::kSteady);
+}
+
+// Tests that the time stamp counter, once calibrated, keeps up with the
+// steady clock.
+TEST(GetMonotonicTimeInNanosTest, TscAgreesWithSteadyClock) {
+  if (!SetMonotonicClock(MonotonicClock::kTsc)) {
+    GTEST_SKIP() << "The CPU has no invariant time stamp counter.";
+  }
+  const auto steady_start = std::chrono::steady_clock::now();
+  const TimeInNanos tsc_start = GetMonotonicTimeInNanos();
+  while (std::chrono::steady_clock::now() - steady_start <
+         std::chrono::milliseconds(50)) {
+  }
+  const TimeInNanos tsc_elapsed = GetMonotonicTimeInNanos() - tsc_start;
+  const TimeInNanos steady_elapsed =
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now() - steady_start)
+          .count();
+  SetMonotonicClock(MonotonicClock::kSteady);
+  EXPECT_NEAR(static_cast<double>(steady_elapsed),
+              static_cast<double>(tsc_elapsed), 0.05 * 50000000);
+}
+
 // Tests FormatEpochTimeInMillisAsIso8601().  The correctness of conversion
 // for particular dates below was verified in Python using
 // datetime.datetime.fromutctimestamp(<timestamp>/1000).
@@ -1555,6 +1630,21 @@ TEST(TestResultPropertyTest, GetTestProperty) {
   EXPECT_DEATH_IF_SUPPORTED(test_result.GetTestProperty(-1), "");
 }
 
+#if GTEST_HAS_ABSL
+// Tests that stack traces taken from the same place are the same when their
+// frames are symbolized from the cache.
+TEST(OsStackTraceGetterTest, RepeatedTracesFromSamePlaceAreEqual) {
+  OsStackTraceGetter getter;
+  std::string traces[2];
+  for (std::string& trace : traces) {
+    trace = getter.CurrentStackTrace(kMaxStackTraceDepth, 0);
+  }
+  // The trace starts above the frame that asked for it.
+  EXPECT_NE(std::string::npos, traces[0].find("testing::Test::Run()"));
+  EXPECT_EQ(traces[0], traces[1]);
+}
+#endif  // GTEST_HAS_ABSL
+
 // Tests the Test class.
 //
 // It's difficult to test every public method of this class (we are
@@ -1577,14 +1667,23 @@ class GTestFlagSaverTest : public Test {
 
     GTEST_FLAG_SET(also_run_disabled_tests, false);
     GTEST_FLAG_SET(break_on_failure, false);
+    GTEST_FLAG_SET(captured_output_limit, 0);
     GTEST_FLAG_SET(catch_exceptions, false);
+    GTEST_FLAG_SET(check_pooled_reset, false);
+    GTEST_FLAG_SET(clock, "steady");
     GTEST_FLAG_SET(death_test_use_fork, false);
+    GTEST_FLAG_SET(death_test_use_posix_spawn, true);
+    GTEST_FLAG_SET(death_test_use_zygote, false);
+    GTEST_FLAG_SET(death_test_concurrency, 1);
+    GTEST_FLAG_SET(death_test_output_limit, 1024 * 1024);
     GTEST_FLAG_SET(color, "auto");
     GTEST_FLAG_SET(fail_fast, false);
     GTEST_FLAG_SET(filter, "");
+    GTEST_FLAG_SET(isolation, "none");
     GTEST_FLAG_SET(list_tests, false);
     GTEST_FLAG_SET(output, "");
     GTEST_FLAG_SET(brief, false);
+    GTEST_FLAG_SET(output_buffering, false);
     GTEST_FLAG_SET(print_time, true);
     GTEST_FLAG_SET(random_seed, 0);
     GTEST_FLAG_SET(repeat, 1);
@@ -1593,6 +1692,7 @@ class GTestFlagSaverTest : public Test {
     GTEST_FLAG_SET(stack_trace_depth, kMaxStackTraceDepth);
     GTEST_FLAG_SET(stream_result_to, "");
     GTEST_FLAG_SET(throw_on_failure, false);
+    GTEST_FLAG_SET(time_precision, 3);
   }
 
   // Restores the Google Test flags that the tests have modified.  This will
@@ -1607,14 +1707,23 @@ class GTestFlagSaverTest : public Test {
   void VerifyAndModifyFlags() {
     EXPECT_FALSE(GTEST_FLAG_GET(also_run_disabled_tests));
     EXPECT_FALSE(GTEST_FLAG_GET(break_on_failure));
+    EXPECT_EQ(0, GTEST_FLAG_GET(captured_output_limit));
     EXPECT_FALSE(GTEST_FLAG_GET(catch_exceptions));
+    EXPECT_FALSE(GTEST_FLAG_GET(check_pooled_reset));
+    EXPECT_STREQ("steady", GTEST_FLAG_GET(clock).c_str());
     EXPECT_STREQ("auto", GTEST_FLAG_GET(color).c_str());
     EXPECT_FALSE(GTEST_FLAG_GET(death_test_use_fork));
+    EXPECT_TRUE(GTEST_FLAG_GET(death_test_use_posix_spawn));
+    EXPECT_FALSE(GTEST_FLAG_GET(death_test_use_zygote));
+    EXPECT_EQ(1, GTEST_FLAG_GET(death_test_concurrency));
+    EXPECT_EQ(1024 * 1024, GTEST_FLAG_GET(death_test_output_limit));
     EXPECT_FALSE(GTEST_FLAG_GET(fail_fast));
     EXPECT_STREQ("", GTEST_FLAG_GET(filter).c_str());
+    EXPECT_STREQ("none", GTEST_FLAG_GET(isolation).c_str());
     EXPECT_FALSE(GTEST_FLAG_GET(list_tests));
     EXPECT_STREQ("", GTEST_FLAG_GET(output).c_str());
     EXPECT_FALSE(GTEST_FLAG_GET(brief));
+    EXPECT_FALSE(GTEST_FLAG_GET(output_buffering));
     EXPECT_TRUE(GTEST_FLAG_GET(print_time));
     EXPECT_EQ(0, GTEST_FLAG_GET(random_seed));
     EXPECT_EQ(1, GTEST_FLAG_GET(repeat));
@@ -1623,17 +1732,27 @@ class GTestFlagSaverTest : public Test {
     EXPECT_EQ(kMaxStackTraceDepth, GTEST_FLAG_GET(stack_trace_depth));
     EXPECT_STREQ("", GTEST_FLAG_GET(stream_result_to).c_str());
     EXPECT_FALSE(GTEST_FLAG_GET(throw_on_failure));
+    EXPECT_EQ(3, GTEST_FLAG_GET(time_precision));
 
     GTEST_FLAG_SET(also_run_disabled_tests, true);
     GTEST_FLAG_SET(break_on_failure, true);
+    GTEST_FLAG_SET(captured_output_limit, 4096);
     GTEST_FLAG_SET(catch_exceptions, true);
+    GTEST_FLAG_SET(check_pooled_reset, true);
+    GTEST_FLAG_SET(clock, "tsc");
     GTEST_FLAG_SET(color, "no");
     GTEST_FLAG_SET(death_test_use_fork, true);
+    GTEST_FLAG_SET(death_test_use_posix_spawn, false);
+    GTEST_FLAG_SET(death_test_use_zygote, true);
+    GTEST_FLAG_SET(death_test_concurrency, 4);
+    GTEST_FLAG_SET(death_test_output_limit, 100);
     GTEST_FLAG_SET(fail_fast, true);
     GTEST_FLAG_SET(filter, "abc");
+    GTEST_FLAG_SET(isolation, "test");
     GTEST_FLAG_SET(list_tests, true);
     GTEST_FLAG_SET(output, "xml:foo.xml");
     GTEST_FLAG_SET(brief, true);
+    GTEST_FLAG_SET(output_buffering, true);
     GTEST_FLAG_SET(print_time, false);
     GTEST_FLAG_SET(random_seed, 1);
     GTEST_FLAG_SET(repeat, 100);
@@ -1642,6 +1761,7 @@ class GTestFlagSaverTest : public Test {
     GTEST_FLAG_SET(stack_trace_depth, 1);
     GTEST_FLAG_SET(stream_result_to, "localhost:1234");
     GTEST_FLAG_SET(throw_on_failure, true);
+    GTEST_FLAG_SET(time_precision, 9);
   }
 
  private:
@@ -4649,6 +4769,27 @@ TEST(StreamableTest, BasicIoManip) {
       "Line 1.\nA NUL char \\0 in line 2.");
 }
 
+enum class TracedColor { kRed, kBlue };
+
+std::ostream& operator<<(std::ostream& os, TracedColor color) {
+  return os << (color == TracedColor::kRed ? "red" : "blue");
+}
+
+// Tests that SCOPED_TRACE of a number or an enum, which is formatted only
+// when a failure is reported, shows the value it was given.
+TEST(ScopedTraceTest, FormatsCopiedValueOnFailure) {
+  int i = 42;
+  TracedColor color = TracedColor::kRed;
+  SCOPED_TRACE(i);
+  SCOPED_TRACE(color);
+  SCOPED_TRACE(2.5);
+  i = 0;
+  color = TracedColor::kBlue;
+  EXPECT_NONFATAL_FAILURE(ADD_FAILURE(), " 42");
+  EXPECT_NONFATAL_FAILURE(ADD_FAILURE(), " red");
+  EXPECT_NONFATAL_FAILURE(ADD_FAILURE(), " 2.5");
+}
+
 // Tests the macros that haven't been covered so far.
 
 void AddFailureHelper(bool* aborted) {
@@ -5452,13 +5593,22 @@ struct Flags {
   Flags()
       : also_run_disabled_tests(false),
         break_on_failure(false),
+        captured_output_limit(0),
         catch_exceptions(false),
+        check_pooled_reset(false),
+        clock("steady"),
         death_test_use_fork(false),
+        death_test_use_posix_spawn(true),
+        death_test_use_zygote(false),
+        death_test_concurrency(1),
+        death_test_output_limit(1024 * 1024),
         fail_fast(false),
         filter(""),
+        isolation("none"),
         list_tests(false),
         output(""),
         brief(false),
+        output_buffering(false),
         print_time(true),
         random_seed(0),
         repeat(1),
@@ -5466,7 +5616,8 @@ struct Flags {
         shuffle(false),
         stack_trace_depth(kMaxStackTraceDepth),
         stream_result_to(""),
-        throw_on_failure(false) {}
+        throw_on_failure(false),
+        time_precision(3) {}
 
   // Factory methods.
 
@@ -5486,6 +5637,14 @@ struct Flags {
     return flags;
   }
 
+  // Creates a Flags struct where the gtest_captured_output_limit flag has
+  // the given value.
+  static Flags CapturedOutputLimit(int32_t captured_output_limit) {
+    Flags flags;
+    flags.captured_output_limit = captured_output_limit;
+    return flags;
+  }
+
   // Creates a Flags struct where the gtest_catch_exceptions flag has
   // the given value.
   static Flags CatchExceptions(bool catch_exceptions) {
@@ -5494,6 +5653,22 @@ struct Flags {
     return flags;
   }
 
+  // Creates a Flags struct where the gtest_check_pooled_reset flag has
+  // the given value.
+  static Flags CheckPooledReset(bool check_pooled_reset) {
+    Flags flags;
+    flags.check_pooled_reset = check_pooled_reset;
+    return flags;
+  }
+
+  // Creates a Flags struct where the gtest_clock flag has the given
+  // value.
+  static Flags Clock(const char* clock) {
+    Flags flags;
+    flags.clock = clock;
+    return flags;
+  }
+
   // Creates a Flags struct where the gtest_death_test_use_fork flag has
   // the given value.
   static Flags DeathTestUseFork(bool death_test_use_fork) {
@@ -5502,6 +5677,38 @@ struct Flags {
     return flags;
   }
 
+  // Creates a Flags struct where the gtest_death_test_use_posix_spawn flag
+  // has the given value.
+  static Flags DeathTestUsePosixSpawn(bool death_test_use_posix_spawn) {
+    Flags flags;
+    flags.death_test_use_posix_spawn = death_test_use_posix_spawn;
+    return flags;
+  }
+
+  // Creates a Flags struct where the gtest_death_test_use_zygote flag has
+  // the given value.
+  static Flags DeathTestUseZygote(bool death_test_use_zygote) {
+    Flags flags;
+    flags.death_test_use_zygote = death_test_use_zygote;
+    return flags;
+  }
+
+  // Creates a Flags struct where the gtest_death_test_concurrency flag has
+  // the given value.
+  static Flags DeathTestConcurrency(int32_t death_test_concurrency) {
+    Flags flags;
+    flags.death_test_concurrency = death_test_concurrency;
+    return flags;
+  }
+
+  // Creates a Flags struct where the gtest_death_test_output_limit flag has
+  // the given value.
+  static Flags DeathTestOutputLimit(int32_t death_test_output_limit) {
+    Flags flags;
+    flags.death_test_output_limit = death_test_output_limit;
+    return flags;
+  }
+
   // Creates a Flags struct where the gtest_fail_fast flag has
   // the given value.
   static Flags FailFast(bool fail_fast) {
@@ -5518,6 +5725,14 @@ struct Flags {
     return flags;
   }
 
+  // Creates a Flags struct where the gtest_isolation flag has the given
+  // value.
+  static Flags Isolation(const char* isolation) {
+    Flags flags;
+    flags.isolation = isolation;
+    return flags;
+  }
+
   // Creates a Flags struct where the gtest_list_tests flag has the
   // given value.
   static Flags ListTests(bool list_tests) {
@@ -5542,6 +5757,14 @@ struct Flags {
     return flags;
   }
 
+  // Creates a Flags struct where the gtest_output_buffering flag has the
+  // given value.
+  static Flags OutputBuffering(bool output_buffering) {
+    Flags flags;
+    flags.output_buffering = output_buffering;
+    return flags;
+  }
+
   // Creates a Flags struct where the gtest_print_time flag has the given
   // value.
   static Flags PrintTime(bool print_time) {
@@ -5608,16 +5831,33 @@ struct Flags {
     return flags;
   }
 
+  // Creates a Flags struct where the gtest_time_precision flag has the
+  // given value.
+  static Flags TimePrecision(int32_t time_precision) {
+    Flags flags;
+    flags.time_precision = time_precision;
+    return flags;
+  }
+
   // These fields store the flag values.
   bool also_run_disabled_tests;
   bool break_on_failure;
+  int32_t captured_output_limit;
   bool catch_exceptions;
+  bool check_pooled_reset;
+  const char* clock;
   bool death_test_use_fork;
+  bool death_test_use_posix_spawn;
+  bool death_test_use_zygote;
+  int32_t death_test_concurrency;
+  int32_t death_test_output_limit;
   bool fail_fast;
   const char* filter;
+  const char* isolation;
   bool list_tests;
   const char* output;
   bool brief;
+  bool output_buffering;
   bool print_time;
   int32_t random_seed;
   int32_t repeat;
@@ -5626,6 +5866,7 @@ struct Flags {
   int32_t stack_trace_depth;
   const char* stream_result_to;
   bool throw_on_failure;
+  int32_t time_precision;
 };
 
 // Fixture for testing ParseGoogleTestFlagsOnly().
@@ -5635,13 +5876,22 @@ class ParseFlagsTest : public Test {
   void SetUp() override {
     GTEST_FLAG_SET(also_run_disabled_tests, false);
     GTEST_FLAG_SET(break_on_failure, false);
+    GTEST_FLAG_SET(captured_output_limit, 0);
     GTEST_FLAG_SET(catch_exceptions, false);
+    GTEST_FLAG_SET(check_pooled_reset, false);
+    GTEST_FLAG_SET(clock, "steady");
     GTEST_FLAG_SET(death_test_use_fork, false);
+    GTEST_FLAG_SET(death_test_use_posix_spawn, true);
+    GTEST_FLAG_SET(death_test_use_zygote, false);
+    GTEST_FLAG_SET(death_test_concurrency, 1);
+    GTEST_FLAG_SET(death_test_output_limit, 1024 * 1024);
     GTEST_FLAG_SET(fail_fast, false);
     GTEST_FLAG_SET(filter, "");
+    GTEST_FLAG_SET(isolation, "none");
     GTEST_FLAG_SET(list_tests, false);
     GTEST_FLAG_SET(output, "");
     GTEST_FLAG_SET(brief, false);
+    GTEST_FLAG_SET(output_buffering, false);
     GTEST_FLAG_SET(print_time, true);
     GTEST_FLAG_SET(random_seed, 0);
     GTEST_FLAG_SET(repeat, 1);
@@ -5650,6 +5900,7 @@ class ParseFlagsTest : public Test {
     GTEST_FLAG_SET(stack_trace_depth, kMaxStackTraceDepth);
     GTEST_FLAG_SET(stream_result_to, "");
     GTEST_FLAG_SET(throw_on_failure, false);
+    GTEST_FLAG_SET(time_precision, 3);
   }
 
   // Asserts that two narrow or wide string arrays are equal.
@@ -5668,14 +5919,28 @@ class ParseFlagsTest : public Test {
     EXPECT_EQ(expected.also_run_disabled_tests,
               GTEST_FLAG_GET(also_run_disabled_tests));
     EXPECT_EQ(expected.break_on_failure, GTEST_FLAG_GET(break_on_failure));
+    EXPECT_EQ(expected.captured_output_limit,
+              GTEST_FLAG_GET(captured_output_limit));
     EXPECT_EQ(expected.catch_exceptions, GTEST_FLAG_GET(catch_exceptions));
+    EXPECT_EQ(expected.check_pooled_reset, GTEST_FLAG_GET(check_pooled_reset));
+    EXPECT_STREQ(expected.clock, GTEST_FLAG_GET(clock).c_str());
     EXPECT_EQ(expected.death_test_use_fork,
               GTEST_FLAG_GET(death_test_use_fork));
+    EXPECT_EQ(expected.death_test_use_posix_spawn,
+              GTEST_FLAG_GET(death_test_use_posix_spawn));
+    EXPECT_EQ(expected.death_test_use_zygote,
+              GTEST_FLAG_GET(death_test_use_zygote));
+    EXPECT_EQ(expected.death_test_concurrency,
+              GTEST_FLAG_GET(death_test_concurrency));
+    EXPECT_EQ(expected.death_test_output_limit,
+              GTEST_FLAG_GET(death_test_output_limit));
     EXPECT_EQ(expected.fail_fast, GTEST_FLAG_GET(fail_fast));
     EXPECT_STREQ(expected.filter, GTEST_FLAG_GET(filter).c_str());
+    EXPECT_STREQ(expected.isolation, GTEST_FLAG_GET(isolation).c_str());
     EXPECT_EQ(expected.list_tests, GTEST_FLAG_GET(list_tests));
     EXPECT_STREQ(expected.output, GTEST_FLAG_GET(output).c_str());
     EXPECT_EQ(expected.brief, GTEST_FLAG_GET(brief));
+    EXPECT_EQ(expected.output_buffering, GTEST_FLAG_GET(output_buffering));
     EXPECT_EQ(expected.print_time, GTEST_FLAG_GET(print_time));
     EXPECT_EQ(expected.random_seed, GTEST_FLAG_GET(random_seed));
     EXPECT_EQ(expected.repeat, GTEST_FLAG_GET(repeat));
@@ -5686,6 +5951,7 @@ class ParseFlagsTest : public Test {
     EXPECT_STREQ(expected.stream_result_to,
                  GTEST_FLAG_GET(stream_result_to).c_str());
     EXPECT_EQ(expected.throw_on_failure, GTEST_FLAG_GET(throw_on_failure));
+    EXPECT_EQ(expected.time_precision, GTEST_FLAG_GET(time_precision));
   }
 
   // Parses a command line (specified by argc1 and argv1), then
@@ -5834,6 +6100,17 @@ TEST_F(ParseFlagsTest, BreakOnFailureTrue) {
   GTEST_TEST_PARSING_FLAGS_(argv, argv2, Flags::BreakOnFailure(true), false);
 }
 
+// Tests parsing --gtest_captured_output_limit=number.
+TEST_F(ParseFlagsTest, CapturedOutputLimit) {
+  const char* argv[] = {"foo.exe", "--gtest_captured_output_limit=4096",
+                        nullptr};
+
+  const char* argv2[] = {"foo.exe", nullptr};
+
+  GTEST_TEST_PARSING_FLAGS_(argv, argv2, Flags::CapturedOutputLimit(4096),
+                            false);
+}
+
 // Tests parsing --gtest_catch_exceptions.
 TEST_F(ParseFlagsTest, CatchExceptions) {
   const char* argv[] = {"foo.exe", "--gtest_catch_exceptions", nullptr};
@@ -5843,6 +6120,24 @@ TEST_F(ParseFlagsTest, CatchExceptions) {
   GTEST_TEST_PARSING_FLAGS_(argv, argv2, Flags::CatchExceptions(true), false);
 }
 
+// Tests parsing --gtest_check_pooled_reset.
+TEST_F(ParseFlagsTest, CheckPooledReset) {
+  const char* argv[] = {"foo.exe", "--gtest_check_pooled_reset", nullptr};
+
+  const char* argv2[] = {"foo.exe", nullptr};
+
+  GTEST_TEST_PARSING_FLAGS_(argv, argv2, Flags::CheckPooledReset(true), false);
+}
+
+// Tests parsing --gtest_clock.
+TEST_F(ParseFlagsTest, Clock) {
+  const char* argv[] = {"foo.exe", "--gtest_clock=tsc", nullptr};
+
+  const char* argv2[] = {"foo.exe", nullptr};
+
+  GTEST_TEST_PARSING_FLAGS_(argv, argv2, Flags::Clock("tsc"), false);
+}
+
 // Tests parsing --gtest_death_test_use_fork.
 TEST_F(ParseFlagsTest, DeathTestUseFork) {
   const char* argv[] = {"foo.exe", "--gtest_death_test_use_fork", nullptr};
@@ -5852,6 +6147,49 @@ TEST_F(ParseFlagsTest, DeathTestUseFork) {
   GTEST_TEST_PARSING_FLAGS_(argv, argv2, Flags::DeathTestUseFork(true), false);
 }
 
+// Tests parsing --gtest_death_test_use_posix_spawn=0.
+TEST_F(ParseFlagsTest, DeathTestUsePosixSpawn) {
+  const char* argv[] = {"foo.exe", "--gtest_death_test_use_posix_spawn=0",
+                        nullptr};
+
+  const char* argv2[] = {"foo.exe", nullptr};
+
+  GTEST_TEST_PARSING_FLAGS_(argv, argv2, Flags::DeathTestUsePosixSpawn(false),
+                            false);
+}
+
+// Tests parsing --gtest_death_test_use_zygote.
+TEST_F(ParseFlagsTest, DeathTestUseZygote) {
+  const char* argv[] = {"foo.exe", "--gtest_death_test_use_zygote", nullptr};
+
+  const char* argv2[] = {"foo.exe", nullptr};
+
+  GTEST_TEST_PARSING_FLAGS_(argv, argv2, Flags::DeathTestUseZygote(true),
+                            false);
+}
+
+// Tests parsing --gtest_death_test_concurrency=number.
+TEST_F(ParseFlagsTest, DeathTestConcurrency) {
+  const char* argv[] = {"foo.exe", "--gtest_death_test_concurrency=4",
+                        nullptr};
+
+  const char* argv2[] = {"foo.exe", nullptr};
+
+  GTEST_TEST_PARSING_FLAGS_(argv, argv2, Flags::DeathTestConcurrency(4),
+                            false);
+}
+
+// Tests parsing --gtest_death_test_output_limit=number.
+TEST_F(ParseFlagsTest, DeathTestOutputLimit) {
+  const char* argv[] = {"foo.exe", "--gtest_death_test_output_limit=4096",
+                        nullptr};
+
+  const char* argv2[] = {"foo.exe", nullptr};
+
+  GTEST_TEST_PARSING_FLAGS_(argv, argv2, Flags::DeathTestOutputLimit(4096),
+                            false);
+}
+
 // Tests having the same flag twice with different values.  The
 // expected behavior is that the one coming last takes precedence.
 TEST_F(ParseFlagsTest, DuplicatedFlags) {
@@ -5877,6 +6215,15 @@ TEST_F(ParseFlagsTest, UnrecognizedFlag) {
   GTEST_TEST_PARSING_FLAGS_(argv, argv2, flags, false);
 }
 
+// Tests parsing --gtest_isolation.
+TEST_F(ParseFlagsTest, Isolation) {
+  const char* argv[] = {"foo.exe", "--gtest_isolation=suite", nullptr};
+
+  const char* argv2[] = {"foo.exe", nullptr};
+
+  GTEST_TEST_PARSING_FLAGS_(argv, argv2, Flags::Isolation("suite"), false);
+}
+
 // Tests having a --gtest_list_tests flag
 TEST_F(ParseFlagsTest, ListTestsFlag) {
   const char* argv[] = {"foo.exe", "--gtest_list_tests", nullptr};
@@ -5978,6 +6325,24 @@ TEST_F(ParseFlagsTest, BriefFlagFalse) {
   GTEST_TEST_PARSING_FLAGS_(argv, argv2, Flags::Brief(false), false);
 }
 
+// Tests having a --gtest_output_buffering flag
+TEST_F(ParseFlagsTest, OutputBufferingFlag) {
+  const char* argv[] = {"foo.exe", "--gtest_output_buffering", nullptr};
+
+  const char* argv2[] = {"foo.exe", nullptr};
+
+  GTEST_TEST_PARSING_FLAGS_(argv, argv2, Flags::OutputBuffering(true), false);
+}
+
+// Tests having a --gtest_output_buffering flag with a "false" value
+TEST_F(ParseFlagsTest, OutputBufferingFlagFalse) {
+  const char* argv[] = {"foo.exe", "--gtest_output_buffering=0", nullptr};
+
+  const char* argv2[] = {"foo.exe", nullptr};
+
+  GTEST_TEST_PARSING_FLAGS_(argv, argv2, Flags::OutputBuffering(false), false);
+}
+
 // Tests having a --gtest_print_time flag
 TEST_F(ParseFlagsTest, PrintTimeFlag) {
   const char* argv[] = {"foo.exe", "--gtest_print_time", nullptr};
@@ -6161,6 +6526,15 @@ TEST_F(ParseFlagsTest, ThrowOnFailureTrue) {
   GTEST_TEST_PARSING_FLAGS_(argv, argv2, Flags::ThrowOnFailure(true), false);
 }
 
+// Tests parsing --gtest_time_precision.
+TEST_F(ParseFlagsTest, TimePrecision) {
+  const char* argv[] = {"foo.exe", "--gtest_time_precision=9", nullptr};
+
+  const char* argv2[] = {"foo.exe", nullptr};
+
+  GTEST_TEST_PARSING_FLAGS_(argv, argv2, Flags::TimePrecision(9), false);
+}
+
 // Tests parsing a bad --gtest_filter flag.
 TEST_F(ParseFlagsTest, FilterBad) {
   const char* argv[] = {"foo.exe", "--gtest_filter", nullptr};
@@ -6949,6 +7323,132 @@ TEST(TestEventListenersTest, Release) {
   delete listener;
 }
 
+// Records the events it receives, along with the test they are about.
+class RecordingListener : public EmptyTestEventListener {
+ public:
+  RecordingListener(std::vector<std::string>* events, bool* is_destroyed)
+      : events_(events), is_destroyed_(is_destroyed) {}
+  ~RecordingListener() override { *is_destroyed_ = true; }
+
+  const TestInfo* last_test_info() const { return last_test_info_; }
+
+ protected:
+  void OnTestStart(const TestInfo& test_info) override {
+    last_test_info_ = &test_info;
+    events_->push_back(std::string("OnTestStart ") + test_info.name());
+  }
+  void OnTestPartResult(const TestPartResult& result) override {
+    events_->push_back(std::string("OnTestPartResult ") + result.message());
+  }
+  void OnTestEnd(const TestInfo& test_info) override {
+    last_test_info_ = &test_info;
+    events_->push_back(std::string("OnTestEnd ") + test_info.name());
+  }
+  void OnTestProgramEnd(const UnitTest& /*unit_test*/) override {
+    events_->push_back("OnTestProgramEnd");
+  }
+
+ private:
+  std::vector<std::string>* events_;
+  bool* is_destroyed_;
+  const TestInfo* last_test_info_ = nullptr;
+};
+
+// Tests that a listener appended with AppendAsync receives its events in
+// order, and all of them by the time a UnitTest event is delivered.
+TEST(TestEventListenersTest, AppendAsyncKeepsOrder) {
+  std::vector<std::string> events;
+  bool is_destroyed = false;
+  const TestInfo& test_info = *UnitTest::GetInstance()->current_test_info();
+  {
+    TestEventListeners listeners;
+    RecordingListener* listener = new RecordingListener(&events, &is_destroyed);
+    listeners.AppendAsync(listener);
+    testing::TestEventListener* repeater =
+        TestEventListenersAccessor::GetRepeater(&listeners);
+    repeater->OnTestStart(test_info);
+    repeater->OnTestPartResult(TestPartResult(
+        TestPartResult::kNonFatalFailure, "foo.cc", 1, "failure"));
+    repeater->OnTestEnd(test_info);
+    repeater->OnTestProgramEnd(*UnitTest::GetInstance());
+
+    ASSERT_EQ(4U, events.size());
+    EXPECT_EQ("OnTestStart AppendAsyncKeepsOrder", events[0]);
+    EXPECT_EQ("OnTestPartResult failure", events[1]);
+    EXPECT_EQ("OnTestEnd AppendAsyncKeepsOrder", events[2]);
+    EXPECT_EQ("OnTestProgramEnd", events[3]);
+#if GTEST_IS_THREADSAFE
+    // The listener received a snapshot rather than the test itself.
+    EXPECT_NE(&test_info, listener->last_test_info());
+#endif  // GTEST_IS_THREADSAFE
+  }
+  EXPECT_TRUE(is_destroyed);
+}
+
+// Tests that releasing a listener appended with AppendAsync delivers the
+// events queued for it, and returns it without deleting it.
+TEST(TestEventListenersTest, ReleaseAsync) {
+  std::vector<std::string> events;
+  bool is_destroyed = false;
+  const TestInfo& test_info = *UnitTest::GetInstance()->current_test_info();
+  RecordingListener* listener = new RecordingListener(&events, &is_destroyed);
+  {
+    TestEventListeners listeners;
+    listeners.AppendAsync(listener);
+    TestEventListenersAccessor::GetRepeater(&listeners)->OnTestEnd(test_info);
+    EXPECT_EQ(listener, listeners.Release(listener));
+    ASSERT_EQ(1U, events.size());
+    EXPECT_EQ("OnTestEnd ReleaseAsync", events[0]);
+
+    TestEventListenersAccessor::GetRepeater(&listeners)->OnTestEnd(test_info);
+    EXPECT_TRUE(listeners.Release(listener) == nullptr);
+  }
+  EXPECT_EQ(1U, events.size());
+  EXPECT_FALSE(is_destroyed);
+  delete listener;
+}
+
+#if GTEST_IS_THREADSAFE
+// Tests that stopping the background threads, as Google Test does before it
+// forks, delivers the events queued for a listener appended with
+// AppendAsync, and that the next event starts its thread again.
+TEST(TestEventListenersTest, StopBackgroundThreadsStopsAsyncListenerThread) {
+  std::vector<std::string> events;
+  bool is_destroyed = false;
+  const TestInfo& test_info = *UnitTest::GetInstance()->current_test_info();
+  {
+    TestEventListeners listeners;
+    listeners.AppendAsync(new RecordingListener(&events, &is_destroyed));
+    testing::TestEventListener* repeater =
+        TestEventListenersAccessor::GetRepeater(&listeners);
+    repeater->OnTestStart(test_info);
+    const size_t running_thread_count = testing::internal::GetThreadCount();
+    testing::internal::StopBackgroundThreads();
+    ASSERT_EQ(1U, events.size());
+    EXPECT_EQ("OnTestStart StopBackgroundThreadsStopsAsyncListenerThread",
+              events[0]);
+
+    // GetThreadCount() returns 0 where it can't count the threads.  The OS
+    // may not report the joined thread as gone right away.
+    if (running_thread_count > 0) {
+      size_t thread_count = testing::internal::GetThreadCount();
+      for (int i = 0; i < 5 && thread_count != running_thread_count - 1;
+           ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        thread_count = testing::internal::GetThreadCount();
+      }
+      EXPECT_EQ(running_thread_count - 1, thread_count);
+    }
+
+    repeater->OnTestEnd(test_info);
+    repeater->OnTestProgramEnd(*UnitTest::GetInstance());
+    ASSERT_EQ(3U, events.size());
+    EXPECT_EQ("OnTestProgramEnd", events[2]);
+  }
+  EXPECT_TRUE(is_destroyed);
+}
+#endif  // GTEST_IS_THREADSAFE
+
 // Tests that no events are forwarded when event forwarding is disabled.
 TEST(EventListenerTest, SuppressEventForwarding) {
   int on_start_counter = 0;
@@ -7750,3 +8250,114 @@ TEST(PatternGlobbingTest, MatchesFilterEdgeCases) {
   EXPECT_FALSE(testing::internal::UnitTestOptions::MatchesFilter("a", ""));
   EXPECT_TRUE(testing::internal::UnitTestOptions::MatchesFilter("", ""));
 }
+
+// A type for testing Pooled<T>.  Reset() leaves value in place when leaky
+// is set.
+struct PooledCounter {
+  PooledCounter() : value(0), leaky(false) { ++live; }
+  ~PooledCounter() { --live; }
+
+  void Reset() {
+    if (!leaky) value = 0;
+  }
+
+  bool operator==(const PooledCounter& other) const {
+    return value == other.value;
+  }
+
+  int value;
+  bool leaky;
+  static int live;
+};
+
+int PooledCounter::live = 0;
+
+// A pooled type without operator==.
+struct PooledBuffer {
+  void Reset() {}
+
+  std::vector<int> data;
+};
+
+// Tests that a Pooled<T> reuses a T that was given back after resetting it.
+TEST(PooledTest, ReusesResetObject) {
+  const PooledCounter* first;
+  {
+    testing::Pooled<PooledCounter> counter;
+    counter->value = 5;
+    first = counter.get();
+  }
+  testing::Pooled<PooledCounter> counter;
+  EXPECT_EQ(first, counter.get());
+  EXPECT_EQ(0, counter->value);
+}
+
+// Tests that Pooled<T> objects that exist at the same time hold different
+// T objects.
+TEST(PooledTest, ConstructsObjectWhenPoolIsEmpty) {
+  testing::Pooled<PooledCounter> counter1;
+  testing::Pooled<PooledCounter> counter2;
+  EXPECT_NE(counter1.get(), counter2.get());
+}
+
+// Tests that the pooled objects are destroyed when the pools are emptied.
+TEST(PooledTest, ClearObjectPoolsDestroysPooledObjects) {
+  testing::internal::ClearObjectPools();
+  { testing::Pooled<PooledCounter> counter; }
+  EXPECT_EQ(1, PooledCounter::live);
+  testing::internal::ClearObjectPools();
+  EXPECT_EQ(0, PooledCounter::live);
+}
+
+// Tests that --gtest_check_pooled_reset reports an object that Reset() did
+// not bring back to its initial state, and does not reuse it.
+TEST(PooledTest, ReportsObjectNotResetWhenChecking) {
+  GTEST_FLAG_SET(check_pooled_reset, true);
+  EXPECT_NONFATAL_FAILURE(
+      {
+        testing::Pooled<PooledCounter> counter;
+        counter->leaky = true;
+        counter->value = 1;
+      },
+      "differs from a newly constructed one after Reset()");
+  testing::Pooled<PooledCounter> counter;
+  EXPECT_EQ(0, counter->value);
+
+  // Types without operator== cannot be checked.
+  { testing::Pooled<PooledBuffer> buffer; }
+}
+
+// Tests that state left behind by Reset() goes unnoticed without
+// --gtest_check_pooled_reset.
+TEST(PooledTest, ReusesObjectNotResetWhenNotChecking) {
+  {
+    testing::Pooled<PooledCounter> counter;
+    counter->leaky = true;
+    counter->value = 1;
+  }
+  testing::Pooled<PooledCounter> counter;
+  EXPECT_EQ(1, counter->value);
+  counter->leaky = false;
+}
+
+// A fixture whose tests share one pooled PooledCounter.
+class PooledFixtureTest : public Test {
+ protected:
+  testing::Pooled<PooledCounter> counter_;
+  static const PooledCounter* previous_;
+};
+
+const PooledCounter* PooledFixtureTest::previous_ = nullptr;
+
+TEST_F(PooledFixtureTest, First) {
+  previous_ = counter_.get();
+  counter_->value = 1;
+}
+
+TEST_F(PooledFixtureTest, Second) {
+  // previous_ is null if First was filtered out.
+  if (previous_ != nullptr) {
+    EXPECT_EQ(previous_, counter_.get());
+  }
+  EXPECT_EQ(0, counter_->value);
+}